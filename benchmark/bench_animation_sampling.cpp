@@ -0,0 +1,116 @@
+#include <hyue/AnimationClip.h>
+#include <hyue/simd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace hyue;
+
+namespace {
+
+using C = TransformHierarchy;
+
+/// A skeleton with keys on every bone at 30 frames per second, as exported from a modelling tool
+SkeletonAnimation make_animation(size_t bone_count, float length)
+{
+    SkeletonAnimation animation;
+    animation.length = length;
+    animation.tracks.resize(bone_count);
+    for (size_t bone = 0; bone < bone_count; ++bone) {
+        float speed = 1 + float(bone % 7) * 0.3f;
+        for (int frame = 0; frame <= int(length * 30); ++frame) {
+            TransformKey key;
+            key.time = float(frame) / 30;
+            float phase = key.time * speed;
+            key.translate = {std::sin(phase) * 0.2f, std::cos(phase) * 0.1f, float(bone) * 0.05f};
+            float angle = 0.6f * std::sin(phase + float(bone));
+            key.rotation = {std::cos(angle / 2), 0, std::sin(angle / 2), 0};
+            animation.tracks[bone].push_back(key);
+        }
+    }
+    return animation;
+}
+
+template <class F>
+double measure_ms(int iterations, F&& f)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+} // namespace
+
+/// Time to sample the skeletons of 500 characters of 80 bones playing the
+/// same animation at different times, one track at a time as Ogre's
+/// Animation::apply does, then from a baked clip at each instruction set
+int main()
+{
+    const size_t character_count = 500, bone_count = 80;
+    const int iterations = 20;
+
+    SkeletonAnimation animation = make_animation(bone_count, 10);
+    AnimationClip clip;
+    clip.bake(animation, AnimationBakeOptions());
+    AnimationCompressionReport report = clip.get_report(animation);
+
+    std::printf("%zu characters of %zu bones, best of %d\n", character_count, bone_count, iterations);
+    std::printf("source %zu keys, %zu bytes; clip %zu frames, %zu bytes, ratio %.1f\n", report.source_keys,
+                report.source_bytes, report.clip_frames, report.clip_bytes, report.ratio);
+    std::printf("max error translation %g, rotation %g rad\n\n", report.max_translation_error,
+                report.max_rotation_error);
+    std::printf("%-24s %10s\n", "sampling", "ms");
+
+    std::vector<float> components[C::COMPONENT_COUNT];
+    float* outputs[C::COMPONENT_COUNT];
+    for (int c = 0; c < C::COMPONENT_COUNT; ++c) {
+        components[c].resize(character_count * bone_count);
+        outputs[c] = components[c].data();
+    }
+    auto time_of = [&](size_t character) { return float(character) * 0.0173f; };
+
+    double ms = measure_ms(iterations, [&]() {
+        for (size_t i = 0; i < character_count; ++i) {
+            for (size_t bone = 0; bone < bone_count; ++bone) {
+                TransformKey key = animation.sample(bone, time_of(i));
+                size_t o = i * bone_count + bone;
+                for (int c = 0; c < 3; ++c) {
+                    components[C::POS_X + c][o] = key.translate.a[c];
+                    components[C::SCALE_X + c][o] = key.scale.a[c];
+                }
+                for (int c = 0; c < 4; ++c)
+                    components[C::ROT_W + c][o] = key.rotation.a[c];
+            }
+        }
+    });
+    std::printf("%-24s %10.3f\n", "per track", ms);
+
+    const SimdLevel levels[] = {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2};
+    const char* level_names[] = {"scalar", "sse2", "avx2"};
+    for (auto level : levels) {
+        set_max_simd_level(level);
+        if (get_simd_level() != level)
+            continue;
+
+        ms = measure_ms(iterations, [&]() {
+            float* character[C::COMPONENT_COUNT];
+            for (size_t i = 0; i < character_count; ++i) {
+                for (int c = 0; c < C::COMPONENT_COUNT; ++c)
+                    character[c] = outputs[c] + i * bone_count;
+                clip.sample(time_of(i), character);
+            }
+        });
+        char name[64];
+        std::snprintf(name, sizeof(name), "clip %s", level_names[int(level)]);
+        std::printf("%-24s %10.3f\n", name, ms);
+    }
+
+    return 0;
+}
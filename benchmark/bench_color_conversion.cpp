@@ -0,0 +1,132 @@
+#include <hyue/Bitwise.h>
+#include <hyue/PixelFormat.h>
+#include <hyue/simd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+using namespace hyue;
+
+/// Best throughput of a conversion in M colours/s
+template <class F>
+static double measure(size_t colors, int iterations, F&& convert)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        convert();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        best = std::min(best, elapsed.count());
+    }
+    return colors / best / 1e6;
+}
+
+/// Throughput of the batch colour conversions of PixelUtil in M colours/s per instruction
+/// set, against converting one colour at a time with pack_color, unpack_color and Bitwise
+int main()
+{
+    const SimdLevel levels[] = {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2};
+    const char* level_names[] = {"scalar", "sse2", "avx2"};
+
+    const size_t count = 1 << 20;
+    const int iterations = 20;
+
+    std::vector<Color> colors(count);
+    for (size_t i = 0; i < count; ++i)
+        colors[i] = Color((i % 257) / 256.0f, (i % 509) / 508.0f, (i % 1021) / 1020.0f, 0.5f);
+    std::vector<Color> out(count);
+    std::vector<uint8_t> pixels(count * 16);
+
+    struct Case {
+        const char* name;
+        std::function<void()> element;
+        std::function<void()> batch;
+    };
+
+    std::vector<Case> cases;
+    for (auto format : {PixelFormat::R8G8B8A8, PixelFormat::B8G8R8A8, PixelFormat::A8R8G8B8}) {
+        const size_t size = PixelUtil::get_elem_bytes(format);
+        cases.push_back({"pack",
+                         [&, format, size]() {
+                             for (size_t i = 0; i < count; ++i)
+                                 PixelUtil::pack_color(colors[i], format, &pixels[i * size]);
+                         },
+                         [&, format]() { PixelUtil::pack_colors(colors.data(), format, pixels.data(), count); }});
+        cases.push_back({"unpack",
+                         [&, format, size]() {
+                             for (size_t i = 0; i < count; ++i)
+                                 PixelUtil::unpack_color(&out[i], format, &pixels[i * size]);
+                         },
+                         [&, format]() { PixelUtil::unpack_colors(pixels.data(), format, out.data(), count); }});
+    }
+    cases.push_back({"pack FLOAT16_RGBA",
+                     [&]() {
+                         auto* halfs = reinterpret_cast<uint16_t*>(pixels.data());
+                         const float* floats = colors[0].get_ptr();
+                         for (size_t i = 0; i < count * 4; ++i)
+                             halfs[i] = Bitwise::float_to_half(floats[i]);
+                     },
+                     [&]() { PixelUtil::pack_colors(colors.data(), PixelFormat::FLOAT16_RGBA, pixels.data(), count); }});
+    cases.push_back({"unpack FLOAT16_RGBA",
+                     [&]() {
+                         auto* halfs = reinterpret_cast<const uint16_t*>(pixels.data());
+                         float* floats = out[0].get_ptr();
+                         for (size_t i = 0; i < count * 4; ++i)
+                             floats[i] = Bitwise::half_to_float(halfs[i]);
+                     },
+                     [&]() { PixelUtil::unpack_colors(pixels.data(), PixelFormat::FLOAT16_RGBA, out.data(), count); }});
+    cases.push_back({"srgb_to_linear",
+                     [&]() {
+                         for (size_t i = 0; i < count; ++i) {
+                             for (int j = 0; j < 3; ++j) {
+                                 float c = colors[i].get_ptr()[j];
+                                 out[i].get_ptr()[j] =
+                                     c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                             }
+                             out[i].a = colors[i].a;
+                         }
+                     },
+                     [&]() { PixelUtil::srgb_to_linear(colors.data(), out.data(), count); }});
+    cases.push_back({"linear_to_srgb",
+                     [&]() {
+                         for (size_t i = 0; i < count; ++i) {
+                             for (int j = 0; j < 3; ++j) {
+                                 float c = colors[i].get_ptr()[j];
+                                 out[i].get_ptr()[j] =
+                                     c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+                             }
+                             out[i].a = colors[i].a;
+                         }
+                     },
+                     [&]() { PixelUtil::linear_to_srgb(colors.data(), out.data(), count); }});
+
+    set_max_simd_level(SimdLevel::AVX2);
+    std::printf("cpu level: %s, %zu colours, best of %d\n\n", level_names[int(get_simd_level())], count, iterations);
+    std::printf("%-28s %10s %10s %10s %10s\n", "conversion", "element", "scalar", "sse2", "avx2");
+
+    const char* format_names[] = {"R8G8B8A8", "B8G8R8A8", "A8R8G8B8"};
+    for (size_t c = 0; c < cases.size(); ++c) {
+        char name[64];
+        if (c < 6)
+            std::snprintf(name, sizeof(name), "%s %s", cases[c].name, format_names[c / 2]);
+        else
+            std::snprintf(name, sizeof(name), "%s", cases[c].name);
+        std::printf("%-28s %10.1f", name, measure(count, iterations, cases[c].element));
+
+        for (auto level : levels) {
+            set_max_simd_level(level);
+            if (get_simd_level() != level) {
+                std::printf(" %10s", "-");
+                continue;
+            }
+            std::printf(" %10.1f", measure(count, iterations, cases[c].batch));
+        }
+        std::printf("\n");
+        set_max_simd_level(SimdLevel::AVX2);
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <hyue/DDSCodec.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace hyue;
+
+/// Best time of a run in milliseconds
+template <class F>
+static double measure(int iterations, F&& run)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+/// Decode rate of src to BYTE_RGBA in megapixels per second
+static double decode_rate(const PixelBox& src, SimdLevel level, Executor* executor, int iterations)
+{
+    PixelBox dst(src.get_width(), src.get_height(), src.get_depth(), PixelFormat::BYTE_RGBA);
+    std::vector<uint8_t> pixels(dst.get_consecutive_size());
+    dst.data = pixels.data();
+
+    set_max_simd_level(level);
+    double ms = measure(iterations, [&]() {
+        if (executor)
+            PixelUtil::decompress(&src, &dst, executor);
+        else
+            PixelUtil::decompress(&src, &dst);
+    });
+    set_max_simd_level(SimdLevel::AVX2);
+
+    return double(src.get_width() * src.get_height() * src.get_depth()) / ms / 1000.0;
+}
+
+/// Block decode rates of the compressed DDS files in Tests/Media, scalar, SSE2 and
+/// in parallel on the worker pool; the files are also tiled into a 4096x4096 surface
+/// to show the scaling on large textures
+int main()
+{
+    const char* files[] = {"BumpyMetal_dxt1.dds", "gras_02_dxt1.dds", "ogreborderUp_dxt3.dds", "ogreborderUp_dxt5.dds"};
+    const int iterations = 20;
+    const int tiled_size = 4096;
+    Executor* pool = &ThreadPool::get_worker_pool();
+
+    std::printf("decode to BYTE_RGBA in MPix/s, best of %d, %zu worker threads\n\n", iterations, pool->get_concurrency());
+    std::printf("%-24s %10s %10s %10s %10s %12s\n", "file", "size", "scalar", "sse2", "parallel", "file decode");
+
+    for (auto name : files) {
+        auto stream = MappedFileDataStream::open(String(HYUE_MEDIA_DIR "/") + name);
+        if (!stream) {
+            std::printf("%-24s missing\n", name);
+            continue;
+        }
+
+        Image image;
+        DDSCodec::decode(stream, &image);
+        PixelBox src = image.get_pixel_box();
+
+        double scalar = decode_rate(src, SimdLevel::NONE, nullptr, iterations);
+        double sse2 = decode_rate(src, SimdLevel::SSE2, nullptr, iterations);
+        double parallel = decode_rate(src, SimdLevel::AVX2, pool, iterations);
+
+        // header parsing, reading and decoding of the whole file
+        Image decoded;
+        double file_ms = measure(iterations, [&]() {
+            stream->seek(0);
+            DDSCodec::decode(stream, &decoded, true);
+        });
+
+        char size[32];
+        std::snprintf(size, sizeof(size), "%ux%u", src.get_width(), src.get_height());
+        std::printf("%-24s %10s %10.1f %10.1f %10.1f %12.1f\n",
+                    name,
+                    size,
+                    scalar,
+                    sse2,
+                    parallel,
+                    double(src.get_width() * src.get_height()) / file_ms / 1000.0);
+
+        // repeat the rows of blocks of the file over a large surface
+        PixelBox tiled(tiled_size, tiled_size, 1, src.format);
+        std::vector<uint8_t> tiled_data(tiled.get_consecutive_size());
+        size_t src_size = src.get_consecutive_size();
+        for (size_t offset = 0; offset < tiled_data.size(); offset += src_size)
+            std::copy(src.data, src.data + std::min(src_size, tiled_data.size() - offset), tiled_data.data() + offset);
+        tiled.data = tiled_data.data();
+
+        std::snprintf(size, sizeof(size), "%dx%d", tiled_size, tiled_size);
+        std::printf("%-24s %10s %10.1f %10.1f %10.1f\n",
+                    "  tiled",
+                    size,
+                    decode_rate(tiled, SimdLevel::NONE, nullptr, 3),
+                    decode_rate(tiled, SimdLevel::SSE2, nullptr, 3),
+                    decode_rate(tiled, SimdLevel::AVX2, pool, 3));
+    }
+    return 0;
+}
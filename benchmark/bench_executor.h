@@ -0,0 +1,17 @@
+#pragma once
+
+#include <hyue/thread.h>
+
+/// Runs the jobs on the calling thread
+struct SerialExecutor : public hyue::Executor {
+    size_t get_concurrency() const override
+    {
+        return 1;
+    }
+
+    void parallel_for(size_t count, const std::function<void(size_t)>& job) override
+    {
+        for (size_t i = 0; i < count; ++i)
+            job(i);
+    }
+};
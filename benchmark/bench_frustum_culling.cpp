@@ -0,0 +1,141 @@
+#include <hyue/CullingStage.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench_executor.h"
+
+using namespace hyue;
+
+namespace {
+
+/// An object as the recursive traversal sees it, bounds and flags next to the rest of its state
+struct Object {
+    vec3 center;
+    vec3 half_size;
+    uint32_t flags;
+    char payload[96];
+};
+
+/// Perspective projection of a camera at eye looking down -z
+mat4 perspective(float fovy, float aspect, float near, float far, const vec3& eye)
+{
+    float f = 1 / std::tan(fovy / 2);
+    mat4 m = {{{f / aspect, 0, 0, 0},
+               {0, f, 0, 0},
+               {0, 0, (far + near) / (near - far), 2 * far * near / (near - far)},
+               {0, 0, -1, 0}}};
+    for (int r = 0; r < 4; ++r)
+        m.a[r][3] -= m.a[r][0] * eye.a[0] + m.a[r][1] * eye.a[1] + m.a[r][2] * eye.a[2];
+    return m;
+}
+
+/// Orthographic projection of the box [min, max], looking down -y as a sun would
+mat4 orthographic(const vec3& min, const vec3& max)
+{
+    // x -> x, z -> y, -y -> z
+    float sx = 2 / (max.a[0] - min.a[0]), sy = 2 / (max.a[2] - min.a[2]), sz = 2 / (max.a[1] - min.a[1]);
+    return {{{sx, 0, 0, -(max.a[0] + min.a[0]) / (max.a[0] - min.a[0])},
+             {0, 0, sy, -(max.a[2] + min.a[2]) / (max.a[2] - min.a[2])},
+             {0, -sz, 0, (max.a[1] + min.a[1]) / (max.a[1] - min.a[1])},
+             {0, 0, 0, 1}}};
+}
+
+template <class F>
+double measure_ms(int iterations, F&& f)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+} // namespace
+
+/// Time to cull 100k objects for a camera and its 4 shadow cascades, testing
+/// one object at a time against CullingStage at each instruction set
+int main()
+{
+    const size_t count = 100000;
+    const int iterations = 50;
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> xz(-1000, 1000);
+    std::uniform_real_distribution<float> y(0, 50);
+    std::uniform_real_distribution<float> size(0.5f, 5);
+
+    std::vector<Object> objects(count);
+    CullingStage stage;
+    stage.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        vec3 min{xz(rng), y(rng), xz(rng)};
+        vec3 max{min.a[0] + size(rng), min.a[1] + size(rng), min.a[2] + size(rng)};
+        stage.set_bounds(i, min, max);
+        stage.set_visibility_flags(i, 1);
+        stage.get_bounds(i, &objects[i].center, &objects[i].half_size);
+        objects[i].flags = 1;
+    }
+
+    // the camera and cascades covering growing slices of its view
+    std::vector<Frustum> frustums;
+    frustums.push_back(Frustum::from_view_projection(perspective(1.0f, 16.0f / 9, 1, 800, vec3{0, 20, 400})));
+    const float splits[] = {0, 50, 150, 400, 800};
+    for (int c = 0; c < 4; ++c) {
+        float near = 400 - splits[c], far = 400 - splits[c + 1];
+        float half_width = splits[c + 1] * 0.9f + 10;
+        frustums.push_back(
+            Frustum::from_view_projection(orthographic(vec3{-half_width, -100, far}, vec3{half_width, 200, near})));
+    }
+
+    std::printf("%zu objects, %zu frustums, best of %d\n\n", count, frustums.size(), iterations);
+    std::printf("%-24s %10s %10s\n", "cull", "ms", "visible");
+
+    std::vector<std::vector<uint32_t>> visible(frustums.size());
+    auto total_visible = [&]() {
+        size_t ret = 0;
+        for (auto& list : visible)
+            ret += list.size();
+        return ret;
+    };
+
+    double ms = measure_ms(iterations, [&]() {
+        for (size_t f = 0; f < frustums.size(); ++f) {
+            visible[f].clear();
+            for (size_t i = 0; i < count; ++i) {
+                if ((objects[i].flags & 1) && frustums[f].is_visible(objects[i].center, objects[i].half_size))
+                    visible[f].push_back(uint32_t(i));
+            }
+        }
+    });
+    std::printf("%-24s %10.3f %10zu\n", "per object", ms, total_visible());
+
+    const SimdLevel levels[] = {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2};
+    const char* level_names[] = {"scalar", "sse2", "avx2"};
+    SerialExecutor serial;
+    for (auto level : levels) {
+        set_max_simd_level(level);
+        if (get_simd_level() != level)
+            continue;
+
+        char name[64];
+        ms = measure_ms(iterations, [&]() { stage.cull(frustums.data(), frustums.size(), 1, visible.data(), &serial); });
+        std::snprintf(name, sizeof(name), "stage %s", level_names[int(level)]);
+        std::printf("%-24s %10.3f %10zu\n", name, ms, total_visible());
+
+        ms = measure_ms(iterations, [&]() { stage.cull(frustums.data(), frustums.size(), 1, visible.data()); });
+        std::snprintf(name, sizeof(name), "stage %s, %zu threads", level_names[int(level)],
+                      ThreadPool::get_worker_pool().get_concurrency());
+        std::printf("%-24s %10.3f %10zu\n", name, ms, total_visible());
+    }
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <hyue/ImageResampler.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace hyue;
+
+/// Best time of a run in milliseconds
+template <class F>
+static double measure(int iterations, F&& run)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+/// Time of a full mip chain per filter, streamed through ImageResampler::generate_mipmaps
+/// and level by level through ImageResampler::scale
+int main()
+{
+    const ResampleFilter filters[] = {ResampleFilter::BOX, ResampleFilter::BILINEAR, ResampleFilter::LANCZOS3};
+    const char* filter_names[] = {"box", "bilinear", "lanczos3"};
+
+    const size_t width = 2048, height = 2048;
+    const int iterations = 5;
+    const PixelFormat format = PixelFormat::A8B8G8R8;
+
+    std::vector<uint8_t> src_data(PixelUtil::get_memory_size(width, height, 1, format));
+    for (size_t i = 0; i < src_data.size(); ++i)
+        src_data[i] = uint8_t(i * 7 + i / 4099);
+    PixelBox src(width, height, 1, format, src_data.data());
+
+    std::vector<std::vector<uint8_t>> levels;
+    std::vector<PixelBox> mips;
+    for (size_t level = 1; ImageResampler::get_mip_size(width, level - 1) > 1
+                           || ImageResampler::get_mip_size(height, level - 1) > 1;
+         ++level) {
+        size_t w = ImageResampler::get_mip_size(width, level);
+        size_t h = ImageResampler::get_mip_size(height, level);
+        levels.emplace_back(PixelUtil::get_memory_size(w, h, 1, format));
+        mips.emplace_back(w, h, 1, format, levels.back().data());
+    }
+
+    std::printf("%zux%zu %s, %zu levels, best of %d\n\n",
+                width,
+                height,
+                PixelUtil::getFormatName(format).c_str(),
+                mips.size(),
+                iterations);
+    std::printf("%-10s %12s %12s\n", "filter", "chain ms", "levels ms");
+
+    for (size_t i = 0; i < sizeof(filters) / sizeof(filters[0]); ++i) {
+        double chain = measure(iterations, [&]() { ImageResampler::generate_mipmaps(src, mips, filters[i]); });
+        double separate = measure(iterations, [&]() {
+            ImageResampler::scale(src, mips[0], filters[i]);
+            for (size_t level = 1; level < mips.size(); ++level)
+                ImageResampler::scale(mips[level - 1], mips[level], filters[i]);
+        });
+        std::printf("%-10s %12.2f %12.2f\n", filter_names[i], chain, separate);
+    }
+
+    return 0;
+}
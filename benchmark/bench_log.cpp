@@ -0,0 +1,65 @@
+#include <hyue/Root.h>
+#include <hyue/log.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+
+using namespace hyue;
+
+/// Log lines per second with num_threads threads logging lines_per_thread lines each,
+/// as seen by the logging threads and including the time to write them out
+static std::pair<double, double> measure(int num_threads, int lines_per_thread, bool enabled)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([=]() {
+            for (int i = 0; i < lines_per_thread; ++i) {
+                if (enabled)
+                    LOG(info) << "thread " << t << " frame " << i << " value " << i * 0.5;
+                else
+                    LOG(debug) << "thread " << t << " frame " << i << " value " << i * 0.5;
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    std::chrono::duration<double> logged = std::chrono::steady_clock::now() - begin;
+    flush_log();
+    std::chrono::duration<double> written = std::chrono::steady_clock::now() - begin;
+
+    double lines = double(num_threads) * lines_per_thread;
+    return {lines / logged.count(), lines / written.count()};
+}
+
+/// Throughput of LOG through the asynchronous sink with 1, 4 and 16 producer threads,
+/// and of LOG calls below the runtime severity filter
+int main()
+{
+    const char* log_file = "bench_log.log";
+    const int total_lines = 400000;
+    const int thread_counts[] = {1, 4, 16};
+
+    // measure the sink and the file, not the terminal
+    std::streambuf* console = std::clog.rdbuf(nullptr);
+    std::printf("%d lines per run, console disabled\n\n", total_lines);
+    std::printf("%-8s %16s %16s %16s\n", "threads", "logged lines/s", "written lines/s", "filtered lines/s");
+
+    {
+        Root root(log_file);
+        set_log_level(LogLevel::info);
+
+        for (int threads : thread_counts) {
+            auto written = measure(threads, total_lines / threads, true);
+            auto filtered = measure(threads, total_lines / threads, false);
+            std::printf("%-8d %16.0f %16.0f %16.0f\n", threads, written.first, written.second, filtered.second);
+        }
+    }
+
+    std::clog.rdbuf(console);
+    std::remove(log_file);
+    return 0;
+}
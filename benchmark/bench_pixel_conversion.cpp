@@ -0,0 +1,89 @@
+#include <hyue/PixelFormat.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace hyue;
+
+/// Best throughput of a conversion in MPix/s
+template <class F>
+static double measure(int pixels, int iterations, F&& convert)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        convert();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        best = std::min(best, elapsed.count());
+    }
+    return pixels / best / 1e6;
+}
+
+/// Throughput of PixelUtil::bulk_pixel_conversion in MPix/s per format pair and instruction set,
+/// and of the banded parallel variant on the worker pool
+int main()
+{
+    const std::pair<PixelFormat, PixelFormat> pairs[] = {
+        {PixelFormat::A8R8G8B8, PixelFormat::A8B8G8R8},
+        {PixelFormat::A8R8G8B8, PixelFormat::B8G8R8A8},
+        {PixelFormat::X8R8G8B8, PixelFormat::R8G8B8A8},
+        {PixelFormat::R8G8B8, PixelFormat::A8B8G8R8},
+        {PixelFormat::B8G8R8, PixelFormat::A8R8G8B8},
+        {PixelFormat::L8, PixelFormat::A8B8G8R8},
+        {PixelFormat::FLOAT16_RGB, PixelFormat::FLOAT32_RGB},
+        {PixelFormat::FLOAT16_RGBA, PixelFormat::FLOAT32_RGBA},
+        // no hand written converters, generated from PixelFormatTraits
+        {PixelFormat::R5G6B5, PixelFormat::A8R8G8B8},
+        {PixelFormat::A2R10G10B10, PixelFormat::FLOAT16_RGBA},
+        {PixelFormat::FLOAT32_RGBA, PixelFormat::A8B8G8R8},
+        {PixelFormat::SHORT_RGBA, PixelFormat::R8G8B8A8},
+    };
+    const SimdLevel levels[] = {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2};
+    const char* level_names[] = {"scalar", "sse2", "avx2"};
+
+    const int width = 2048, height = 2048;
+    const int iterations = 10;
+
+    set_max_simd_level(SimdLevel::AVX2);
+    std::printf("cpu level: %s, %zu threads, %dx%d, best of %d\n\n",
+                level_names[int(get_simd_level())],
+                ThreadPool::get_worker_pool().get_concurrency(),
+                width,
+                height,
+                iterations);
+    std::printf("%-16s %-16s %10s %10s %10s %10s\n", "src", "dst", "scalar", "sse2", "avx2", "parallel");
+
+    for (auto& pair : pairs) {
+        std::vector<uint8_t> src_data(PixelUtil::get_memory_size(width, height, 1, pair.first), 0x5a);
+        std::vector<uint8_t> dst_data(PixelUtil::get_memory_size(width, height, 1, pair.second));
+        PixelBox src(width, height, 1, pair.first, src_data.data());
+        PixelBox dst(width, height, 1, pair.second, dst_data.data());
+
+        std::printf("%-16s %-16s",
+                    PixelUtil::getFormatName(pair.first).c_str(),
+                    PixelUtil::getFormatName(pair.second).c_str());
+
+        for (auto level : levels) {
+            set_max_simd_level(level);
+            if (get_simd_level() != level) {
+                std::printf(" %10s", "-");
+                continue;
+            }
+
+            std::printf(" %10.1f", measure(width * height, iterations, [&]() {
+                            PixelUtil::bulk_pixel_conversion(&src, &dst);
+                        }));
+        }
+
+        set_max_simd_level(SimdLevel::AVX2);
+        std::printf(" %10.1f\n", measure(width * height, iterations, [&]() {
+                        PixelUtil::bulk_pixel_conversion(&src, &dst, &ThreadPool::get_worker_pool());
+                    }));
+    }
+
+    set_max_simd_level(SimdLevel::AVX2);
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <hyue/RenderQueue.h>
+#include <hyue/thread.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench_executor.h"
+
+using namespace hyue;
+
+namespace {
+
+template <class F>
+double measure_ms(int iterations, F&& f)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+} // namespace
+
+/// Time to queue and sort back to front a frame of transparent renderables,
+/// with std::stable_sort as Ogre does below its radix threshold, with the
+/// radix sort on one and on all threads, and with the coherent mode on a
+/// camera moving a little between frames
+int main()
+{
+    const size_t count = 500000;
+    const int iterations = 20;
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> depth(1, 2000);
+    std::vector<RenderablePass> list(count);
+    for (size_t i = 0; i < count; ++i)
+        list[i] = {uint32_t(i), uint32_t(rng() % 16), depth(rng)};
+
+    std::printf("%zu renderables, best of %d\n\n", count, iterations);
+    std::printf("%-24s %10s\n", "sort", "ms");
+
+    QueuedRenderableCollection queue;
+    queue.set_organisation_mode(QueuedRenderableCollection::OM_SORT_DESCENDING);
+    auto queue_frame = [&]() {
+        queue.clear();
+        for (auto& rp : list)
+            queue.add_renderable(rp.pass, rp.renderable, rp.depth);
+    };
+
+    std::vector<RenderablePass> sorted;
+    double ms = measure_ms(iterations, [&]() {
+        sorted = list;
+        std::stable_sort(sorted.begin(), sorted.end(), [](const RenderablePass& a, const RenderablePass& b) {
+            return a.depth > b.depth || (a.depth == b.depth && a.pass < b.pass);
+        });
+    });
+    std::printf("%-24s %10.3f\n", "std::stable_sort", ms);
+
+    SerialExecutor serial;
+    ms = measure_ms(iterations, [&]() {
+        queue_frame();
+        queue.sort(&serial);
+    });
+    std::printf("%-24s %10.3f\n", "radix", ms);
+
+    char name[64];
+    ms = measure_ms(iterations, [&]() {
+        queue_frame();
+        queue.sort();
+    });
+    std::snprintf(name, sizeof(name), "radix, %zu threads", ThreadPool::get_worker_pool().get_concurrency());
+    std::printf("%-24s %10.3f\n", name, ms);
+
+    queue.set_coherent(true);
+    queue_frame();
+    queue.sort();
+    std::uniform_real_distribution<float> jitter(-2, 2);
+    size_t moves = 0;
+    ms = measure_ms(iterations, [&]() {
+        // the camera backs off, a few renderables move on their own
+        for (auto& rp : list)
+            rp.depth = rp.depth * 1.001f + 0.5f;
+        for (int i = 0; i < 1000; ++i)
+            list[rng() % count].depth += jitter(rng);
+        queue_frame();
+        queue.sort();
+        moves = queue.get_sort_stats().moves;
+    });
+    std::snprintf(name, sizeof(name), "coherent, %zu moves", moves);
+    std::printf("%-24s %10.3f\n", name, ms);
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <hyue/SkinningStage.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench_executor.h"
+
+using namespace hyue;
+
+namespace {
+
+struct Vertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+/// An animated entity, its bind pose, bone weights and skinned buffers
+struct Mesh {
+    std::vector<Vertex> vertices;
+    std::vector<float> weights;
+    std::vector<uint8_t> indices;
+    std::vector<float> positions;
+    std::vector<float> normals;
+};
+
+/// Skin one weight at a time, the loop of Ogre's OptimisedUtilGeneral::softwareVertexSkinning
+void skin_per_weight(const Mesh& mesh, const std::vector<mat3x4>& bones, float* positions, float* normals)
+{
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        const Vertex& v = mesh.vertices[i];
+        float p[3] = {}, n[3] = {};
+        for (int k = 0; k < 4; ++k) {
+            float weight = mesh.weights[i * 4 + k];
+            if (!weight)
+                continue;
+            const mat3x4& m = bones[mesh.indices[i * 4 + k]];
+            for (int r = 0; r < 3; ++r) {
+                p[r] += (m.a[r][0] * v.position[0] + m.a[r][1] * v.position[1] + m.a[r][2] * v.position[2] + m.a[r][3]) *
+                        weight;
+                n[r] += (m.a[r][0] * v.normal[0] + m.a[r][1] * v.normal[1] + m.a[r][2] * v.normal[2]) * weight;
+            }
+        }
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        for (int r = 0; r < 3; ++r) {
+            positions[i * 3 + r] = p[r];
+            normals[i * 3 + r] = length > 1e-08f ? n[r] / length : n[r];
+        }
+    }
+}
+
+template <class F>
+double measure_ms(int iterations, F&& f)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+} // namespace
+
+/// Time to skin a frame of 200 entities of 5000 vertices with 4 bones per
+/// vertex and normals, one entity after the other as Entity::updateAnimation
+/// does, then with SkinningStage at each instruction set
+int main()
+{
+    const size_t mesh_count = 200, vertex_count = 5000;
+    const int iterations = 20;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(-1, 1);
+    std::vector<mat3x4> bones(64);
+    for (auto& bone : bones) {
+        // near identity rotations, the exact values do not matter for timing
+        bone = {{{1, unit(rng) * 0.1f, unit(rng) * 0.1f, unit(rng)},
+                 {unit(rng) * 0.1f, 1, unit(rng) * 0.1f, unit(rng)},
+                 {unit(rng) * 0.1f, unit(rng) * 0.1f, 1, unit(rng)}}};
+    }
+
+    std::vector<Mesh> meshes(mesh_count);
+    for (auto& mesh : meshes) {
+        mesh.vertices.resize(vertex_count);
+        mesh.weights.resize(vertex_count * 4);
+        mesh.indices.resize(vertex_count * 4);
+        mesh.positions.resize(vertex_count * 3);
+        mesh.normals.resize(vertex_count * 3);
+        for (size_t i = 0; i < vertex_count; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                mesh.vertices[i].position[c] = unit(rng);
+                mesh.vertices[i].normal[c] = unit(rng);
+            }
+            for (int k = 0; k < 4; ++k) {
+                mesh.weights[i * 4 + k] = 0.25f;
+                mesh.indices[i * 4 + k] = uint8_t(rng() % bones.size());
+            }
+        }
+    }
+
+    std::printf("%zu meshes of %zu vertices, best of %d\n\n", mesh_count, vertex_count, iterations);
+    std::printf("%-24s %10s\n", "skinning", "ms");
+
+    double ms = measure_ms(iterations, [&]() {
+        for (auto& mesh : meshes)
+            skin_per_weight(mesh, bones, mesh.positions.data(), mesh.normals.data());
+    });
+    std::printf("%-24s %10.3f\n", "per weight", ms);
+
+    SkinningStage stage;
+    auto queue_frame = [&]() {
+        for (auto& mesh : meshes) {
+            SkinnedVertexData data;
+            data.src_position = mesh.vertices[0].position;
+            data.dst_position = mesh.positions.data();
+            data.src_position_stride = sizeof(Vertex);
+            data.dst_position_stride = 3 * sizeof(float);
+            data.src_normal = mesh.vertices[0].normal;
+            data.dst_normal = mesh.normals.data();
+            data.src_normal_stride = sizeof(Vertex);
+            data.dst_normal_stride = 3 * sizeof(float);
+            data.blend_weights = mesh.weights.data();
+            data.blend_indices = mesh.indices.data();
+            data.blend_weight_stride = 4 * sizeof(float);
+            data.blend_index_stride = 4;
+            data.weights_per_vertex = 4;
+            data.blend_matrices = bones.data();
+            data.vertex_count = vertex_count;
+            stage.add_skinning(data);
+        }
+    };
+
+    const SimdLevel levels[] = {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2};
+    const char* level_names[] = {"scalar", "sse2", "avx2"};
+    SerialExecutor serial;
+    for (auto level : levels) {
+        set_max_simd_level(level);
+        if (get_simd_level() != level)
+            continue;
+
+        char name[64];
+        ms = measure_ms(iterations, [&]() {
+            queue_frame();
+            stage.run(&serial);
+        });
+        std::snprintf(name, sizeof(name), "stage %s", level_names[int(level)]);
+        std::printf("%-24s %10.3f\n", name, ms);
+
+        ms = measure_ms(iterations, [&]() {
+            queue_frame();
+            stage.run();
+        });
+        std::snprintf(name, sizeof(name), "stage %s, %zu threads", level_names[int(level)],
+                      ThreadPool::get_worker_pool().get_concurrency());
+        std::printf("%-24s %10.3f\n", name, ms);
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <hyue/StreamReader.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+
+using namespace hyue;
+
+/// Best time of a run in milliseconds
+template <class F>
+static double measure(int iterations, F&& run)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+/// Time to split a text file into lines with DataStream::get_line, DataStream::read_line
+/// and StreamReader, over a file stream and over memory
+int main()
+{
+    const char* path = "bench_stream_reader.txt";
+    const int line_count = 200000;
+    const int iterations = 5;
+
+    {
+        std::ofstream out(path, std::ios::binary);
+        for (int i = 0; i < line_count; ++i)
+            out << "    pass " << i << " { texture_unit diffuse_" << (i * 7919) % 1000 << ".png }\n";
+    }
+
+    auto open_file = [&]() -> DataStreamPtr {
+        return std::make_shared<FileStreamDataStream>(new std::ifstream(path, std::ios::binary));
+    };
+    auto open_memory = [&]() -> DataStreamPtr {
+        auto file = open_file();
+        return std::make_shared<MemoryDataStream>(file.get());
+    };
+
+    std::printf("%d lines, best of %d\n\n", line_count, iterations);
+    std::printf("%-8s %12s %12s %12s\n", "stream", "get_line ms", "read_line ms", "reader ms");
+
+    const std::pair<const char*, std::function<DataStreamPtr()>> sources[] = {
+        {"file", open_file},
+        {"memory", open_memory},
+    };
+    for (auto& source : sources) {
+        size_t lines = 0;
+        double get_line = measure(iterations, [&]() {
+            auto stream = source.second();
+            while (!stream->is_eof()) {
+                stream->get_line(false);
+                ++lines;
+            }
+        });
+        double read_line = measure(iterations, [&]() {
+            auto stream = source.second();
+            char buf[256];
+            while (!stream->is_eof()) {
+                stream->read_line(buf, sizeof(buf) - 1);
+                ++lines;
+            }
+        });
+        double reader = measure(iterations, [&]() {
+            StreamReader reader(source.second());
+            std::string_view line;
+            while (reader.read_line(&line))
+                ++lines;
+        });
+        std::printf("%-8s %12.2f %12.2f %12.2f\n", source.first, get_line, read_line, reader);
+    }
+
+    std::remove(path);
+    return 0;
+}
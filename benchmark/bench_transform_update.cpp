@@ -0,0 +1,150 @@
+#include <hyue/TransformHierarchy.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "bench_executor.h"
+
+using namespace hyue;
+using boost::qvm::operator*;
+
+namespace {
+
+/// A node as Ogre lays it out: the transform and the children list on the heap, one node at a time
+struct PointerNode {
+    vec3 position, scale, derived_position, derived_scale;
+    quat orientation, derived_orientation;
+    float world[12];
+    PointerNode* parent = nullptr;
+    std::vector<PointerNode*> children;
+
+    /// Node::_update: update from the parent, then recurse into the children
+    void update()
+    {
+        if (parent) {
+            derived_orientation = parent->derived_orientation * orientation;
+            for (int i = 0; i < 3; ++i)
+                derived_scale.a[i] = parent->derived_scale.a[i] * scale.a[i];
+            vec3 v = position;
+            for (int i = 0; i < 3; ++i)
+                v.a[i] *= parent->derived_scale.a[i];
+            derived_position = parent->derived_orientation * v;
+            for (int i = 0; i < 3; ++i)
+                derived_position.a[i] += parent->derived_position.a[i];
+        } else {
+            derived_orientation = orientation;
+            derived_scale = scale;
+            derived_position = position;
+        }
+
+        auto r = boost::qvm::convert_to<boost::qvm::mat<float, 3, 3>>(derived_orientation);
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 3; ++col)
+                world[row * 4 + col] = r.a[row][col] * derived_scale.a[col];
+            world[row * 4 + 3] = derived_position.a[row];
+        }
+
+        for (auto child : children)
+            child->update();
+    }
+};
+
+template <class F>
+double measure_ms(int iterations, F&& f)
+{
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+} // namespace
+
+/// Time to update the transforms of a 64k node scene graph, recursing through
+/// heap allocated nodes against TransformHierarchy at each instruction set
+int main()
+{
+    const size_t roots = 256;
+    const size_t count = 65536;
+    const int iterations = 50;
+
+    // random tree: every node picks a parent among the nodes created before it,
+    // biased towards recent ones to get some depth
+    std::mt19937 rng(5);
+    std::vector<int> parents(count, -1);
+    for (size_t i = roots; i < count; ++i)
+        parents[i] = int(i / 2 + rng() % (i / 2));
+
+    std::vector<std::unique_ptr<PointerNode>> pointer_nodes;
+    std::vector<PointerNode*> pointer_roots;
+    TransformHierarchy hierarchy;
+    std::vector<TransformHierarchy::Handle> handles;
+    for (size_t i = 0; i < count; ++i) {
+        vec3 position{float(rng() % 100), float(rng() % 100), float(rng() % 100)};
+        quat orientation = boost::qvm::rot_quat(vec3{0, 1, 0}, float(rng() % 628) / 100);
+        vec3 scale{1.5f, 1.0f, 0.5f};
+
+        auto node = std::make_unique<PointerNode>();
+        node->position = position;
+        node->orientation = orientation;
+        node->scale = scale;
+        if (parents[i] >= 0) {
+            node->parent = pointer_nodes[parents[i]].get();
+            node->parent->children.push_back(node.get());
+        } else {
+            pointer_roots.push_back(node.get());
+        }
+        pointer_nodes.push_back(std::move(node));
+
+        handles.push_back(hierarchy.create(parents[i] >= 0 ? handles[parents[i]] : TransformHierarchy::NONE));
+        hierarchy.set_position(handles[i], position);
+        hierarchy.set_orientation(handles[i], orientation);
+        hierarchy.set_scale(handles[i], scale);
+    }
+    hierarchy.update();
+
+    std::printf("%zu nodes, %zu levels, best of %d\n\n", count, hierarchy.get_depth(), iterations);
+    std::printf("%-24s %10s\n", "update", "ms");
+
+    double pointer_ms = measure_ms(iterations, [&]() {
+        for (auto root : pointer_roots)
+            root->update();
+    });
+    std::printf("%-24s %10.3f\n", "pointer recursion", pointer_ms);
+
+    const SimdLevel levels[] = {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2};
+    const char* level_names[] = {"scalar", "sse2", "avx2"};
+    SerialExecutor serial;
+    for (auto level : levels) {
+        set_max_simd_level(level);
+        if (get_simd_level() != level)
+            continue;
+
+        double ms = measure_ms(iterations, [&]() {
+            hierarchy.set_position(handles[0], vec3{0, 0, 0});
+            hierarchy.update(&serial);
+        });
+        char name[64];
+        std::snprintf(name, sizeof(name), "soa %s", level_names[int(level)]);
+        std::printf("%-24s %10.3f\n", name, ms);
+
+        ms = measure_ms(iterations, [&]() {
+            hierarchy.set_position(handles[0], vec3{0, 0, 0});
+            hierarchy.update();
+        });
+        std::snprintf(name, sizeof(name), "soa %s, %zu threads", level_names[int(level)],
+                      ThreadPool::get_worker_pool().get_concurrency());
+        std::printf("%-24s %10.3f\n", name, ms);
+    }
+
+    return 0;
+}
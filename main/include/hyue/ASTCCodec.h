@@ -0,0 +1,29 @@
+#pragma once
+
+#include <hyue/DataStream.h>
+#include <hyue/Image.h>
+
+namespace hyue {
+
+class Executor;
+
+/** Reader of .astc files, as written by the ARM ASTC encoder.
+
+    The files hold a single 2D image without mip maps; 3D block footprints
+    are not supported.
+*/
+class HYUE_API ASTCCodec {
+public:
+    /// Whether data starts with the ASTC magic number
+    static bool is_astc(const void* data, size_t size);
+
+    /** Read an ASTC file into an image.
+    @param stream Stream positioned at the start of the file
+    @param image Receives the image
+    @param decompress Decode the blocks to PixelFormat::BYTE_RGBA; HDR content decodes to magenta
+    @param executor Runs the decoding in parallel; nullptr uses ThreadPool::get_worker_pool()
+    */
+    static void decode(const DataStreamPtr& stream, Image* image, bool decompress = false, Executor* executor = nullptr);
+};
+
+} // namespace hyue
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <hyue/TransformHierarchy.h>
+
+#include <vector>
+
+namespace hyue {
+
+/// A keyframe of a bone, the data of Ogre's TransformKeyFrame
+struct TransformKey {
+    float time = 0;
+    vec3 translate{0, 0, 0};
+    quat rotation{1, 0, 0, 0};
+    vec3 scale{1, 1, 1};
+};
+
+/** Keyframed animation of a skeleton the way Ogre's Animation stores it, a
+    track of keys sorted by time for every bone.
+
+    Keys are interpolated linearly, rotations by nlerp along the shortest path,
+    as NodeAnimationTrack::getInterpolatedKeyFrame does with IM_LINEAR and
+    RIM_LINEAR. This is the source AnimationClip bakes from.
+*/
+struct HYUE_API SkeletonAnimation {
+    float length = 0;
+    /// Keys of every bone, bones without keys keep the identity transform
+    std::vector<std::vector<TransformKey>> tracks;
+
+    /** Transform of a bone at a time. Times past the length wrap around,
+        times outside of the keys get the first or last key.
+    */
+    TransformKey sample(size_t bone, float time) const;
+};
+
+/// How AnimationClip::bake samples and reduces an animation
+struct AnimationBakeOptions {
+    /// Frames per second of the uniform sampling
+    float sample_rate = 30;
+    /** Add the times of the source keys to the uniform frames, then drop the
+        frames that interpolating their neighbours reproduces within the
+        tolerances below for every bone.
+    */
+    bool reduce_frames = true;
+    /** Largest errors the frame reduction may add. They are checked before
+        quantization, so the clip can be off by them plus the quantization
+        error, which AnimationCompressionReport measures together.
+    */
+    float translation_tolerance = 1e-3f;
+    /// In radians
+    float rotation_tolerance = 1e-3f;
+    float scale_tolerance = 1e-3f;
+};
+
+/// Size and accuracy of a baked clip against its source
+struct AnimationCompressionReport {
+    /// Keys of the source, each counted with a pointer to it as in Ogre's key lists
+    size_t source_keys = 0;
+    size_t source_bytes = 0;
+    size_t clip_frames = 0;
+    size_t clip_bytes = 0;
+    double ratio = 0;
+    /// Largest errors over every bone, at every source key time and between frames
+    float max_translation_error = 0;
+    /// In radians
+    float max_rotation_error = 0;
+    float max_scale_error = 0;
+};
+
+/** A skeleton animation baked into a compact layout sampled for all the bones
+    at once.
+
+    Frames hold every bone, so finding the frames around a time is a single
+    search for the whole skeleton. Within a frame each component is an array
+    over the bones: rotations quantized to 16 bits per component, translations
+    and scales to 16 bits over the range of each bone. sample() reads two
+    frames and interpolates 4 (SSE2) or 8 (AVX2) bones per instruction
+    straight into arrays laid out as TransformHierarchy components.
+@par
+    Rotations are stored with the sign of the previous frame, so that
+    interpolating neighbouring frames always takes the shortest path without
+    a test per bone. Clips whose bones all keep a unit scale store no scale.
+*/
+class HYUE_API AnimationClip {
+public:
+    AnimationClip();
+    ~AnimationClip();
+
+    /// Replace the clip by an animation sampled and quantized
+    void bake(const SkeletonAnimation& animation, const AnimationBakeOptions& options);
+
+    size_t get_bone_count() const
+    {
+        return bone_count_;
+    }
+
+    float get_length() const
+    {
+        return length_;
+    }
+
+    size_t get_frame_count() const
+    {
+        return times_.size();
+    }
+
+    /// Whether the scales are stored, false when all of them are 1
+    bool has_scale() const
+    {
+        return has_scale_;
+    }
+
+    /// Bytes of the frames and ranges
+    size_t get_memory_size() const;
+
+    /** Sample all the bones at a time, wrapped like SkeletonAnimation::sample().
+    @param time Time in the clip
+    @param components One array of get_bone_count() floats per TransformHierarchy::Component
+    */
+    void sample(float time, float* const* components) const;
+
+    /// Measure the size and error of the clip against the animation it was baked from
+    AnimationCompressionReport get_report(const SkeletonAnimation& animation) const;
+
+private:
+    /// Store a frame of transforms, one per bone, after the range of every bone is known
+    void quantize_frame(size_t frame, const std::vector<TransformKey>& pose, std::vector<quat>* previous);
+
+    size_t bone_count_ = 0;
+    /// Bones rounded up to a whole number of AVX2 registers
+    size_t stride_ = 0;
+    float length_ = 0;
+    bool has_scale_ = false;
+    std::vector<float> times_;
+    /// w, x, y, z of every bone for every frame, scaled by 32767
+    std::vector<int16_t> rotations_;
+    /// x, y, z of every bone for every frame, over the range of the bone
+    std::vector<uint16_t> translations_;
+    std::vector<uint16_t> scales_;
+    /// Minimum and quantization step of every component and bone, no scale ones without scale
+    std::vector<float> translation_min_;
+    std::vector<float> translation_step_;
+    std::vector<float> scale_min_;
+    std::vector<float> scale_step_;
+};
+
+} // namespace hyue
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <future>
+
 #include <hyue/DataStream.h>
 
 namespace hyue {
@@ -22,10 +24,15 @@ struct HYUE_API FileInfo {
     size_t uncompressed_size;
     // is dir
     bool is_dir;
+    /// Position of the entry in the directory of its archive, for archives
+    /// that open their entries by it
+    size_t index = 0;
 };
 
 using FileInfoList = std::vector<FileInfo>;
 
+using MemoryDataStreamFuture = std::future<MemoryDataStreamPtr>;
+
 /** Archive-handling class.
 
     An archive is a generic term for a container of files. This may be a
@@ -99,6 +106,26 @@ public:
     */
     virtual DataStreamPtr open(const String& filename, bool read_only = true) const = 0;
 
+    /** Read a whole file into memory on the I/O thread pool (ThreadPool::get_io_pool).
+    @note
+        The archive must stay loaded until the returned future is ready, and
+        open() must be safe to call from several threads, which holds for the
+        archives shipped with the library.
+    @param filename The fully qualified name of the file
+    @return A future for the file contents; it holds a null pointer if the file
+        is not present, or the exception thrown while reading it.
+    */
+    MemoryDataStreamFuture open_async(const String& filename) const;
+
+    /** Read several files into memory on the I/O thread pool.
+
+        The files are read in parallel, in the order given as far as the pool
+        allows; see open_async for the requirements.
+    @param filenames The fully qualified names of the files
+    @return One future per file, in the order of filenames
+    */
+    std::vector<MemoryDataStreamFuture> open_batch_async(const StringVector& filenames) const;
+
     /** Create a new file (or overwrite one already there).
     @note If the archive is read-only then this method will fail.
     @param filename The fully qualified name of the file
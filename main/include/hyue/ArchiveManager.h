@@ -1,5 +1,8 @@
 #pragma once
 
+#include <mutex>
+#include <unordered_map>
+
 #include <hyue/Singleton.h>
 #include <hyue/Archive.h>
 #include <hyue/ArchiveFactory.h>
@@ -31,23 +34,96 @@ public:
     void unload(const String& filename);
 
     const ArchiveMap* get_archives() const;
+
+    /** Loads an archive and mounts it into the virtual file system.
+    @param filename Name of the archive, as for load()
+    @param archive_type Type of the archive, as for load()
+    @param mount_point Virtual directory the archive contents appear under, "" for the root
+    @param priority Mounts with a higher priority hide files of the same
+        path in lower ones; on a tie the later mount wins
+    */
+    Archive* mount(const String& filename,
+                   const String& archive_type,
+                   const String& mount_point = "",
+                   int priority = 0);
+
+    /** Mounts an already loaded archive into the virtual file system.
+
+        The same archive can be mounted several times at different mount points.
+    */
+    void mount(Archive* arch, const String& mount_point = "", int priority = 0);
+
+    /// Removes every mount of an archive from the virtual file system, the archive stays loaded
+    void unmount(Archive* arch);
+
+    /** Rebuilds the path table of the virtual file system.
+
+        The table is a snapshot of the archive contents at mount time, call this
+        after files were added to or removed from a mounted archive.
+    */
+    void refresh_mounts();
+
+    /** Opens a file of the virtual file system.
+    @param path Virtual path of the file, e.g. "textures/stone.png"
+    @return The stream from the highest priority archive holding the file, or a
+        null pointer if no mounted archive has it.
+    */
+    DataStreamPtr open(const String& path) const;
+
+    /// Whether a file exists in the virtual file system
+    bool exists(const String& path) const;
+
+    /// The archive the virtual file system resolves a path to, or a null pointer
+    Archive* find_archive(const String& path) const;
     /** Adds a new ArchiveFactory to the list of available factories.
 
         Plugin developers who add new archive codecs need to call
         this after defining their ArchiveFactory subclass and
-        Archive subclasses for their archive type.
+        Archive subclasses for their archive type. Factories can be added and
+        removed from any thread, e.g. by plugins installing in parallel.
     */
     void add_archive_factory(ArchiveFactory* factory);
 
+    /// Removes the ArchiveFactory of a type, archives it created must be unloaded first
+    void remove_archive_factory(const String& archive_type);
+
+    /// Whether an ArchiveFactory for a type was added
+    bool has_archive_factory(const String& archive_type) const;
+
 private:
     ArchiveFactory* get_archive_factory(const String& archive_type);
 
+    /// Insert the files of a mount into vfs_table_, replacing entries already there
+    void add_mount_files(size_t mount_index);
+
+    /// Canonical form of a virtual path: '/' separated, no leading or trailing '/'
+    static String normalize_vfs_path(const String& path);
+
 private:
+    struct Mount {
+        Archive* archive;
+        /// Normalized mount point, "" for the root
+        String mount_point;
+        int priority;
+    };
+
+    struct VfsEntry {
+        Archive* archive;
+        /// Name of the file inside the archive
+        String filename;
+    };
+
     using ArchiveFactoryMap = std::map<String, ArchiveFactory*>;
     /// Factories available to create archives, indexed by archive type (String identifier e.g. 'Zip')
     ArchiveFactoryMap arch_factories_;
+    /// Guards arch_factories_
+    mutable std::mutex factories_mutex_;
     /// Currently loaded archives
     ArchiveMap archives_;
+    /// Mounted archives, sorted by ascending priority then mount order
+    std::vector<Mount> mounts_;
+    /// Virtual path of every mounted file to the archive that wins for it
+    std::unordered_map<String, VfsEntry> vfs_table_;
 };
 
 } // namespace hyue
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <hyue/Frustum.h>
+
+namespace hyue {
+
+class Executor;
+
+/** Frustum culling over a flat array of world space bounding boxes.
+
+    Objects are indices into arrays of box centers, half sizes and visibility
+    flags, one array per component. cull() tests 4 (SSE2) or 8 (AVX2) boxes
+    per instruction against the planes of several frustums at once, e.g. a
+    camera and its shadow cascades, splitting the objects into ranges run on
+    an Executor. The lists of each range are concatenated in range order, so
+    the visible objects always come out sorted by index, whatever the threads
+    did.
+*/
+class HYUE_API CullingStage {
+public:
+    CullingStage();
+    ~CullingStage();
+
+    /// Set the number of objects, new objects have no bounds and flags 0 (never visible)
+    void resize(size_t count);
+
+    size_t size() const
+    {
+        return flags_.size();
+    }
+
+    /// Set the world space bounds of an object
+    void set_bounds(size_t index, const vec3& min, const vec3& max);
+
+    /** Set the world space bounds of an object from its local bounds and its
+        world matrix, the box enclosing the transformed one.
+    */
+    void set_bounds(size_t index, const vec3& min, const vec3& max, const mat4& world);
+
+    /// Center and half size of an object
+    void get_bounds(size_t index, vec3* center, vec3* half_size) const;
+
+    /// Flags matched against the mask given to cull(), like Ogre's MovableObject::setVisibilityFlags
+    void set_visibility_flags(size_t index, uint32_t flags)
+    {
+        flags_[index] = flags;
+    }
+
+    uint32_t get_visibility_flags(size_t index) const
+    {
+        return flags_[index];
+    }
+
+    /** Find the objects inside each of a set of frustums.
+    @param frustums The frustums to test against
+    @param frustum_count Number of frustums, and of visible lists
+    @param visibility_mask Objects are only visible if their flags share a bit with it
+    @param visible Receives the indices of the visible objects of every frustum, in increasing order
+    @param executor Where to run the ranges, ThreadPool::get_worker_pool() if null
+    */
+    void cull(const Frustum* frustums,
+              size_t frustum_count,
+              uint32_t visibility_mask,
+              std::vector<uint32_t>* visible,
+              Executor* executor = nullptr);
+
+    /// cull() for a single frustum
+    void cull(const Frustum& frustum, uint32_t visibility_mask, std::vector<uint32_t>* visible, Executor* executor = nullptr)
+    {
+        cull(&frustum, 1, visibility_mask, visible, executor);
+    }
+
+private:
+    /// Box centers and half sizes, x, y and z
+    std::vector<float> center_[3];
+    std::vector<float> half_size_[3];
+    std::vector<uint32_t> flags_;
+    /// Visible lists of every range and frustum, kept to reuse their memory
+    std::vector<std::vector<uint32_t>> range_visible_;
+};
+
+} // namespace hyue
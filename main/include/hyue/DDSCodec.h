@@ -0,0 +1,33 @@
+#pragma once
+
+#include <hyue/DataStream.h>
+#include <hyue/Image.h>
+
+namespace hyue {
+
+class Executor;
+
+/** Reader of DirectDraw Surface files.
+
+    Supports 2D, volume and cube map textures with mip maps, stored in
+    legacy FourCC, DX10 extended or bit mask described formats. Block
+    compressed data is either kept as is, for upload to a GPU, or decoded
+    on the CPU.
+*/
+class HYUE_API DDSCodec {
+public:
+    /// Whether data starts with the DDS magic number
+    static bool is_dds(const void* data, size_t size);
+
+    /** Read a DDS file into an image.
+    @param stream Stream positioned at the start of the file
+    @param image Receives all faces and mip levels of the file
+    @param decompress Decode block compressed formats to PixelFormat::BYTE_RGBA, see
+        PixelUtil::is_decompressible; uncompressed formats are loaded unchanged
+    @param executor Runs the decoding of large levels in parallel; nullptr uses
+        ThreadPool::get_worker_pool()
+    */
+    static void decode(const DataStreamPtr& stream, Image* image, bool decompress = false, Executor* executor = nullptr);
+};
+
+} // namespace hyue
@@ -246,6 +246,84 @@ private:
 
 using MemoryDataStreamPtr = SharedPtr<MemoryDataStream>;
 
+/** Read-only subclass of MemoryDataStream over a memory-mapped file.
+
+    The file contents are accessed directly through the mapping, so get_ptr()
+    and get_size() can be used to parse the file in place without copying it
+    into a heap buffer first. The mapping is released when the stream is closed.
+*/
+class HYUE_API MappedFileDataStream : public MemoryDataStream {
+public:
+    /** Wrap an existing read-only mapping.
+    @param name The name to give the stream
+    @param p_map Start of the mapping, as returned by mmap
+    @param size The size of the mapping in bytes
+    */
+    MappedFileDataStream(const String& name, void* p_map, size_t size);
+
+    ~MappedFileDataStream();
+
+    /** @copydoc DataStream::close
+     */
+    void close(void) override;
+
+    /** Map a file into memory and return a stream on it.
+    @param full_path The path of the file to map
+    @param name The name to give the stream, defaults to full_path
+    @return The stream, or a null pointer if the file could not be mapped
+    */
+    static SharedPtr<MappedFileDataStream> open(const String& full_path, const String& name = "");
+
+private:
+    /// Start of the mapping, null once unmapped
+    void* map_;
+    /// Length of the mapping
+    size_t map_size_;
+};
+
+using MappedFileDataStreamPtr = SharedPtr<MappedFileDataStream>;
+
+/** Read-only MemoryDataStream over a byte range of memory owned by something
+    else, such as a slice of a MemoryDataStream, a mapped file or a stored zip entry.
+
+    Nothing is copied: the view reads the memory in place and keeps its owner
+    alive, but has its own read position. Any number of views of the same
+    memory can therefore be read concurrently, one thread per view. The viewed
+    memory must not be written, and a parent stream not closed, while views of
+    it are in use.
+*/
+class HYUE_API DataStreamView : public MemoryDataStream {
+public:
+    /** View a range of another memory stream.
+    @param name The name to give the stream
+    @param parent The stream whose memory is viewed; its read position is
+        neither used nor changed. Views of views share the original owner.
+    @param offset Start of the range within parent
+    @param size The size of the range in bytes
+    */
+    DataStreamView(const String& name, const MemoryDataStreamPtr& parent, size_t offset, size_t size);
+
+    /** View memory kept valid by an owner.
+    @param name The name to give the stream
+    @param owner Object the memory belongs to, held until the view is closed
+    @param p_mem Start of the range
+    @param size The size of the range in bytes
+    */
+    DataStreamView(const String& name, SharedPtr<const void> owner, const void* p_mem, size_t size);
+
+    ~DataStreamView();
+
+    /** @copydoc DataStream::close
+     */
+    void close(void) override;
+
+private:
+    /// Keeps the viewed memory alive, null once closed
+    SharedPtr<const void> owner_;
+};
+
+using DataStreamViewPtr = SharedPtr<DataStreamView>;
+
 /** Common subclass of DataStream for handling data from
     std::basic_istream.
 */
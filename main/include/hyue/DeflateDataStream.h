@@ -0,0 +1,113 @@
+#pragma once
+
+#include <hyue/DataStream.h>
+
+/// Default uncompressed distance between the checkpoints of a DeflateDataStream
+#define HYUE_DEFLATE_CHECKPOINT_INTERVAL (1024 * 1024)
+
+namespace hyue {
+
+/** Read-only stream inflating deflate, zlib or gzip data on demand.
+
+    Data is inflated into the 32 KiB window deflate itself needs, so memory
+    use does not depend on the size of the data and nothing is written to
+    temporary files. Reads and seeks within the last 32 KiB inflated are
+    served from the window; skip() forward inflates and discards.
+
+    While inflating for the first time, the stream records a checkpoint of the
+    decompressor every checkpoint_interval uncompressed bytes. Seeking to
+    any position then restarts from the nearest checkpoint before it, so
+    random access costs time proportional to the distance from that checkpoint,
+    at about 43 KiB of memory per checkpoint. Seeking back needs a seekable
+    compressed stream.
+*/
+class HYUE_API DeflateDataStream : public DataStream {
+public:
+    /// Wrapping of the deflate data (rfc1951)
+    enum StreamType {
+        /// Detect zlib and gzip headers, raw deflate data otherwise
+        AUTO = -1,
+        /// No header, no checksum
+        DEFLATE = 0,
+        /// 2 byte header, adler32 checksum (rfc1950)
+        ZLIB = 1,
+        /// 10 byte header and optional fields, crc32 and size (rfc1952); the checksum is not verified
+        GZIP = 2,
+    };
+
+    /** Constructor
+    @param name The name to give the stream
+    @param compressed_stream The compressed data, from its current position
+    @param type The wrapping of the data
+    @param checkpoint_interval Uncompressed bytes between checkpoints, 0 to only
+        keep the start of the data; shorter intervals are raised to the 32 KiB window
+    */
+    DeflateDataStream(const String& name,
+                      const DataStreamPtr& compressed_stream,
+                      StreamType type = AUTO,
+                      size_t checkpoint_interval = HYUE_DEFLATE_CHECKPOINT_INTERVAL);
+
+    ~DeflateDataStream();
+
+    /// Wrapping of the data, detected if constructed with AUTO
+    StreamType get_stream_type() const { return type_; }
+
+    /// Number of checkpoints recorded so far, including the start of the data
+    size_t get_checkpoint_count() const { return index_.size(); }
+
+    /** @copydoc DataStream::read
+     */
+    size_t read(void* buf, size_t count) override;
+
+    /** @copydoc DataStream::skip
+     */
+    void skip(long count) override;
+
+    /** Repositions the read point to a specified byte; positions past the end
+        of the data move to the end.
+     */
+    void seek(size_t pos) override;
+
+    /** @copydoc DataStream::tell
+     */
+    size_t tell(void) const override;
+
+    /** @copydoc DataStream::eof
+     */
+    bool is_eof(void) const override;
+
+    /** @copydoc DataStream::close
+     */
+    void close(void) override;
+
+private:
+    /// Decompressor, window and positions; copied to make a checkpoint
+    struct State;
+
+    /// Read and check the gzip header, returns the size of the header
+    size_t read_gzip_header();
+    /// Inflate the next piece into the window, returns false at the end of the data
+    bool inflate_next();
+    /// Continue inflating from a checkpoint
+    void restore(const State& checkpoint);
+
+    DataStreamPtr compressed_;
+    StreamType type_;
+    size_t checkpoint_interval_;
+
+    /// Current decompressor
+    std::unique_ptr<State> state_;
+    /// Checkpoints in order of their position, the first one is the start of the data
+    std::vector<std::unique_ptr<State>> index_;
+
+    /// Compressed data read ahead of the decompressor
+    std::vector<uint8_t> input_;
+    /// Unconsumed range of input_
+    size_t input_begin_;
+    size_t input_end_;
+
+    /// Read position in the uncompressed data
+    size_t pos_;
+};
+
+} // namespace hyue
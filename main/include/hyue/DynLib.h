@@ -2,23 +2,37 @@
 
 #include <hyue/type.h>
 
+#include <mutex>
+#include <unordered_map>
+
 namespace hyue {
 
+/// Options of DynLib::load, 0 binds symbols lazily and makes them global
+enum DynLibFlags {
+    /// Resolve every symbol while loading (RTLD_NOW), instead of on first call
+    DYNLIB_BIND_NOW = 1 << 0,
+    /// Keep the symbols of the library out of the global namespace (RTLD_LOCAL)
+    DYNLIB_LOCAL = 1 << 1,
+};
+
 class HYUE_API DynLib {
 public:
     DynLib(const String& name);
     ~DynLib();
 
     /** Load the library
+    @param flags DynLibFlags
     */
-
-    void load();
+    void load(int flags = 0);
     /** Unload the library
     */
     void unload();
     /// Get the name of the library
     const String& get_name(void) const { return name_; }
 
+    /// Whether the library is loaded
+    bool is_loaded() const { return handle_ != nullptr; }
+
     /**
         Returns the address of the given symbol from the loaded library.
         @param
@@ -28,6 +42,9 @@ public:
             the symbol.
         @par
             If the function fails, the returned value is <b>NULL</b>.
+        @par
+            Lookups are cached until the library is unloaded, and safe from
+            any thread.
 
     */
     void* get_symbol( const String& symbol_name ) const;
@@ -36,7 +53,11 @@ private:
     String name_;
 
     using DynLibHandle = void *;
-    DynLibHandle handle_;
+    DynLibHandle handle_ = nullptr;
+
+    /// Results of get_symbol, including the symbols not found
+    mutable std::unordered_map<String, void*> symbols_;
+    mutable std::mutex symbols_mutex_;
 
     String get_dyn_lib_error();
 };
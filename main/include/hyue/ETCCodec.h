@@ -0,0 +1,35 @@
+#pragma once
+
+#include <hyue/DataStream.h>
+#include <hyue/Image.h>
+
+namespace hyue {
+
+class Executor;
+
+/** Reader of PKM and KTX (version 1) files.
+
+    PKM files hold a single ETC1 or ETC2 image; KTX files may also hold mip
+    maps and cube maps in the other compressed formats GPUs know, see
+    PixelFormat. The ETC and ASTC formats can be decoded on the CPU.
+*/
+class HYUE_API ETCCodec {
+public:
+    /// Whether data starts with the PKM magic number
+    static bool is_pkm(const void* data, size_t size);
+
+    /// Whether data starts with the KTX identifier
+    static bool is_ktx(const void* data, size_t size);
+
+    /** Read a PKM or KTX file into an image.
+    @param stream Stream positioned at the start of the file
+    @param image Receives all faces and mip levels of the file
+    @param decompress Decode compressed formats to PixelFormat::BYTE_RGBA, see
+        PixelUtil::is_decompressible
+    @param executor Runs the decoding of large levels in parallel; nullptr uses
+        ThreadPool::get_worker_pool()
+    */
+    static void decode(const DataStreamPtr& stream, Image* image, bool decompress = false, Executor* executor = nullptr);
+};
+
+} // namespace hyue
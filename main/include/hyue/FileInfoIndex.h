@@ -0,0 +1,102 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <unordered_map>
+
+#include <hyue/Archive.h>
+
+namespace hyue {
+
+/** Lookup structure over the FileInfo entries of an archive.
+
+    Archives build it once in Archive::load, so exact lookups are a single hash
+    probe and wildcard searches only visit the directories that can match the
+    literal part of the pattern, instead of scanning every entry.
+@par
+    Entries are keyed by the name archives match patterns against (the
+    FileInfo::filename), and grouped by their parent directory, the part of the
+    key before the last '/'. The index is not synchronised; it can be read from
+    several threads as long as nobody adds or removes entries.
+*/
+class HYUE_API FileInfoIndex {
+public:
+    using Callback = std::function<void(const FileInfo&)>;
+
+    /** Constructor
+    @param root_dir Directory key of the entries at the top of the archive
+    */
+    explicit FileInfoIndex(const String& root_dir = "");
+
+    /// Set the directory key of the entries at the top of the archive
+    void set_root_dir(const String& root_dir)
+    {
+        root_dir_ = root_dir;
+    }
+
+    /// Remove all entries
+    void clear();
+
+    /// Prepare for count entries in total, avoiding rehashes while adding them
+    void reserve(size_t count)
+    {
+        entries_.reserve(count);
+    }
+
+    /// Add an entry, replacing any entry with the same key
+    void add(const String& key, const FileInfo& info);
+
+    /// Remove an entry, if present
+    void remove(const String& key);
+
+    /// Find the entry with the given key, or a null pointer
+    const FileInfo* find(const String& key) const;
+
+    /// Whether an entry with the given key exists
+    bool exists(const String& key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    /// Number of entries
+    size_t size() const
+    {
+        return entries_.size();
+    }
+
+    /** Visit entries.
+    @param recursive Whether to visit all entries or only those at the top of the archive
+    @param dirs Visit directories instead of files
+    @param callback Called for every entry
+    */
+    void list(bool recursive, bool dirs, const Callback& callback) const;
+
+    /** Visit entries whose key matches a pattern (see StringUtils::fnmatch).
+    @param pattern The pattern to search for; wildcards are allowed
+    @param recursive Whether to visit all entries or only those at the top of the archive
+    @param dirs Visit directories instead of files
+    @param callback Called for every matching entry
+    */
+    void find(const String& pattern, bool recursive, bool dirs, const Callback& callback) const;
+
+    /// Directory key of an entry key
+    static String get_dir_key(const String& key);
+
+private:
+    using EntryMap = std::unordered_map<String, FileInfo>;
+    using Entry = EntryMap::value_type;
+
+    /// Visit the entries of every directory at or below dir
+    void for_each_dir_under(const String& dir,
+                            bool recursive,
+                            const std::function<void(const Entry*)>& callback) const;
+
+    /// Key of the directory holding top level entries
+    String root_dir_;
+    /// All entries by key; node based, so children_ can point into it
+    EntryMap entries_;
+    /// Entries by directory key, sorted so a directory subtree is a contiguous range
+    std::map<String, std::vector<const Entry*>> children_;
+};
+
+} // namespace hyue
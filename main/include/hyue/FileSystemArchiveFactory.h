@@ -19,6 +19,24 @@ public:
 
     /// Get whether hidden files are ignored during filesystem enumeration.
     static bool is_ignore_hidden();
+
+    /// Set a directory in which archives cache the listing of their tree, so
+    /// later loads only check the modification time of each directory and
+    /// rescan those that changed. File sizes are not refreshed when files are
+    /// rewritten in place. Pass an empty string (the default) to scan the
+    /// whole tree on every load.
+    static void set_listing_cache_dir(const String& dir);
+
+    /// Get the directory in which archive listings are cached.
+    static const String& get_listing_cache_dir();
+
+    /// Set the file size, in bytes, from which read-only files are opened as a
+    /// MappedFileDataStream instead of being streamed through std::ifstream.
+    /// Pass std::numeric_limits<size_t>::max() to disable memory mapping.
+    static void set_mmap_threshold(size_t threshold);
+
+    /// Get the file size from which read-only files are memory mapped.
+    static size_t get_mmap_threshold();
 };
 
 } // namespace hyue
\ No newline at end of file
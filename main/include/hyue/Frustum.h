@@ -0,0 +1,46 @@
+#pragma once
+
+#include <hyue/math.h>
+
+namespace hyue {
+
+/// Plane n.x + d = 0, with the positive side the one n points to
+struct Plane {
+    vec3 normal;
+    float d;
+
+    /// Signed distance of a point, in units of |normal|
+    float get_distance(const vec3& point) const
+    {
+        return normal.a[0] * point.a[0] + normal.a[1] * point.a[1] + normal.a[2] * point.a[2] + d;
+    }
+};
+
+/** The volume seen by a camera or a shadow cascade, as six planes facing inwards.
+
+    A box is visible when it is not completely on the negative side of any
+    plane, as in Ogre's Frustum::isVisible; this may keep boxes close to the
+    corners of the frustum that are actually outside.
+*/
+struct HYUE_API Frustum {
+    enum PlaneIndex {
+        PLANE_NEAR,
+        PLANE_FAR,
+        PLANE_LEFT,
+        PLANE_RIGHT,
+        PLANE_TOP,
+        PLANE_BOTTOM,
+    };
+
+    Plane planes[6];
+
+    /** Extract the planes of a view projection matrix (column vectors, clip
+        depth from -1 to 1 like Ogre), normalized.
+    */
+    static Frustum from_view_projection(const mat4& m);
+
+    /// Whether an axis aligned box, given by its center and half size, is at least partly inside
+    bool is_visible(const vec3& center, const vec3& half_size) const;
+};
+
+} // namespace hyue
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+
+#include <hyue/PixelFormat.h>
+
+namespace hyue {
+
+class Executor;
+
+/** Pixels of a texture in system memory: all mip levels of all faces.
+
+    The levels of face 0 come first, largest level first, followed by the
+    levels of the next face. Each level is laid out consecutively.
+*/
+class HYUE_API Image {
+public:
+    Image();
+
+    /** Allocate storage, discarding previous contents.
+    @param format Pixel format, compressed formats are allowed
+    @param width Width of the top level
+    @param height Height of the top level
+    @param depth Depth of the top level, 1 for 2D images
+    @param num_faces 6 for cube maps, 1 otherwise
+    @param num_mipmaps Number of levels below the top level
+    */
+    void create(PixelFormat format,
+                uint32_t width,
+                uint32_t height,
+                uint32_t depth = 1,
+                uint32_t num_faces = 1,
+                uint32_t num_mipmaps = 0);
+
+    /// Pixels of one level of one face
+    PixelBox get_pixel_box(size_t face = 0, size_t mipmap = 0) const;
+
+    /** Decode all levels of all faces of a block compressed image to PixelFormat::BYTE_RGBA.
+    @param executor Runs the decoding of large levels in parallel; nullptr uses
+        ThreadPool::get_worker_pool()
+    @remarks The format must be PixelUtil::is_decompressible
+    */
+    void decompress(Executor* executor = nullptr);
+
+    uint8_t* get_data() { return buffer_.data(); }
+    const uint8_t* get_data() const { return buffer_.data(); }
+    /// Bytes of all levels of all faces
+    size_t get_size() const { return buffer_.size(); }
+
+    PixelFormat get_format() const { return format_; }
+    uint32_t get_width() const { return width_; }
+    uint32_t get_height() const { return height_; }
+    uint32_t get_depth() const { return depth_; }
+    uint32_t get_num_faces() const { return num_faces_; }
+    uint32_t get_num_mipmaps() const { return num_mipmaps_; }
+
+    /// Bytes needed for the levels of all faces of an image
+    static size_t calculate_size(uint32_t num_mipmaps,
+                                 uint32_t num_faces,
+                                 uint32_t width,
+                                 uint32_t height,
+                                 uint32_t depth,
+                                 PixelFormat format);
+
+private:
+    std::vector<uint8_t> buffer_;
+    PixelFormat format_;
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t depth_;
+    uint32_t num_faces_;
+    uint32_t num_mipmaps_;
+};
+
+} // namespace hyue
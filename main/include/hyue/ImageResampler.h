@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+
+#include <hyue/PixelFormat.h>
+
+namespace hyue {
+
+/// Reconstruction filters of ImageResampler
+enum class ResampleFilter {
+    /// Average of the source pixels a destination pixel covers, the classic mip filter
+    BOX,
+    /// Linear interpolation, widened to a tent over all covered pixels when shrinking
+    BILINEAR,
+    /// Windowed sinc with 3 lobes; sharpest, with slight ringing at hard edges
+    LANCZOS3,
+};
+
+/** Scaling of PixelBox contents and mip chain generation.
+
+    Filtering is separable: every row is filtered horizontally once, then
+    destination rows are blended from the few filtered rows under the
+    vertical filter, so only that window of rows is kept in memory. Pixels
+    are filtered as linear float RGBA with SIMD, any accessible format can be
+    read and written; no gamma correction is applied.
+*/
+class HYUE_API ImageResampler {
+public:
+    /** Scale the pixels of src to the size of dst.
+        @param src Source pixels, any uncompressed format and pitches
+        @param dst Destination pixels, any uncompressed format and pitches
+        @param filter Reconstruction filter
+    */
+    static void scale(const PixelBox& src, const PixelBox& dst, ResampleFilter filter = ResampleFilter::BILINEAR);
+
+    /** Generate a mip chain.
+
+        Level i + 1 is filtered from the float result of level i, so there is no
+        quantisation between levels. For 2D images all levels are produced
+        in a single pass over src: rows flow through the chain as soon as they
+        are complete, which keeps the working set at a few rows per level.
+    @param src The full size image
+    @param mips Destination of the levels below src, each normally half the size of the previous one
+    @param filter Reconstruction filter
+    */
+    static void generate_mipmaps(const PixelBox& src,
+                                 const std::vector<PixelBox>& mips,
+                                 ResampleFilter filter = ResampleFilter::BOX);
+
+    /// Size of a dimension at a mip level, never below 1
+    static size_t get_mip_size(size_t size, size_t level)
+    {
+        return std::max<size_t>(1, size >> level);
+    }
+};
+
+} // namespace hyue
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <hyue/TransformHierarchy.h>
+
+namespace hyue {
+
+/** A node of a scene graph, with the interface of Ogre's Node.
+
+    The transform of the node lives in a TransformHierarchy, the node only
+    keeps its handle there plus the tree links and the name. Setting the
+    transform is a store into the hierarchy arrays; derived transforms are the
+    ones of the last TransformHierarchy::update(), or computed on demand by
+    walking up the parents if something changed since.
+@par
+    Nodes do not own each other: destroying a node detaches it from its parent
+    and its children become root nodes.
+*/
+class HYUE_API Node {
+public:
+    /// Spaces translate and rotate can work in
+    enum TransformSpace {
+        /// Relative to the node itself
+        TS_LOCAL,
+        /// Relative to the parent of the node
+        TS_PARENT,
+        /// Relative to the world
+        TS_WORLD,
+    };
+
+    /** Constructor
+    @param hierarchy Where the transform of the node is stored, must outlive the node
+    @param name Name of the node, need not be unique
+    */
+    explicit Node(TransformHierarchy* hierarchy, const String& name = "");
+    virtual ~Node();
+
+    Node(const Node&) = delete;
+    Node& operator=(const Node&) = delete;
+
+    const String& get_name() const
+    {
+        return name_;
+    }
+
+    TransformHierarchy* get_hierarchy() const
+    {
+        return hierarchy_;
+    }
+
+    TransformHierarchy::Handle get_handle() const
+    {
+        return handle_;
+    }
+
+    /// The parent of the node, or a null pointer
+    Node* get_parent() const
+    {
+        return parent_;
+    }
+
+    /// Create a node in the same hierarchy, attached as a child of this one
+    std::unique_ptr<Node> create_child(const String& name = "",
+                                       const vec3& translate = vec3{0, 0, 0},
+                                       const quat& rotate = quat{1, 0, 0, 0});
+
+    /// Attach a node without parent as a child of this one
+    void add_child(Node* child);
+
+    /// Detach a child, it becomes a root node
+    void remove_child(Node* child);
+
+    /// Detach all children
+    void remove_all_children();
+
+    size_t num_children() const
+    {
+        return children_.size();
+    }
+
+    Node* get_child(size_t index) const;
+
+    /// The first child with a name, or a null pointer
+    Node* get_child(const String& name) const;
+
+    void set_position(const vec3& position);
+    vec3 get_position() const;
+
+    void set_orientation(const quat& orientation);
+    quat get_orientation() const;
+
+    /// Reset the orientation to identity
+    void reset_orientation();
+
+    void set_scale(const vec3& scale);
+    vec3 get_scale() const;
+
+    /// Whether the node is rotated by the orientation of its parent, true by default
+    void set_inherit_orientation(bool inherit);
+    bool get_inherit_orientation() const;
+
+    /// Whether the node is scaled by the scale of its parent, true by default
+    void set_inherit_scale(bool inherit);
+    bool get_inherit_scale() const;
+
+    /// Scale the node, combining the factors with the current scale
+    void scale(const vec3& scale);
+
+    /// Move the node along the axes of a transform space
+    void translate(const vec3& d, TransformSpace relative_to = TS_PARENT);
+
+    /// Rotate the node around the axes of a transform space
+    void rotate(const quat& q, TransformSpace relative_to = TS_LOCAL);
+
+    /// Rotate the node around an axis of a transform space
+    void rotate(const vec3& axis, float radians, TransformSpace relative_to = TS_LOCAL);
+
+    vec3 get_derived_position() const;
+    quat get_derived_orientation() const;
+    vec3 get_derived_scale() const;
+
+    /// Matrix from the local space of the node to world space
+    mat4 get_full_transform() const;
+
+private:
+    TransformHierarchy* hierarchy_;
+    TransformHierarchy::Handle handle_;
+    String name_;
+    Node* parent_ = nullptr;
+    std::vector<Node*> children_;
+};
+
+} // namespace hyue
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <hyue/ArchiveFactory.h>
+
+/// Default alignment of the stored entries of a pack, one page
+#define HYUE_PACK_ALIGNMENT 4096
+
+namespace hyue {
+
+/** Factory of read-only archives in the hyue pack format (type "Pack").
+
+    A pack is a single file meant to be memory mapped: a header, a table of
+    contents sorted by name and the names, followed by the file data starting
+    on a page boundary. Each entry is either stored, at a multiple of the
+    pack alignment so it can be used in place, or compressed as one LZ4 block.
+@par
+    Loading a pack maps it and reads the table of contents, nothing else is
+    touched until entries are opened. Opening is a binary search of the table
+    of contents; stored entries are returned as a DataStreamView of the mapping,
+    LZ4 entries are decompressed into a MemoryDataStream. Packs are built with
+    PackWriter, or the hyue_pack command line tool.
+*/
+class HYUE_API PackArchiveFactory : public ArchiveFactory {
+public:
+    const String& get_type(void) const override;
+
+    using ArchiveFactory::create_instance;
+
+    Archive* create_instance(const String& name, bool read_only) override;
+};
+
+/** Builds pack files read by PackArchiveFactory.
+
+    Files are added by name, names use '/' as directory separator. The data of
+    added files is only read, and compressed, while the pack is written.
+*/
+class HYUE_API PackWriter {
+public:
+    /// How an entry is stored
+    enum Compression {
+        /// Uncompressed, aligned to the pack alignment
+        STORE = 0,
+        /// One LZ4 block, stored instead if that saves less than an eighth of the size
+        LZ4 = 1,
+    };
+
+    /** Constructor
+    @param alignment Alignment of the stored entries within the pack, a power of two
+    */
+    explicit PackWriter(size_t alignment = HYUE_PACK_ALIGNMENT);
+
+    ~PackWriter();
+
+    /** Add a file from memory, replacing any entry with the same name.
+    @param name The name of the entry
+    @param data The contents, copied
+    @param size The size of the contents in bytes
+    @param compression How to store the entry
+    */
+    void add(const String& name, const void* data, size_t size, Compression compression = LZ4);
+
+    /** Add a file from disk, replacing any entry with the same name.
+    @param name The name of the entry
+    @param path The file to read when writing the pack
+    @param compression How to store the entry
+    */
+    void add_file(const String& name, const FilePath& path, Compression compression = LZ4);
+
+    /** Add all the files below a directory, named by their path relative to it.
+        Hidden files are skipped if FileSystemArchiveFactory::is_ignore_hidden().
+    @param dir The directory to scan
+    @param compression How to store the entries
+    @return The number of files added
+    */
+    size_t add_directory(const FilePath& dir, Compression compression = LZ4);
+
+    /// Number of entries added
+    size_t get_entry_count() const
+    {
+        return entries_.size();
+    }
+
+    /** Write the pack; panics on I/O errors.
+    @param path The file to create or overwrite
+    @return The size of the pack in bytes
+    */
+    size_t write(const String& path) const;
+
+private:
+    struct Entry {
+        /// File to read, empty for entries added from memory
+        FilePath path;
+        /// Contents of entries added from memory
+        std::vector<uint8_t> data;
+        Compression compression;
+    };
+
+    size_t alignment_;
+    /// Entries in the order of the table of contents
+    std::map<String, Entry> entries_;
+};
+
+} // namespace hyue
@@ -5,6 +5,8 @@
 
 namespace hyue {
 
+class Executor;
+
 enum class PixelFormat {
     /// Unknown pixel format.
     UNKNOWN = 0,
@@ -590,6 +592,44 @@ public:
     */
     static void unpack_color(uint8_t* r, uint8_t* g, uint8_t* b, uint8_t* a, PixelFormat pf, const void* src);
 
+    /** Pack consecutive colors to consecutive pixels, with the same results as
+        calling pack_color() for each of them.
+        @param src      The colors
+        @param pf       Pixelformat in which to write the colors
+        @param dest     Destination memory location
+        @param count    The number of colors
+        @remarks The 8 bit RGBA/BGRA/ARGB formats and their X variants are converted
+        with SIMD, as are FLOAT16_RGBA and FLOAT32_RGBA; other formats pack one
+        color at a time.
+    */
+    static void pack_colors(const Color* src, PixelFormat pf, void* dest, size_t count);
+    /** Unpack consecutive pixels to consecutive colors, with the same results as
+        calling unpack_color() for each of them.
+        @param src      Source memory location
+        @param pf       Pixelformat in which to read the colors
+        @param dest     The colors
+        @param count    The number of pixels
+        @remarks Vectorised for the same formats as pack_colors().
+    */
+    static void unpack_colors(const void* src, PixelFormat pf, Color* dest, size_t count);
+
+    /// Bitwise::float_to_half of count values, with SIMD
+    static void float_to_half(const float* src, uint16_t* dest, size_t count);
+    /// Bitwise::half_to_float of count values, with SIMD
+    static void half_to_float(const uint16_t* src, float* dest, size_t count);
+
+    /** Convert colors from the sRGB transfer function to linear, alpha is kept.
+        @param src      The sRGB colors
+        @param dest     The linear colors, may be src
+        @param count    The number of colors
+        @remarks With SIMD the curve is evaluated with polynomials, within 1e-6 of
+        std::pow for values in [0, 1]. Infinities and NaN come out as they went
+        in on every path.
+    */
+    static void srgb_to_linear(const Color* src, Color* dest, size_t count);
+    /// Inverse of srgb_to_linear(), with the same accuracy
+    static void linear_to_srgb(const Color* src, Color* dest, size_t count);
+
     /** Convert consecutive pixels from one format to another. No dithering or filtering is being done.
         Converting from RGB to luminance takes the R channel.  In case the source and destination format match,
         just a copy is done.
@@ -616,11 +656,48 @@ public:
     */
     static void bulk_pixel_conversion(const PixelBox* src, const PixelBox* dst);
 
+    /** Convert pixels from one format to another, splitting the work into bands
+        of slices or rows that run in parallel.
+        @param  src         PixelBox containing the source pixels, pitches and format
+        @param  dst         PixelBox containing the destination pixels, pitches and format
+        @param  executor    Runs the bands; nullptr uses ThreadPool::get_worker_pool()
+        @remarks Small boxes and compressed formats are converted on the calling thread.
+    */
+    static void bulk_pixel_conversion(const PixelBox* src, const PixelBox* dst, Executor* executor);
+
     /** Flips pixels inplace in vertical direction.
         @param  box         PixelBox containing pixels, pitches and format
         @remarks Non consecutive pixel boxes are supported.
      */
     static void bulk_pixel_vertical_flip(const PixelBox* box);
+
+    /** Flips pixels inplace in vertical direction, swapping bands of rows in parallel.
+        @param  box         PixelBox containing pixels, pitches and format
+        @param  executor    Runs the bands; nullptr uses ThreadPool::get_worker_pool()
+     */
+    static void bulk_pixel_vertical_flip(const PixelBox* box, Executor* executor);
+
+    /// Whether decompress() has a CPU decoder for a compressed format
+    static bool is_decompressible(PixelFormat format);
+
+    /** Decode block compressed pixels into any uncompressed format.
+        @param  src         Compressed pixels, consecutive and starting at a block boundary
+        @param  dst         Destination pixels of the same size, any uncompressed format and pitches
+        @remarks Blocks are decoded to 8 bit RGBA a row of blocks at a time, then converted
+        to the destination format. BC1-BC5 decode with SSE2: the colour palettes of
+        4 blocks at a time, and the 16 alpha or channel values of a block at once.
+        ETC1, ETC2 and ASTC LDR are scalar, and HDR or malformed ASTC blocks decode
+        to magenta.
+     */
+    static void decompress(const PixelBox* src, const PixelBox* dst);
+
+    /** Decode block compressed pixels, splitting the work into bands of block rows
+        that run in parallel.
+        @param  src         Compressed pixels, consecutive and starting at a block boundary
+        @param  dst         Destination pixels of the same size, any uncompressed format and pitches
+        @param  executor    Runs the bands; nullptr uses ThreadPool::get_worker_pool()
+     */
+    static void decompress(const PixelBox* src, const PixelBox* dst, Executor* executor);
 };
 
 // inline const String& to_string(PixelFormat v) { return PixelUtil::getFormatName(v); }
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <hyue/type.h>
+
+#if defined(_MSC_VER)
+    #define HYUE_PLUGIN_EXPORT extern "C" __declspec(dllexport)
+#else
+    #define HYUE_PLUGIN_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+/** Defines the entry points PluginManager looks up in a plugin library.
+
+    Put it in one source file of the library, with the Plugin subclass it
+    creates, e.g. HYUE_PLUGIN(MyCodecPlugin). The class needs a default
+    constructor.
+*/
+#define HYUE_PLUGIN(cls)                                                 \
+    HYUE_PLUGIN_EXPORT hyue::Plugin* hyue_create_plugin() { return new cls(); } \
+    HYUE_PLUGIN_EXPORT void hyue_destroy_plugin(hyue::Plugin* plugin) { delete plugin; }
+
+namespace hyue {
+
+/** Class defining a generic hyue plugin.
+
+    Plugins are either compiled in and registered with
+    PluginManager::add_plugin, or live in a shared library defining the entry
+    points of HYUE_PLUGIN. The plugin lifecycle is:
+    - install: the plugin registers what it provides (factories, codecs...),
+      once the plugins it depends on are installed. Plugins which do not
+      depend on each other may be installed at the same time on different
+      threads, so install must only touch thread safe registries such as
+      ArchiveManager::add_archive_factory.
+    - initialise: called on the main thread after every plugin is installed.
+    - shutdown: called in reverse order before any plugin is uninstalled.
+    - uninstall: the plugin removes what it registered, in reverse order.
+*/
+class HYUE_API Plugin {
+public:
+    virtual ~Plugin() { }
+
+    /// Unique name of the plugin
+    virtual const String& get_name() const = 0;
+
+    /// Names of the plugins which must be installed before this one
+    virtual StringVector get_dependencies() const
+    {
+        return {};
+    }
+
+    /// Register what the plugin provides, possibly on a worker thread
+    virtual void install() = 0;
+
+    /// Finish setting up, once all plugins are installed
+    virtual void initialise() { }
+
+    /// Release the resources of initialise, before any plugin is uninstalled
+    virtual void shutdown() { }
+
+    /// Remove what install registered
+    virtual void uninstall() = 0;
+};
+
+/// Signature of the hyue_create_plugin entry point of plugin libraries
+using CreatePluginFunc = Plugin* (*)();
+/// Signature of the hyue_destroy_plugin entry point of plugin libraries
+using DestroyPluginFunc = void (*)(Plugin*);
+
+} // namespace hyue
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <hyue/Singleton.h>
+#include <hyue/DynLib.h>
+#include <hyue/Plugin.h>
+#include <hyue/thread.h>
+
+namespace hyue {
+
+/// Load statistics of a plugin
+struct PluginInfo {
+    String name;
+    /// The library the plugin comes from, "" for static plugins
+    String library;
+    /// Time spent opening the library
+    double load_ms = 0;
+    /// Time spent in Plugin::install
+    double install_ms = 0;
+    /// Install wave, plugins of the same wave are independent and installed in parallel
+    size_t wave = 0;
+};
+
+/** Loads plugins and runs their lifecycle, owned by Root.
+
+    Plugins are queued from libraries, directories, a plugins.cfg file or
+    compiled in, then load() brings them all up: libraries are opened one
+    after the other (the dynamic loader serializes them anyway), then the
+    plugins are installed in waves following their dependencies, the plugins
+    of a wave in parallel on an Executor. The time taken by each plugin is
+    logged and kept in get_plugin_info().
+*/
+class HYUE_API PluginManager : public Singleton<PluginManager> {
+public:
+    PluginManager();
+    ~PluginManager();
+
+    /** Set how plugin libraries are opened, DynLibFlags.
+
+        The default 0 binds lazily, which is the fastest to load. DYNLIB_BIND_NOW
+        resolves everything up front, so missing symbols fail at load time.
+    */
+    void set_library_flags(int flags)
+    {
+        library_flags_ = flags;
+    }
+
+    int get_library_flags() const
+    {
+        return library_flags_;
+    }
+
+    /// Queue a plugin library to be opened by load()
+    void add_library(const String& path);
+
+    /** Queue every shared library of a directory, not recursively.
+    @return The number of libraries queued
+    */
+    size_t add_directory(const String& dir);
+
+    /** Queue the libraries of a plugins.cfg file.
+
+        "PluginFolder=" sets the directory the following "Plugin=" entries are
+        relative to, "Plugin=" names a library with or without its extension.
+        Empty lines and lines starting with '#' are skipped.
+    @return The number of libraries queued
+    */
+    size_t add_config(const String& path);
+
+    /// Queue a compiled in plugin, it is not owned and must outlive the manager
+    void add_plugin(Plugin* plugin);
+
+    /** Open the queued libraries and install the queued plugins.
+
+        Panics if a plugin name is used twice, a dependency is missing or
+        dependencies form a cycle; plugins installed before the error stay
+        installed, the others are dropped.
+    @param executor Where to install independent plugins, ThreadPool::get_worker_pool() if null
+    */
+    void load(Executor* executor = nullptr);
+
+    /// Call Plugin::initialise of the installed plugins in dependency order
+    void initialise();
+
+    /// Call Plugin::shutdown of the initialised plugins in reverse order
+    void shutdown();
+
+    /// Shut down, uninstall in reverse order and release every plugin and library
+    void unload();
+
+    /// An installed plugin by name, or a null pointer
+    Plugin* get_plugin(const String& name) const;
+
+    /// Statistics of the installed plugins, in install order
+    const std::vector<PluginInfo>& get_plugin_info() const
+    {
+        return info_;
+    }
+
+private:
+    struct Entry {
+        Plugin* plugin = nullptr;
+        /// The library which created the plugin, null for static plugins
+        DynLib* library = nullptr;
+        PluginInfo info;
+    };
+
+    /// Open a library and create its plugin
+    Entry load_library(const String& path);
+
+    /// Release a plugin which is not installed
+    void destroy(Entry& entry);
+
+    int library_flags_ = 0;
+    StringVector queued_libraries_;
+    std::vector<Plugin*> queued_plugins_;
+
+    /// Installed plugins, in install order
+    std::vector<Entry> installed_;
+    std::vector<PluginInfo> info_;
+    std::vector<std::unique_ptr<DynLib>> libraries_;
+    bool initialised_ = false;
+};
+
+} // namespace hyue
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <hyue/type.h>
+
+#include <vector>
+
+namespace hyue {
+
+class Executor;
+
+/** A renderable queued with one of its passes, renderable and pass are ids
+    chosen by the caller. Renderable ids must be dense, indices into the
+    caller's renderables: the coherent sort keeps a table indexed by them.
+*/
+struct RenderablePass {
+    uint32_t renderable;
+    uint32_t pass;
+    /// View depth used by the depth sorted modes
+    float depth;
+};
+
+/** A list of renderables queued for rendering and sorted in one of the
+    orders of Ogre's QueuedRenderableCollection.
+
+    All the sorting state lives in the collection, so queues for several
+    viewports can be built and sorted at the same time on different threads.
+    Large collections are radix sorted, with the digit passes split across an
+    Executor. In coherent mode the order of the previous sort is reused as the
+    starting point and fixed up by insertion sort, which is close to linear
+    when the order barely changes between frames, and the renderables new to
+    the collection are sorted apart and merged in. When too much moved, the
+    collection falls back to the radix sort.
+@par
+    Whatever the path taken, the result is the one of a stable sort of the
+    renderables in the order they were added.
+*/
+class HYUE_API QueuedRenderableCollection {
+public:
+    /// Organisation modes, with the values of Ogre's
+    enum OrganisationMode {
+        /// Grouped by increasing pass, in order of addition within a pass
+        OM_PASS_GROUP = 1,
+        /// Back to front, by decreasing depth then increasing pass
+        OM_SORT_DESCENDING = 2,
+        /// Front to back, by increasing depth then increasing pass
+        OM_SORT_ASCENDING = 6,
+    };
+
+    /// What the last sort() did
+    struct SortStats {
+        /// Whether the order of the previous sort was reused
+        bool coherent = false;
+        /// Elements shifted by the insertion sort of the coherent path
+        size_t moves = 0;
+        /// Radix passes run, passes where every key has the same digit are skipped
+        size_t radix_passes = 0;
+        /// Whether the radix passes were split across the executor
+        bool parallel = false;
+    };
+
+    QueuedRenderableCollection();
+    ~QueuedRenderableCollection();
+
+    QueuedRenderableCollection(const QueuedRenderableCollection&) = delete;
+    QueuedRenderableCollection& operator=(const QueuedRenderableCollection&) = delete;
+
+    /// Change the order, forgets the order of the previous sort
+    void set_organisation_mode(OrganisationMode mode);
+
+    OrganisationMode get_organisation_mode() const
+    {
+        return mode_;
+    }
+
+    /** Reuse the order of the previous sort, for queues whose order is stable
+        from frame to frame. Needs dense renderable ids, see RenderablePass.
+    */
+    void set_coherent(bool coherent)
+    {
+        coherent_ = coherent;
+    }
+
+    bool is_coherent() const
+    {
+        return coherent_;
+    }
+
+    /// Empty the collection, keeping its memory and the order of the previous sort
+    void clear();
+
+    void add_renderable(uint32_t pass, uint32_t renderable, float depth)
+    {
+        queued_.push_back({renderable, pass, depth});
+    }
+
+    /** Add a list of renderables with the same pass, e.g. the visible list of
+        a CullingStage.
+    @param renderables The renderables to add
+    @param pass The pass of all of them
+    @param depths View depth of every renderable, indexed by renderable
+    */
+    void add_renderables(const std::vector<uint32_t>& renderables, uint32_t pass, const float* depths);
+
+    size_t size() const
+    {
+        return queued_.size();
+    }
+
+    /** Sort the renderables added since the last clear().
+    @param executor Where to run the passes of a large radix sort, ThreadPool::get_worker_pool() if null
+    */
+    void sort(Executor* executor = nullptr);
+
+    /// The renderables in the order of the last sort()
+    const std::vector<RenderablePass>& get_sorted() const
+    {
+        return sorted_;
+    }
+
+    const SortStats& get_sort_stats() const
+    {
+        return stats_;
+    }
+
+private:
+    /// A sort key and the order of addition, which breaks ties
+    struct SortItem {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    uint64_t get_sort_key(const RenderablePass& rp) const;
+    /// Sort items_ by reusing the previous order, false when the fix up had too much to do
+    bool sort_coherent();
+    void radix_sort(Executor* executor);
+    /// Remember the rank of every renderable for the next coherent sort
+    void store_ranks();
+
+    OrganisationMode mode_ = OM_PASS_GROUP;
+    bool coherent_ = false;
+    std::vector<RenderablePass> queued_;
+    std::vector<RenderablePass> sorted_;
+    SortStats stats_;
+
+    /// Keys being sorted and the scratch buffer of the radix passes
+    std::vector<SortItem> items_;
+    std::vector<SortItem> scratch_;
+    /// Digit counts of every block of a radix pass
+    std::vector<size_t> counts_;
+
+    /// First rank of a renderable in the previous sort, valid when stamp is sort_count_
+    struct RankEntry {
+        uint32_t rank;
+        uint32_t stamp;
+    };
+    std::vector<RankEntry> ranks_;
+    /// Rank of the next occurrence of the renderable at every rank of the previous sort
+    std::vector<uint32_t> next_ranks_;
+    /// Previous rank of every item being sorted
+    std::vector<uint32_t> item_ranks_;
+    /// Previous ranks still in use, and how many are before each word of them
+    std::vector<uint64_t> rank_bits_;
+    std::vector<uint32_t> rank_offsets_;
+    uint32_t sort_count_ = 0;
+    size_t ranked_count_ = 0;
+};
+
+} // namespace hyue
@@ -3,6 +3,7 @@
 #include <hyue/Singleton.h>
 #include <hyue/ArchiveFactory.h>
 #include <hyue/ArchiveManager.h>
+#include <hyue/PluginManager.h>
 
 namespace hyue {
 
@@ -14,6 +15,7 @@ public:
 private:
     std::vector<std::unique_ptr<ArchiveFactory>> archive_factories_;
     std::unique_ptr<ArchiveManager>              archive_manager_;
+    std::unique_ptr<PluginManager>               plugin_manager_;
 };
 
 } // namespace hyue
\ No newline at end of file
@@ -9,7 +9,7 @@
 namespace hyue {
 
 template<class T> 
-class Singleton: private boost::noncopyable {
+class HYUE_API Singleton: private boost::noncopyable {
 public:
     Singleton()
     {
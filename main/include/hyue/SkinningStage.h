@@ -0,0 +1,128 @@
+#pragma once
+
+#include <hyue/math.h>
+
+#include <vector>
+
+namespace hyue {
+
+class Executor;
+
+/** Vertex buffers of a mesh skinned in software, the arguments of Ogre's
+    OptimisedUtil::softwareVertexSkinning. Strides are in bytes.
+*/
+struct SkinnedVertexData {
+    const float* src_position = nullptr;
+    float* dst_position = nullptr;
+    size_t src_position_stride = 0;
+    size_t dst_position_stride = 0;
+
+    /// Normals are optional, null when the mesh has none
+    const float* src_normal = nullptr;
+    float* dst_normal = nullptr;
+    size_t src_normal_stride = 0;
+    size_t dst_normal_stride = 0;
+
+    /// weights_per_vertex weights and indices per vertex, weights summing to one
+    const float* blend_weights = nullptr;
+    const uint8_t* blend_indices = nullptr;
+    size_t blend_weight_stride = 0;
+    size_t blend_index_stride = 0;
+    size_t weights_per_vertex = 0;
+
+    /** Blend matrices indexed by the blend indices, already remapped from
+        bones the way Ogre's Mesh::softwareVertexBlend does. Only the indices
+        of non zero weights are read.
+    */
+    const mat3x4* blend_matrices = nullptr;
+
+    size_t vertex_count = 0;
+};
+
+/** Vertex buffers of a mesh morphed in software, the arguments of Ogre's
+    OptimisedUtil::softwareVertexMorph. Strides are in bytes, normals follow
+    the positions in the same buffers.
+*/
+struct MorphVertexData {
+    /// Parametric distance from the first to the second key
+    float t = 0;
+    const float* src_position1 = nullptr;
+    const float* src_position2 = nullptr;
+    float* dst_position = nullptr;
+    size_t src_stride1 = 0;
+    size_t src_stride2 = 0;
+    size_t dst_stride = 0;
+    bool morph_normals = false;
+
+    size_t vertex_count = 0;
+};
+
+/** Software skinning and morphing of all the animated meshes of a frame.
+
+    Meshes are queued with add_skinning() and add_morph() and run() splits
+    their vertices into ranges of bounded size, grouped into jobs run on an
+    Executor so several small meshes share a job. Skinning blends the matrices of a vertex
+    and transforms it once, a matrix row per SSE2 register, or the rows of
+    two vertices per AVX2 register with FMA; morphing is a plain loop. The
+    vertex and time counters of every run() are kept for profiling.
+*/
+class HYUE_API SkinningStage {
+public:
+    /// Counters of the last run()
+    struct FrameStats {
+        size_t skinned_vertices = 0;
+        size_t morphed_vertices = 0;
+        size_t meshes = 0;
+        /// Jobs the vertex ranges were grouped into, run on the Executor when there are several
+        size_t jobs = 0;
+        double milliseconds = 0;
+    };
+
+    SkinningStage();
+    ~SkinningStage();
+
+    SkinningStage(const SkinningStage&) = delete;
+    SkinningStage& operator=(const SkinningStage&) = delete;
+
+    /// Queue a mesh to skin, its buffers must stay valid until run() returns
+    void add_skinning(const SkinnedVertexData& data);
+
+    /// Queue a mesh to morph, its buffers must stay valid until run() returns
+    void add_morph(const MorphVertexData& data);
+
+    /// Number of meshes queued
+    size_t size() const
+    {
+        return skinned_.size() + morphed_.size();
+    }
+
+    /** Skin and morph all the queued meshes, then empty the queue.
+    @param executor Where to run the vertex ranges, ThreadPool::get_worker_pool() if null
+    */
+    void run(Executor* executor = nullptr);
+
+    /// Forget the queued meshes
+    void clear();
+
+    const FrameStats& get_frame_stats() const
+    {
+        return stats_;
+    }
+
+private:
+    /// Vertices [begin, end) of a queued mesh, skinned meshes first then morphed ones
+    struct Range {
+        uint32_t mesh;
+        size_t begin;
+        size_t end;
+    };
+
+    std::vector<SkinnedVertexData> skinned_;
+    std::vector<MorphVertexData> morphed_;
+    std::vector<Range> ranges_;
+    /// First range of every job, followed by the end of the last job
+    std::vector<size_t> jobs_;
+    FrameStats stats_;
+};
+
+} // namespace hyue
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <string_view>
+
+#include <hyue/DataStream.h>
+
+/// Default size of the blocks StreamReader reads from its stream
+#define HYUE_STREAM_READER_BLOCK_SIZE (64 * 1024)
+
+namespace hyue {
+
+/** Buffered line and token scanner over a DataStream.
+
+    The stream is read in large blocks, lines and tokens are handed out as
+    string_views into the block, so parsing does not allocate per line. A
+    view stays valid until the next call on the reader. The data is
+    treated as bytes: NUL characters are ordinary content, and lines
+    longer than a block grow the buffer instead of being cut.
+
+    Streams derived from MemoryDataStream are scanned in place without
+    copying. The reader consumes its stream ahead of the data handed out,
+    use tell() for the position of the reader itself.
+*/
+class HYUE_API StreamReader {
+public:
+    /** Constructor
+    @param stream The stream to read, from its current position
+    @param block_size Number of bytes read from the stream at a time
+    @param buffer Storage for the blocks, e.g. to reuse it across many streams; owned by the reader if null
+    */
+    explicit StreamReader(const DataStreamPtr& stream,
+                          size_t block_size = HYUE_STREAM_READER_BLOCK_SIZE,
+                          std::vector<char>* buffer = nullptr);
+
+    StreamReader(const StreamReader&) = delete;
+    StreamReader& operator=(const StreamReader&) = delete;
+
+    /** Read the next line.
+
+        The delimiter is removed from the stream but not included in the
+        line. When delim is "\n", a trailing '\r' is removed as well.
+    @param line Receives the line
+    @param delim The character sequence ending a line, may be longer than one character
+    @return false if the stream ended before any data of a line
+    */
+    bool read_line(std::string_view* line, std::string_view delim = "\n");
+
+    /** Skip the next line.
+    @return The number of bytes skipped, including the delimiter
+    */
+    size_t skip_line(std::string_view delim = "\n");
+
+    /** Read the next token, skipping separators in front of it.
+    @param token Receives the token
+    @param separators Set of characters separating tokens
+    @return false if only separators were left
+    */
+    bool read_token(std::string_view* token, std::string_view separators = " \t\r\n");
+
+    /** Read bytes, e.g. a binary chunk between text lines.
+    @return The number of bytes read
+    */
+    size_t read(void* buf, size_t count);
+
+    /// Number of bytes consumed through the reader
+    size_t tell() const
+    {
+        return consumed_;
+    }
+
+    /// Whether all data of the stream was consumed
+    bool is_eof();
+
+private:
+    /// Make more data available, returns false once the stream ended
+    bool fill();
+
+    /// Take count bytes from the front of the data
+    std::string_view consume(size_t count, size_t skip);
+
+    /// Position of the first separator at or after from, or npos
+    size_t find_separator(size_t from, bool separator) const;
+
+    DataStreamPtr stream_;
+    size_t block_size_;
+    std::vector<char> own_buffer_;
+    std::vector<char>* buffer_;
+
+    /// Scanned data; the buffer, or the memory of a MemoryDataStream
+    const char* data_;
+    /// Unconsumed data is [begin_, end_) of data_
+    size_t begin_;
+    size_t end_;
+    bool in_place_;
+    bool stream_ended_;
+    size_t consumed_;
+
+    /// Separators of the last read_token call, and their lookup table
+    String separators_;
+    bool separator_table_[256];
+};
+
+} // namespace hyue
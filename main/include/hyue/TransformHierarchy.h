@@ -0,0 +1,149 @@
+#pragma once
+
+#include <hyue/math.h>
+
+namespace hyue {
+
+class Executor;
+
+/** Position, orientation and scale of a tree of nodes, stored data oriented.
+
+    Every component of the local and derived (world space) transforms lives
+    in its own array, with the nodes sorted by depth so that a level of the
+    tree is a contiguous range and its parents all sit in the levels before.
+    update() then recomputes the derived transforms and world matrices level
+    by level, each level in SIMD batches split across worker threads, instead
+    of recursing through the tree one node at a time.
+@par
+    Nodes are referred to by handles which stay valid until destroyed. Changing
+    the shape of the tree (create, destroy, set_parent) only marks the layout
+    dirty, the arrays are re-sorted by the next update(). Derived transforms
+    read before update() are computed on demand by walking up the parents.
+*/
+class HYUE_API TransformHierarchy {
+public:
+    using Handle = uint32_t;
+
+    /// No node, the parent of root nodes
+    static constexpr Handle NONE = ~Handle(0);
+
+    /// Components of a transform, one array each
+    enum Component {
+        POS_X,
+        POS_Y,
+        POS_Z,
+        ROT_W,
+        ROT_X,
+        ROT_Y,
+        ROT_Z,
+        SCALE_X,
+        SCALE_Y,
+        SCALE_Z,
+        COMPONENT_COUNT,
+    };
+
+    TransformHierarchy();
+    ~TransformHierarchy();
+
+    TransformHierarchy(const TransformHierarchy&) = delete;
+    TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+    /// Create a node with an identity transform, inheriting orientation and scale
+    Handle create(Handle parent = NONE);
+
+    /// Destroy a node, its children become root nodes
+    void destroy(Handle node);
+
+    /// Attach a node to a new parent, or make it a root node with NONE
+    void set_parent(Handle node, Handle parent);
+
+    /// The parent of a node, NONE for root nodes
+    Handle get_parent(Handle node) const;
+
+    /// Number of live nodes
+    size_t size() const
+    {
+        return count_;
+    }
+
+    /// Number of depth levels of the tree, as of the last update()
+    size_t get_depth() const
+    {
+        return levels_.size() - 2;
+    }
+
+    void set_position(Handle node, const vec3& position);
+    vec3 get_position(Handle node) const;
+
+    void set_orientation(Handle node, const quat& orientation);
+    quat get_orientation(Handle node) const;
+
+    void set_scale(Handle node, const vec3& scale);
+    vec3 get_scale(Handle node) const;
+
+    /// Whether the node is rotated by the orientation of its parent
+    void set_inherit_orientation(Handle node, bool inherit);
+    bool get_inherit_orientation(Handle node) const;
+
+    /// Whether the node is scaled by the scale of its parent
+    void set_inherit_scale(Handle node, bool inherit);
+    bool get_inherit_scale(Handle node) const;
+
+    /// Position in world space, combined with all the parents
+    vec3 get_derived_position(Handle node) const;
+    /// Orientation in world space, combined with all the parents
+    quat get_derived_orientation(Handle node) const;
+    /// Scale in world space, combined with all the parents
+    vec3 get_derived_scale(Handle node) const;
+    /// Matrix from the local space of the node to world space
+    mat4 get_world_matrix(Handle node) const;
+
+    /** Recompute the derived transforms and world matrices of all the nodes.
+    @param executor Where to run the batches of a level, ThreadPool::get_worker_pool() if null
+    */
+    void update(Executor* executor = nullptr);
+
+    /// Whether transforms changed since the last update()
+    bool is_dirty() const
+    {
+        return dirty_;
+    }
+
+private:
+    /// Decomposed transform of a single node
+    struct Transform {
+        float c[COMPONENT_COUNT];
+    };
+
+    uint32_t get_slot(Handle node) const;
+    uint32_t get_parent_slot(uint32_t slot) const;
+    Transform get_local(uint32_t slot) const;
+    /// Derived transform of a slot, computed from its ancestors while the hierarchy is dirty
+    Transform get_derived(uint32_t slot) const;
+    void set_flag(Handle node, uint8_t flag, bool value);
+
+    /// Sort the slots by depth and drop the destroyed ones
+    void rebuild_layout();
+
+    /// Transform components of every slot
+    std::vector<float> local_[COMPONENT_COUNT];
+    std::vector<float> derived_[COMPONENT_COUNT];
+    /// Rows of the 3x4 world matrix of every slot, row major
+    std::vector<float> world_[12];
+    /// Parent slot of every slot, slot 0 is an identity root above the root nodes
+    std::vector<int32_t> parent_;
+    /// Inherit flags of every slot
+    std::vector<uint8_t> flags_;
+    /// Handle of every slot, NONE for destroyed nodes and slot 0
+    std::vector<Handle> handles_;
+    /// Slot of every handle
+    std::vector<uint32_t> slots_;
+    std::vector<Handle> free_handles_;
+    /// First slot of every level, followed by the end of the last level
+    std::vector<size_t> levels_;
+    size_t count_ = 0;
+    bool dirty_ = false;
+    bool layout_dirty_ = false;
+};
+
+} // namespace hyue
@@ -11,6 +11,16 @@ public:
     using ArchiveFactory::create_instance;
 
     Archive* create_instance(const String& name, bool read_only) override;
+
+    /// Set the uncompressed entry size, in bytes, from which opened entries are
+    /// inflated on demand while being read instead of into a MemoryDataStream.
+    /// Pass std::numeric_limits<size_t>::max() to always inflate whole entries.
+    /// Entries stored without compression are always opened as a DataStreamView
+    /// of the archive data.
+    static void set_stream_threshold(size_t threshold);
+
+    /// Get the uncompressed entry size from which entries are streamed.
+    static size_t get_stream_threshold();
 };
 
 class HYUE_API EmbeddedZipArchiveFactory : public ZipArchiveFactory {
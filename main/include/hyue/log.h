@@ -2,6 +2,41 @@
 
 #include <hyue/type.h>
 
+#include <atomic>
+
 #include <boost/log/trivial.hpp>
 
-#define LOG(...) BOOST_LOG_TRIVIAL(__VA_ARGS__)
\ No newline at end of file
+namespace hyue {
+
+using LogLevel = boost::log::trivial::severity_level;
+
+namespace detail {
+/// Lowest severity that is logged, see set_log_level
+HYUE_API extern std::atomic<int> g_log_level;
+} // namespace detail
+
+/// Whether messages of a severity pass the runtime filter
+inline bool is_log_enabled(LogLevel level)
+{
+    return int(level) >= detail::g_log_level.load(std::memory_order_relaxed);
+}
+
+/** Set the lowest severity that is logged.
+
+    LOG checks it before the message is formatted, so disabled messages
+    cost a single relaxed load.
+*/
+HYUE_API void set_log_level(LogLevel level);
+
+/// The lowest severity that is logged
+HYUE_API LogLevel get_log_level();
+
+/// Block until every message logged so far was written out
+HYUE_API void flush_log();
+
+} // namespace hyue
+
+#define LOG(severity)                                                           \
+    if (!hyue::is_log_enabled(boost::log::trivial::severity_level::severity)) { \
+    } else                                                                      \
+        BOOST_LOG_TRIVIAL(severity)
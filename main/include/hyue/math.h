@@ -6,6 +6,9 @@
 #include <boost/qvm/vec.hpp>
 #include <boost/qvm/mat_operations.hpp>
 #include <boost/qvm/vec_operations.hpp>
+#include <boost/qvm/quat.hpp>
+#include <boost/qvm/quat_operations.hpp>
+#include <boost/qvm/quat_vec_operations.hpp>
 
 namespace hyue::math {
 
@@ -27,6 +30,11 @@ namespace hyue {
 
 using vec3 = boost::qvm::vec<float, 3>;
 using ivec3 = boost::qvm::vec<int, 3>;
+/// Quaternion, a[0] is the scalar (w) part and a[1..3] the vector (x, y, z) part
+using quat = boost::qvm::quat<float>;
+using mat4 = boost::qvm::mat<float, 4, 4>;
+/// Affine transform, the upper 3 rows of a mat4, like Ogre's Affine3
+using mat3x4 = boost::qvm::mat<float, 3, 4>;
 
 using boost::qvm::operator==;
 }
\ No newline at end of file
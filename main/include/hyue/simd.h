@@ -0,0 +1,51 @@
+#pragma once
+
+#include <hyue/type.h>
+
+namespace hyue {
+
+/** Instruction sets the vectorised code paths of the library can use.
+
+    The levels are ordered, a CPU supporting one level supports all lower ones.
+    The AVX2 level also requires FMA.
+    On ARM the SSE2 kernels are built on NEON through SSE2NEON.h.
+*/
+enum class SimdLevel {
+    NONE,
+    SSE2,
+    AVX2,
+};
+
+/// Highest instruction set supported by both the build and the running CPU, capped by set_max_simd_level
+HYUE_API SimdLevel get_simd_level();
+
+/** Cap the instruction set used by the vectorised code paths.
+
+    Mostly useful to compare the paths against each other, e.g. in tests and
+    benchmarks; SimdLevel::NONE forces the scalar code.
+*/
+HYUE_API void set_max_simd_level(SimdLevel level);
+
+/** Kernel of the highest instruction set get_simd_level() allows.
+
+    A null kernel is not built in, the next lower one is used instead.
+*/
+template <class F>
+F select_simd(F avx2, F sse2, F scalar)
+{
+    switch (get_simd_level()) {
+        case SimdLevel::AVX2:
+            if (avx2)
+                return avx2;
+            [[fallthrough]];
+        case SimdLevel::SSE2:
+            if (sse2)
+                return sse2;
+            [[fallthrough]];
+        case SimdLevel::NONE:
+            break;
+    }
+    return scalar;
+}
+
+} // namespace hyue
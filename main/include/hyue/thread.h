@@ -1,6 +1,108 @@
-// #pragma once
+#pragma once
 
-// #include <memory>
-// #include <thread>
-// #include <mutex>
-// #include <condition_variable>
+#include <hyue/type.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace hyue {
+
+/** Interface for running a batch of independent jobs, possibly in parallel.
+
+    Parallel algorithms of the library take an Executor so applications can
+    plug in their own job system; ThreadPool is the default implementation.
+*/
+class HYUE_API Executor {
+public:
+    virtual ~Executor() { }
+
+    /// Number of jobs that can run at the same time
+    virtual size_t get_concurrency() const = 0;
+
+    /** Run job(0) to job(count - 1) and return once all of them finished.
+
+        Jobs may run in any order and on any thread, including the calling one.
+        If jobs throw, the first exception is rethrown after all jobs finished.
+    */
+    virtual void parallel_for(size_t count, const std::function<void(size_t)>& job) = 0;
+};
+
+/** Fixed size pool of worker threads running queued tasks in FIFO order.
+
+    Tasks are plain callables; submit() hands back a std::future for the
+    result, exceptions thrown by a task are stored in that future. The
+    destructor finishes every task already queued before joining the workers.
+*/
+class HYUE_API ThreadPool : public Executor {
+public:
+    using Task = std::function<void()>;
+
+    /** Constructor
+    @param num_threads Number of workers, 0 means one per hardware thread
+    */
+    explicit ThreadPool(size_t num_threads = 0);
+    ~ThreadPool() override;
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Number of worker threads
+    size_t size() const
+    {
+        return workers_.size();
+    }
+
+    /// Queue a task and get a future for its result
+    template <class F>
+    auto submit(F&& f) -> std::future<decltype(f())>
+    {
+        using Result = decltype(f());
+
+        // std::function needs a copyable callable, packaged_task is move only
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+        std::future<Result> ret = task->get_future();
+        post([task]() { (*task)(); });
+        return ret;
+    }
+
+    /// Queue a task without a result; it must not throw
+    void post(Task task);
+
+    /// Workers plus the calling thread, which takes part in parallel_for
+    size_t get_concurrency() const override
+    {
+        return workers_.size() + 1;
+    }
+
+    /// @copydoc Executor::parallel_for
+    void parallel_for(size_t count, const std::function<void(size_t)>& job) override;
+
+    /** The pool used for asynchronous file I/O, e.g. Archive::open_async.
+
+        Created on first use; file reads mostly wait on the disk, so it is
+        small and independent of the number of cores.
+    */
+    static ThreadPool& get_io_pool();
+
+    /** The pool used for CPU bound work when no Executor is given.
+
+        Created on first use, with one worker less than the hardware threads
+        since the thread calling parallel_for works as well.
+    */
+    static ThreadPool& get_worker_pool();
+
+private:
+    void run();
+
+    std::vector<std::thread> workers_;
+    std::deque<Task> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stop_;
+};
+
+} // namespace hyue
@@ -0,0 +1,98 @@
+#include <hyue/ASTCCodec.h>
+
+#include <string.h>
+
+#include <hyue/panic.h>
+
+namespace hyue {
+
+namespace {
+
+/// Sizes are 24 bit little endian
+struct ASTCHeader {
+    uint8_t magic[4];
+    uint8_t block_dim_x;
+    uint8_t block_dim_y;
+    uint8_t block_dim_z;
+    uint8_t x_size[3];
+    uint8_t y_size[3];
+    uint8_t z_size[3];
+};
+
+static_assert(sizeof(ASTCHeader) == 16, "ASTC header must not be padded");
+
+const uint8_t ASTC_MAGIC[4] = {0x13, 0xAB, 0xA1, 0x5C};
+
+void read_exact(DataStream& stream, void* buf, size_t count)
+{
+    if (stream.read(buf, count) != count)
+        panic("Unexpected end of ASTC file");
+}
+
+inline uint32_t read_u24_le(const uint8_t* p)
+{
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16;
+}
+
+PixelFormat get_format(uint32_t block_width, uint32_t block_height)
+{
+    switch (block_width << 8 | block_height) {
+        case 0x0404:
+            return PixelFormat::ASTC_RGBA_4X4_LDR;
+        case 0x0504:
+            return PixelFormat::ASTC_RGBA_5X4_LDR;
+        case 0x0505:
+            return PixelFormat::ASTC_RGBA_5X5_LDR;
+        case 0x0605:
+            return PixelFormat::ASTC_RGBA_6X5_LDR;
+        case 0x0606:
+            return PixelFormat::ASTC_RGBA_6X6_LDR;
+        case 0x0805:
+            return PixelFormat::ASTC_RGBA_8X5_LDR;
+        case 0x0806:
+            return PixelFormat::ASTC_RGBA_8X6_LDR;
+        case 0x0808:
+            return PixelFormat::ASTC_RGBA_8X8_LDR;
+        case 0x0A05:
+            return PixelFormat::ASTC_RGBA_10X5_LDR;
+        case 0x0A06:
+            return PixelFormat::ASTC_RGBA_10X6_LDR;
+        case 0x0A08:
+            return PixelFormat::ASTC_RGBA_10X8_LDR;
+        case 0x0A0A:
+            return PixelFormat::ASTC_RGBA_10X10_LDR;
+        case 0x0C0A:
+            return PixelFormat::ASTC_RGBA_12X10_LDR;
+        case 0x0C0C:
+            return PixelFormat::ASTC_RGBA_12X12_LDR;
+        default:
+            panic("Unsupported block footprint in ASTC file");
+    }
+    return PixelFormat::UNKNOWN;
+}
+
+} // namespace
+
+bool ASTCCodec::is_astc(const void* data, size_t size)
+{
+    return size >= sizeof(ASTC_MAGIC) && memcmp(data, ASTC_MAGIC, sizeof(ASTC_MAGIC)) == 0;
+}
+
+void ASTCCodec::decode(const DataStreamPtr& stream, Image* image, bool decompress, Executor* executor)
+{
+    ASTCHeader header;
+    read_exact(*stream, &header, sizeof(header));
+    if (!is_astc(header.magic, sizeof(header.magic)))
+        panic("This is not an ASTC file!");
+    if (header.block_dim_z != 1 || read_u24_le(header.z_size) > 1)
+        panic("3D ASTC textures are not supported");
+
+    PixelFormat format = get_format(header.block_dim_x, header.block_dim_y);
+    image->create(format, read_u24_le(header.x_size), read_u24_le(header.y_size));
+    read_exact(*stream, image->get_data(), image->get_size());
+
+    if (decompress)
+        image->decompress(executor);
+}
+
+} // namespace hyue
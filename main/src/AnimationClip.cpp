@@ -0,0 +1,403 @@
+#include <hyue/AnimationClip.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <hyue/panic.h>
+#include <hyue/simd.h>
+
+#include "animation_sample_simd.h"
+
+namespace hyue {
+
+namespace {
+
+using C = TransformHierarchy;
+
+/// Rotation components are stored times this
+constexpr float ROTATION_SCALE = 32767;
+
+/// Largest quantized translation or scale
+constexpr float RANGE_STEPS = 65535;
+
+/// Bring a time past the length back into the animation, as Ogre's TimeIndex
+float wrap_time(float time, float length)
+{
+    if (length > 0 && time > length)
+        time -= length * std::ceil(time / length - 1);
+    return time;
+}
+
+/** Keys around a time and the position between them, as Ogre's
+    AnimationTrack::getKeyFramesAtTime: the first key at or after the time,
+    or the last key, and the one before unless the time is on it.
+*/
+template <class GetTime>
+float find_keys(size_t count, float time, GetTime get_time, size_t* key1, size_t* key2)
+{
+    size_t lo = 0, hi = count - 1;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (get_time(mid) < time)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *key2 = lo;
+    *key1 = (lo > 0 && time < get_time(lo)) ? lo - 1 : lo;
+    float t1 = get_time(*key1), t2 = get_time(*key2);
+    return t1 == t2 ? 0.0f : (time - t1) / (t2 - t1);
+}
+
+float dot(const quat& a, const quat& b)
+{
+    return a.a[0] * b.a[0] + a.a[1] * b.a[1] + a.a[2] * b.a[2] + a.a[3] * b.a[3];
+}
+
+vec3 lerp(const vec3& a, const vec3& b, float t)
+{
+    return {a.a[0] + (b.a[0] - a.a[0]) * t, a.a[1] + (b.a[1] - a.a[1]) * t, a.a[2] + (b.a[2] - a.a[2]) * t};
+}
+
+/// Ogre's Quaternion::nlerp with the shortest path
+quat nlerp(const quat& a, const quat& b, float t)
+{
+    float sign = dot(a, b) < 0 ? -1.0f : 1.0f;
+    quat ret;
+    float length = 0;
+    for (int c = 0; c < 4; ++c) {
+        ret.a[c] = a.a[c] + (sign * b.a[c] - a.a[c]) * t;
+        length += ret.a[c] * ret.a[c];
+    }
+    length = std::sqrt(length);
+    for (int c = 0; c < 4; ++c)
+        ret.a[c] /= length;
+    return ret;
+}
+
+TransformKey interpolate(const TransformKey& a, const TransformKey& b, float t)
+{
+    TransformKey ret;
+    ret.translate = lerp(a.translate, b.translate, t);
+    ret.rotation = nlerp(a.rotation, b.rotation, t);
+    ret.scale = lerp(a.scale, b.scale, t);
+    return ret;
+}
+
+float get_distance(const vec3& a, const vec3& b)
+{
+    vec3 d = {a.a[0] - b.a[0], a.a[1] - b.a[1], a.a[2] - b.a[2]};
+    return std::sqrt(d.a[0] * d.a[0] + d.a[1] * d.a[1] + d.a[2] * d.a[2]);
+}
+
+/// Angle of the rotation between two unit quaternions
+float get_angle(const quat& a, const quat& b)
+{
+    return 2 * std::acos(std::min(1.0f, std::abs(dot(a, b))));
+}
+
+float get_max_difference(const vec3& a, const vec3& b)
+{
+    return std::max({std::abs(a.a[0] - b.a[0]), std::abs(a.a[1] - b.a[1]), std::abs(a.a[2] - b.a[2])});
+}
+
+/// Largest translation, rotation and scale errors
+struct Errors {
+    float translation = 0;
+    float rotation = 0;
+    float scale = 0;
+
+    void add(const TransformKey& a, const TransformKey& b)
+    {
+        translation = std::max(translation, get_distance(a.translate, b.translate));
+        rotation = std::max(rotation, get_angle(a.rotation, b.rotation));
+        scale = std::max(scale, get_max_difference(a.scale, b.scale));
+    }
+};
+
+/** Frames to keep so that interpolating between kept frames reproduces
+    every dropped frame within the tolerances, greedily extending each span
+    as far as it goes.
+*/
+std::vector<size_t> reduce_frames(const std::vector<float>& times,
+                                  const std::vector<std::vector<TransformKey>>& poses,
+                                  const AnimationBakeOptions& options)
+{
+    auto reproduces = [&](size_t a, size_t c) {
+        for (size_t j = a + 1; j < c; ++j) {
+            float t = (times[j] - times[a]) / (times[c] - times[a]);
+            for (size_t bone = 0; bone < poses[j].size(); ++bone) {
+                Errors errors;
+                errors.add(interpolate(poses[a][bone], poses[c][bone], t), poses[j][bone]);
+                if (errors.translation > options.translation_tolerance ||
+                    errors.rotation > options.rotation_tolerance || errors.scale > options.scale_tolerance)
+                    return false;
+            }
+        }
+        return true;
+    };
+
+    std::vector<size_t> kept = {0};
+    for (size_t c = 2; c < times.size(); ++c) {
+        if (!reproduces(kept.back(), c))
+            kept.push_back(c - 1);
+    }
+    if (times.size() > 1)
+        kept.push_back(times.size() - 1);
+    return kept;
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------
+TransformKey SkeletonAnimation::sample(size_t bone, float time) const
+{
+    const std::vector<TransformKey>& keys = tracks[bone];
+    if (keys.empty())
+        return TransformKey();
+
+    size_t key1, key2;
+    float t = find_keys(
+        keys.size(), wrap_time(time, length), [&](size_t i) { return keys[i].time; }, &key1, &key2);
+    TransformKey ret = interpolate(keys[key1], keys[key2], t);
+    ret.time = time;
+    return ret;
+}
+
+//-----------------------------------------------------------------------
+void sample_clip_scalar(const ClipSampleBatch& batch, size_t begin, size_t end)
+{
+    const float alpha = batch.alpha;
+    const size_t stride = batch.stride;
+    for (size_t b = begin; b < end; ++b) {
+        // the scale of the quantized rotation goes away with the normalisation
+        float q[4], length = 0;
+        for (int c = 0; c < 4; ++c) {
+            float q1 = batch.rotation[0][c * stride + b], q2 = batch.rotation[1][c * stride + b];
+            q[c] = q1 + (q2 - q1) * alpha;
+            length += q[c] * q[c];
+        }
+        length = std::sqrt(length);
+        for (int c = 0; c < 4; ++c)
+            batch.components[C::ROT_W + c][b] = q[c] / length;
+
+        for (int c = 0; c < 3; ++c) {
+            size_t i = c * stride + b;
+            float t1 = batch.translation[0][i], t2 = batch.translation[1][i];
+            batch.components[C::POS_X + c][b] = batch.translation_min[i] + batch.translation_step[i] * (t1 + (t2 - t1) * alpha);
+            if (batch.scale[0]) {
+                float s1 = batch.scale[0][i], s2 = batch.scale[1][i];
+                batch.components[C::SCALE_X + c][b] = batch.scale_min[i] + batch.scale_step[i] * (s1 + (s2 - s1) * alpha);
+            } else {
+                batch.components[C::SCALE_X + c][b] = 1;
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+AnimationClip::AnimationClip()
+{
+}
+
+AnimationClip::~AnimationClip()
+{
+}
+
+//-----------------------------------------------------------------------
+void AnimationClip::bake(const SkeletonAnimation& animation, const AnimationBakeOptions& options)
+{
+    HYUE_ASSERT(options.sample_rate > 0, "animation sample rate must be positive");
+    bone_count_ = animation.tracks.size();
+    stride_ = (bone_count_ + 7) & ~size_t(7);
+    length_ = std::max(animation.length, 0.0f);
+
+    // uniform frames, the last one at the end, and the source keys for the reduction
+    std::vector<float> times;
+    size_t uniform = size_t(std::ceil(length_ * options.sample_rate));
+    for (size_t f = 0; f < uniform; ++f)
+        times.push_back(float(f) / options.sample_rate);
+    times.push_back(length_);
+    if (options.reduce_frames) {
+        for (auto& track : animation.tracks) {
+            for (auto& key : track) {
+                if (key.time > 0 && key.time < length_)
+                    times.push_back(key.time);
+            }
+        }
+        std::sort(times.begin(), times.end());
+        times.erase(std::unique(times.begin(), times.end()), times.end());
+    }
+
+    std::vector<std::vector<TransformKey>> poses(times.size(), std::vector<TransformKey>(bone_count_));
+    for (size_t f = 0; f < times.size(); ++f) {
+        for (size_t bone = 0; bone < bone_count_; ++bone)
+            poses[f][bone] = animation.sample(bone, times[f]);
+    }
+
+    std::vector<size_t> kept(times.size());
+    for (size_t f = 0; f < kept.size(); ++f)
+        kept[f] = f;
+    if (options.reduce_frames)
+        kept = reduce_frames(times, poses, options);
+
+    // range of every translation and scale component over the kept frames
+    translation_min_.assign(3 * stride_, 0);
+    translation_step_.assign(3 * stride_, 0);
+    scale_min_.assign(3 * stride_, 0);
+    scale_step_.assign(3 * stride_, 0);
+    has_scale_ = false;
+    for (size_t bone = 0; bone < bone_count_; ++bone) {
+        for (int c = 0; c < 3; ++c) {
+            float t_min = poses[kept[0]][bone].translate.a[c], t_max = t_min;
+            float s_min = poses[kept[0]][bone].scale.a[c], s_max = s_min;
+            for (size_t f : kept) {
+                const TransformKey& key = poses[f][bone];
+                t_min = std::min(t_min, key.translate.a[c]);
+                t_max = std::max(t_max, key.translate.a[c]);
+                s_min = std::min(s_min, key.scale.a[c]);
+                s_max = std::max(s_max, key.scale.a[c]);
+            }
+            size_t i = c * stride_ + bone;
+            translation_min_[i] = t_min;
+            translation_step_[i] = (t_max - t_min) / RANGE_STEPS;
+            scale_min_[i] = s_min;
+            scale_step_[i] = (s_max - s_min) / RANGE_STEPS;
+            has_scale_ = has_scale_ || s_min != 1 || s_max != 1;
+        }
+    }
+
+    if (!has_scale_) {
+        // unit scales are implied, the ranges are not kept either
+        std::vector<float>().swap(scale_min_);
+        std::vector<float>().swap(scale_step_);
+    }
+
+    times_.resize(kept.size());
+    rotations_.assign(kept.size() * 4 * stride_, 0);
+    translations_.assign(kept.size() * 3 * stride_, 0);
+    scales_.assign(has_scale_ ? kept.size() * 3 * stride_ : 0, 0);
+    std::vector<quat> previous(bone_count_, quat{1, 0, 0, 0});
+    for (size_t k = 0; k < kept.size(); ++k) {
+        times_[k] = times[kept[k]];
+        quantize_frame(k, poses[kept[k]], &previous);
+    }
+}
+
+//-----------------------------------------------------------------------
+void AnimationClip::quantize_frame(size_t frame, const std::vector<TransformKey>& pose, std::vector<quat>* previous)
+{
+    auto quantize = [](float value, float min, float step) {
+        return step > 0 ? uint16_t(std::min(RANGE_STEPS, std::round((value - min) / step))) : uint16_t(0);
+    };
+
+    int16_t* rotation = &rotations_[frame * 4 * stride_];
+    uint16_t* translation = &translations_[frame * 3 * stride_];
+    uint16_t* scale = has_scale_ ? &scales_[frame * 3 * stride_] : nullptr;
+    for (size_t bone = 0; bone < bone_count_; ++bone) {
+        // same hemisphere as the previous frame, so interpolating takes the shortest path
+        quat q = pose[bone].rotation;
+        if (dot(q, (*previous)[bone]) < 0) {
+            for (int c = 0; c < 4; ++c)
+                q.a[c] = -q.a[c];
+        }
+        (*previous)[bone] = q;
+        for (int c = 0; c < 4; ++c)
+            rotation[c * stride_ + bone] = int16_t(std::round(q.a[c] * ROTATION_SCALE));
+
+        for (int c = 0; c < 3; ++c) {
+            size_t i = c * stride_ + bone;
+            translation[i] = quantize(pose[bone].translate.a[c], translation_min_[i], translation_step_[i]);
+            if (scale)
+                scale[i] = quantize(pose[bone].scale.a[c], scale_min_[i], scale_step_[i]);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+size_t AnimationClip::get_memory_size() const
+{
+    return times_.size() * sizeof(float) + rotations_.size() * sizeof(int16_t) +
+           (translations_.size() + scales_.size()) * sizeof(uint16_t) +
+           (translation_min_.size() + translation_step_.size() + scale_min_.size() + scale_step_.size()) * sizeof(float);
+}
+
+//-----------------------------------------------------------------------
+void AnimationClip::sample(float time, float* const* components) const
+{
+    if (times_.empty())
+        return;
+
+    size_t frame1, frame2;
+    ClipSampleBatch batch;
+    batch.alpha = find_keys(
+        times_.size(), wrap_time(time, length_), [&](size_t i) { return times_[i]; }, &frame1, &frame2);
+    batch.rotation[0] = &rotations_[frame1 * 4 * stride_];
+    batch.rotation[1] = &rotations_[frame2 * 4 * stride_];
+    batch.translation[0] = &translations_[frame1 * 3 * stride_];
+    batch.translation[1] = &translations_[frame2 * 3 * stride_];
+    batch.scale[0] = has_scale_ ? &scales_[frame1 * 3 * stride_] : nullptr;
+    batch.scale[1] = has_scale_ ? &scales_[frame2 * 3 * stride_] : nullptr;
+    batch.translation_min = translation_min_.data();
+    batch.translation_step = translation_step_.data();
+    batch.scale_min = scale_min_.data();
+    batch.scale_step = scale_step_.data();
+    batch.stride = stride_;
+    batch.components = components;
+    ClipSampler sample = select_simd(HYUE_AVX2_KERNEL(avx2_sample_clip),
+                                     HYUE_SSE2_KERNEL(sse2_sample_clip),
+                                     sample_clip_scalar);
+    sample(batch, 0, bone_count_);
+}
+
+//-----------------------------------------------------------------------
+AnimationCompressionReport AnimationClip::get_report(const SkeletonAnimation& animation) const
+{
+    HYUE_ASSERT(animation.tracks.size() == bone_count_, "the animation does not have the bones of the clip");
+
+    AnimationCompressionReport report;
+    for (auto& track : animation.tracks)
+        report.source_keys += track.size();
+    report.source_bytes = report.source_keys * (sizeof(TransformKey) + sizeof(void*));
+    report.clip_frames = times_.size();
+    report.clip_bytes = get_memory_size();
+    report.ratio = report.clip_bytes ? double(report.source_bytes) / double(report.clip_bytes) : 0;
+
+    // at the source keys, the frames and half way between frames
+    std::vector<float> times = times_;
+    for (size_t k = 0; k + 1 < times_.size(); ++k)
+        times.push_back((times_[k] + times_[k + 1]) / 2);
+    for (auto& track : animation.tracks) {
+        for (auto& key : track) {
+            if (key.time >= 0 && key.time <= length_)
+                times.push_back(key.time);
+        }
+    }
+
+    std::vector<float> components[C::COMPONENT_COUNT];
+    float* outputs[C::COMPONENT_COUNT];
+    for (int c = 0; c < C::COMPONENT_COUNT; ++c) {
+        components[c].resize(bone_count_);
+        outputs[c] = components[c].data();
+    }
+    Errors errors;
+    for (float time : times) {
+        sample(time, outputs);
+        for (size_t bone = 0; bone < bone_count_; ++bone) {
+            TransformKey key;
+            for (int c = 0; c < 3; ++c) {
+                key.translate.a[c] = components[C::POS_X + c][bone];
+                key.scale.a[c] = components[C::SCALE_X + c][bone];
+            }
+            for (int c = 0; c < 4; ++c)
+                key.rotation.a[c] = components[C::ROT_W + c][bone];
+            errors.add(key, animation.sample(bone, time));
+        }
+    }
+    report.max_translation_error = errors.translation;
+    report.max_rotation_error = errors.rotation;
+    report.max_scale_error = errors.scale;
+    return report;
+}
+
+} // namespace hyue
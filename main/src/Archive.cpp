@@ -1,6 +1,7 @@
 #include <hyue/Archive.h>
 
 #include <hyue/panic.h>
+#include <hyue/thread.h>
 
 namespace hyue {
 
@@ -29,4 +30,33 @@ void Archive::remove(const String&)
     panic("This archive does not support removal of files. Archive::remove");
 }
 
+//---------------------------------------------------------------------
+MemoryDataStreamFuture Archive::open_async(const String& filename) const
+{
+    return ThreadPool::get_io_pool().submit([this, filename]() -> MemoryDataStreamPtr {
+        DataStreamPtr stream = open(filename);
+        if (!stream)
+            return nullptr;
+
+        // already read into memory; mapped files and views, which may be of a
+        // mapped file, still have to be paged in
+        auto memory_stream = std::dynamic_pointer_cast<MemoryDataStream>(stream);
+        if (memory_stream && !std::dynamic_pointer_cast<MappedFileDataStream>(stream)
+            && !std::dynamic_pointer_cast<DataStreamView>(stream))
+            return memory_stream;
+
+        return std::make_shared<MemoryDataStream>(filename, stream.get());
+    });
+}
+
+//---------------------------------------------------------------------
+std::vector<MemoryDataStreamFuture> Archive::open_batch_async(const StringVector& filenames) const
+{
+    std::vector<MemoryDataStreamFuture> ret;
+    ret.reserve(filenames.size());
+    for (auto& filename : filenames)
+        ret.push_back(open_async(filename));
+    return ret;
+}
+
 } // namespace hyue
\ No newline at end of file
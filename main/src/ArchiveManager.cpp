@@ -1,6 +1,9 @@
 #include <hyue/ArchiveManager.h>
 
+#include <algorithm>
+
 #include <hyue/log.h>
+#include <hyue/StringUtils.h>
 
 namespace hyue {
 
@@ -17,6 +20,7 @@ ArchiveManager::ArchiveManager()
 
 ArchiveFactory* ArchiveManager::get_archive_factory(const String& archive_type)
 {
+    std::lock_guard<std::mutex> lock(factories_mutex_);
     auto it = arch_factories_.find(archive_type);
     if (it == arch_factories_.end()) {
         // Factory not found
@@ -58,6 +62,7 @@ void ArchiveManager::unload(const String& filename)
     ArchiveMap::iterator i = archives_.find(filename);
 
     if (i != archives_.end()) {
+        unmount(i->second);
         i->second->unload();
         // Find factory to destroy. An archive factory created this file, it should still be there!
         auto factory = get_archive_factory(i->second->get_type());
@@ -88,13 +93,149 @@ ArchiveManager::~ArchiveManager()
     }
     // Empty the list
     archives_.clear();
+    mounts_.clear();
+    vfs_table_.clear();
+}
+
+//-----------------------------------------------------------------------
+Archive* ArchiveManager::mount(const String& filename,
+                               const String& archive_type,
+                               const String& mount_point,
+                               int priority)
+{
+    Archive* arch = load(filename, archive_type, true);
+    mount(arch, mount_point, priority);
+    return arch;
+}
+
+//-----------------------------------------------------------------------
+void ArchiveManager::mount(Archive* arch, const String& mount_point, int priority)
+{
+    HYUE_ASSERT(arch, "cannot mount a null archive");
+
+    // after every mount of the same or lower priority, so ties go to the later mount
+    auto it = std::upper_bound(mounts_.begin(), mounts_.end(), priority, [](int p, const Mount& m) {
+        return p < m.priority;
+    });
+    bool on_top = it == mounts_.end();
+    it = mounts_.insert(it, Mount{arch, normalize_vfs_path(mount_point), priority});
+
+    if (on_top) {
+        // nothing can hide the new files, overwrite in place
+        add_mount_files(it - mounts_.begin());
+    } else {
+        refresh_mounts();
+    }
+
+    LOG(info) << "Archive '" << arch->get_name() << "' mounted at '/" << it->mount_point
+              << "' with priority " << priority;
+}
+
+//-----------------------------------------------------------------------
+void ArchiveManager::unmount(Archive* arch)
+{
+    auto it = std::remove_if(mounts_.begin(), mounts_.end(), [arch](const Mount& m) {
+        return m.archive == arch;
+    });
+    if (it == mounts_.end())
+        return;
+
+    mounts_.erase(it, mounts_.end());
+    refresh_mounts();
+}
+
+//-----------------------------------------------------------------------
+void ArchiveManager::refresh_mounts()
+{
+    vfs_table_.clear();
+    for (size_t i = 0; i < mounts_.size(); ++i)
+        add_mount_files(i);
+}
+
+//-----------------------------------------------------------------------
+void ArchiveManager::add_mount_files(size_t mount_index)
+{
+    const Mount& m = mounts_[mount_index];
+
+    // file system archives list names prefixed by the archive location, the
+    // names other archives list are already relative to them
+    String prefix;
+    if (m.archive->get_type() == "FileSystem")
+        prefix = normalize_vfs_path(m.archive->get_name());
+
+    for (auto& name : m.archive->list(true, false)) {
+        String filename = normalize_vfs_path(name);
+        if (!prefix.empty() && filename.size() > prefix.size() && filename[prefix.size()] == '/'
+            && filename.compare(0, prefix.size(), prefix) == 0) {
+            filename.erase(0, prefix.size() + 1);
+        }
+
+        String path = m.mount_point.empty() ? filename : m.mount_point + "/" + filename;
+        vfs_table_[path] = VfsEntry{m.archive, filename};
+    }
+}
+
+//-----------------------------------------------------------------------
+String ArchiveManager::normalize_vfs_path(const String& path)
+{
+    String ret = StringUtils::normalize_file_path(path);
+
+    size_t begin = ret.find_first_not_of('/');
+    if (begin == String::npos)
+        return "";
+    size_t end = ret.find_last_not_of('/');
+    return ret.substr(begin, end - begin + 1);
+}
+
+//-----------------------------------------------------------------------
+Archive* ArchiveManager::find_archive(const String& path) const
+{
+    auto it = vfs_table_.find(normalize_vfs_path(path));
+    return it == vfs_table_.end() ? nullptr : it->second.archive;
+}
+
+//-----------------------------------------------------------------------
+bool ArchiveManager::exists(const String& path) const
+{
+    return find_archive(path) != nullptr;
+}
+
+//-----------------------------------------------------------------------
+DataStreamPtr ArchiveManager::open(const String& path) const
+{
+    auto it = vfs_table_.find(normalize_vfs_path(path));
+    if (it == vfs_table_.end()) {
+        LOG(error) << "File '" << path << "' not found in any mounted archive";
+        return nullptr;
+    }
+
+    return it->second.archive->open(it->second.filename);
 }
 
 //-----------------------------------------------------------------------
 void ArchiveManager::add_archive_factory(ArchiveFactory* factory)
 {
-    arch_factories_.emplace(factory->get_type(), factory);
+    {
+        std::lock_guard<std::mutex> lock(factories_mutex_);
+        arch_factories_.emplace(factory->get_type(), factory);
+    }
     LOG(info) << "ArchiveFactory for type '" << factory->get_type() << "' registered";
 }
+//-----------------------------------------------------------------------
+void ArchiveManager::remove_archive_factory(const String& archive_type)
+{
+    {
+        std::lock_guard<std::mutex> lock(factories_mutex_);
+        if (arch_factories_.erase(archive_type) == 0)
+            return;
+    }
+    LOG(info) << "ArchiveFactory for type '" << archive_type << "' removed";
+}
+//-----------------------------------------------------------------------
+bool ArchiveManager::has_archive_factory(const String& archive_type) const
+{
+    std::lock_guard<std::mutex> lock(factories_mutex_);
+    return arch_factories_.count(archive_type) != 0;
+}
 
 } // namespace hyue
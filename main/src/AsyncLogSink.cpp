@@ -0,0 +1,231 @@
+#include "AsyncLogSink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <boost/log/trivial.hpp>
+#include <boost/log/utility/formatting_ostream.hpp>
+
+namespace hyue {
+
+/// Records a thread can queue before it has to wait for the writer
+#define HYUE_LOG_RING_SIZE 4096
+/// Interval of the writer when nothing asks it to write earlier
+#define HYUE_LOG_WRITE_INTERVAL_MS 10
+
+namespace {
+
+/// Producer index and the writer index are on separate cache lines
+struct alignas(64) AlignedIndex {
+    std::atomic<size_t> value{0};
+};
+
+} // namespace
+
+struct AsyncLogBackend::Ring {
+    struct Entry {
+        boost::log::record_view rec;
+        /// Global order of the record, to merge the rings
+        uint64_t sequence;
+    };
+
+    Entry slots[HYUE_LOG_RING_SIZE];
+    /// Next slot the writer reads
+    AlignedIndex head;
+    /// Next slot the producer writes
+    AlignedIndex tail;
+    /// Set when the thread exited, the writer drops the ring once it is empty
+    std::atomic<bool> retired{false};
+};
+
+namespace {
+
+/// Source of Ring::Entry::sequence
+std::atomic<uint64_t> g_sequence(0);
+
+/// All rings, owned together with the threads they belong to
+std::mutex g_rings_mutex;
+std::vector<std::shared_ptr<AsyncLogBackend::Ring>> g_rings;
+
+/// The ring of the calling thread, registered on first use
+struct ThreadRing {
+    std::shared_ptr<AsyncLogBackend::Ring> ring;
+
+    ThreadRing() : ring(std::make_shared<AsyncLogBackend::Ring>())
+    {
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        g_rings.push_back(ring);
+    }
+
+    ~ThreadRing()
+    {
+        ring->retired = true;
+    }
+};
+
+AsyncLogBackend::Ring& get_thread_ring()
+{
+    thread_local ThreadRing ring;
+    return *ring.ring;
+}
+
+} // namespace
+
+AsyncLogBackend::AsyncLogBackend(const boost::log::formatter& formatter,
+                                 const boost::shared_ptr<boost::log::sinks::text_file_backend>& file,
+                                 std::ostream* console)
+: formatter_(formatter),
+  file_(file),
+  console_(console),
+  stop_(false),
+  wake_requested_(false),
+  flush_requested_(0),
+  flush_done_(0)
+{
+    writer_ = std::thread([this]() { run(); });
+}
+
+AsyncLogBackend::~AsyncLogBackend()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+}
+
+void AsyncLogBackend::consume(const boost::log::record_view& rec)
+{
+    Ring& ring = get_thread_ring();
+    size_t tail = ring.tail.value.load(std::memory_order_relaxed);
+
+    // full: let the writer catch up rather than dropping messages
+    while (tail - ring.head.value.load(std::memory_order_acquire) == HYUE_LOG_RING_SIZE) {
+        wake_requested_ = true;
+        wake_.notify_one();
+        std::this_thread::yield();
+    }
+
+    Ring::Entry& entry = ring.slots[tail % HYUE_LOG_RING_SIZE];
+    entry.rec = rec;
+    entry.sequence = g_sequence.fetch_add(1, std::memory_order_relaxed);
+    ring.tail.value.store(tail + 1, std::memory_order_release);
+
+    auto severity = rec[boost::log::trivial::severity];
+    bool urgent = severity && severity.get() >= boost::log::trivial::error;
+    if (urgent || tail + 1 - ring.head.value.load(std::memory_order_relaxed) >= HYUE_LOG_RING_SIZE / 2) {
+        // notifying without the mutex may be missed, the writer wakes up by itself soon after
+        wake_requested_ = true;
+        wake_.notify_one();
+    }
+
+    // the process may go down right after a fatal message
+    if (severity && severity.get() == boost::log::trivial::fatal)
+        flush();
+}
+
+void AsyncLogBackend::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t request = ++flush_requested_;
+    wake_.notify_one();
+    flushed_.wait(lock, [&]() { return flush_done_ >= request; });
+}
+
+void AsyncLogBackend::run()
+{
+    bool stop = false;
+    while (!stop) {
+        uint64_t requested;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait_for(lock, std::chrono::milliseconds(HYUE_LOG_WRITE_INTERVAL_MS), [this]() {
+                return stop_ || wake_requested_ || flush_requested_ != flush_done_;
+            });
+            wake_requested_ = false;
+            requested = flush_requested_;
+            stop = stop_;
+        }
+
+        drain();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            flush_done_ = requested;
+        }
+        flushed_.notify_all();
+    }
+}
+
+bool AsyncLogBackend::drain()
+{
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        rings = g_rings;
+    }
+
+    batch_.clear();
+    String line;
+    boost::log::formatting_ostream stream(line);
+    bool any = false;
+
+    struct Cursor {
+        Ring* ring;
+        size_t head;
+        size_t tail;
+    };
+    std::vector<Cursor> cursors;
+    for (auto& ring : rings) {
+        // read retired before the records, so the last ones of an exiting thread are not missed
+        if (ring->retired) {
+            std::lock_guard<std::mutex> lock(g_rings_mutex);
+            g_rings.erase(std::remove(g_rings.begin(), g_rings.end(), ring), g_rings.end());
+        }
+        size_t head = ring->head.value.load(std::memory_order_relaxed);
+        size_t tail = ring->tail.value.load(std::memory_order_acquire);
+        if (head != tail)
+            cursors.push_back({ring.get(), head, tail});
+    }
+
+    // merge the rings by sequence, so the batch is in logging order
+    while (!cursors.empty()) {
+        auto cursor = std::min_element(cursors.begin(), cursors.end(), [](const Cursor& a, const Cursor& b) {
+            return a.ring->slots[a.head % HYUE_LOG_RING_SIZE].sequence
+                   < b.ring->slots[b.head % HYUE_LOG_RING_SIZE].sequence;
+        });
+        Ring::Entry& entry = cursor->ring->slots[cursor->head % HYUE_LOG_RING_SIZE];
+
+        line.clear();
+        formatter_(entry.rec, stream);
+        stream.flush();
+
+        if (file_)
+            file_->consume(entry.rec, line);
+        batch_ += line;
+        batch_ += '\n';
+
+        entry.rec = boost::log::record_view();
+        any = true;
+
+        if (++cursor->head == cursor->tail) {
+            cursor->ring->head.value.store(cursor->tail, std::memory_order_release);
+            cursors.erase(cursor);
+        }
+    }
+
+    if (any) {
+        if (console_) {
+            console_->write(batch_.data(), std::streamsize(batch_.size()));
+            console_->flush();
+        }
+        if (file_)
+            file_->flush();
+    }
+    return any;
+}
+
+} // namespace hyue
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <boost/log/core/record_view.hpp>
+#include <boost/log/expressions/formatter.hpp>
+#include <boost/log/detail/fake_mutex.hpp>
+#include <boost/log/sinks/basic_sink_backend.hpp>
+#include <boost/log/sinks/basic_sink_frontend.hpp>
+#include <boost/log/sinks/text_file_backend.hpp>
+
+#include <hyue/type.h>
+
+namespace hyue {
+
+/** Boost.Log backend queueing records for a background writer thread.
+
+    Each logging thread pushes its records into its own single producer,
+    single consumer ring, so consume() neither locks nor formats. The
+    writer drains all rings every few milliseconds (or earlier when a ring
+    fills up or an error is logged), formats the records and writes them
+    to the console and the log file in one batch with a single flush.
+
+    Records of one thread keep their order; the rings are merged by a global
+    sequence number, so records of different threads are in logging order
+    as well, except for ones racing with the writer picking up a batch.
+*/
+class AsyncLogBackend
+: public boost::log::sinks::basic_sink_backend<
+      boost::log::sinks::combine_requirements<boost::log::sinks::concurrent_feeding,
+                                              boost::log::sinks::flushing>::type> {
+public:
+    /** Constructor
+    @param formatter Formats a record into a line
+    @param file The file backend to write to, may be null
+    @param console The stream to write to, may be null
+    */
+    AsyncLogBackend(const boost::log::formatter& formatter,
+                    const boost::shared_ptr<boost::log::sinks::text_file_backend>& file,
+                    std::ostream* console);
+    ~AsyncLogBackend();
+
+    /// Queue a record, called by the logging thread
+    void consume(const boost::log::record_view& rec);
+
+    /// Wait until everything queued so far was written
+    void flush();
+
+    struct Ring;
+
+private:
+    void run();
+    /// Write all queued records, returns false if there were none
+    bool drain();
+
+    boost::log::formatter formatter_;
+    boost::shared_ptr<boost::log::sinks::text_file_backend> file_;
+    std::ostream* console_;
+    String batch_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    bool stop_;
+    std::atomic<bool> wake_requested_;
+    uint64_t flush_requested_;
+    uint64_t flush_done_;
+    std::thread writer_;
+};
+
+/** Frontend feeding AsyncLogBackend without a lock.
+
+    Unlike unlocked_sink it is marked as cross thread, which makes the core
+    detach thread specific attribute values such as the severity before
+    the record is queued.
+*/
+class AsyncLogSink : public boost::log::sinks::basic_sink_frontend {
+public:
+    explicit AsyncLogSink(const boost::shared_ptr<AsyncLogBackend>& backend)
+    : boost::log::sinks::basic_sink_frontend(true),
+      backend_(backend)
+    {
+    }
+
+    void consume(const boost::log::record_view& rec) override
+    {
+        boost::log::aux::fake_mutex mutex;
+        feed_record(rec, mutex, *backend_);
+    }
+
+    void flush() override
+    {
+        boost::log::aux::fake_mutex mutex;
+        flush_backend(mutex, *backend_);
+    }
+
+private:
+    boost::shared_ptr<AsyncLogBackend> backend_;
+};
+
+} // namespace hyue
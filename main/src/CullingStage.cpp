@@ -0,0 +1,151 @@
+#include <hyue/CullingStage.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <hyue/panic.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
+
+#include "culling_simd.h"
+
+namespace hyue {
+
+namespace {
+
+/// Objects per range of a cull, a multiple of 8 so only the last range has a scalar tail
+constexpr size_t CULL_RANGE = 16384;
+
+} // namespace
+
+//-----------------------------------------------------------------------
+void cull_scalar(const CullingBatch& batch, size_t begin, size_t end, std::vector<uint32_t>* visible)
+{
+    for (size_t i = begin; i < end; ++i) {
+        if (!(batch.flags[i] & batch.visibility_mask))
+            continue;
+
+        vec3 center{batch.center[0][i], batch.center[1][i], batch.center[2][i]};
+        vec3 half_size{batch.half_size[0][i], batch.half_size[1][i], batch.half_size[2][i]};
+        for (size_t f = 0; f < batch.frustum_count; ++f) {
+            if (batch.frustums[f].is_visible(center, half_size))
+                visible[f].push_back(uint32_t(i));
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+CullingStage::CullingStage()
+{
+}
+
+CullingStage::~CullingStage()
+{
+}
+
+//-----------------------------------------------------------------------
+void CullingStage::resize(size_t count)
+{
+    for (int i = 0; i < 3; ++i) {
+        center_[i].resize(count, 0);
+        half_size_[i].resize(count, 0);
+    }
+    flags_.resize(count, 0);
+}
+
+//-----------------------------------------------------------------------
+void CullingStage::set_bounds(size_t index, const vec3& min, const vec3& max)
+{
+    for (int i = 0; i < 3; ++i) {
+        center_[i][index] = (min.a[i] + max.a[i]) * 0.5f;
+        half_size_[i][index] = (max.a[i] - min.a[i]) * 0.5f;
+    }
+}
+
+//-----------------------------------------------------------------------
+void CullingStage::set_bounds(size_t index, const vec3& min, const vec3& max, const mat4& world)
+{
+    // the center is transformed, the half size is stretched by the absolute
+    // value of the linear part, as in Ogre's AxisAlignedBox::transform
+    float center[3], half_size[3];
+    for (int i = 0; i < 3; ++i) {
+        center[i] = (min.a[i] + max.a[i]) * 0.5f;
+        half_size[i] = (max.a[i] - min.a[i]) * 0.5f;
+    }
+    for (int r = 0; r < 3; ++r) {
+        float c = world.a[r][3], h = 0;
+        for (int k = 0; k < 3; ++k) {
+            c += world.a[r][k] * center[k];
+            h += std::abs(world.a[r][k]) * half_size[k];
+        }
+        center_[r][index] = c;
+        half_size_[r][index] = h;
+    }
+}
+
+//-----------------------------------------------------------------------
+void CullingStage::get_bounds(size_t index, vec3* center, vec3* half_size) const
+{
+    for (int i = 0; i < 3; ++i) {
+        center->a[i] = center_[i][index];
+        half_size->a[i] = half_size_[i][index];
+    }
+}
+
+//-----------------------------------------------------------------------
+void CullingStage::cull(const Frustum* frustums,
+                        size_t frustum_count,
+                        uint32_t visibility_mask,
+                        std::vector<uint32_t>* visible,
+                        Executor* executor)
+{
+    for (size_t f = 0; f < frustum_count; ++f)
+        visible[f].clear();
+    const size_t count = size();
+    if (count == 0 || frustum_count == 0)
+        return;
+
+    CullingBatch batch;
+    for (int i = 0; i < 3; ++i) {
+        batch.center[i] = center_[i].data();
+        batch.half_size[i] = half_size_[i].data();
+    }
+    batch.flags = flags_.data();
+    batch.visibility_mask = visibility_mask;
+    batch.frustums = frustums;
+    batch.frustum_count = frustum_count;
+
+    CullKernel kernel = select_simd(HYUE_AVX2_KERNEL(avx2_cull),
+                                    HYUE_SSE2_KERNEL(sse2_cull),
+                                    cull_scalar);
+    size_t ranges = (count + CULL_RANGE - 1) / CULL_RANGE;
+    if (ranges == 1) {
+        kernel(batch, 0, count, visible);
+        return;
+    }
+
+    // one list per range and frustum, concatenated in range order below
+    if (range_visible_.size() < ranges * frustum_count)
+        range_visible_.resize(ranges * frustum_count);
+    if (!executor)
+        executor = &ThreadPool::get_worker_pool();
+    executor->parallel_for(ranges, [&](size_t r) {
+        std::vector<uint32_t>* lists = &range_visible_[r * frustum_count];
+        for (size_t f = 0; f < frustum_count; ++f)
+            lists[f].clear();
+        kernel(batch, r * CULL_RANGE, std::min((r + 1) * CULL_RANGE, count), lists);
+    });
+
+    for (size_t f = 0; f < frustum_count; ++f) {
+        size_t total = 0;
+        for (size_t r = 0; r < ranges; ++r)
+            total += range_visible_[r * frustum_count + f].size();
+        visible[f].reserve(total);
+        for (size_t r = 0; r < ranges; ++r) {
+            auto& list = range_visible_[r * frustum_count + f];
+            visible[f].insert(visible[f].end(), list.begin(), list.end());
+        }
+    }
+}
+
+} // namespace hyue
@@ -0,0 +1,353 @@
+#include <hyue/DDSCodec.h>
+
+#include <string.h>
+
+#include <hyue/Bitwise.h>
+#include <hyue/panic.h>
+
+namespace hyue {
+
+namespace {
+
+struct DDSPixelFormat {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t four_cc;
+    uint32_t rgb_bits;
+    uint32_t red_mask;
+    uint32_t green_mask;
+    uint32_t blue_mask;
+    uint32_t alpha_mask;
+};
+
+struct DDSCaps {
+    uint32_t caps1;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+};
+
+/// Main header, preceded by 'DDS '
+struct DDSHeader {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t size_or_pitch;
+    uint32_t depth;
+    uint32_t mip_map_count;
+    uint32_t reserved1[11];
+    DDSPixelFormat pixel_format;
+    DDSCaps caps;
+    uint32_t reserved2;
+};
+
+/// Follows the main header when its FourCC is 'DX10'
+struct DDSExtendedHeader {
+    uint32_t dxgi_format;
+    uint32_t resource_dimension;
+    uint32_t misc_flag;
+    uint32_t array_size;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(DDSHeader) == 124, "DDS header must not be padded");
+static_assert(sizeof(DDSExtendedHeader) == 20, "DDS extended header must not be padded");
+
+constexpr uint32_t four_cc(char a, char b, char c, char d)
+{
+    return uint32_t(uint8_t(a)) | uint32_t(uint8_t(b)) << 8 | uint32_t(uint8_t(c)) << 16 | uint32_t(uint8_t(d)) << 24;
+}
+
+const uint32_t DDS_PIXELFORMAT_SIZE = sizeof(DDSPixelFormat);
+const uint32_t DDS_HEADER_SIZE = sizeof(DDSHeader);
+
+const uint32_t DDPF_ALPHAPIXELS = 0x00000001;
+const uint32_t DDPF_FOURCC = 0x00000004;
+const uint32_t DDSCAPS_MIPMAP = 0x00400000;
+const uint32_t DDSCAPS2_CUBEMAP = 0x00000200;
+const uint32_t DDSCAPS2_VOLUME = 0x00200000;
+
+// Special FourCC codes
+const uint32_t D3DFMT_R16F = 111;
+const uint32_t D3DFMT_G16R16F = 112;
+const uint32_t D3DFMT_A16B16G16R16F = 113;
+const uint32_t D3DFMT_R32F = 114;
+const uint32_t D3DFMT_G32R32F = 115;
+const uint32_t D3DFMT_A32B32G32R32F = 116;
+
+void read_exact(DataStream& stream, void* buf, size_t count)
+{
+    if (stream.read(buf, count) != count)
+        panic("Unexpected end of DDS file");
+}
+
+/// Header fields are little endian
+template <typename T>
+void read_header(DataStream& stream, T* header)
+{
+    read_exact(stream, header, sizeof(T));
+#if HYUE_ENDIAN_BIG
+    Bitwise::bswap_chunks(header, sizeof(uint32_t), sizeof(T) / sizeof(uint32_t));
+#endif
+}
+
+PixelFormat convert_dxgi_format(uint32_t dxgi_format)
+{
+    switch (dxgi_format) {
+        case 2: // DXGI_FORMAT_R32G32B32A32_FLOAT
+            return PixelFormat::FLOAT32_RGBA;
+        case 3: // DXGI_FORMAT_R32G32B32A32_UINT
+            return PixelFormat::R32G32B32A32_UINT;
+        case 4: // DXGI_FORMAT_R32G32B32A32_SINT
+            return PixelFormat::R32G32B32A32_SINT;
+        case 6: // DXGI_FORMAT_R32G32B32_FLOAT
+            return PixelFormat::FLOAT32_RGB;
+        case 7: // DXGI_FORMAT_R32G32B32_UINT
+            return PixelFormat::R32G32B32_UINT;
+        case 8: // DXGI_FORMAT_R32G32B32_SINT
+            return PixelFormat::R32G32B32_SINT;
+        case 10: // DXGI_FORMAT_R16G16B16A16_FLOAT
+            return PixelFormat::FLOAT16_RGBA;
+        case 12: // DXGI_FORMAT_R16G16B16A16_UINT
+            return PixelFormat::R16G16B16A16_UINT;
+        case 13: // DXGI_FORMAT_R16G16B16A16_SNORM
+            return PixelFormat::R16G16B16A16_SNORM;
+        case 14: // DXGI_FORMAT_R16G16B16A16_SINT
+            return PixelFormat::R16G16B16A16_SINT;
+        case 16: // DXGI_FORMAT_R32G32_FLOAT
+            return PixelFormat::FLOAT32_GR;
+        case 17: // DXGI_FORMAT_R32G32_UINT
+            return PixelFormat::R32G32_UINT;
+        case 18: // DXGI_FORMAT_R32G32_SINT
+            return PixelFormat::R32G32_SINT;
+        case 24: // DXGI_FORMAT_R10G10B10A2_UNORM
+        case 25: // DXGI_FORMAT_R10G10B10A2_UINT
+            return PixelFormat::A2B10G10R10;
+        case 26: // DXGI_FORMAT_R11G11B10_FLOAT
+            return PixelFormat::R11G11B10_FLOAT;
+        case 28: // DXGI_FORMAT_R8G8B8A8_UNORM
+        case 29: // DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+            return PixelFormat::A8B8G8R8;
+        case 30: // DXGI_FORMAT_R8G8B8A8_UINT
+            return PixelFormat::R8G8B8A8_UINT;
+        case 31: // DXGI_FORMAT_R8G8B8A8_SNORM
+            return PixelFormat::R8G8B8A8_SNORM;
+        case 32: // DXGI_FORMAT_R8G8B8A8_SINT
+            return PixelFormat::R8G8B8A8_SINT;
+        case 34: // DXGI_FORMAT_R16G16_FLOAT
+            return PixelFormat::FLOAT16_GR;
+        case 35: // DXGI_FORMAT_R16G16_UNORM
+            return PixelFormat::SHORT_GR;
+        case 36: // DXGI_FORMAT_R16G16_UINT
+            return PixelFormat::R16G16_UINT;
+        case 37: // DXGI_FORMAT_R16G16_SNORM
+            return PixelFormat::R16G16_SNORM;
+        case 38: // DXGI_FORMAT_R16G16_SINT
+            return PixelFormat::R16G16_SINT;
+        case 41: // DXGI_FORMAT_R32_FLOAT
+            return PixelFormat::FLOAT32_R;
+        case 42: // DXGI_FORMAT_R32_UINT
+            return PixelFormat::R32_UINT;
+        case 43: // DXGI_FORMAT_R32_SINT
+            return PixelFormat::R32_SINT;
+        case 49: // DXGI_FORMAT_R8G8_UNORM
+        case 50: // DXGI_FORMAT_R8G8_UINT
+            return PixelFormat::R8G8_UINT;
+        case 52: // DXGI_FORMAT_R8G8_SINT
+            return PixelFormat::R8G8_SINT;
+        case 54: // DXGI_FORMAT_R16_FLOAT
+            return PixelFormat::FLOAT16_R;
+        case 56: // DXGI_FORMAT_R16_UNORM
+            return PixelFormat::L16;
+        case 57: // DXGI_FORMAT_R16_UINT
+            return PixelFormat::R16_UINT;
+        case 58: // DXGI_FORMAT_R16_SNORM
+            return PixelFormat::R16_SNORM;
+        case 59: // DXGI_FORMAT_R16_SINT
+            return PixelFormat::R16_SINT;
+        case 61: // DXGI_FORMAT_R8_UNORM
+            return PixelFormat::R8;
+        case 62: // DXGI_FORMAT_R8_UINT
+            return PixelFormat::R8_UINT;
+        case 63: // DXGI_FORMAT_R8_SNORM
+            return PixelFormat::R8_SNORM;
+        case 64: // DXGI_FORMAT_R8_SINT
+            return PixelFormat::R8_SINT;
+        case 65: // DXGI_FORMAT_A8_UNORM
+            return PixelFormat::A8;
+        case 71: // DXGI_FORMAT_BC1_UNORM
+        case 72: // DXGI_FORMAT_BC1_UNORM_SRGB
+            return PixelFormat::DXT1;
+        case 74: // DXGI_FORMAT_BC2_UNORM
+        case 75: // DXGI_FORMAT_BC2_UNORM_SRGB
+            return PixelFormat::DXT3;
+        case 77: // DXGI_FORMAT_BC3_UNORM
+        case 78: // DXGI_FORMAT_BC3_UNORM_SRGB
+            return PixelFormat::DXT5;
+        case 80: // DXGI_FORMAT_BC4_UNORM
+            return PixelFormat::BC4_UNORM;
+        case 81: // DXGI_FORMAT_BC4_SNORM
+            return PixelFormat::BC4_SNORM;
+        case 83: // DXGI_FORMAT_BC5_UNORM
+            return PixelFormat::BC5_UNORM;
+        case 84: // DXGI_FORMAT_BC5_SNORM
+            return PixelFormat::BC5_SNORM;
+        case 85: // DXGI_FORMAT_B5G6R5_UNORM
+            return PixelFormat::R5G6B5;
+        case 86: // DXGI_FORMAT_B5G5R5A1_UNORM
+            return PixelFormat::A1R5G5B5;
+        case 87: // DXGI_FORMAT_B8G8R8A8_UNORM
+            return PixelFormat::A8R8G8B8;
+        case 88: // DXGI_FORMAT_B8G8R8X8_UNORM
+            return PixelFormat::X8R8G8B8;
+        case 95: // DXGI_FORMAT_BC6H_UF16
+            return PixelFormat::BC6H_UF16;
+        case 96: // DXGI_FORMAT_BC6H_SF16
+            return PixelFormat::BC6H_SF16;
+        case 98: // DXGI_FORMAT_BC7_UNORM
+        case 99: // DXGI_FORMAT_BC7_UNORM_SRGB
+            return PixelFormat::BC7_UNORM;
+        default:
+            panic("Unsupported DirectX format found in DDS file");
+    }
+    return PixelFormat::UNKNOWN;
+}
+
+PixelFormat convert_four_cc_format(uint32_t fourcc)
+{
+    switch (fourcc) {
+        case four_cc('D', 'X', 'T', '1'):
+            return PixelFormat::DXT1;
+        case four_cc('D', 'X', 'T', '2'):
+            return PixelFormat::DXT2;
+        case four_cc('D', 'X', 'T', '3'):
+            return PixelFormat::DXT3;
+        case four_cc('D', 'X', 'T', '4'):
+            return PixelFormat::DXT4;
+        case four_cc('D', 'X', 'T', '5'):
+            return PixelFormat::DXT5;
+        case four_cc('A', 'T', 'I', '1'):
+        case four_cc('B', 'C', '4', 'U'):
+            return PixelFormat::BC4_UNORM;
+        case four_cc('B', 'C', '4', 'S'):
+            return PixelFormat::BC4_SNORM;
+        case four_cc('A', 'T', 'I', '2'):
+        case four_cc('B', 'C', '5', 'U'):
+            return PixelFormat::BC5_UNORM;
+        case four_cc('B', 'C', '5', 'S'):
+            return PixelFormat::BC5_SNORM;
+        case D3DFMT_R16F:
+            return PixelFormat::FLOAT16_R;
+        case D3DFMT_G16R16F:
+            return PixelFormat::FLOAT16_GR;
+        case D3DFMT_A16B16G16R16F:
+            return PixelFormat::FLOAT16_RGBA;
+        case D3DFMT_R32F:
+            return PixelFormat::FLOAT32_R;
+        case D3DFMT_G32R32F:
+            return PixelFormat::FLOAT32_GR;
+        case D3DFMT_A32B32G32R32F:
+            return PixelFormat::FLOAT32_RGBA;
+        default:
+            panic("Unsupported FourCC format found in DDS file");
+    }
+    return PixelFormat::UNKNOWN;
+}
+
+/// Uncompressed format with the given bit layout
+PixelFormat convert_pixel_format(uint32_t rgb_bits, uint32_t r_mask, uint32_t g_mask, uint32_t b_mask, uint32_t a_mask)
+{
+    for (int i = int(PixelFormat::UNKNOWN) + 1; i < int(PixelFormat::COUNT); ++i) {
+        PixelFormat pf = static_cast<PixelFormat>(i);
+        if (PixelUtil::get_elem_bits(pf) != rgb_bits)
+            continue;
+
+        uint64_t masks[4];
+        PixelUtil::get_bit_masks(pf, masks);
+        int bits[4];
+        PixelUtil::get_bit_depths(pf, bits);
+        // for alpha, deal with 'X8' formats by checking bit counts
+        if (masks[0] == r_mask && masks[1] == g_mask && masks[2] == b_mask
+            && (masks[3] == a_mask || (a_mask == 0 && bits[3] == 0)))
+            return pf;
+    }
+    panic("Cannot determine pixel format of DDS file");
+    return PixelFormat::UNKNOWN;
+}
+
+} // namespace
+
+bool DDSCodec::is_dds(const void* data, size_t size)
+{
+    return size >= 4 && memcmp(data, "DDS ", 4) == 0;
+}
+
+void DDSCodec::decode(const DataStreamPtr& stream, Image* image, bool decompress, Executor* executor)
+{
+    char magic[4];
+    read_exact(*stream, magic, sizeof(magic));
+    if (!is_dds(magic, sizeof(magic)))
+        panic("This is not a DDS file!");
+
+    DDSHeader header;
+    read_header(*stream, &header);
+    if (header.size != DDS_HEADER_SIZE || header.pixel_format.size != DDS_PIXELFORMAT_SIZE)
+        panic("DDS header size mismatch!");
+
+    uint32_t depth = 1, num_faces = 1;
+    if (header.caps.caps2 & DDSCAPS2_CUBEMAP)
+        num_faces = 6;
+    else if (header.caps.caps2 & DDSCAPS2_VOLUME)
+        depth = std::max(1u, header.depth);
+
+    uint32_t num_mipmaps = 0;
+    if ((header.caps.caps1 & DDSCAPS_MIPMAP) && header.mip_map_count > 0)
+        num_mipmaps = header.mip_map_count - 1;
+
+    PixelFormat source_format;
+    if (header.pixel_format.flags & DDPF_FOURCC) {
+        // the DX10 extended header is needed for BC6H and BC7
+        if (header.pixel_format.four_cc == four_cc('D', 'X', '1', '0')) {
+            DDSExtendedHeader ext_header;
+            read_header(*stream, &ext_header);
+            source_format = convert_dxgi_format(ext_header.dxgi_format);
+        } else {
+            source_format = convert_four_cc_format(header.pixel_format.four_cc);
+        }
+    } else {
+        source_format = convert_pixel_format(header.pixel_format.rgb_bits,
+                                             header.pixel_format.red_mask,
+                                             header.pixel_format.green_mask,
+                                             header.pixel_format.blue_mask,
+                                             header.pixel_format.flags & DDPF_ALPHAPIXELS ? header.pixel_format.alpha_mask : 0);
+    }
+
+    bool decode_blocks = decompress && PixelUtil::is_compressed(source_format);
+    if (decode_blocks && !PixelUtil::is_decompressible(source_format))
+        panic("No decoder for DDS pixel format " + PixelUtil::getFormatName(source_format));
+
+    PixelFormat format = decode_blocks ? PixelFormat::BYTE_RGBA : source_format;
+    image->create(format, header.width, header.height, depth, num_faces, num_mipmaps);
+
+    // all mips of a face, then the next face
+    std::vector<uint8_t> blocks;
+    for (uint32_t face = 0; face < num_faces; ++face) {
+        for (uint32_t mip = 0; mip <= num_mipmaps; ++mip) {
+            PixelBox dst = image->get_pixel_box(face, mip);
+            if (!decode_blocks) {
+                // sizeOrPitch is not reliable, the data is assumed to be tightly packed
+                read_exact(*stream, dst.data, dst.get_consecutive_size());
+                continue;
+            }
+
+            PixelBox src(int(dst.get_width()), int(dst.get_height()), int(dst.get_depth()), source_format);
+            blocks.resize(src.get_consecutive_size());
+            read_exact(*stream, blocks.data(), blocks.size());
+            src.data = blocks.data();
+            PixelUtil::decompress(&src, &dst, executor);
+        }
+    }
+}
+
+} // namespace hyue
@@ -3,6 +3,10 @@
 #include <fstream>
 
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <hyue/StringUtils.h>
 #include <hyue/panic.h>
@@ -381,6 +385,93 @@ void MemoryDataStream::close(void)
     }
 }
 
+//-----------------------------------------------------------------------
+// MappedFileDataStream
+//-----------------------------------------------------------------------
+MappedFileDataStream::MappedFileDataStream(const String& name, void* p_map, size_t size)
+: MemoryDataStream(name, p_map, size, false, true),
+  map_(p_map),
+  map_size_(size)
+{
+}
+
+MappedFileDataStream::~MappedFileDataStream()
+{
+    close();
+}
+
+void MappedFileDataStream::close(void)
+{
+    if (map_) {
+        munmap(map_, map_size_);
+        map_ = nullptr;
+        map_size_ = 0;
+    }
+    MemoryDataStream::close();
+}
+
+MappedFileDataStreamPtr MappedFileDataStream::open(const String& full_path, const String& name)
+{
+    int fd = ::open(full_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG(error) << "Cannot open file: " + full_path;
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        // mmap can not map an empty range
+        ::close(fd);
+        return nullptr;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* p_map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps its own reference to the file
+    ::close(fd);
+
+    if (p_map == MAP_FAILED) {
+        LOG(error) << "Cannot map file: " + full_path;
+        return nullptr;
+    }
+
+    const String& stream_name = name.empty() ? full_path : name;
+    return std::make_shared<MappedFileDataStream>(stream_name, p_map, size);
+}
+
+//-----------------------------------------------------------------------
+// DataStreamView
+//-----------------------------------------------------------------------
+DataStreamView::DataStreamView(const String& name, const MemoryDataStreamPtr& parent, size_t offset, size_t size)
+: MemoryDataStream(name, parent->get_ptr() + offset, size, false, true),
+  owner_(parent)
+{
+    HYUE_ASSERT(offset <= parent->get_size() && size <= parent->get_size() - offset,
+                "View of " + name + " exceeds its parent " + parent->get_name());
+
+    // hold on to the memory itself, not to a view the caller may close
+    auto view = dynamic_cast<DataStreamView*>(parent.get());
+    if (view)
+        owner_ = view->owner_;
+}
+
+DataStreamView::DataStreamView(const String& name, SharedPtr<const void> owner, const void* p_mem, size_t size)
+: MemoryDataStream(name, const_cast<void*>(p_mem), size, false, true),
+  owner_(std::move(owner))
+{
+}
+
+DataStreamView::~DataStreamView()
+{
+    close();
+}
+
+void DataStreamView::close(void)
+{
+    MemoryDataStream::close();
+    owner_.reset();
+}
+
 //-----------------------------------------------------------------------
 // FileStreamDataStream
 //-----------------------------------------------------------------------
@@ -0,0 +1,273 @@
+#include <hyue/DeflateDataStream.h>
+
+#include <algorithm>
+
+#include <string.h>
+
+#include <hyue/panic.h>
+
+extern "C" {
+// the miniz implementation is compiled as part of zip/zip.c
+#define MINIZ_HEADER_FILE_ONLY
+#include "zip/miniz.h"
+}
+
+/// Size of the compressed data read from the source at a time
+#define HYUE_DEFLATE_INPUT_SIZE (16 * 1024)
+
+namespace hyue {
+
+namespace {
+
+const size_t WINDOW_SIZE = TINFL_LZ_DICT_SIZE;
+const size_t WINDOW_MASK = WINDOW_SIZE - 1;
+
+// gzip header flags
+const uint8_t GZIP_FHCRC = 0x02;
+const uint8_t GZIP_FEXTRA = 0x04;
+const uint8_t GZIP_FNAME = 0x08;
+const uint8_t GZIP_FCOMMENT = 0x10;
+
+bool is_gzip_header(const uint8_t* p, size_t size)
+{
+    return size >= 3 && p[0] == 0x1f && p[1] == 0x8b && p[2] == 8;
+}
+
+bool is_zlib_header(const uint8_t* p, size_t size)
+{
+    // deflate with at most a 32 KiB window, and the check bits
+    return size >= 2 && (p[0] & 0x0f) == 8 && (p[0] >> 4) <= 7 && ((p[0] << 8) | p[1]) % 31 == 0;
+}
+
+} // namespace
+
+/** Everything needed to continue inflating from a position.
+
+    The decompressor writes into window as a ring buffer, so window also holds
+    the last WINDOW_SIZE bytes of output, which later data may refer to.
+*/
+struct DeflateDataStream::State {
+    tinfl_decompressor inflator;
+    /// The next byte of output goes to window[produced & WINDOW_MASK]
+    uint8_t window[WINDOW_SIZE];
+    /// Uncompressed bytes inflated so far
+    size_t produced;
+    /// Offset in the compressed stream of the next byte the decompressor takes
+    size_t consumed;
+    /// Whether the end of the deflate data was reached
+    bool done;
+    /// Whether the source ran out of compressed data
+    bool input_ended;
+};
+
+DeflateDataStream::DeflateDataStream(const String& name,
+                                     const DataStreamPtr& compressed_stream,
+                                     StreamType type,
+                                     size_t checkpoint_interval)
+: DataStream(name),
+  compressed_(compressed_stream),
+  type_(type),
+  checkpoint_interval_(checkpoint_interval ? std::max(checkpoint_interval, WINDOW_SIZE) : 0),
+  state_(new State()),
+  input_(HYUE_DEFLATE_INPUT_SIZE),
+  input_begin_(0),
+  input_end_(0),
+  pos_(0)
+{
+    tinfl_init(&state_->inflator);
+    state_->consumed = compressed_->tell();
+
+    input_end_ = compressed_->read(input_.data(), input_.size());
+    if (type_ == AUTO) {
+        if (is_gzip_header(input_.data(), input_end_))
+            type_ = GZIP;
+        else if (is_zlib_header(input_.data(), input_end_))
+            type_ = ZLIB;
+        else
+            type_ = DEFLATE;
+    }
+
+    if (type_ == GZIP) {
+        size_t header = read_gzip_header();
+        state_->consumed += header;
+    }
+
+    // the start of the data is always a checkpoint
+    index_.push_back(std::unique_ptr<State>(new State(*state_)));
+}
+
+DeflateDataStream::~DeflateDataStream()
+{
+    close();
+}
+
+size_t DeflateDataStream::read_gzip_header()
+{
+    size_t size = 0;
+    auto take = [&](size_t count) -> const uint8_t* {
+        // the optional fields may be longer than one input block
+        if (input_end_ - input_begin_ < count) {
+            memmove(input_.data(), input_.data() + input_begin_, input_end_ - input_begin_);
+            input_end_ -= input_begin_;
+            input_begin_ = 0;
+            if (input_.size() < count)
+                input_.resize(count);
+            input_end_ += compressed_->read(input_.data() + input_end_, input_.size() - input_end_);
+            if (input_end_ < count)
+                panic("Unexpected end of gzip header in " + name_);
+        }
+        const uint8_t* ret = input_.data() + input_begin_;
+        input_begin_ += count;
+        size += count;
+        return ret;
+    };
+    auto skip_string = [&]() {
+        while (*take(1) != 0) {
+        }
+    };
+
+    const uint8_t* header = take(10);
+    if (!is_gzip_header(header, 10))
+        panic("Invalid gzip header in " + name_);
+
+    uint8_t flags = header[3];
+    if (flags & GZIP_FEXTRA) {
+        const uint8_t* length = take(2);
+        take(size_t(length[0]) | size_t(length[1]) << 8);
+    }
+    if (flags & GZIP_FNAME)
+        skip_string();
+    if (flags & GZIP_FCOMMENT)
+        skip_string();
+    if (flags & GZIP_FHCRC)
+        take(2);
+    return size;
+}
+
+bool DeflateDataStream::inflate_next()
+{
+    State& state = *state_;
+    if (state.done)
+        return false;
+
+    for (;;) {
+        if (input_begin_ == input_end_ && !state.input_ended) {
+            input_begin_ = 0;
+            input_end_ = compressed_->read(input_.data(), input_.size());
+            state.input_ended = input_end_ == 0;
+        }
+
+        mz_uint32 flags = type_ == ZLIB ? TINFL_FLAG_PARSE_ZLIB_HEADER : 0;
+        if (!state.input_ended)
+            flags |= TINFL_FLAG_HAS_MORE_INPUT;
+
+        size_t window_pos = state.produced & WINDOW_MASK;
+        size_t in_size = input_end_ - input_begin_;
+        size_t out_size = WINDOW_SIZE - window_pos;
+        tinfl_status status = tinfl_decompress(&state.inflator,
+                                               input_.data() + input_begin_,
+                                               &in_size,
+                                               state.window,
+                                               state.window + window_pos,
+                                               &out_size,
+                                               flags);
+        input_begin_ += in_size;
+        state.consumed += in_size;
+        state.produced += out_size;
+
+        if (status < TINFL_STATUS_DONE)
+            panic("Corrupt deflate data in " + name_);
+        if (status == TINFL_STATUS_DONE) {
+            state.done = true;
+            size_ = state.produced;
+            return out_size > 0;
+        }
+        if (status == TINFL_STATUS_NEEDS_MORE_INPUT && state.input_ended)
+            panic("Unexpected end of deflate data in " + name_);
+
+        if (out_size > 0) {
+            if (checkpoint_interval_ && state.produced >= index_.back()->produced + checkpoint_interval_)
+                index_.push_back(std::unique_ptr<State>(new State(state)));
+            return true;
+        }
+    }
+}
+
+void DeflateDataStream::restore(const State& checkpoint)
+{
+    *state_ = checkpoint;
+
+    compressed_->seek(state_->consumed);
+    input_begin_ = 0;
+    input_end_ = 0;
+}
+
+size_t DeflateDataStream::read(void* buf, size_t count)
+{
+    if (!state_)
+        return 0;
+
+    uint8_t* dst = static_cast<uint8_t*>(buf);
+    size_t total = 0;
+    while (total < count) {
+        if (pos_ == state_->produced) {
+            if (!inflate_next())
+                break;
+            continue;
+        }
+
+        // pos_ is within the window, copy up to its end or the wrap around
+        size_t offset = pos_ & WINDOW_MASK;
+        size_t cnt = std::min({count - total, state_->produced - pos_, WINDOW_SIZE - offset});
+        memcpy(dst + total, state_->window + offset, cnt);
+        total += cnt;
+        pos_ += cnt;
+    }
+    return total;
+}
+
+void DeflateDataStream::skip(long count)
+{
+    // skipping back past the start stops at it
+    seek(count < -long(pos_) ? 0 : size_t(long(pos_) + count));
+}
+
+void DeflateDataStream::seek(size_t pos)
+{
+    if (!state_)
+        return;
+
+    // restart from the last checkpoint before pos if pos is behind the
+    // window, or if that checkpoint is ahead of the decompressor
+    auto it = std::upper_bound(index_.begin(), index_.end(), pos, [](size_t p, const std::unique_ptr<State>& s) {
+        return p < s->produced;
+    });
+    const State& checkpoint = **(it - 1);
+    size_t window_begin = state_->produced - std::min(state_->produced, WINDOW_SIZE);
+    if (pos < window_begin || checkpoint.produced > state_->produced)
+        restore(checkpoint);
+
+    while (state_->produced < pos && inflate_next()) {
+    }
+    pos_ = std::min(pos, state_->produced);
+}
+
+size_t DeflateDataStream::tell(void) const
+{
+    return pos_;
+}
+
+bool DeflateDataStream::is_eof(void) const
+{
+    return !state_ || (state_->done && pos_ == state_->produced);
+}
+
+void DeflateDataStream::close(void)
+{
+    access_ = 0;
+    state_.reset();
+    index_.clear();
+    compressed_.reset();
+}
+
+} // namespace hyue
@@ -14,10 +14,12 @@ DynLib::DynLib( const String& name )
 
 DynLib::~DynLib() {}
 
-void DynLib::load() {
+void DynLib::load(int flags) {
     LOG(debug) << "Loading library " << name_;
 
-    handle_ = (DynLibHandle) dlopen(name_.c_str(), RTLD_LAZY | RTLD_GLOBAL);
+    int mode = (flags & DYNLIB_BIND_NOW) ? RTLD_NOW : RTLD_LAZY;
+    mode |= (flags & DYNLIB_LOCAL) ? RTLD_LOCAL : RTLD_GLOBAL;
+    handle_ = (DynLibHandle) dlopen(name_.c_str(), mode);
 
     if(!handle_) {
         panic("Could not load dynamic library " + name_ + ".  System Error: " + get_dyn_lib_error());
@@ -28,7 +30,14 @@ void DynLib::unload() {
     // Log library unload
     LOG(debug) << "Unloading library " + name_;
 
-    if(dlclose( handle_ ))
+    {
+        std::lock_guard<std::mutex> lock(symbols_mutex_);
+        symbols_.clear();
+    }
+
+    DynLibHandle handle = handle_;
+    handle_ = nullptr;
+    if(dlclose( handle ))
     {
         panic("Could not unload dynamic library " + name_ + ".  System Error: " + get_dyn_lib_error());
     }
@@ -43,7 +52,14 @@ String DynLib::get_dyn_lib_error()
 
 void* DynLib::get_symbol(const String& name) const
 {
-    return (void*)dlsym( handle_, name.c_str());
+    std::lock_guard<std::mutex> lock(symbols_mutex_);
+    auto it = symbols_.find(name);
+    if (it != symbols_.end())
+        return it->second;
+
+    void* symbol = (void*)dlsym( handle_, name.c_str());
+    symbols_.emplace(name, symbol);
+    return symbol;
 }
 
 }
\ No newline at end of file
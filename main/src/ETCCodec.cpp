@@ -0,0 +1,247 @@
+#include <hyue/ETCCodec.h>
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <hyue/Bitwise.h>
+#include <hyue/panic.h>
+
+// In a PKM-file, the codecs are stored using the following identifiers
+//
+// identifier                         value               codec
+// --------------------------------------------------------------------
+// ETC1_RGB_NO_MIPMAPS                  0                 GL_ETC1_RGB8_OES
+// ETC2PACKAGE_RGB_NO_MIPMAPS           1                 GL_COMPRESSED_RGB8_ETC2
+// ETC2PACKAGE_RGBA_NO_MIPMAPS_OLD      2, not used       -
+// ETC2PACKAGE_RGBA_NO_MIPMAPS          3                 GL_COMPRESSED_RGBA8_ETC2_EAC
+// ETC2PACKAGE_RGBA1_NO_MIPMAPS         4                 GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2
+// ETC2PACKAGE_R_NO_MIPMAPS             5                 GL_COMPRESSED_R11_EAC
+// ETC2PACKAGE_RG_NO_MIPMAPS            6                 GL_COMPRESSED_RG11_EAC
+// ETC2PACKAGE_R_SIGNED_NO_MIPMAPS      7                 GL_COMPRESSED_SIGNED_R11_EAC
+// ETC2PACKAGE_RG_SIGNED_NO_MIPMAPS     8                 GL_COMPRESSED_SIGNED_RG11_EAC
+
+namespace hyue {
+
+namespace {
+
+/// Fields are big endian
+struct PKMHeader {
+    uint8_t name[4];
+    uint8_t version[2];
+    uint8_t texture_type[2];
+    uint8_t padded_width[2];
+    uint8_t padded_height[2];
+    uint8_t width[2];
+    uint8_t height[2];
+};
+
+struct KTXHeader {
+    uint8_t identifier[12];
+    uint32_t endianness;
+    uint32_t gl_type;
+    uint32_t gl_type_size;
+    uint32_t gl_format;
+    uint32_t gl_internal_format;
+    uint32_t gl_base_internal_format;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t number_of_array_elements;
+    uint32_t number_of_faces;
+    uint32_t number_of_mipmap_levels;
+    uint32_t bytes_of_key_value_data;
+};
+
+static_assert(sizeof(PKMHeader) == 16, "PKM header must not be padded");
+static_assert(sizeof(KTXHeader) == 64, "KTX header must not be padded");
+
+const uint8_t KTX_IDENTIFIER[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+const uint32_t KTX_ENDIAN_REF = 0x04030201;
+const uint32_t KTX_ENDIAN_REF_REV = 0x01020304;
+
+void read_exact(DataStream& stream, void* buf, size_t count)
+{
+    if (stream.read(buf, count) != count)
+        panic("Unexpected end of ETC file");
+}
+
+inline uint32_t read_u16_be(const uint8_t* p)
+{
+    return uint32_t(p[0]) << 8 | p[1];
+}
+
+PixelFormat convert_pkm_format(const PKMHeader& header)
+{
+    // File version 2.0 supports ETC2 in addition to ETC1
+    if (header.version[0] != '2' || header.version[1] != '0')
+        return PixelFormat::ETC1_RGB8;
+
+    switch (read_u16_be(header.texture_type)) {
+        case 1:
+            return PixelFormat::ETC2_RGB8;
+        case 3:
+            return PixelFormat::ETC2_RGBA8;
+        case 4:
+            return PixelFormat::ETC2_RGB8A1;
+        case 5:
+        case 6:
+        case 7:
+        case 8:
+            panic("EAC R11 and RG11 PKM files are not supported");
+            return PixelFormat::UNKNOWN;
+        default:
+            return PixelFormat::ETC1_RGB8;
+    }
+}
+
+PixelFormat convert_gl_format(uint32_t internal_format)
+{
+    switch (internal_format) {
+        case 37492: // GL_COMPRESSED_RGB8_ETC2
+            return PixelFormat::ETC2_RGB8;
+        case 37496: // GL_COMPRESSED_RGBA8_ETC2_EAC
+            return PixelFormat::ETC2_RGBA8;
+        case 37494: // GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2
+            return PixelFormat::ETC2_RGB8A1;
+        case 35986: // ATC_RGB
+            return PixelFormat::ATC_RGB;
+        case 35987: // ATC_RGB_Explicit
+            return PixelFormat::ATC_RGBA_EXPLICIT_ALPHA;
+        case 34798: // ATC_RGB_Interpolated
+            return PixelFormat::ATC_RGBA_INTERPOLATED_ALPHA;
+        case 33777: // DXT 1
+            return PixelFormat::DXT1;
+        case 33778: // DXT 3
+            return PixelFormat::DXT3;
+        case 33779: // DXT 5
+            return PixelFormat::DXT5;
+        case 0x8c00: // COMPRESSED_RGB_PVRTC_4BPPV1_IMG
+            return PixelFormat::PVRTC_RGB4;
+        case 0x8c01: // COMPRESSED_RGB_PVRTC_2BPPV1_IMG
+            return PixelFormat::PVRTC_RGB2;
+        case 0x8c02: // COMPRESSED_RGBA_PVRTC_4BPPV1_IMG
+            return PixelFormat::PVRTC_RGBA4;
+        case 0x8c03: // COMPRESSED_RGBA_PVRTC_2BPPV1_IMG
+            return PixelFormat::PVRTC_RGBA2;
+        case 0x93B0: // COMPRESSED_RGBA_ASTC_4x4_KHR
+            return PixelFormat::ASTC_RGBA_4X4_LDR;
+        case 0x93B1: // COMPRESSED_RGBA_ASTC_5x4_KHR
+            return PixelFormat::ASTC_RGBA_5X4_LDR;
+        case 0x93B2: // COMPRESSED_RGBA_ASTC_5x5_KHR
+            return PixelFormat::ASTC_RGBA_5X5_LDR;
+        case 0x93B3: // COMPRESSED_RGBA_ASTC_6x5_KHR
+            return PixelFormat::ASTC_RGBA_6X5_LDR;
+        case 0x93B4: // COMPRESSED_RGBA_ASTC_6x6_KHR
+            return PixelFormat::ASTC_RGBA_6X6_LDR;
+        case 0x93B5: // COMPRESSED_RGBA_ASTC_8x5_KHR
+            return PixelFormat::ASTC_RGBA_8X5_LDR;
+        case 0x93B6: // COMPRESSED_RGBA_ASTC_8x6_KHR
+            return PixelFormat::ASTC_RGBA_8X6_LDR;
+        case 0x93B7: // COMPRESSED_RGBA_ASTC_8x8_KHR
+            return PixelFormat::ASTC_RGBA_8X8_LDR;
+        case 0x93B8: // COMPRESSED_RGBA_ASTC_10x5_KHR
+            return PixelFormat::ASTC_RGBA_10X5_LDR;
+        case 0x93B9: // COMPRESSED_RGBA_ASTC_10x6_KHR
+            return PixelFormat::ASTC_RGBA_10X6_LDR;
+        case 0x93BA: // COMPRESSED_RGBA_ASTC_10x8_KHR
+            return PixelFormat::ASTC_RGBA_10X8_LDR;
+        case 0x93BB: // COMPRESSED_RGBA_ASTC_10x10_KHR
+            return PixelFormat::ASTC_RGBA_10X10_LDR;
+        case 0x93BC: // COMPRESSED_RGBA_ASTC_12x10_KHR
+            return PixelFormat::ASTC_RGBA_12X10_LDR;
+        case 0x93BD: // COMPRESSED_RGBA_ASTC_12x12_KHR
+            return PixelFormat::ASTC_RGBA_12X12_LDR;
+        case 0x8D64: // GL_ETC1_RGB8_OES
+            return PixelFormat::ETC1_RGB8;
+        case 0x8C3A: // GL_R11F_G11F_B10F
+            return PixelFormat::R11G11B10_FLOAT;
+        default:
+            panic("Unsupported glInternalFormat in KTX file");
+    }
+    return PixelFormat::UNKNOWN;
+}
+
+void decode_pkm(DataStream& stream, Image* image)
+{
+    PKMHeader header;
+    read_exact(stream, &header, sizeof(header));
+
+    // ETC has no mip maps, the padded size follows from the block size
+    image->create(convert_pkm_format(header), read_u16_be(header.width), read_u16_be(header.height));
+    read_exact(stream, image->get_data(), image->get_size());
+}
+
+void decode_ktx(DataStream& stream, Image* image)
+{
+    KTXHeader header;
+    read_exact(stream, &header, sizeof(header));
+
+    bool swap = header.endianness == KTX_ENDIAN_REF_REV;
+    if (swap)
+        Bitwise::bswap_chunks(&header.endianness, sizeof(uint32_t), 13);
+    if (header.endianness != KTX_ENDIAN_REF)
+        panic("Invalid endianness in KTX file");
+    if (header.number_of_array_elements > 0)
+        panic("KTX texture arrays are not supported");
+
+    uint32_t levels = std::max(1u, header.number_of_mipmap_levels);
+    image->create(convert_gl_format(header.gl_internal_format),
+                  header.pixel_width,
+                  std::max(1u, header.pixel_height),
+                  std::max(1u, header.pixel_depth),
+                  header.number_of_faces,
+                  levels - 1);
+    stream.skip(long(header.bytes_of_key_value_data));
+
+    // the faces of a cube map level share the size field, which covers one face
+    for (uint32_t level = 0; level < levels; ++level) {
+        uint32_t image_size;
+        read_exact(stream, &image_size, sizeof(image_size));
+        if (swap)
+            image_size = Bitwise::bswap32(image_size);
+
+        for (uint32_t face = 0; face < header.number_of_faces; ++face) {
+            PixelBox box = image->get_pixel_box(face, level);
+            size_t size = std::min<size_t>(image_size, box.get_consecutive_size());
+            read_exact(stream, box.data, size);
+            // compressed data needs no padding, uncompressed rows are assumed to be packed
+            stream.skip(long(image_size - size));
+        }
+    }
+}
+
+} // namespace
+
+bool ETCCodec::is_pkm(const void* data, size_t size)
+{
+    return size >= 4 && memcmp(data, "PKM ", 4) == 0;
+}
+
+bool ETCCodec::is_ktx(const void* data, size_t size)
+{
+    return size >= sizeof(KTX_IDENTIFIER) && memcmp(data, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) == 0;
+}
+
+void ETCCodec::decode(const DataStreamPtr& stream, Image* image, bool decompress, Executor* executor)
+{
+    uint8_t magic[sizeof(KTX_IDENTIFIER)];
+    size_t start = stream->tell();
+    size_t count = stream->read(magic, sizeof(magic));
+    stream->seek(start);
+
+    if (is_pkm(magic, count))
+        decode_pkm(*stream, image);
+    else if (is_ktx(magic, count))
+        decode_ktx(*stream, image);
+    else
+        panic("This is not a PKM or KTX file!");
+
+    if (decompress && PixelUtil::is_compressed(image->get_format())) {
+        if (!PixelUtil::is_decompressible(image->get_format()))
+            panic("No decoder for pixel format " + PixelUtil::getFormatName(image->get_format()));
+        image->decompress(executor);
+    }
+}
+
+} // namespace hyue
@@ -0,0 +1,128 @@
+#include <hyue/FileInfoIndex.h>
+
+#include <algorithm>
+
+#include <hyue/StringUtils.h>
+
+namespace hyue {
+
+/// Characters with a special meaning in StringUtils::fnmatch patterns
+static const char* g_pattern_special_chars = "*?[\\";
+
+FileInfoIndex::FileInfoIndex(const String& root_dir)
+: root_dir_(root_dir)
+{
+}
+
+void FileInfoIndex::clear()
+{
+    children_.clear();
+    entries_.clear();
+}
+
+String FileInfoIndex::get_dir_key(const String& key)
+{
+    size_t pos = key.find_last_of('/');
+    if (pos == String::npos)
+        return "";
+    // keep the root of absolute paths
+    return key.substr(0, pos == 0 ? 1 : pos);
+}
+
+void FileInfoIndex::add(const String& key, const FileInfo& info)
+{
+    remove(key);
+
+    auto result = entries_.emplace(key, info);
+    children_[get_dir_key(key)].push_back(&*result.first);
+}
+
+void FileInfoIndex::remove(const String& key)
+{
+    auto it = entries_.find(key);
+    if (it == entries_.end())
+        return;
+
+    auto dir_it = children_.find(get_dir_key(key));
+    if (dir_it != children_.end()) {
+        auto& siblings = dir_it->second;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), &*it), siblings.end());
+        if (siblings.empty())
+            children_.erase(dir_it);
+    }
+
+    entries_.erase(it);
+}
+
+const FileInfo* FileInfoIndex::find(const String& key) const
+{
+    auto it = entries_.find(key);
+    return it == entries_.end() ? nullptr : &it->second;
+}
+
+void FileInfoIndex::for_each_dir_under(const String& dir,
+                                       bool recursive,
+                                       const std::function<void(const Entry*)>& callback) const
+{
+    if (!recursive) {
+        // only top level entries can match
+        auto it = children_.find(root_dir_);
+        if (it == children_.end())
+            return;
+        for (auto entry : it->second)
+            callback(entry);
+        return;
+    }
+
+    // keys of a subtree share the directory as prefix, so they form one range of the map
+    for (auto it = children_.lower_bound(dir);
+         it != children_.end() && (dir.empty() || it->first.compare(0, dir.size(), dir) == 0);
+         ++it) {
+        const String& key = it->first;
+        // skip siblings sharing the prefix, e.g. "ab" when looking under "a"
+        bool under = dir.empty() || key.size() == dir.size() || dir.back() == '/'
+                     || key[dir.size()] == '/';
+        if (!under)
+            continue;
+
+        for (auto entry : it->second)
+            callback(entry);
+    }
+}
+
+void FileInfoIndex::list(bool recursive, bool dirs, const Callback& callback) const
+{
+    for_each_dir_under("", recursive, [&](const Entry* entry) {
+        if (entry->second.is_dir == dirs)
+            callback(entry->second);
+    });
+}
+
+void FileInfoIndex::find(const String& pattern,
+                         bool recursive,
+                         bool dirs,
+                         const Callback& callback) const
+{
+    size_t wildcard = pattern.find_first_of(g_pattern_special_chars);
+
+    if (wildcard == String::npos) {
+        // no wildcards, the pattern only matches itself
+        const FileInfo* info = find(pattern);
+        if (info && info->is_dir == dirs && (recursive || get_dir_key(pattern) == root_dir_))
+            callback(*info);
+        return;
+    }
+
+    // any match lives below the directory part of the literal prefix
+    String dir;
+    size_t slash = pattern.find_last_of('/', wildcard);
+    if (slash != String::npos)
+        dir = pattern.substr(0, slash == 0 ? 1 : slash);
+
+    for_each_dir_under(dir, recursive, [&](const Entry* entry) {
+        if (entry->second.is_dir == dirs && StringUtils::fnmatch(entry->first, pattern))
+            callback(entry->second);
+    });
+}
+
+} // namespace hyue
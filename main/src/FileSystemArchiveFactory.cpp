@@ -4,14 +4,42 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <iterator>
+#include <unordered_map>
+
+#include <stdio.h>
+#include <string.h>
 
 #include <hyue/panic.h>
 #include <hyue/log.h>
 #include <hyue/StringUtils.h>
+#include <hyue/FileInfoIndex.h>
+#include <hyue/thread.h>
 
 namespace hyue {
 
+/// A file or subdirectory found in a directory
+struct DirEntry {
+    String name;
+    bool is_dir;
+    uint64_t size;
+};
+
+/// Contents of one directory of an archive
+struct DirListing {
+    /// Path relative to the archive, '/' separated, empty for the archive itself
+    String rel_path;
+    /// Modification time of the directory, 0 if it must be scanned again next time
+    int64_t mtime;
+    std::vector<DirEntry> entries;
+};
+
+/// Cached listings by relative path
+using ListingCache = std::unordered_map<String, DirListing>;
+
 class FileSystemArchive : public Archive {
 public:
     FileSystemArchive(const String& name, const String& arch_type, bool read_only);
@@ -55,34 +83,28 @@ public:
     bool exists(const String& filename) const override;
 
 private:
-    /** Utility method to retrieve all files in a directory matching pattern.
-    @param pattern
-        File pattern.
-    @param recursive
-        Whether to cascade down directories.
-    @param dirs
-        Set to @c true if you want the directories to be listed instead of files.
-    @param simple_list
-        Populated if retrieving a simple list.
-    @param detailList
-        Populated if retrieving a detailed list.
-    */
-    void find_files(const String& pattern,
-                    bool recursive,
-                    bool dirs,
-                    StringVector* simple_list,
-                    FileInfoList* detail_list) const;
-
-    void find_files_recursive(const FilePath& path,
-                              const String& pattern,
-                              bool recursive,
-                              bool dirs,
-                              StringVector* simple_list,
-                              FileInfoList* detail_list) const;
+    /// Add the entries of a scanned directory to index_
+    void index_listing(const DirListing& listing);
+
+    /// Add a single file or directory to index_
+    void index_file(const FilePath& path, bool is_dir);
+
+    /// Index key of a path inside this archive
+    static String get_index_key(const FilePath& path);
+
+    /// Every file and directory of the archive, built once in load()
+    FileInfoIndex index_;
 };
 
 bool g_ignore_hidden = true;
 
+// where archive listings are cached, empty if they are not
+String g_listing_cache_dir;
+
+// mapping has a fixed cost (page table setup, one fault per page), so small
+// files are cheaper to read through a plain stream
+size_t g_mmap_threshold = 1024 * 1024;
+
 FileSystemArchive::FileSystemArchive(const String& name, const String& arch_type, bool read_only)
 : Archive(name, arch_type)
 {
@@ -107,15 +129,311 @@ FileSystemArchive::~FileSystemArchive()
     unload();
 }
 
+//-----------------------------------------------------------------------
+// Directory scanning
+//-----------------------------------------------------------------------
+
+const char LISTING_CACHE_MAGIC[4] = {'H', 'Y', 'L', 'C'};
+const uint32_t LISTING_CACHE_VERSION = 1;
+
+/** Directories modified this close to the start of a scan are not cached, a
+    change right after it may not move their modification time on file systems
+    with coarse timestamps.
+*/
+const auto LISTING_CACHE_RACY_TIME = std::chrono::seconds(2);
+
+/// Cache file of an archive, named by a hash of its absolute path
+static String get_listing_cache_file(const String& root_key)
+{
+    // FNV-1a, stable across runs and builds
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : root_key)
+        hash = (hash ^ c) * 1099511628211ull;
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.listing", (unsigned long long)hash);
+    return (FilePath(g_listing_cache_dir) / name).string();
+}
+
+/// Read the cached listings of an archive, leaves cache empty if there are none
+static void read_listing_cache(const String& file, const String& root_key, ListingCache* cache)
+{
+    std::ifstream is(file, std::ios::binary);
+    if (!is)
+        return;
+    String data((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+    size_t pos = 0;
+    bool ok = true;
+    auto take = [&](void* dst, size_t size) {
+        if (!ok || data.size() - pos < size) {
+            ok = false;
+            return;
+        }
+        memcpy(dst, data.data() + pos, size);
+        pos += size;
+    };
+    auto take_string = [&](String* dst) {
+        uint32_t length = 0;
+        take(&length, sizeof(length));
+        if (!ok || data.size() - pos < length) {
+            ok = false;
+            return;
+        }
+        dst->assign(data, pos, length);
+        pos += length;
+    };
+
+    char magic[4] = {};
+    uint32_t version = 0;
+    uint8_t ignore_hidden = 0;
+    String root;
+    uint64_t count = 0;
+    take(magic, sizeof(magic));
+    take(&version, sizeof(version));
+    take(&ignore_hidden, sizeof(ignore_hidden));
+    take_string(&root);
+    take(&count, sizeof(count));
+    if (!ok || memcmp(magic, LISTING_CACHE_MAGIC, 4) != 0 || version != LISTING_CACHE_VERSION
+        || bool(ignore_hidden) != g_ignore_hidden || root != root_key)
+        return;
+
+    for (uint64_t i = 0; i < count && ok; ++i) {
+        DirListing listing;
+        uint64_t entries = 0;
+        take_string(&listing.rel_path);
+        take(&listing.mtime, sizeof(listing.mtime));
+        take(&entries, sizeof(entries));
+        for (uint64_t j = 0; j < entries && ok; ++j) {
+            DirEntry entry;
+            uint8_t is_dir = 0;
+            take_string(&entry.name);
+            take(&is_dir, sizeof(is_dir));
+            take(&entry.size, sizeof(entry.size));
+            entry.is_dir = is_dir != 0;
+            listing.entries.push_back(std::move(entry));
+        }
+        String key = listing.rel_path;
+        (*cache)[key] = std::move(listing);
+    }
+
+    if (!ok) {
+        LOG(warning) << "ignoring corrupt listing cache " + file;
+        cache->clear();
+    }
+}
+
+/// Replace the cached listings of an archive; failures only cost a rescan
+static void write_listing_cache(const String& file, const String& root_key, const std::vector<DirListing>& listings)
+{
+    String data;
+    auto put = [&](const void* src, size_t size) { data.append(static_cast<const char*>(src), size); };
+    auto put_string = [&](const String& str) {
+        uint32_t length = uint32_t(str.size());
+        put(&length, sizeof(length));
+        data += str;
+    };
+
+    uint8_t ignore_hidden = g_ignore_hidden;
+    uint64_t count = listings.size();
+    put(LISTING_CACHE_MAGIC, sizeof(LISTING_CACHE_MAGIC));
+    put(&LISTING_CACHE_VERSION, sizeof(LISTING_CACHE_VERSION));
+    put(&ignore_hidden, sizeof(ignore_hidden));
+    put_string(root_key);
+    put(&count, sizeof(count));
+    for (const DirListing& listing : listings) {
+        uint64_t entries = listing.entries.size();
+        put_string(listing.rel_path);
+        put(&listing.mtime, sizeof(listing.mtime));
+        put(&entries, sizeof(entries));
+        for (const DirEntry& entry : listing.entries) {
+            uint8_t is_dir = entry.is_dir;
+            put_string(entry.name);
+            put(&is_dir, sizeof(is_dir));
+            put(&entry.size, sizeof(entry.size));
+        }
+    }
+
+    // write a temporary file and rename it, so concurrent loads never see half a cache
+    std::error_code ec;
+    std_fs::create_directories(g_listing_cache_dir, ec);
+    String tmp_file = file + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream os(tmp_file, std::ios::binary | std::ios::trunc);
+        os.write(data.data(), data.size());
+        if (!os) {
+            LOG(warning) << "could not write listing cache " + file;
+            std_fs::remove(tmp_file, ec);
+            return;
+        }
+    }
+    std_fs::rename(tmp_file, file, ec);
+    if (ec) {
+        LOG(warning) << "could not write listing cache " + file;
+        std_fs::remove(tmp_file, ec);
+    }
+}
+
+/// Read the entries of one directory, or take them from the cache if it did not change
+static DirListing scan_directory(const FilePath& root,
+                                 const String& rel_path,
+                                 const ListingCache& cache,
+                                 std_fs::file_time_type racy_time,
+                                 bool* from_cache)
+{
+    FilePath path = rel_path.empty() ? root : root / rel_path;
+
+    DirListing listing;
+    listing.rel_path = rel_path;
+
+    std::error_code ec;
+    auto mtime = std_fs::last_write_time(path, ec);
+    listing.mtime = ec || mtime >= racy_time ? 0 : int64_t(mtime.time_since_epoch().count());
+
+    auto it = cache.find(rel_path);
+    if (listing.mtime != 0 && it != cache.end() && it->second.mtime == listing.mtime) {
+        listing.entries = it->second.entries;
+        *from_cache = true;
+        return listing;
+    }
+    *from_cache = false;
+
+    std_fs::directory_iterator dir_it(path, ec);
+    if (ec) {
+        LOG(warning) << "could not scan directory " + path.string() + ": " + ec.message();
+        listing.mtime = 0;
+        return listing;
+    }
+    for (const auto& entry : dir_it) {
+        String filename = entry.path().filename().u8string();
+        if (g_ignore_hidden && !filename.empty() && filename[0] == '.')
+            continue;
+        if (filename == "." || filename == "..")
+            continue;
+
+        // the type usually comes with the directory entry, only files need a stat
+        DirEntry dir_entry;
+        dir_entry.name = filename;
+        dir_entry.is_dir = entry.is_directory(ec);
+        if (!dir_entry.is_dir && !entry.is_regular_file(ec))
+            continue;
+        dir_entry.size = dir_entry.is_dir ? 0 : entry.file_size(ec);
+        if (ec)
+            dir_entry.size = 0;
+        listing.entries.push_back(std::move(dir_entry));
+    }
+    return listing;
+}
+
+/** List all directories below root, root included.
+
+    Directories are scanned in parallel on the I/O pool: every worker takes a
+    directory from a shared stack, lists it and pushes its subdirectories back,
+    so the walk spreads over the whole tree whatever its shape. Directories
+    whose modification time matches cache are not read but copied from it.
+@param changed Set if any directory was read instead of taken from the cache
+*/
+static std::vector<DirListing> scan_tree(const FilePath& root, const ListingCache& cache, bool* changed)
+{
+    ThreadPool& pool = ThreadPool::get_io_pool();
+    size_t jobs = pool.get_concurrency();
+    auto racy_time = std_fs::file_time_type::clock::now() - LISTING_CACHE_RACY_TIME;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<String> pending{""};
+    size_t active = 0;
+    std::vector<std::vector<DirListing>> results(jobs);
+    std::vector<char> rescanned(jobs, 0);
+
+    pool.parallel_for(jobs, [&](size_t job) {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            // done once nothing is pending and nobody can push more
+            cond.wait(lock, [&]() { return !pending.empty() || active == 0; });
+            if (pending.empty())
+                return;
+
+            String rel_path = std::move(pending.back());
+            pending.pop_back();
+            ++active;
+            lock.unlock();
+
+            bool from_cache = false;
+            DirListing listing;
+            try {
+                listing = scan_directory(root, rel_path, cache, racy_time, &from_cache);
+            } catch (...) {
+                // keep the walk consistent, parallel_for rethrows
+                lock.lock();
+                --active;
+                cond.notify_all();
+                throw;
+            }
+            if (!from_cache)
+                rescanned[job] = 1;
+
+            lock.lock();
+            for (const DirEntry& entry : listing.entries) {
+                if (entry.is_dir)
+                    pending.push_back(rel_path.empty() ? entry.name : rel_path + "/" + entry.name);
+            }
+            results[job].push_back(std::move(listing));
+            --active;
+            cond.notify_all();
+        }
+    });
+
+    *changed = std::find(rescanned.begin(), rescanned.end(), 1) != rescanned.end();
+
+    std::vector<DirListing> ret;
+    for (auto& listings : results) {
+        for (auto& listing : listings)
+            ret.push_back(std::move(listing));
+    }
+    return ret;
+}
+
 //-----------------------------------------------------------------------
 void FileSystemArchive::load()
 {
-    // nothing to do here
+    // the whole tree is scanned once, in parallel and through the listing
+    // cache if enabled; list(), find() and exists() only consult the index
+    index_.clear();
+    index_.set_root_dir(FileInfoIndex::get_dir_key(get_index_key(FilePath(name_) / "_")));
+
+    std::error_code ec;
+    if (!std_fs::is_directory(name_, ec))
+        return;
+
+    String cache_file;
+    String root_key;
+    ListingCache cache;
+    if (!g_listing_cache_dir.empty()) {
+        root_key = get_index_key(std_fs::absolute(name_, ec));
+        cache_file = get_listing_cache_file(root_key);
+        read_listing_cache(cache_file, root_key, &cache);
+    }
+
+    bool changed = false;
+    std::vector<DirListing> listings = scan_tree(name_, cache, &changed);
+    std::sort(listings.begin(), listings.end(), [](const DirListing& a, const DirListing& b) {
+        return a.rel_path < b.rel_path;
+    });
+    size_t count = 0;
+    for (const DirListing& listing : listings)
+        count += listing.entries.size();
+    index_.reserve(count);
+    for (const DirListing& listing : listings)
+        index_listing(listing);
+
+    if (!cache_file.empty() && (changed || listings.size() != cache.size()))
+        write_listing_cache(cache_file, root_key, listings);
 }
 
 void FileSystemArchive::unload()
 {
-    // nothing to see here, move along
+    index_.clear();
 }
 
 FilePath concatenate_path(const FilePath& base, const FilePath& name)
@@ -194,6 +512,16 @@ DataStreamPtr FileSystemArchive::open(const String& filename, bool read_only) co
     if (!read_only)
         mode |= std::ios::out;
 
+    if (read_only) {
+        String full_path = concatenate_path(name_, filename);
+        size_t file_size = get_file_size(full_path);
+        if (file_size > 0 && file_size >= g_mmap_threshold) {
+            DataStreamPtr stream = MappedFileDataStream::open(full_path, filename);
+            if (stream)
+                return stream;
+        }
+    }
+
     return open_file_stream(concatenate_path(name_, filename), mode, filename);
 }
 
@@ -219,6 +547,8 @@ DataStreamPtr FileSystemArchive::create(const String& filename)
         panic("Cannot open file: " + filename);
     }
 
+    index_file(full_path, false);
+
     /// Construct return stream, tell it to delete on destroy
     return std::make_shared<FileStreamDataStream>(filename, rw_stream, 0, true);
 }
@@ -229,112 +559,81 @@ void FileSystemArchive::remove(const String& filename)
         panic("Cannot remove a file from a read-only archive");
     }
     String full_path = concatenate_path(name_, filename);
-    ::remove(full_path.c_str());
+    if (::remove(full_path.c_str()) == 0)
+        index_.remove(get_index_key(full_path));
 }
 
 StringVector FileSystemArchive::list(bool recursive, bool dirs) const
 {
-    // directory change requires locking due to saved returns
     StringVector ret;
-    find_files("*", recursive, dirs, &ret, nullptr);
+    index_.list(recursive, dirs, [&ret](const FileInfo& f) { ret.push_back(f.filename); });
     return ret;
 }
 
-void FileSystemArchive::find_files_recursive(const FilePath& path,
-                                             const String& pattern,
-                                             bool recursive,
-                                             bool dirs,
-                                             StringVector* simple_list,
-                                             FileInfoList* detail_list) const
+String FileSystemArchive::get_index_key(const FilePath& path)
 {
+    String key = path.lexically_normal().generic_string();
+    if (key.size() > 1 && key.back() == '/')
+        key.pop_back();
+    return key;
+}
 
-    for (const auto& entry : std_fs::directory_iterator(path)) {
-
-        auto filename = entry.path().filename();
-        if (g_ignore_hidden) {
-            if ((!filename.empty()) && filename.u8string()[0] == '.') {
-                continue;
-            }
-        }
-
-        if (filename == "." || filename == "..")
-            continue;
-
-        auto entry_path = entry.path();
-
-        bool should_add = false;
-        bool is_dir = false;
-
-        if (std_fs::is_directory(entry.status())) {
-            if (recursive) {
-                find_files_recursive(entry_path,
-                                     pattern,
-                                     recursive,
-                                     dirs,
-                                     simple_list,
-                                     detail_list);
-            }
-
-            if (dirs) {
-                should_add = true;
-            }
-
-            is_dir = true;
-
-        } else if (std_fs::is_regular_file(entry.status())) {
-            if (!dirs) {
-                should_add = true;
-            }
-        }
-
-        should_add = should_add && StringUtils::fnmatch(entry_path, pattern);
-
-        // todo pattern
-        if (should_add) {
-            if (simple_list) {
-                simple_list->push_back(entry_path);
-            }
-
-            if (detail_list) {
-                auto file_size = get_file_size(entry_path);
-                FileInfo f_info;
-                f_info.archive = this;
-                f_info.filename = entry_path;
-                f_info.dir = entry_path.parent_path();
-                f_info.basename = entry_path.filename();
-                f_info.compressed_size = file_size;
-                f_info.uncompressed_size = file_size;
-                f_info.is_dir = is_dir;
-                detail_list->push_back(std::move(f_info));
-            }
-        }
+void FileSystemArchive::index_listing(const DirListing& listing)
+{
+    FilePath dir(name_);
+    if (!listing.rel_path.empty())
+        dir /= listing.rel_path;
+
+    // entry names hold no separators or dot components, so the paths and keys
+    // of the entries are those of the directory plus the name, without parsing
+    String dir_path = dir.string();
+    String parent_path = (dir / "_").parent_path().string();
+    String dir_key = get_index_key(dir);
+    if (!dir_path.empty() && dir_path.back() != '/')
+        dir_path += '/';
+    if (dir_key == ".")
+        dir_key.clear();
+    else if (!dir_key.empty() && dir_key.back() != '/')
+        dir_key += '/';
+
+    for (const DirEntry& entry : listing.entries) {
+        FileInfo f_info;
+        f_info.archive = this;
+        f_info.filename = dir_path + entry.name;
+        f_info.dir = parent_path;
+        f_info.basename = entry.name;
+        f_info.compressed_size = size_t(entry.size);
+        f_info.uncompressed_size = size_t(entry.size);
+        f_info.is_dir = entry.is_dir;
+        index_.add(dir_key + entry.name, f_info);
     }
 }
 
-void FileSystemArchive::find_files(const String& pattern,
-                                   bool recursive,
-                                   bool dirs,
-                                   StringVector* simple_list,
-                                   FileInfoList* detail_list) const
+void FileSystemArchive::index_file(const FilePath& path, bool is_dir)
 {
-    find_files_recursive(name_, pattern, recursive, dirs, simple_list, detail_list);
+    auto file_size = is_dir ? 0 : get_file_size(path);
+    FileInfo f_info;
+    f_info.archive = this;
+    f_info.filename = path;
+    f_info.dir = path.parent_path();
+    f_info.basename = path.filename();
+    f_info.compressed_size = file_size;
+    f_info.uncompressed_size = file_size;
+    f_info.is_dir = is_dir;
+    index_.add(get_index_key(path), f_info);
 }
 
 FileInfoList FileSystemArchive::list_file_info(bool recursive, bool dirs) const
 {
     FileInfoList ret;
-
-    find_files("*", recursive, dirs, nullptr, &ret);
-
+    index_.list(recursive, dirs, [&ret](const FileInfo& f) { ret.push_back(f); });
     return ret;
 }
 
 StringVector FileSystemArchive::find(const String& pattern, bool recursive, bool dirs) const
 {
     StringVector ret;
-
-    find_files(pattern, recursive, dirs, &ret, nullptr);
-
+    index_.find(pattern, recursive, dirs, [&ret](const FileInfo& f) { ret.push_back(f.filename); });
     return ret;
 }
 
@@ -343,9 +642,7 @@ FileInfoList FileSystemArchive::find_file_info(const String& pattern,
                                                bool dirs) const
 {
     FileInfoList ret;
-
-    find_files(pattern, recursive, dirs, nullptr, &ret);
-
+    index_.find(pattern, recursive, dirs, [&ret](const FileInfo& f) { ret.push_back(f); });
     return ret;
 }
 
@@ -354,24 +651,8 @@ bool FileSystemArchive::exists(const String& filename) const
     if (filename.empty())
         return false;
 
-    String full_path = concatenate_path(name_, filename);
-
-    struct stat st;
-    bool ret = (stat(full_path.c_str(), &st) == 0);
-
-    // stat will return true if the filename is absolute, but we need to check
-    // the file is actually in this archive
-    if (ret && is_absolute_path(filename)) {
-        // only valid if full path starts with our base
-        if (is_case_sensitive()) {
-            ret = StringUtils::starts_with(full_path, name_, false);
-        } else {
-
-            ret = StringUtils::starts_with(full_path, name_, true);
-        }
-    }
-
-    return ret;
+    // absolute names outside of the archive are simply not in the index
+    return index_.exists(get_index_key(concatenate_path(name_, filename)));
 }
 
 //-----------------------------------------------------------------------
@@ -398,4 +679,24 @@ bool FileSystemArchiveFactory::is_ignore_hidden()
     return g_ignore_hidden;
 }
 
+void FileSystemArchiveFactory::set_listing_cache_dir(const String& dir)
+{
+    g_listing_cache_dir = dir;
+}
+
+const String& FileSystemArchiveFactory::get_listing_cache_dir()
+{
+    return g_listing_cache_dir;
+}
+
+void FileSystemArchiveFactory::set_mmap_threshold(size_t threshold)
+{
+    g_mmap_threshold = threshold;
+}
+
+size_t FileSystemArchiveFactory::get_mmap_threshold()
+{
+    return g_mmap_threshold;
+}
+
 } // namespace hyue
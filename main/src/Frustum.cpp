@@ -0,0 +1,52 @@
+#include <hyue/Frustum.h>
+
+#include <cmath>
+
+namespace hyue {
+
+//-----------------------------------------------------------------------
+Frustum Frustum::from_view_projection(const mat4& m)
+{
+    // a clip space point is inside when -w <= x, y, z <= w, each inequality
+    // is a plane made of the fourth row plus or minus another one
+    static const struct {
+        int row;
+        float sign;
+    } rows[6] = {
+        {2, 1},  // near:   w + z >= 0
+        {2, -1}, // far:    w - z >= 0
+        {0, 1},  // left:   w + x >= 0
+        {0, -1}, // right:  w - x >= 0
+        {1, -1}, // top:    w - y >= 0
+        {1, 1},  // bottom: w + y >= 0
+    };
+
+    Frustum ret;
+    for (int i = 0; i < 6; ++i) {
+        float p[4];
+        for (int c = 0; c < 4; ++c)
+            p[c] = m.a[3][c] + rows[i].sign * m.a[rows[i].row][c];
+
+        float length = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        float inv = length > 0 ? 1 / length : 0;
+        ret.planes[i].normal = vec3{p[0] * inv, p[1] * inv, p[2] * inv};
+        ret.planes[i].d = p[3] * inv;
+    }
+    return ret;
+}
+
+//-----------------------------------------------------------------------
+bool Frustum::is_visible(const vec3& center, const vec3& half_size) const
+{
+    for (auto& plane : planes) {
+        float distance = plane.get_distance(center);
+        float max_abs_distance = std::abs(plane.normal.a[0] * half_size.a[0])
+                                 + std::abs(plane.normal.a[1] * half_size.a[1])
+                                 + std::abs(plane.normal.a[2] * half_size.a[2]);
+        if (distance < -max_abs_distance)
+            return false;
+    }
+    return true;
+}
+
+} // namespace hyue
@@ -0,0 +1,87 @@
+#include <hyue/Image.h>
+
+#include <algorithm>
+
+#include <hyue/panic.h>
+
+namespace hyue {
+
+Image::Image()
+: format_(PixelFormat::UNKNOWN),
+  width_(0),
+  height_(0),
+  depth_(0),
+  num_faces_(0),
+  num_mipmaps_(0)
+{
+}
+
+void Image::create(PixelFormat format,
+                   uint32_t width,
+                   uint32_t height,
+                   uint32_t depth,
+                   uint32_t num_faces,
+                   uint32_t num_mipmaps)
+{
+    HYUE_ASSERT(num_faces == 1 || num_faces == 6, "Images have either 1 or 6 faces");
+    HYUE_ASSERT(num_faces == 1 || depth == 1, "Cube maps can not have depth");
+
+    format_ = format;
+    width_ = width;
+    height_ = height;
+    depth_ = depth;
+    num_faces_ = num_faces;
+    num_mipmaps_ = num_mipmaps;
+    buffer_.assign(calculate_size(num_mipmaps, num_faces, width, height, depth, format), 0);
+}
+
+PixelBox Image::get_pixel_box(size_t face, size_t mipmap) const
+{
+    HYUE_ASSERT(face < num_faces_ && mipmap <= num_mipmaps_, "Face or mipmap out of range");
+
+    size_t face_size = calculate_size(num_mipmaps_, 1, width_, height_, depth_, format_);
+    size_t offset = face * face_size;
+
+    uint32_t width = width_, height = height_, depth = depth_;
+    for (size_t mip = 0; mip < mipmap; ++mip) {
+        offset += PixelUtil::get_memory_size(int(width), int(height), int(depth), format_);
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        depth = std::max(1u, depth / 2);
+    }
+
+    return PixelBox(int(width), int(height), int(depth), format_, const_cast<uint8_t*>(buffer_.data()) + offset);
+}
+
+void Image::decompress(Executor* executor)
+{
+    Image decoded;
+    decoded.create(PixelFormat::BYTE_RGBA, width_, height_, depth_, num_faces_, num_mipmaps_);
+    for (uint32_t face = 0; face < num_faces_; ++face) {
+        for (uint32_t mip = 0; mip <= num_mipmaps_; ++mip) {
+            PixelBox src = get_pixel_box(face, mip);
+            PixelBox dst = decoded.get_pixel_box(face, mip);
+            PixelUtil::decompress(&src, &dst, executor);
+        }
+    }
+    std::swap(*this, decoded);
+}
+
+size_t Image::calculate_size(uint32_t num_mipmaps,
+                             uint32_t num_faces,
+                             uint32_t width,
+                             uint32_t height,
+                             uint32_t depth,
+                             PixelFormat format)
+{
+    size_t size = 0;
+    for (uint32_t mip = 0; mip <= num_mipmaps; ++mip) {
+        size += PixelUtil::get_memory_size(int(width), int(height), int(depth), format) * num_faces;
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        depth = std::max(1u, depth / 2);
+    }
+    return size;
+}
+
+} // namespace hyue
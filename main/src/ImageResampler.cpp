@@ -0,0 +1,500 @@
+#include <hyue/ImageResampler.h>
+
+#include <cmath>
+
+#include <hyue/panic.h>
+
+#include "simd_intrinsics.h"
+
+namespace hyue {
+
+namespace {
+
+/// Filtering works on 4 floats per pixel, in RGBA order
+const size_t CHANNELS = 4;
+
+struct FilterKernel {
+    /// Radius of the kernel at unit scale
+    float support;
+    float (*weight)(float x);
+};
+
+float box_weight(float x)
+{
+    // half open, so a pixel on the edge between two cells is counted once
+    return (x >= -0.5f && x < 0.5f) ? 1.0f : 0.0f;
+}
+
+float triangle_weight(float x)
+{
+    x = std::fabs(x);
+    return x < 1.0f ? 1.0f - x : 0.0f;
+}
+
+float sinc(float x)
+{
+    if (std::fabs(x) < 1e-6f)
+        return 1.0f;
+    x *= float(M_PI);
+    return std::sin(x) / x;
+}
+
+float lanczos3_weight(float x)
+{
+    return std::fabs(x) < 3.0f ? sinc(x) * sinc(x / 3.0f) : 0.0f;
+}
+
+FilterKernel get_filter_kernel(ResampleFilter filter)
+{
+    switch (filter) {
+        case ResampleFilter::BOX:
+            return {0.5f, &box_weight};
+        case ResampleFilter::BILINEAR:
+            return {1.0f, &triangle_weight};
+        case ResampleFilter::LANCZOS3:
+            return {3.0f, &lanczos3_weight};
+    }
+    panic("unknown resample filter");
+    return {0.0f, nullptr};
+}
+
+/** Filter taps along one axis.
+
+    Destination pixel i blends count[i] source pixels starting at first[i], with
+    the weights at weights[i * max_taps]. Taps outside the source are folded
+    onto the edge pixels (clamp to edge), and the weights are normalised.
+*/
+struct AxisTaps {
+    std::vector<size_t> first;
+    std::vector<size_t> count;
+    std::vector<float> weights;
+    size_t max_taps;
+
+    AxisTaps(size_t src_size, size_t dst_size, const FilterKernel& kernel)
+    {
+        // widen the kernel when shrinking, so every source pixel contributes
+        float scale = float(dst_size) / float(src_size);
+        float filter_scale = std::max(1.0f, 1.0f / scale);
+        float support = std::max(kernel.support * filter_scale, 0.5f);
+
+        max_taps = size_t(std::ceil(support * 2)) + 1;
+        first.resize(dst_size);
+        count.resize(dst_size);
+        weights.assign(dst_size * max_taps, 0.0f);
+
+        // weights of one destination pixel before trimming and normalising
+        std::vector<float> row(max_taps + 2);
+
+        for (size_t i = 0; i < dst_size; ++i) {
+            float center = (float(i) + 0.5f) / scale;
+            long begin = long(std::floor(center - support));
+            long end = long(std::ceil(center + support));
+
+            size_t tap_begin = size_t(std::clamp(begin, 0L, long(src_size) - 1));
+            size_t tap_end = size_t(std::clamp(end, 0L, long(src_size) - 1));
+            std::fill(row.begin(), row.end(), 0.0f);
+
+            float total = 0;
+            for (long s = begin; s <= end; ++s) {
+                float value = kernel.weight((float(s) + 0.5f - center) / filter_scale);
+                size_t tap = size_t(std::clamp(s, long(tap_begin), long(tap_end)));
+                row[tap - tap_begin] += value;
+                total += value;
+            }
+
+            // the range is rounded outwards, drop the taps that got no weight
+            size_t lo = 0, hi = tap_end - tap_begin;
+            while (lo < hi && row[lo] == 0.0f)
+                ++lo;
+            while (hi > lo && row[hi] == 0.0f)
+                --hi;
+
+            // a box narrower than a pixel can fall between samples, take the nearest
+            if (total == 0.0f) {
+                tap_begin = std::min(size_t(center), src_size - 1);
+                lo = hi = 0;
+                row[0] = total = 1.0f;
+            }
+
+            HYUE_ASSERT(hi - lo < max_taps, "filter taps overflow");
+            float* w = &weights[i * max_taps];
+            for (size_t k = lo; k <= hi; ++k)
+                w[k - lo] = row[k] / total;
+
+            tap_begin += lo;
+            tap_end = tap_begin + hi - lo;
+            first[i] = tap_begin;
+            count[i] = tap_end - tap_begin + 1;
+        }
+    }
+};
+
+/// Horizontal pass: dst pixel x blends the source pixels under its taps
+void filter_row(const float* src, float* dst, const AxisTaps& taps)
+{
+    for (size_t x = 0; x < taps.first.size(); ++x) {
+        const float* s = src + taps.first[x] * CHANNELS;
+        const float* w = &taps.weights[x * taps.max_taps];
+        size_t n = taps.count[x];
+#if HYUE_SIMD_SSE2
+        __m128 acc = _mm_mul_ps(_mm_set1_ps(w[0]), _mm_loadu_ps(s));
+        for (size_t k = 1; k < n; ++k)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(s + k * CHANNELS)));
+        _mm_storeu_ps(dst + x * CHANNELS, acc);
+#else
+        float acc[CHANNELS] = {};
+        for (size_t k = 0; k < n; ++k)
+            for (size_t c = 0; c < CHANNELS; ++c)
+                acc[c] += w[k] * s[k * CHANNELS + c];
+        std::copy(acc, acc + CHANNELS, dst + x * CHANNELS);
+#endif
+    }
+}
+
+/// Vertical pass: dst = sum of rows[k] * weights[k], over size floats
+void blend_rows(const float* const* rows, const float* weights, size_t n, float* dst, size_t size)
+{
+    size_t i = 0;
+#if HYUE_SIMD_SSE2
+    for (; i + 4 <= size; i += 4) {
+        __m128 acc = _mm_mul_ps(_mm_set1_ps(weights[0]), _mm_loadu_ps(rows[0] + i));
+        for (size_t k = 1; k < n; ++k)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i)));
+        _mm_storeu_ps(dst + i, acc);
+    }
+#endif
+    for (; i < size; ++i) {
+        float acc = 0;
+        for (size_t k = 0; k < n; ++k)
+            acc += weights[k] * rows[k][i];
+        dst[i] = acc;
+    }
+}
+
+/// 8 bit RGBA (A8B8G8R8 memory order) to float RGBA
+void bytes_to_float(const uint8_t* src, float* dst, size_t count)
+{
+    size_t i = 0;
+#if HYUE_SIMD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+    for (; i + 16 <= count; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_ps(dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+        _mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+        _mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = src[i] * (1.0f / 255.0f);
+}
+
+/// float RGBA to 8 bit RGBA, clamped and rounded
+void float_to_bytes(const float* src, uint8_t* dst, size_t count)
+{
+    size_t i = 0;
+#if HYUE_SIMD_SSE2
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    auto to_int = [&](const float* p) {
+        __m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(p), scale), half);
+        return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(v, zero), scale));
+    };
+    for (; i + 16 <= count; i += 16) {
+        __m128i lo = _mm_packs_epi32(to_int(src + i), to_int(src + i + 4));
+        __m128i hi = _mm_packs_epi32(to_int(src + i + 8), to_int(src + i + 12));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = uint8_t(std::clamp(src[i] * 255.0f + 0.5f, 0.0f, 255.0f));
+}
+
+/// Whether a format goes through 8 bit RGBA instead of converting to float directly
+bool is_byte_format(PixelFormat format)
+{
+    return PixelUtil::get_component_type(format) == PixelComponentType::BYTE;
+}
+
+/// One row of a PixelBox
+PixelBox get_row(const PixelBox& box, size_t y, size_t z)
+{
+    return box.get_sub_volume(
+        Box(box.left, box.top + y, box.front + z, box.right, box.top + y + 1, box.front + z + 1), false);
+}
+
+/// Read row y of slice z of a PixelBox as float RGBA
+void read_row(const PixelBox& box, size_t y, size_t z, float* dst, std::vector<uint8_t>* scratch)
+{
+    PixelBox src = get_row(box, y, z);
+    size_t width = box.get_width();
+
+    if (is_byte_format(box.format)) {
+        scratch->resize(width * CHANNELS);
+        PixelBox bytes(width, 1, 1, PixelFormat::A8B8G8R8, scratch->data());
+        PixelUtil::bulk_pixel_conversion(&src, &bytes);
+        bytes_to_float(scratch->data(), dst, width * CHANNELS);
+    } else {
+        PixelBox floats(width, 1, 1, PixelFormat::FLOAT32_RGBA, dst);
+        PixelUtil::bulk_pixel_conversion(&src, &floats);
+    }
+}
+
+/// Write float RGBA to row y of slice z of a PixelBox
+void write_row(const PixelBox& box, size_t y, size_t z, const float* src, std::vector<uint8_t>* scratch)
+{
+    PixelBox dst = get_row(box, y, z);
+    size_t width = box.get_width();
+
+    if (is_byte_format(box.format)) {
+        scratch->resize(width * CHANNELS);
+        float_to_bytes(src, scratch->data(), width * CHANNELS);
+        PixelBox bytes(width, 1, 1, PixelFormat::A8B8G8R8, scratch->data());
+        PixelUtil::bulk_pixel_conversion(&bytes, &dst);
+    } else {
+        PixelBox floats(width, 1, 1, PixelFormat::FLOAT32_RGBA, const_cast<float*>(src));
+        PixelUtil::bulk_pixel_conversion(&floats, &dst);
+    }
+}
+
+/// Produces the float RGBA rows of an image one after another
+class RowStage {
+public:
+    RowStage(size_t width, size_t height) : width_(width), height_(height), next_(0) { }
+    virtual ~RowStage() { }
+
+    size_t get_width() const
+    {
+        return width_;
+    }
+
+    /// Whether all rows were produced
+    bool done() const
+    {
+        return next_ == height_;
+    }
+
+    /// The next row; valid until the following call
+    const float* next_row()
+    {
+        HYUE_ASSERT(!done(), "no rows left");
+        return produce_row(next_++);
+    }
+
+protected:
+    virtual const float* produce_row(size_t y) = 0;
+
+    size_t width_;
+    size_t height_;
+    size_t next_;
+};
+
+/// Rows of a slice of a PixelBox
+class PixelBoxStage : public RowStage {
+public:
+    PixelBoxStage(const PixelBox& box, size_t z)
+    : RowStage(box.get_width(), box.get_height()),
+      box_(box),
+      z_(z),
+      row_(box.get_width() * CHANNELS)
+    {
+    }
+
+protected:
+    const float* produce_row(size_t y) override
+    {
+        read_row(box_, y, z_, row_.data(), &scratch_);
+        return row_.data();
+    }
+
+private:
+    PixelBox box_;
+    size_t z_;
+    std::vector<float> row_;
+    std::vector<uint8_t> scratch_;
+};
+
+/** Rows of another stage resampled to a new size.
+
+    Input rows are filtered horizontally as they arrive and kept in a ring
+    of max_taps rows, every output row blends the window of that ring under
+    its vertical taps. Each output row is optionally written to a PixelBox.
+*/
+class ResampleStage : public RowStage {
+public:
+    ResampleStage(RowStage* input, size_t width, size_t height, size_t input_height, const FilterKernel& kernel)
+    : RowStage(width, height),
+      input_(input),
+      x_taps_(input->get_width(), width, kernel),
+      y_taps_(input_height, height, kernel),
+      ring_(y_taps_.max_taps * width * CHANNELS),
+      rows_(y_taps_.max_taps),
+      input_rows_(0),
+      row_(width * CHANNELS),
+      output_(nullptr)
+    {
+    }
+
+    /// Also write every produced row to slice z of box
+    void set_output(const PixelBox* box, size_t z)
+    {
+        output_ = box;
+        output_z_ = z;
+    }
+
+protected:
+    const float* produce_row(size_t y) override
+    {
+        size_t first = y_taps_.first[y];
+        size_t count = y_taps_.count[y];
+
+        while (input_rows_ < first + count) {
+            filter_row(input_->next_row(), get_ring_row(input_rows_), x_taps_);
+            ++input_rows_;
+        }
+
+        for (size_t k = 0; k < count; ++k)
+            rows_[k] = get_ring_row(first + k);
+        blend_rows(rows_.data(), &y_taps_.weights[y * y_taps_.max_taps], count, row_.data(), row_.size());
+
+        if (output_)
+            write_row(*output_, y, output_z_, row_.data(), &scratch_);
+        return row_.data();
+    }
+
+private:
+    float* get_ring_row(size_t input_y)
+    {
+        return &ring_[(input_y % y_taps_.max_taps) * width_ * CHANNELS];
+    }
+
+    RowStage* input_;
+    AxisTaps x_taps_;
+    AxisTaps y_taps_;
+    std::vector<float> ring_;
+    /// Ring rows under the taps of the row being produced
+    std::vector<const float*> rows_;
+    size_t input_rows_;
+    std::vector<float> row_;
+    const PixelBox* output_;
+    size_t output_z_;
+    std::vector<uint8_t> scratch_;
+};
+
+/// Rows of a slice kept in memory as float RGBA
+class MemoryStage : public RowStage {
+public:
+    MemoryStage(const float* data, size_t width, size_t height)
+    : RowStage(width, height),
+      data_(data)
+    {
+    }
+
+protected:
+    const float* produce_row(size_t y) override
+    {
+        return data_ + y * width_ * CHANNELS;
+    }
+
+private:
+    const float* data_;
+};
+
+/// Scale one slice of src to width x height float RGBA
+std::vector<float> scale_slice(const PixelBox& src, size_t z, size_t width, size_t height, const FilterKernel& kernel)
+{
+    PixelBoxStage input(src, z);
+    ResampleStage stage(&input, width, height, src.get_height(), kernel);
+
+    std::vector<float> ret(width * height * CHANNELS);
+    for (size_t y = 0; y < height; ++y) {
+        const float* row = stage.next_row();
+        std::copy(row, row + width * CHANNELS, &ret[y * width * CHANNELS]);
+    }
+    return ret;
+}
+
+} // namespace
+
+void ImageResampler::scale(const PixelBox& src, const PixelBox& dst, ResampleFilter filter)
+{
+    HYUE_ASSERT(!PixelUtil::is_compressed(src.format) && !PixelUtil::is_compressed(dst.format),
+                "can not scale compressed pixel data");
+
+    FilterKernel kernel = get_filter_kernel(filter);
+    size_t width = dst.get_width(), height = dst.get_height();
+
+    if (src.get_depth() == 1 && dst.get_depth() == 1) {
+        PixelBoxStage input(src, 0);
+        ResampleStage stage(&input, width, height, src.get_height(), kernel);
+        stage.set_output(&dst, 0);
+        while (!stage.done())
+            stage.next_row();
+        return;
+    }
+
+    // volumes: scale every source slice in 2D, then filter across slices
+    std::vector<std::vector<float>> slices;
+    for (size_t z = 0; z < src.get_depth(); ++z)
+        slices.push_back(scale_slice(src, z, width, height, kernel));
+
+    AxisTaps z_taps(src.get_depth(), dst.get_depth(), kernel);
+    std::vector<const float*> rows(z_taps.max_taps);
+    std::vector<float> row(width * CHANNELS);
+    std::vector<uint8_t> scratch;
+    for (size_t z = 0; z < dst.get_depth(); ++z) {
+        size_t count = z_taps.count[z];
+        for (size_t y = 0; y < height; ++y) {
+            for (size_t k = 0; k < count; ++k)
+                rows[k] = &slices[z_taps.first[z] + k][y * width * CHANNELS];
+            blend_rows(rows.data(), &z_taps.weights[z * z_taps.max_taps], count, row.data(), row.size());
+            write_row(dst, y, z, row.data(), &scratch);
+        }
+    }
+}
+
+void ImageResampler::generate_mipmaps(const PixelBox& src, const std::vector<PixelBox>& mips, ResampleFilter filter)
+{
+    if (mips.empty())
+        return;
+
+    bool is_2d = src.get_depth() == 1;
+    for (auto& mip : mips)
+        is_2d = is_2d && mip.get_depth() == 1;
+
+    if (!is_2d) {
+        // volumes go level by level through scale()
+        scale(src, mips[0], filter);
+        for (size_t i = 1; i < mips.size(); ++i)
+            scale(mips[i - 1], mips[i], filter);
+        return;
+    }
+
+    FilterKernel kernel = get_filter_kernel(filter);
+
+    // chain of stages, each level pulls rows from the one above as it needs them
+    std::vector<std::unique_ptr<RowStage>> stages;
+    stages.push_back(std::make_unique<PixelBoxStage>(src, 0));
+    size_t input_height = src.get_height();
+    for (auto& mip : mips) {
+        auto stage = std::make_unique<ResampleStage>(
+            stages.back().get(), mip.get_width(), mip.get_height(), input_height, kernel);
+        stage->set_output(&mip, 0);
+        input_height = mip.get_height();
+        stages.push_back(std::move(stage));
+    }
+
+    // running the last level produces almost everything, then finish the
+    // trailing rows of the others bottom up, as draining a level may pull
+    // rows from the level above it
+    for (size_t i = stages.size() - 1; i > 0; --i) {
+        while (!stages[i]->done())
+            stages[i]->next_row();
+    }
+}
+
+} // namespace hyue
@@ -0,0 +1,230 @@
+#include <hyue/Node.h>
+
+#include <algorithm>
+
+#include <hyue/panic.h>
+
+namespace hyue {
+
+using boost::qvm::operator*;
+
+//-----------------------------------------------------------------------
+Node::Node(TransformHierarchy* hierarchy, const String& name)
+    : hierarchy_(hierarchy)
+    , handle_(hierarchy->create())
+    , name_(name)
+{
+}
+
+Node::~Node()
+{
+    if (parent_)
+        parent_->remove_child(this);
+    for (auto child : children_)
+        child->parent_ = nullptr;
+    hierarchy_->destroy(handle_);
+}
+
+//-----------------------------------------------------------------------
+std::unique_ptr<Node> Node::create_child(const String& name, const vec3& translate, const quat& rotate)
+{
+    auto ret = std::make_unique<Node>(hierarchy_, name);
+    ret->set_position(translate);
+    ret->set_orientation(rotate);
+    add_child(ret.get());
+    return ret;
+}
+
+//-----------------------------------------------------------------------
+void Node::add_child(Node* child)
+{
+    HYUE_ASSERT(!child->parent_, "node '" + child->name_ + "' already has a parent");
+    HYUE_ASSERT(child->hierarchy_ == hierarchy_, "nodes of different hierarchies cannot be linked");
+
+    hierarchy_->set_parent(child->handle_, handle_);
+    child->parent_ = this;
+    children_.push_back(child);
+}
+
+//-----------------------------------------------------------------------
+void Node::remove_child(Node* child)
+{
+    auto it = std::find(children_.begin(), children_.end(), child);
+    if (it == children_.end())
+        return;
+
+    hierarchy_->set_parent(child->handle_, TransformHierarchy::NONE);
+    child->parent_ = nullptr;
+    children_.erase(it);
+}
+
+//-----------------------------------------------------------------------
+void Node::remove_all_children()
+{
+    for (auto child : children_) {
+        hierarchy_->set_parent(child->handle_, TransformHierarchy::NONE);
+        child->parent_ = nullptr;
+    }
+    children_.clear();
+}
+
+//-----------------------------------------------------------------------
+Node* Node::get_child(size_t index) const
+{
+    HYUE_ASSERT(index < children_.size(), "child index out of bounds");
+    return children_[index];
+}
+
+Node* Node::get_child(const String& name) const
+{
+    for (auto child : children_) {
+        if (child->name_ == name)
+            return child;
+    }
+    return nullptr;
+}
+
+//-----------------------------------------------------------------------
+void Node::set_position(const vec3& position)
+{
+    hierarchy_->set_position(handle_, position);
+}
+
+vec3 Node::get_position() const
+{
+    return hierarchy_->get_position(handle_);
+}
+
+void Node::set_orientation(const quat& orientation)
+{
+    hierarchy_->set_orientation(handle_, orientation);
+}
+
+quat Node::get_orientation() const
+{
+    return hierarchy_->get_orientation(handle_);
+}
+
+void Node::reset_orientation()
+{
+    set_orientation(boost::qvm::identity_quat<float>());
+}
+
+void Node::set_scale(const vec3& scale)
+{
+    hierarchy_->set_scale(handle_, scale);
+}
+
+vec3 Node::get_scale() const
+{
+    return hierarchy_->get_scale(handle_);
+}
+
+void Node::set_inherit_orientation(bool inherit)
+{
+    hierarchy_->set_inherit_orientation(handle_, inherit);
+}
+
+bool Node::get_inherit_orientation() const
+{
+    return hierarchy_->get_inherit_orientation(handle_);
+}
+
+void Node::set_inherit_scale(bool inherit)
+{
+    hierarchy_->set_inherit_scale(handle_, inherit);
+}
+
+bool Node::get_inherit_scale() const
+{
+    return hierarchy_->get_inherit_scale(handle_);
+}
+
+//-----------------------------------------------------------------------
+void Node::scale(const vec3& scale)
+{
+    vec3 s = get_scale();
+    for (int i = 0; i < 3; ++i)
+        s.a[i] *= scale.a[i];
+    set_scale(s);
+}
+
+//-----------------------------------------------------------------------
+void Node::translate(const vec3& d, TransformSpace relative_to)
+{
+    vec3 move = d;
+    switch (relative_to) {
+        case TS_LOCAL:
+            // position is relative to parent so transform downwards
+            move = get_orientation() * d;
+            break;
+        case TS_WORLD:
+            // position is relative to parent so transform upwards
+            if (parent_) {
+                move = boost::qvm::inverse(parent_->get_derived_orientation()) * d;
+                vec3 parent_scale = parent_->get_derived_scale();
+                for (int i = 0; i < 3; ++i)
+                    move.a[i] /= parent_scale.a[i];
+            }
+            break;
+        case TS_PARENT:
+            break;
+    }
+
+    vec3 position = get_position();
+    for (int i = 0; i < 3; ++i)
+        position.a[i] += move.a[i];
+    set_position(position);
+}
+
+//-----------------------------------------------------------------------
+void Node::rotate(const quat& q, TransformSpace relative_to)
+{
+    // normalise quaternion to avoid drift
+    quat qnorm = boost::qvm::normalized(q);
+
+    switch (relative_to) {
+        case TS_PARENT:
+            // rotations are normally relative to local axes, transform up
+            set_orientation(qnorm * get_orientation());
+            break;
+        case TS_WORLD: {
+            // rotations are normally relative to local axes, transform up
+            quat derived = get_derived_orientation();
+            set_orientation(get_orientation() * boost::qvm::inverse(derived) * qnorm * derived);
+            break;
+        }
+        case TS_LOCAL:
+            // note the order of the mult, i.e. q comes after
+            set_orientation(get_orientation() * qnorm);
+            break;
+    }
+}
+
+void Node::rotate(const vec3& axis, float radians, TransformSpace relative_to)
+{
+    rotate(boost::qvm::rot_quat(axis, radians), relative_to);
+}
+
+//-----------------------------------------------------------------------
+vec3 Node::get_derived_position() const
+{
+    return hierarchy_->get_derived_position(handle_);
+}
+
+quat Node::get_derived_orientation() const
+{
+    return hierarchy_->get_derived_orientation(handle_);
+}
+
+vec3 Node::get_derived_scale() const
+{
+    return hierarchy_->get_derived_scale(handle_);
+}
+
+mat4 Node::get_full_transform() const
+{
+    return hierarchy_->get_world_matrix(handle_);
+}
+
+} // namespace hyue
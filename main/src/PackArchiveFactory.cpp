@@ -0,0 +1,501 @@
+#include <hyue/PackArchiveFactory.h>
+
+#include <hyue/FileSystemArchiveFactory.h>
+#include <hyue/StringUtils.h>
+#include <hyue/FileInfoIndex.h>
+#include <hyue/log.h>
+#include <hyue/panic.h>
+
+#include "lz4_block.h"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <string_view>
+
+#include <string.h>
+
+namespace hyue {
+
+/* Pack layout, all integers little endian:
+
+    header (PACK_HEADER_SIZE bytes)
+        char[4]  magic "HYPK"
+        uint32   version
+        uint32   entry count
+        uint32   alignment of the stored entries
+        uint64   offset of the names
+        uint64   size of the names
+    table of contents, one PACK_ENTRY_SIZE record per entry sorted by name
+        uint64   offset of the data
+        uint64   size of the data in the pack
+        uint64   uncompressed size
+        uint32   offset of the name within the names
+        uint32   length of the name
+        uint32   compression, a PackWriter::Compression
+        uint32   reserved, 0
+    names, without terminators
+    data, from the first page boundary after the names
+*/
+const char PACK_MAGIC[4] = {'H', 'Y', 'P', 'K'};
+const uint32_t PACK_VERSION = 1;
+const size_t PACK_HEADER_SIZE = 32;
+const size_t PACK_ENTRY_SIZE = 40;
+const size_t PACK_PAGE_SIZE = 4096;
+/// Alignment of compressed entries, which are never used in place
+const size_t PACK_LZ4_ALIGNMENT = 8;
+
+static uint32_t get_u32(const uint8_t* p)
+{
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+static uint64_t get_u64(const uint8_t* p)
+{
+    return uint64_t(get_u32(p)) | uint64_t(get_u32(p + 4)) << 32;
+}
+
+static void put_u32(uint8_t* p, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i)
+        p[i] = uint8_t(v >> (8 * i));
+}
+
+static void put_u64(uint8_t* p, uint64_t v)
+{
+    put_u32(p, uint32_t(v));
+    put_u32(p + 4, uint32_t(v >> 32));
+}
+
+static size_t align_up(size_t offset, size_t alignment)
+{
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+class PackArchive : public Archive {
+public:
+    PackArchive(const String& name, const String& arch_type);
+    ~PackArchive();
+
+    /// @copydoc Archive::isCaseSensitive
+    bool is_case_sensitive(void) const override
+    {
+        return true;
+    }
+
+    /// @copydoc Archive::load
+    void load() override;
+    /// @copydoc Archive::unload
+    void unload() override;
+
+    /// @copydoc Archive::open
+    DataStreamPtr open(const String& filename, bool read_only = true) const override;
+
+    /// @copydoc Archive::create
+    DataStreamPtr create(const String& filename) override;
+
+    /// @copydoc Archive::remove
+    void remove(const String& filename) override;
+
+    /// @copydoc Archive::list
+    StringVector list(bool recursive = true, bool dirs = false) const override;
+
+    /// @copydoc Archive::listFileInfo
+    FileInfoList list_file_info(bool recursive = true, bool dirs = false) const override;
+
+    /// @copydoc Archive::find
+    StringVector find(const String& pattern,
+                      bool recursive = true,
+                      bool dirs = false) const override;
+
+    /// @copydoc Archive::findFileInfo
+    FileInfoList find_file_info(const String& pattern,
+                                bool recursive = true,
+                                bool dirs = false) const override;
+
+    /// @copydoc Archive::exists
+    bool exists(const String& filename) const override;
+
+private:
+    /// A table of contents record, checked against the pack size
+    struct Entry {
+        std::string_view name;
+        const uint8_t* data;
+        size_t stored_size;
+        size_t size;
+        PackWriter::Compression compression;
+    };
+
+    /// Check and read the table of contents of buffer_ into entries_
+    bool read_entries();
+    /// Add the files and their parent directories to index_
+    void index_entries();
+    /// Binary search of the table of contents, null if not present
+    const Entry* find_entry(const String& filename) const;
+
+    /// The mapped pack, null if not loaded
+    MemoryDataStreamPtr buffer_;
+    /// Table of contents, sorted by name; the names point into buffer_
+    std::vector<Entry> entries_;
+    /// Files and directories, for listing and pattern searches
+    FileInfoIndex index_;
+};
+
+PackArchive::PackArchive(const String& name, const String& arch_type)
+: Archive(name, arch_type)
+{
+}
+
+PackArchive::~PackArchive()
+{
+    unload();
+}
+
+DataStreamPtr open_file_stream(const String& full_path,
+                               std::ios::openmode mode,
+                               const String& name = "");
+
+void PackArchive::load()
+{
+    if (buffer_)
+        return;
+
+    MemoryDataStreamPtr buffer = MappedFileDataStream::open(name_);
+    if (!buffer) {
+        auto file_stream = open_file_stream(name_, std::ios::binary);
+        if (file_stream)
+            buffer = std::make_shared<MemoryDataStream>(file_stream.get());
+    }
+    if (!buffer)
+        return;
+
+    buffer_ = buffer;
+    if (!read_entries()) {
+        LOG(error) << "could not read pack archive " + name_;
+        unload();
+        return;
+    }
+    index_entries();
+}
+
+bool PackArchive::read_entries()
+{
+    const uint8_t* pack = buffer_->get_ptr();
+    size_t pack_size = buffer_->get_size();
+    if (pack_size < PACK_HEADER_SIZE || memcmp(pack, PACK_MAGIC, 4) != 0)
+        return false;
+    if (get_u32(pack + 4) != PACK_VERSION)
+        return false;
+
+    size_t count = get_u32(pack + 8);
+    uint64_t names_offset = get_u64(pack + 16);
+    uint64_t names_size = get_u64(pack + 24);
+    if (count > (pack_size - PACK_HEADER_SIZE) / PACK_ENTRY_SIZE)
+        return false;
+    if (names_offset > pack_size || names_size > pack_size - names_offset)
+        return false;
+    const char* names = reinterpret_cast<const char*>(pack + names_offset);
+
+    entries_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* record = pack + PACK_HEADER_SIZE + i * PACK_ENTRY_SIZE;
+        uint64_t offset = get_u64(record);
+        uint64_t stored_size = get_u64(record + 8);
+        uint64_t size = get_u64(record + 16);
+        uint32_t name_offset = get_u32(record + 24);
+        uint32_t name_length = get_u32(record + 28);
+        uint32_t compression = get_u32(record + 32);
+
+        if (name_offset > names_size || name_length > names_size - name_offset)
+            return false;
+        if (offset > pack_size || stored_size > pack_size - offset)
+            return false;
+        if (compression == PackWriter::STORE ? stored_size != size : compression != PackWriter::LZ4)
+            return false;
+        if (compression == PackWriter::LZ4 && size > LZ4_MAX_INPUT_SIZE)
+            return false;
+
+        Entry& entry = entries_[i];
+        entry.name = std::string_view(names + name_offset, name_length);
+        entry.data = pack + offset;
+        entry.stored_size = size_t(stored_size);
+        entry.size = size_t(size);
+        entry.compression = PackWriter::Compression(compression);
+
+        // lookups rely on the order
+        if (i > 0 && !(entries_[i - 1].name < entry.name))
+            return false;
+    }
+    return true;
+}
+
+void PackArchive::index_entries()
+{
+    std::set<String> dirs;
+    for (const Entry& entry : entries_) {
+        FileInfo info;
+        info.archive = this;
+        info.filename = String(entry.name);
+        StringUtils::split_filename(info.filename, &info.dir, &info.basename);
+        info.compressed_size = entry.stored_size;
+        info.uncompressed_size = entry.size;
+        info.is_dir = false;
+        index_.add(info.filename, info);
+
+        // directories are implied by the names
+        for (String dir = FileInfoIndex::get_dir_key(info.filename); !dir.empty() && dirs.insert(dir).second;
+             dir = FileInfoIndex::get_dir_key(dir)) {
+            FileInfo dir_info;
+            dir_info.archive = this;
+            dir_info.filename = dir;
+            StringUtils::split_filename(dir, &dir_info.dir, &dir_info.basename);
+            dir_info.compressed_size = 0;
+            dir_info.uncompressed_size = 0;
+            dir_info.is_dir = true;
+            index_.add(dir, dir_info);
+        }
+    }
+}
+
+void PackArchive::unload()
+{
+    // streams still open keep the mapping alive
+    buffer_.reset();
+    entries_.clear();
+    index_.clear();
+}
+
+const PackArchive::Entry* PackArchive::find_entry(const String& filename) const
+{
+    std::string_view name(filename);
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), name, [](const Entry& e, std::string_view n) {
+        return e.name < n;
+    });
+    if (it == entries_.end() || it->name != name)
+        return nullptr;
+    return &*it;
+}
+
+DataStreamPtr PackArchive::open(const String& filename, bool read_only) const
+{
+    const Entry* entry = find_entry(filename);
+    if (!entry) {
+        LOG(error) << "could not open " + filename;
+        return nullptr;
+    }
+
+    if (entry->compression == PackWriter::STORE)
+        return std::make_shared<DataStreamView>(filename, buffer_, entry->data, entry->size);
+
+    auto ret = std::make_shared<MemoryDataStream>(filename, entry->size, true, true);
+    if (!lz4_decompress(entry->data, entry->stored_size, ret->get_ptr(), entry->size))
+        panic("Corrupt LZ4 data in " + filename);
+    return ret;
+}
+
+DataStreamPtr PackArchive::create(const String& filename)
+{
+    panic("Modification of pack archives is not implemented");
+    return nullptr;
+}
+
+void PackArchive::remove(const String& filename)
+{
+    panic("Modification of pack archives is not implemented");
+}
+
+StringVector PackArchive::list(bool recursive, bool dirs) const
+{
+    StringVector ret;
+    index_.list(recursive, dirs, [&ret](const FileInfo& f) { ret.push_back(f.filename); });
+    return ret;
+}
+
+FileInfoList PackArchive::list_file_info(bool recursive, bool dirs) const
+{
+    FileInfoList ret;
+    index_.list(recursive, dirs, [&ret](const FileInfo& f) { ret.push_back(f); });
+    return ret;
+}
+
+StringVector PackArchive::find(const String& pattern, bool recursive, bool dirs) const
+{
+    StringVector ret;
+    index_.find(pattern, recursive, dirs, [&ret](const FileInfo& f) { ret.push_back(f.filename); });
+    return ret;
+}
+
+FileInfoList PackArchive::find_file_info(const String& pattern, bool recursive, bool dirs) const
+{
+    FileInfoList ret;
+    index_.find(pattern, recursive, dirs, [&ret](const FileInfo& f) { ret.push_back(f); });
+    return ret;
+}
+
+bool PackArchive::exists(const String& filename) const
+{
+    return index_.exists(filename);
+}
+
+//-----------------------------------------------------------------------
+// PackArchiveFactory
+//-----------------------------------------------------------------------
+
+const String& PackArchiveFactory::get_type(void) const
+{
+    static String name = "Pack";
+    return name;
+}
+
+Archive* PackArchiveFactory::create_instance(const String& name, bool read_only)
+{
+    if (!read_only)
+        return nullptr;
+
+    return new PackArchive(name, get_type());
+}
+
+//-----------------------------------------------------------------------
+// PackWriter
+//-----------------------------------------------------------------------
+
+PackWriter::PackWriter(size_t alignment)
+: alignment_(alignment)
+{
+    HYUE_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0, "Pack alignment must be a power of two");
+}
+
+PackWriter::~PackWriter()
+{
+}
+
+void PackWriter::add(const String& name, const void* data, size_t size, Compression compression)
+{
+    Entry& entry = entries_[name];
+    entry.path.clear();
+    entry.data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+    entry.compression = compression;
+}
+
+void PackWriter::add_file(const String& name, const FilePath& path, Compression compression)
+{
+    Entry& entry = entries_[name];
+    entry.path = path;
+    entry.data.clear();
+    entry.compression = compression;
+}
+
+size_t PackWriter::add_directory(const FilePath& dir, Compression compression)
+{
+    std::error_code ec;
+    std_fs::recursive_directory_iterator it(dir, ec);
+    if (ec)
+        panic("Cannot scan directory " + dir.string() + ": " + ec.message());
+
+    size_t count = 0;
+    for (; it != std_fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec)
+            panic("Cannot scan directory " + dir.string() + ": " + ec.message());
+
+        String filename = it->path().filename().u8string();
+        if (FileSystemArchiveFactory::is_ignore_hidden() && !filename.empty() && filename[0] == '.') {
+            if (it->is_directory(ec))
+                it.disable_recursion_pending();
+            continue;
+        }
+        if (!it->is_regular_file(ec))
+            continue;
+
+        add_file(it->path().lexically_relative(dir).generic_u8string(), it->path(), compression);
+        ++count;
+    }
+    return count;
+}
+
+size_t PackWriter::write(const String& path) const
+{
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    if (!os)
+        panic("Cannot create pack " + path);
+
+    // the table of contents is filled in while the data is written
+    String names;
+    for (const auto& item : entries_)
+        names += item.first;
+    if (entries_.size() > UINT32_MAX || names.size() > UINT32_MAX)
+        panic("Too many entries for pack " + path);
+
+    size_t toc_size = entries_.size() * PACK_ENTRY_SIZE;
+    size_t names_offset = PACK_HEADER_SIZE + toc_size;
+    std::vector<uint8_t> head(align_up(names_offset + names.size(), PACK_PAGE_SIZE));
+    memcpy(head.data(), PACK_MAGIC, 4);
+    put_u32(&head[4], PACK_VERSION);
+    put_u32(&head[8], uint32_t(entries_.size()));
+    put_u32(&head[12], uint32_t(alignment_));
+    put_u64(&head[16], names_offset);
+    put_u64(&head[24], names.size());
+    memcpy(&head[names_offset], names.data(), names.size());
+    os.write(reinterpret_cast<const char*>(head.data()), head.size());
+
+    const std::vector<char> padding(std::max(alignment_, PACK_LZ4_ALIGNMENT));
+    size_t offset = head.size();
+    size_t name_offset = 0;
+    uint8_t* record = &head[PACK_HEADER_SIZE];
+    for (const auto& item : entries_) {
+        const Entry& entry = item.second;
+
+        std::vector<uint8_t> file_data;
+        const std::vector<uint8_t>* data = &entry.data;
+        if (!entry.path.empty()) {
+            std::ifstream is(entry.path, std::ios::binary | std::ios::ate);
+            if (!is)
+                panic("Cannot open file: " + entry.path.string());
+            file_data.resize(size_t(is.tellg()));
+            is.seekg(0);
+            if (!is.read(reinterpret_cast<char*>(file_data.data()), file_data.size()))
+                panic("Cannot read file: " + entry.path.string());
+            data = &file_data;
+        }
+
+        Compression compression = STORE;
+        const uint8_t* stored = data->data();
+        size_t stored_size = data->size();
+        std::vector<uint8_t> compressed;
+        if (entry.compression == LZ4 && !data->empty()) {
+            // LZ4 entries cost a copy when opened, only keep worthwhile ones
+            compressed.resize(lz4_compress_bound(data->size()));
+            size_t size = lz4_compress(data->data(), data->size(), compressed.data(), compressed.size());
+            if (size != 0 && size <= data->size() - data->size() / 8) {
+                compression = LZ4;
+                stored = compressed.data();
+                stored_size = size;
+            }
+        }
+
+        size_t aligned = align_up(offset, compression == STORE ? alignment_ : PACK_LZ4_ALIGNMENT);
+        os.write(padding.data(), aligned - offset);
+        os.write(reinterpret_cast<const char*>(stored), stored_size);
+        if (!os)
+            panic("Cannot write pack " + path);
+
+        put_u64(record, aligned);
+        put_u64(record + 8, stored_size);
+        put_u64(record + 16, data->size());
+        put_u32(record + 24, uint32_t(name_offset));
+        put_u32(record + 28, uint32_t(item.first.size()));
+        put_u32(record + 32, compression);
+        record += PACK_ENTRY_SIZE;
+
+        name_offset += item.first.size();
+        offset = aligned + stored_size;
+    }
+
+    os.seekp(PACK_HEADER_SIZE);
+    os.write(reinterpret_cast<const char*>(&head[PACK_HEADER_SIZE]), toc_size);
+    os.close();
+    if (!os)
+        panic("Cannot write pack " + path);
+    return offset;
+}
+
+} // namespace hyue
@@ -2,11 +2,19 @@
 
 #include <string.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+
 #include <hyue/panic.h>
 #include <hyue/Bitwise.h>
 #include <hyue/StringUtils.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
 
-#include "PixelFormatDescription.h"
+#include "PixelFormatTraits.h"
+#include "block_decompression.h"
+#include "pixel_conversion_simd.h"
 
 namespace {
 #include "pixel_conversion.inl"
@@ -14,6 +22,73 @@ namespace {
 
 namespace hyue {
 
+/// Fastest vectorised row converter for a format pair on this CPU, or nullptr
+static PixelRowConverter get_simd_row_converter(PixelFormat src_format, PixelFormat dst_format)
+{
+    PixelRowConverter ret = nullptr;
+    switch (get_simd_level()) {
+        case SimdLevel::AVX2:
+#if HYUE_SIMD_AVX2
+            ret = get_avx2_row_converter(src_format, dst_format);
+            if (ret)
+                break;
+#endif
+            [[fallthrough]];
+        case SimdLevel::SSE2:
+#if HYUE_SIMD_SSE2
+            ret = get_sse2_row_converter(src_format, dst_format);
+#endif
+            break;
+        case SimdLevel::NONE:
+            break;
+    }
+    return ret;
+}
+
+/// Fastest vectorised colour packer for a format on this CPU, or nullptr
+static ColorPacker get_simd_color_packer(PixelFormat format)
+{
+    ColorPacker ret = nullptr;
+    switch (get_simd_level()) {
+        case SimdLevel::AVX2:
+#if HYUE_SIMD_AVX2
+            ret = get_avx2_color_packer(format);
+            break;
+#endif
+            [[fallthrough]];
+        case SimdLevel::SSE2:
+#if HYUE_SIMD_SSE2
+            ret = get_sse2_color_packer(format);
+#endif
+            break;
+        case SimdLevel::NONE:
+            break;
+    }
+    return ret;
+}
+
+/// Fastest vectorised colour unpacker for a format on this CPU, or nullptr
+static ColorUnpacker get_simd_color_unpacker(PixelFormat format)
+{
+    ColorUnpacker ret = nullptr;
+    switch (get_simd_level()) {
+        case SimdLevel::AVX2:
+#if HYUE_SIMD_AVX2
+            ret = get_avx2_color_unpacker(format);
+            break;
+#endif
+            [[fallthrough]];
+        case SimdLevel::SSE2:
+#if HYUE_SIMD_SSE2
+            ret = get_sse2_color_unpacker(format);
+#endif
+            break;
+        case SimdLevel::NONE:
+            break;
+    }
+    return ret;
+}
+
 //-----------------------------------------------------------------------
 size_t PixelBox::get_consecutive_size() const
 {
@@ -112,11 +187,11 @@ size_t PixelUtil::get_memory_size(int width, int height, int depth, PixelFormat
             case PixelFormat::ETC2_RGB8:
             case PixelFormat::ETC2_RGB8A1:
             case PixelFormat::ATC_RGB:
-                return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+                return ((width + 3) / 4) * ((height + 3) / 4) * 8 * depth;
             case PixelFormat::ETC2_RGBA8:
             case PixelFormat::ATC_RGBA_EXPLICIT_ALPHA:
             case PixelFormat::ATC_RGBA_INTERPOLATED_ALPHA:
-                return ((width + 3) / 4) * ((height + 3) / 4) * 16;
+                return ((width + 3) / 4) * ((height + 3) / 4) * 16 * depth;
 
             case PixelFormat::ASTC_RGBA_4X4_LDR:
                 return astc_slice_size(width, height, 4, 4) * depth;
@@ -200,7 +275,16 @@ void PixelUtil::get_bit_shifts(PixelFormat format, unsigned char rgba[4])
     rgba[3] = des.ashift;
 }
 //-----------------------------------------------------------------------
-const String& PixelUtil::getFormatName(PixelFormat srcformat) { return getDescriptionFor(srcformat).name; }
+const String& PixelUtil::getFormatName(PixelFormat srcformat)
+{
+    static const auto names = [] {
+        std::array<String, size_t(PixelFormat::COUNT)> ret;
+        for (size_t i = 0; i < ret.size(); ++i)
+            ret[i] = _pixelFormats[i].name;
+        return ret;
+    }();
+    return names[size_t(srcformat)];
+}
 //-----------------------------------------------------------------------
 bool PixelUtil::is_accessible(PixelFormat srcformat)
 {
@@ -384,67 +468,7 @@ void PixelUtil::pack_color(const float r, const float g, const float b, const fl
         // And write to memory
         Bitwise::int_write(dest, des.elem_bytes, value);
     } else {
-        switch (pf) {
-            case PixelFormat::FLOAT32_R:
-                ((float*)dest)[0] = r;
-                break;
-            case PixelFormat::FLOAT32_GR:
-                ((float*)dest)[0] = g;
-                ((float*)dest)[1] = r;
-                break;
-            case PixelFormat::FLOAT32_RGB:
-                ((float*)dest)[0] = r;
-                ((float*)dest)[1] = g;
-                ((float*)dest)[2] = b;
-                break;
-            case PixelFormat::FLOAT32_RGBA:
-                ((float*)dest)[0] = r;
-                ((float*)dest)[1] = g;
-                ((float*)dest)[2] = b;
-                ((float*)dest)[3] = a;
-                break;
-            case PixelFormat::DEPTH16:
-            case PixelFormat::FLOAT16_R:
-                ((uint16_t*)dest)[0] = Bitwise::float_to_half(r);
-                break;
-            case PixelFormat::FLOAT16_GR:
-                ((uint16_t*)dest)[0] = Bitwise::float_to_half(g);
-                ((uint16_t*)dest)[1] = Bitwise::float_to_half(r);
-                break;
-            case PixelFormat::FLOAT16_RGB:
-                ((uint16_t*)dest)[0] = Bitwise::float_to_half(r);
-                ((uint16_t*)dest)[1] = Bitwise::float_to_half(g);
-                ((uint16_t*)dest)[2] = Bitwise::float_to_half(b);
-                break;
-            case PixelFormat::FLOAT16_RGBA:
-                ((uint16_t*)dest)[0] = Bitwise::float_to_half(r);
-                ((uint16_t*)dest)[1] = Bitwise::float_to_half(g);
-                ((uint16_t*)dest)[2] = Bitwise::float_to_half(b);
-                ((uint16_t*)dest)[3] = Bitwise::float_to_half(a);
-                break;
-            case PixelFormat::SHORT_RGB:
-                ((uint16_t*)dest)[0] = (uint16_t)Bitwise::float_to_fixed(r, 16);
-                ((uint16_t*)dest)[1] = (uint16_t)Bitwise::float_to_fixed(g, 16);
-                ((uint16_t*)dest)[2] = (uint16_t)Bitwise::float_to_fixed(b, 16);
-                break;
-            case PixelFormat::SHORT_RGBA:
-                ((uint16_t*)dest)[0] = (uint16_t)Bitwise::float_to_fixed(r, 16);
-                ((uint16_t*)dest)[1] = (uint16_t)Bitwise::float_to_fixed(g, 16);
-                ((uint16_t*)dest)[2] = (uint16_t)Bitwise::float_to_fixed(b, 16);
-                ((uint16_t*)dest)[3] = (uint16_t)Bitwise::float_to_fixed(a, 16);
-                break;
-            case PixelFormat::BYTE_LA:
-                ((uint8_t*)dest)[0] = (uint8_t)Bitwise::float_to_fixed(r, 8);
-                ((uint8_t*)dest)[1] = (uint8_t)Bitwise::float_to_fixed(a, 8);
-                break;
-            case PixelFormat::A8:
-                ((uint8_t*)dest)[0] = (uint8_t)Bitwise::float_to_fixed(r, 8);
-                break;
-            default:
-                // Not yet supported
-                panic("pack to " + getFormatName(pf) + " not implemented");
-                break;
-        }
+        pack_non_native(r, g, b, a, pf, dest);
     }
 }
 //-----------------------------------------------------------------------
@@ -478,6 +502,137 @@ void PixelUtil::unpack_color(uint8_t* r, uint8_t* g, uint8_t* b, uint8_t* a, Pix
     }
 }
 //-----------------------------------------------------------------------
+void PixelUtil::pack_colors(const Color* src, PixelFormat pf, void* dest, size_t count)
+{
+    static_assert(sizeof(Color) == 4 * sizeof(float), "colours are packed as float arrays");
+
+    if (ColorPacker packer = get_simd_color_packer(pf)) {
+        packer(src, static_cast<uint8_t*>(dest), count);
+        return;
+    }
+    switch (pf) {
+        case PixelFormat::FLOAT32_RGBA:
+            memcpy(dest, src, count * sizeof(Color));
+            return;
+        case PixelFormat::FLOAT16_RGBA:
+            float_to_half(src->get_ptr(), static_cast<uint16_t*>(dest), count * 4);
+            return;
+        default:
+            break;
+    }
+    const size_t size = get_elem_bytes(pf);
+    uint8_t* dst = static_cast<uint8_t*>(dest);
+    for (size_t i = 0; i < count; ++i)
+        pack_color(src[i], pf, dst + i * size);
+}
+//-----------------------------------------------------------------------
+void PixelUtil::unpack_colors(const void* src, PixelFormat pf, Color* dest, size_t count)
+{
+    if (ColorUnpacker unpacker = get_simd_color_unpacker(pf)) {
+        unpacker(static_cast<const uint8_t*>(src), dest, count);
+        return;
+    }
+    switch (pf) {
+        case PixelFormat::FLOAT32_RGBA:
+            memcpy(dest, src, count * sizeof(Color));
+            return;
+        case PixelFormat::FLOAT16_RGBA:
+            half_to_float(static_cast<const uint16_t*>(src), dest->get_ptr(), count * 4);
+            return;
+        default:
+            break;
+    }
+    const size_t size = get_elem_bytes(pf);
+    const uint8_t* s = static_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < count; ++i)
+        unpack_color(&dest[i], pf, s + i * size);
+}
+//-----------------------------------------------------------------------
+void PixelUtil::float_to_half(const float* src, uint16_t* dest, size_t count)
+{
+    switch (get_simd_level()) {
+        case SimdLevel::AVX2:
+#if HYUE_SIMD_AVX2
+            avx2_float_to_half(src, dest, count);
+            return;
+#endif
+            [[fallthrough]];
+        case SimdLevel::SSE2:
+#if HYUE_SIMD_SSE2
+            sse2_float_to_half(src, dest, count);
+            return;
+#endif
+            [[fallthrough]];
+        case SimdLevel::NONE:
+            pixel_simd::float_to_half(src, dest, count);
+            break;
+    }
+}
+//-----------------------------------------------------------------------
+void PixelUtil::half_to_float(const uint16_t* src, float* dest, size_t count)
+{
+    const uint8_t* s = reinterpret_cast<const uint8_t*>(src);
+    uint8_t* d = reinterpret_cast<uint8_t*>(dest);
+    if (PixelRowConverter converter = get_simd_row_converter(PixelFormat::FLOAT16_R, PixelFormat::FLOAT32_R))
+        converter(s, d, count);
+    else
+        pixel_simd::half_to_float(s, d, count);
+}
+//-----------------------------------------------------------------------
+void PixelUtil::srgb_to_linear(const Color* src, Color* dest, size_t count)
+{
+    switch (get_simd_level()) {
+        case SimdLevel::AVX2:
+#if HYUE_SIMD_AVX2
+            avx2_srgb_to_linear(src, dest, count);
+            return;
+#endif
+            [[fallthrough]];
+        case SimdLevel::SSE2:
+#if HYUE_SIMD_SSE2
+            sse2_srgb_to_linear(src, dest, count);
+            return;
+#endif
+            [[fallthrough]];
+        case SimdLevel::NONE:
+            break;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const float* c = src[i].get_ptr();
+        float* d = dest[i].get_ptr();
+        for (int j = 0; j < 3; ++j)
+            d[j] = c[j] <= 0.04045f ? c[j] / 12.92f : std::pow((c[j] + 0.055f) / 1.055f, 2.4f);
+        d[3] = c[3];
+    }
+}
+//-----------------------------------------------------------------------
+void PixelUtil::linear_to_srgb(const Color* src, Color* dest, size_t count)
+{
+    switch (get_simd_level()) {
+        case SimdLevel::AVX2:
+#if HYUE_SIMD_AVX2
+            avx2_linear_to_srgb(src, dest, count);
+            return;
+#endif
+            [[fallthrough]];
+        case SimdLevel::SSE2:
+#if HYUE_SIMD_SSE2
+            sse2_linear_to_srgb(src, dest, count);
+            return;
+#endif
+            [[fallthrough]];
+        case SimdLevel::NONE:
+            break;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const float* c = src[i].get_ptr();
+        float* d = dest[i].get_ptr();
+        for (int j = 0; j < 3; ++j)
+            d[j] = c[j] <= 0.0031308f ? c[j] * 12.92f : 1.055f * std::pow(c[j], 1.0f / 2.4f) - 0.055f;
+        d[3] = c[3];
+    }
+}
+//-----------------------------------------------------------------------
 void PixelUtil::unpack_color(float* r, float* g, float* b, float* a, PixelFormat pf, const void* src)
 {
     const PixelFormatDescription& des = getDescriptionFor(pf);
@@ -498,69 +653,23 @@ void PixelUtil::unpack_color(float* r, float* g, float* b, float* a, PixelFormat
             *a = 1.0f; // No alpha, default a component to full
         }
     } else {
-        switch (pf) {
-            case PixelFormat::FLOAT32_R:
-                *r = *g = *b = ((const float*)src)[0];
-                *a = 1.0f;
-                break;
-            case PixelFormat::FLOAT32_GR:
-                *g = ((const float*)src)[0];
-                *r = *b = ((const float*)src)[1];
-                *a = 1.0f;
-                break;
-            case PixelFormat::FLOAT32_RGB:
-                *r = ((const float*)src)[0];
-                *g = ((const float*)src)[1];
-                *b = ((const float*)src)[2];
-                *a = 1.0f;
-                break;
-            case PixelFormat::FLOAT32_RGBA:
-                *r = ((const float*)src)[0];
-                *g = ((const float*)src)[1];
-                *b = ((const float*)src)[2];
-                *a = ((const float*)src)[3];
-                break;
-            case PixelFormat::FLOAT16_R:
-                *r = *g = *b = Bitwise::half_to_float(((const uint16_t*)src)[0]);
-                *a = 1.0f;
-                break;
-            case PixelFormat::FLOAT16_GR:
-                *g = Bitwise::half_to_float(((const uint16_t*)src)[0]);
-                *r = *b = Bitwise::half_to_float(((const uint16_t*)src)[1]);
-                *a = 1.0f;
-                break;
-            case PixelFormat::FLOAT16_RGB:
-                *r = Bitwise::half_to_float(((const uint16_t*)src)[0]);
-                *g = Bitwise::half_to_float(((const uint16_t*)src)[1]);
-                *b = Bitwise::half_to_float(((const uint16_t*)src)[2]);
-                *a = 1.0f;
-                break;
-            case PixelFormat::FLOAT16_RGBA:
-                *r = Bitwise::half_to_float(((const uint16_t*)src)[0]);
-                *g = Bitwise::half_to_float(((const uint16_t*)src)[1]);
-                *b = Bitwise::half_to_float(((const uint16_t*)src)[2]);
-                *a = Bitwise::half_to_float(((const uint16_t*)src)[3]);
-                break;
-            case PixelFormat::SHORT_RGB:
-                *r = Bitwise::fixed_to_float(((const uint16_t*)src)[0], 16);
-                *g = Bitwise::fixed_to_float(((const uint16_t*)src)[1], 16);
-                *b = Bitwise::fixed_to_float(((const uint16_t*)src)[2], 16);
-                *a = 1.0f;
-                break;
-            case PixelFormat::SHORT_RGBA:
-                *r = Bitwise::fixed_to_float(((const uint16_t*)src)[0], 16);
-                *g = Bitwise::fixed_to_float(((const uint16_t*)src)[1], 16);
-                *b = Bitwise::fixed_to_float(((const uint16_t*)src)[2], 16);
-                *a = Bitwise::fixed_to_float(((const uint16_t*)src)[3], 16);
-                break;
-            case PixelFormat::BYTE_LA:
-                *r = *g = *b = Bitwise::fixed_to_float(((const uint8_t*)src)[0], 8);
-                *a = Bitwise::fixed_to_float(((const uint8_t*)src)[1], 8);
-                break;
-            default:
-                // Not yet supported
-                panic("unpack from " + getFormatName(pf) + " not implemented");
-                break;
+        unpack_non_native(pf, src, r, g, b, a);
+    }
+}
+//-----------------------------------------------------------------------
+/// Convert a box a row at a time
+static void convert_rows(const PixelBox& src, const PixelBox& dst, PixelRowConverter row_converter)
+{
+    const size_t srcPixelSize = PixelUtil::get_elem_bytes(src.format);
+    const size_t dstPixelSize = PixelUtil::get_elem_bytes(dst.format);
+    const size_t width = src.get_width();
+    for (size_t z = 0; z < src.get_depth(); z++) {
+        for (size_t y = 0; y < src.get_height(); y++) {
+            const uint8_t* srcptr =
+                src.get_top_left_front_pixel_ptr() + (z * src.slice_pitch + y * src.row_pitch) * srcPixelSize;
+            uint8_t* dstptr =
+                dst.get_top_left_front_pixel_ptr() + (z * dst.slice_pitch + y * dst.row_pitch) * dstPixelSize;
+            row_converter(srcptr, dstptr, width);
         }
     }
 }
@@ -639,11 +748,22 @@ void PixelUtil::bulk_pixel_conversion(const PixelBox* src, const PixelBox* dst)
         return;
     }
 
+    if (PixelRowConverter row_converter = get_simd_row_converter(src->format, dst->format)) {
+        convert_rows(*src, *dst, row_converter);
+        return;
+    }
+
     if (doOptimizedConversion(*src, *dst)) {
         // If so, good
         return;
     }
 
+    // every other pair of packable formats has a converter generated from PixelFormatTraits
+    if (PixelRowConverter row_converter = get_traits_row_converter(src->format, dst->format)) {
+        convert_rows(*src, *dst, row_converter);
+        return;
+    }
+
     const size_t srcPixelSize = PixelUtil::get_elem_bytes(src->format);
     const size_t dstPixelSize = PixelUtil::get_elem_bytes(dst->format);
     uint8_t* srcptr = src->get_top_left_front_pixel_ptr();
@@ -676,40 +796,199 @@ void PixelUtil::bulk_pixel_conversion(const PixelBox* src, const PixelBox* dst)
     }
 }
 //-----------------------------------------------------------------------
-void PixelUtil::bulk_pixel_vertical_flip(const PixelBox* box)
+/// Pixels a parallel job should at least cover to be worth scheduling
+#define HYUE_PARALLEL_MIN_JOB_PIXELS (64 * 1024)
+
+/** Split depth slices of rows rows each into bands and run them on executor.
+
+    Whole slices are handed out when there are enough of them, otherwise every
+    slice is cut into bands of rows. fn gets the slice range and row range of a band.
+*/
+static void parallel_for_bands(size_t depth,
+                               size_t rows,
+                               size_t row_pixels,
+                               Executor* executor,
+                               const std::function<void(size_t, size_t, size_t, size_t)>& fn)
 {
-    // Check for compressed formats, we don't support decompression, compression or recoding
-    HYUE_ASSERT(!PixelUtil::is_compressed(box->format), "This method can not be used for compressed formats");
+    if (!executor)
+        executor = &ThreadPool::get_worker_pool();
+
+    // a few jobs per thread to even out uneven progress
+    size_t jobs = std::min(executor->get_concurrency() * 4,
+                           depth * rows * row_pixels / HYUE_PARALLEL_MIN_JOB_PIXELS);
+
+    if (jobs <= 1) {
+        fn(0, depth, 0, rows);
+    } else if (depth >= jobs) {
+        executor->parallel_for(jobs, [&](size_t i) {
+            fn(depth * i / jobs, depth * (i + 1) / jobs, 0, rows);
+        });
+    } else {
+        size_t bands = std::min(rows, (jobs + depth - 1) / depth);
+        executor->parallel_for(depth * bands, [&](size_t i) {
+            size_t z = i / bands, band = i % bands;
+            fn(z, z + 1, rows * band / bands, rows * (band + 1) / bands);
+        });
+    }
+}
+
+//-----------------------------------------------------------------------
+void PixelUtil::bulk_pixel_conversion(const PixelBox* src, const PixelBox* dst, Executor* executor)
+{
+    HYUE_ASSERT(src->get_size() == dst->get_size(), "");
+
+    // compressed data can only be copied with slice granularity anyway
+    if (PixelUtil::is_compressed(src->format) || PixelUtil::is_compressed(dst->format)) {
+        bulk_pixel_conversion(src, dst);
+        return;
+    }
+
+    parallel_for_bands(src->get_depth(),
+                       src->get_height(),
+                       src->get_width(),
+                       executor,
+                       [src, dst](size_t z_begin, size_t z_end, size_t y_begin, size_t y_end) {
+                           // same band in both boxes, keeping their pitches
+                           PixelBox src_band = src->get_sub_volume(
+                               Box(src->left, src->top + y_begin, src->front + z_begin,
+                                   src->right, src->top + y_end, src->front + z_end),
+                               false);
+                           PixelBox dst_band = dst->get_sub_volume(
+                               Box(dst->left, dst->top + y_begin, dst->front + z_begin,
+                                   dst->right, dst->top + y_end, dst->front + z_end),
+                               false);
+                           bulk_pixel_conversion(&src_band, &dst_band);
+                       });
+}
 
+//-----------------------------------------------------------------------
+/// Swap rows [y_begin, y_end) of slices [z_begin, z_end) with their mirrored rows
+static void flip_rows(const PixelBox* box, size_t z_begin, size_t z_end, size_t y_begin, size_t y_end)
+{
     const size_t pixelSize = PixelUtil::get_elem_bytes(box->format);
     const size_t copySize = box->get_width() * pixelSize;
 
     // Calculate pitches in bytes
     const size_t row_pitchBytes = box->row_pitch * pixelSize;
     const size_t slice_pitchBytes = box->slice_pitch * pixelSize;
+    const size_t height = box->get_height();
+
+    for (size_t z = z_begin; z < z_end; z++) {
+        uint8_t* sliceptr = box->get_top_left_front_pixel_ptr() + z * slice_pitchBytes;
+        for (size_t y = y_begin; y < y_end; y++) {
+            uint8_t* srcptr = sliceptr + y * row_pitchBytes;
+            uint8_t* dstptr = sliceptr + (height - 1 - y) * row_pitchBytes;
+            std::swap_ranges(srcptr, srcptr + copySize, dstptr);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+void PixelUtil::bulk_pixel_vertical_flip(const PixelBox* box)
+{
+    // Check for compressed formats, we don't support decompression, compression or recoding
+    HYUE_ASSERT(!PixelUtil::is_compressed(box->format), "This method can not be used for compressed formats");
+
+    flip_rows(box, 0, box->get_depth(), 0, box->get_height() / 2);
+}
+
+//-----------------------------------------------------------------------
+void PixelUtil::bulk_pixel_vertical_flip(const PixelBox* box, Executor* executor)
+{
+    HYUE_ASSERT(!PixelUtil::is_compressed(box->format), "This method can not be used for compressed formats");
 
-    uint8_t* basesrcptr = box->get_top_left_front_pixel_ptr();
-    uint8_t* basedstptr = basesrcptr + (box->bottom - box->top - 1) * row_pitchBytes;
-    uint8_t* tmpptr = (uint8_t*)malloc(copySize);
-
-    // swap rows
-    const size_t halfRowCount = (box->bottom - box->top) >> 1;
-    for (size_t z = box->front; z < box->back; z++) {
-        uint8_t* srcptr = basesrcptr;
-        uint8_t* dstptr = basedstptr;
-        for (size_t y = 0; y < halfRowCount; y++) {
-            // swap rows
-            memcpy(tmpptr, dstptr, copySize);
-            memcpy(dstptr, srcptr, copySize);
-            memcpy(srcptr, tmpptr, copySize);
-            srcptr += row_pitchBytes;
-            dstptr -= row_pitchBytes;
+    // every job swaps a band of the upper half with the mirrored band of the lower half
+    parallel_for_bands(box->get_depth(),
+                       box->get_height() / 2,
+                       box->get_width() * 2,
+                       executor,
+                       [box](size_t z_begin, size_t z_end, size_t y_begin, size_t y_end) {
+                           flip_rows(box, z_begin, z_end, y_begin, y_end);
+                       });
+}
+
+//-----------------------------------------------------------------------
+bool PixelUtil::is_decompressible(PixelFormat format)
+{
+    BlockFormat block;
+    return get_block_format(format, &block);
+}
+
+//-----------------------------------------------------------------------
+/// Decode block rows [y_begin, y_end) of slices [z_begin, z_end) of src into dst
+static void decompress_block_rows(const BlockFormat& block,
+                                  const PixelBox* src,
+                                  const PixelBox* dst,
+                                  size_t z_begin,
+                                  size_t z_end,
+                                  size_t y_begin,
+                                  size_t y_end)
+{
+    const size_t width = src->get_width(), height = src->get_height();
+    const size_t blocks_x = (width + block.block_width - 1) / block.block_width;
+    const size_t row_bytes = blocks_x * block.block_bytes;
+    const size_t slice_bytes = PixelUtil::get_memory_size(int(width), int(height), 1, src->format);
+
+    // one decoded row of blocks, wide enough for the partial block at the right edge
+    const size_t row_pixels = blocks_x * block.block_width;
+    std::vector<uint8_t> decoded(row_pixels * block.block_height * 4);
+
+    for (size_t z = z_begin; z < z_end; z++) {
+        const uint8_t* slice = src->data + (src->front + z) * slice_bytes;
+        for (size_t y = y_begin; y < y_end; y++) {
+            block.decode(slice + y * row_bytes, blocks_x, decoded.data(), row_pixels * 4);
+
+            // the bottom row of blocks may stick out of the image
+            size_t top = y * block.block_height;
+            size_t rows = std::min(block.block_height, height - top);
+            PixelBox decoded_box(int(width), int(rows), 1, PixelFormat::BYTE_RGBA, decoded.data());
+            decoded_box.row_pitch = row_pixels;
+            decoded_box.slice_pitch = row_pixels * rows;
+            PixelBox dst_band = dst->get_sub_volume(
+                Box(dst->left, dst->top + top, dst->front + z, dst->right, dst->top + top + rows, dst->front + z + 1),
+                false);
+            PixelUtil::bulk_pixel_conversion(&decoded_box, &dst_band);
         }
-        basesrcptr += slice_pitchBytes;
-        basedstptr += slice_pitchBytes;
     }
+}
+
+//-----------------------------------------------------------------------
+/// Check the boxes of PixelUtil::decompress and find the decoder of src
+static BlockFormat get_decompression_format(const PixelBox* src, const PixelBox* dst)
+{
+    HYUE_ASSERT(src->get_size() == dst->get_size(), "");
+    HYUE_ASSERT(!PixelUtil::is_compressed(dst->format), "Can not decompress into a compressed format");
+
+    BlockFormat block;
+    if (!get_block_format(src->format, &block))
+        panic("No decoder for pixel format " + PixelUtil::getFormatName(src->format));
+    HYUE_ASSERT(src->is_consecutive() && src->left == 0 && src->top == 0,
+                "Compressed pixels must be consecutive and start at a block boundary");
+    return block;
+}
+
+//-----------------------------------------------------------------------
+void PixelUtil::decompress(const PixelBox* src, const PixelBox* dst)
+{
+    BlockFormat block = get_decompression_format(src, dst);
+    size_t block_rows = (src->get_height() + block.block_height - 1) / block.block_height;
+    decompress_block_rows(block, src, dst, 0, src->get_depth(), 0, block_rows);
+}
 
-    free(tmpptr);
+//-----------------------------------------------------------------------
+void PixelUtil::decompress(const PixelBox* src, const PixelBox* dst, Executor* executor)
+{
+    BlockFormat block = get_decompression_format(src, dst);
+
+    // bands are whole rows of blocks, every block is decoded exactly once
+    size_t block_rows = (src->get_height() + block.block_height - 1) / block.block_height;
+    parallel_for_bands(src->get_depth(),
+                       block_rows,
+                       src->get_width() * block.block_height,
+                       executor,
+                       [&block, src, dst](size_t z_begin, size_t z_end, size_t y_begin, size_t y_end) {
+                           decompress_block_rows(block, src, dst, z_begin, z_end, y_begin, y_end);
+                       });
 }
 
 Color PixelBox::get_color(size_t x, size_t y, size_t z) const
@@ -7,7 +7,7 @@ namespace hyue {
  */
 struct PixelFormatDescription {
     /* Name of the format, as in the enum */
-    const String name;
+    const char* name;
     /* Number of bytes one element (colour value) takes. */
     uint8_t elem_bytes;
     /* Pixel format flags, see enum PixelFormatFlags for the bit field
@@ -31,8 +31,8 @@ struct PixelFormatDescription {
 
 // clang-format off
 //-----------------------------------------------------------------------
-/** Pixel format database */
-PixelFormatDescription _pixelFormats[] = {
+/** Pixel format database, constant so PixelFormatTraits can read it at compile time */
+constexpr PixelFormatDescription _pixelFormats[] = {
     //-----------------------------------------------------------------------
     { 
         "PF_UNKNOWN",
@@ -1838,4 +1838,7 @@ PixelFormatDescription _pixelFormats[] = {
 };
 // clang-format on
 
+static_assert(sizeof(_pixelFormats) / sizeof(_pixelFormats[0]) == size_t(PixelFormat::COUNT),
+              "one description per pixel format");
+
 } // namespace hyue
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <hyue/PixelFormat.h>
+#include <hyue/Bitwise.h>
+#include <hyue/panic.h>
+
+#include "PixelFormatDescription.h"
+#include "pixel_conversion_simd.h"
+
+namespace hyue {
+
+/// PixelUtil::pack_color of the formats that are not PFF_NATIVEENDIAN
+inline void pack_non_native(float r, float g, float b, float a, PixelFormat pf, void* dest)
+{
+    switch (pf) {
+        case PixelFormat::FLOAT32_R:
+            ((float*)dest)[0] = r;
+            break;
+        case PixelFormat::FLOAT32_GR:
+            ((float*)dest)[0] = g;
+            ((float*)dest)[1] = r;
+            break;
+        case PixelFormat::FLOAT32_RGB:
+            ((float*)dest)[0] = r;
+            ((float*)dest)[1] = g;
+            ((float*)dest)[2] = b;
+            break;
+        case PixelFormat::FLOAT32_RGBA:
+            ((float*)dest)[0] = r;
+            ((float*)dest)[1] = g;
+            ((float*)dest)[2] = b;
+            ((float*)dest)[3] = a;
+            break;
+        case PixelFormat::DEPTH16:
+        case PixelFormat::FLOAT16_R:
+            ((uint16_t*)dest)[0] = Bitwise::float_to_half(r);
+            break;
+        case PixelFormat::FLOAT16_GR:
+            ((uint16_t*)dest)[0] = Bitwise::float_to_half(g);
+            ((uint16_t*)dest)[1] = Bitwise::float_to_half(r);
+            break;
+        case PixelFormat::FLOAT16_RGB:
+            ((uint16_t*)dest)[0] = Bitwise::float_to_half(r);
+            ((uint16_t*)dest)[1] = Bitwise::float_to_half(g);
+            ((uint16_t*)dest)[2] = Bitwise::float_to_half(b);
+            break;
+        case PixelFormat::FLOAT16_RGBA:
+            ((uint16_t*)dest)[0] = Bitwise::float_to_half(r);
+            ((uint16_t*)dest)[1] = Bitwise::float_to_half(g);
+            ((uint16_t*)dest)[2] = Bitwise::float_to_half(b);
+            ((uint16_t*)dest)[3] = Bitwise::float_to_half(a);
+            break;
+        case PixelFormat::SHORT_RGB:
+            ((uint16_t*)dest)[0] = (uint16_t)Bitwise::float_to_fixed(r, 16);
+            ((uint16_t*)dest)[1] = (uint16_t)Bitwise::float_to_fixed(g, 16);
+            ((uint16_t*)dest)[2] = (uint16_t)Bitwise::float_to_fixed(b, 16);
+            break;
+        case PixelFormat::SHORT_RGBA:
+            ((uint16_t*)dest)[0] = (uint16_t)Bitwise::float_to_fixed(r, 16);
+            ((uint16_t*)dest)[1] = (uint16_t)Bitwise::float_to_fixed(g, 16);
+            ((uint16_t*)dest)[2] = (uint16_t)Bitwise::float_to_fixed(b, 16);
+            ((uint16_t*)dest)[3] = (uint16_t)Bitwise::float_to_fixed(a, 16);
+            break;
+        case PixelFormat::BYTE_LA:
+            ((uint8_t*)dest)[0] = (uint8_t)Bitwise::float_to_fixed(r, 8);
+            ((uint8_t*)dest)[1] = (uint8_t)Bitwise::float_to_fixed(a, 8);
+            break;
+        case PixelFormat::A8:
+            ((uint8_t*)dest)[0] = (uint8_t)Bitwise::float_to_fixed(r, 8);
+            break;
+        default:
+            // Not yet supported
+            panic("pack to " + PixelUtil::getFormatName(pf) + " not implemented");
+            break;
+    }
+}
+
+/// PixelUtil::unpack_color of the formats that are not PFF_NATIVEENDIAN
+inline void unpack_non_native(PixelFormat pf, const void* src, float* r, float* g, float* b, float* a)
+{
+    switch (pf) {
+        case PixelFormat::FLOAT32_R:
+            *r = *g = *b = ((const float*)src)[0];
+            *a = 1.0f;
+            break;
+        case PixelFormat::FLOAT32_GR:
+            *g = ((const float*)src)[0];
+            *r = *b = ((const float*)src)[1];
+            *a = 1.0f;
+            break;
+        case PixelFormat::FLOAT32_RGB:
+            *r = ((const float*)src)[0];
+            *g = ((const float*)src)[1];
+            *b = ((const float*)src)[2];
+            *a = 1.0f;
+            break;
+        case PixelFormat::FLOAT32_RGBA:
+            *r = ((const float*)src)[0];
+            *g = ((const float*)src)[1];
+            *b = ((const float*)src)[2];
+            *a = ((const float*)src)[3];
+            break;
+        case PixelFormat::FLOAT16_R:
+            *r = *g = *b = Bitwise::half_to_float(((const uint16_t*)src)[0]);
+            *a = 1.0f;
+            break;
+        case PixelFormat::FLOAT16_GR:
+            *g = Bitwise::half_to_float(((const uint16_t*)src)[0]);
+            *r = *b = Bitwise::half_to_float(((const uint16_t*)src)[1]);
+            *a = 1.0f;
+            break;
+        case PixelFormat::FLOAT16_RGB:
+            *r = Bitwise::half_to_float(((const uint16_t*)src)[0]);
+            *g = Bitwise::half_to_float(((const uint16_t*)src)[1]);
+            *b = Bitwise::half_to_float(((const uint16_t*)src)[2]);
+            *a = 1.0f;
+            break;
+        case PixelFormat::FLOAT16_RGBA:
+            *r = Bitwise::half_to_float(((const uint16_t*)src)[0]);
+            *g = Bitwise::half_to_float(((const uint16_t*)src)[1]);
+            *b = Bitwise::half_to_float(((const uint16_t*)src)[2]);
+            *a = Bitwise::half_to_float(((const uint16_t*)src)[3]);
+            break;
+        case PixelFormat::SHORT_RGB:
+            *r = Bitwise::fixed_to_float(((const uint16_t*)src)[0], 16);
+            *g = Bitwise::fixed_to_float(((const uint16_t*)src)[1], 16);
+            *b = Bitwise::fixed_to_float(((const uint16_t*)src)[2], 16);
+            *a = 1.0f;
+            break;
+        case PixelFormat::SHORT_RGBA:
+            *r = Bitwise::fixed_to_float(((const uint16_t*)src)[0], 16);
+            *g = Bitwise::fixed_to_float(((const uint16_t*)src)[1], 16);
+            *b = Bitwise::fixed_to_float(((const uint16_t*)src)[2], 16);
+            *a = Bitwise::fixed_to_float(((const uint16_t*)src)[3], 16);
+            break;
+        case PixelFormat::BYTE_LA:
+            *r = *g = *b = Bitwise::fixed_to_float(((const uint8_t*)src)[0], 8);
+            *a = Bitwise::fixed_to_float(((const uint8_t*)src)[1], 8);
+            break;
+        default:
+            // Not yet supported
+            panic("unpack from " + PixelUtil::getFormatName(pf) + " not implemented");
+            break;
+    }
+}
+
+/** Whether PixelFormatTraits can pack and unpack a format: the native endian
+    formats of at most 32 bits with channels narrower than 32 bits, and the
+    other formats pack_color and unpack_color both support.
+*/
+constexpr bool has_pixel_format_traits(PixelFormat format)
+{
+    const PixelFormatDescription& des = _pixelFormats[size_t(format)];
+    if (des.flags & PFF_NATIVEENDIAN)
+        return des.elem_bytes <= 4 && des.rbits < 32 && des.gbits < 32 && des.bbits < 32 && des.abits < 32;
+
+    switch (format) {
+        case PixelFormat::FLOAT32_R:
+        case PixelFormat::FLOAT32_GR:
+        case PixelFormat::FLOAT32_RGB:
+        case PixelFormat::FLOAT32_RGBA:
+        case PixelFormat::FLOAT16_R:
+        case PixelFormat::FLOAT16_GR:
+        case PixelFormat::FLOAT16_RGB:
+        case PixelFormat::FLOAT16_RGBA:
+        case PixelFormat::SHORT_RGB:
+        case PixelFormat::SHORT_RGBA:
+        case PixelFormat::BYTE_LA:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/** The description of a pixel format as compile time constants.
+
+    pack() and unpack() give the same results as PixelUtil::pack_color and
+    unpack_color, but with the layout known to the compiler every mask, shift
+    and branch on the format folds away.
+*/
+template <PixelFormat F>
+struct PixelFormatTraits {
+    static_assert(has_pixel_format_traits(F), "format can not be packed per pixel");
+
+    static constexpr PixelFormatDescription description = _pixelFormats[size_t(F)];
+    static constexpr uint8_t elem_bytes = description.elem_bytes;
+    static constexpr uint32_t flags = description.flags;
+
+    /// Unpack one pixel to r, g, b, a
+    static inline void unpack(const uint8_t* src, float* rgba)
+    {
+        constexpr const PixelFormatDescription& des = description;
+        if constexpr ((des.flags & PFF_NATIVEENDIAN) != 0) {
+            const unsigned int value = Bitwise::int_read(src, des.elem_bytes);
+            if constexpr ((des.flags & PFF_LUMINANCE) != 0) {
+                rgba[0] = rgba[1] = rgba[2] = Bitwise::fixed_to_float((value & des.rmask) >> des.rshift, des.rbits);
+            } else {
+                rgba[0] = Bitwise::fixed_to_float((value & des.rmask) >> des.rshift, des.rbits);
+                rgba[1] = Bitwise::fixed_to_float((value & des.gmask) >> des.gshift, des.gbits);
+                rgba[2] = Bitwise::fixed_to_float((value & des.bmask) >> des.bshift, des.bbits);
+            }
+            if constexpr ((des.flags & PFF_HAS_ALPHA) != 0)
+                rgba[3] = Bitwise::fixed_to_float((value & des.amask) >> des.ashift, des.abits);
+            else
+                rgba[3] = 1.0f;
+        } else {
+            unpack_non_native(F, src, &rgba[0], &rgba[1], &rgba[2], &rgba[3]);
+        }
+    }
+
+    /// Pack r, g, b, a to one pixel
+    static inline void pack(const float* rgba, uint8_t* dst)
+    {
+        constexpr const PixelFormatDescription& des = description;
+        if constexpr ((des.flags & PFF_NATIVEENDIAN) != 0) {
+            const unsigned int value = ((Bitwise::float_to_fixed(rgba[0], des.rbits) << des.rshift) & des.rmask)
+                                       | ((Bitwise::float_to_fixed(rgba[1], des.gbits) << des.gshift) & des.gmask)
+                                       | ((Bitwise::float_to_fixed(rgba[2], des.bbits) << des.bshift) & des.bmask)
+                                       | ((Bitwise::float_to_fixed(rgba[3], des.abits) << des.ashift) & des.amask);
+            Bitwise::int_write(dst, des.elem_bytes, value);
+        } else {
+            pack_non_native(rgba[0], rgba[1], rgba[2], rgba[3], F, dst);
+        }
+    }
+};
+
+/** Row converter between two formats with PixelFormatTraits, or nullptr.
+
+    The converters of every pair are generated at compile time into one table,
+    so picking one costs two lookups instead of a format switch per pixel.
+*/
+PixelRowConverter get_traits_row_converter(PixelFormat src_format, PixelFormat dst_format);
+
+} // namespace hyue
@@ -0,0 +1,360 @@
+#include <hyue/PluginManager.h>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <set>
+
+#include <hyue/log.h>
+#include <hyue/StringUtils.h>
+
+namespace hyue {
+
+namespace {
+
+#if HYUE_OS_WINDOWS
+const char* const LIBRARY_EXTENSION = ".dll";
+#elif BOOST_OS_MACOS
+const char* const LIBRARY_EXTENSION = ".dylib";
+#else
+const char* const LIBRARY_EXTENSION = ".so";
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------
+template <>
+PluginManager* Singleton<PluginManager>::singleton_ = nullptr;
+
+//-----------------------------------------------------------------------
+PluginManager::PluginManager()
+{
+}
+
+PluginManager::~PluginManager()
+{
+    unload();
+}
+
+//-----------------------------------------------------------------------
+void PluginManager::add_library(const String& path)
+{
+    queued_libraries_.push_back(path);
+}
+
+//-----------------------------------------------------------------------
+size_t PluginManager::add_directory(const String& dir)
+{
+    StringVector paths;
+    for (auto& entry : std_fs::directory_iterator(dir)) {
+        if (entry.is_regular_file() && entry.path().extension() == LIBRARY_EXTENSION)
+            paths.push_back(entry.path().string());
+    }
+    // directory order is unspecified, keep loads reproducible
+    std::sort(paths.begin(), paths.end());
+
+    for (auto& path : paths)
+        add_library(path);
+    return paths.size();
+}
+
+//-----------------------------------------------------------------------
+size_t PluginManager::add_config(const String& path)
+{
+    std::ifstream is(path);
+    if (!is)
+        panic("Cannot open plugin configuration '" + path + "'");
+
+    // relative folders are relative to the configuration file
+    FilePath base = FilePath(path).parent_path();
+    FilePath folder = base;
+    size_t count = 0;
+
+    String line;
+    while (std::getline(is, line)) {
+        StringUtils::trim(&line);
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        size_t eq = line.find('=');
+        if (eq == String::npos)
+            continue;
+        String key = StringUtils::trim(line.substr(0, eq));
+        String value = StringUtils::trim(line.substr(eq + 1));
+
+        if (key == "PluginFolder") {
+            folder = base / value;
+        } else if (key == "Plugin") {
+            FilePath library = folder / value;
+            if (!library.has_extension())
+                library += LIBRARY_EXTENSION;
+            add_library(library.string());
+            ++count;
+        }
+    }
+    return count;
+}
+
+//-----------------------------------------------------------------------
+void PluginManager::add_plugin(Plugin* plugin)
+{
+    HYUE_ASSERT(plugin, "cannot add a null plugin");
+    queued_plugins_.push_back(plugin);
+}
+
+//-----------------------------------------------------------------------
+PluginManager::Entry PluginManager::load_library(const String& path)
+{
+    Entry ret;
+    ret.info.library = path;
+
+    auto begin = Clock::now();
+    auto library = std::make_unique<DynLib>(path);
+    library->load(library_flags_);
+
+    auto create = reinterpret_cast<CreatePluginFunc>(library->get_symbol("hyue_create_plugin"));
+    if (!create || !library->get_symbol("hyue_destroy_plugin")) {
+        library->unload();
+        panic("Library '" + path + "' is not a hyue plugin");
+    }
+    // DynLib does not unload on destruction, a throwing plugin must not leak the handle
+    try {
+        ret.plugin = create();
+        ret.info.load_ms = elapsed_ms(begin);
+        ret.info.name = ret.plugin->get_name();
+    } catch (...) {
+        if (ret.plugin)
+            reinterpret_cast<DestroyPluginFunc>(library->get_symbol("hyue_destroy_plugin"))(ret.plugin);
+        library->unload();
+        throw;
+    }
+
+    ret.library = library.get();
+    libraries_.push_back(std::move(library));
+    return ret;
+}
+
+//-----------------------------------------------------------------------
+void PluginManager::destroy(Entry& entry)
+{
+    if (!entry.library)
+        return;
+
+    auto destroy_plugin = reinterpret_cast<DestroyPluginFunc>(entry.library->get_symbol("hyue_destroy_plugin"));
+    destroy_plugin(entry.plugin);
+    entry.plugin = nullptr;
+
+    auto it = std::find_if(libraries_.begin(), libraries_.end(), [&](const std::unique_ptr<DynLib>& lib) {
+        return lib.get() == entry.library;
+    });
+    (*it)->unload();
+    libraries_.erase(it);
+    entry.library = nullptr;
+}
+
+//-----------------------------------------------------------------------
+void PluginManager::load(Executor* executor)
+{
+    auto begin = Clock::now();
+
+    std::vector<Entry> pending;
+    auto drop_pending = [&]() {
+        for (auto& entry : pending)
+            destroy(entry);
+    };
+
+    // the dynamic loader holds a global lock, opening libraries in parallel gains nothing
+    StringVector libraries;
+    libraries.swap(queued_libraries_);
+    try {
+        for (auto& path : libraries)
+            pending.push_back(load_library(path));
+    } catch (...) {
+        drop_pending();
+        throw;
+    }
+    for (auto plugin : queued_plugins_) {
+        Entry entry;
+        entry.plugin = plugin;
+        entry.info.name = plugin->get_name();
+        pending.push_back(entry);
+    }
+    queued_plugins_.clear();
+
+    // sort into waves, each plugin goes in the wave after its last dependency
+    std::set<String> names;
+    for (auto& entry : installed_)
+        names.insert(entry.info.name);
+    for (auto& entry : pending) {
+        if (!names.insert(entry.info.name).second) {
+            drop_pending();
+            panic("Plugin '" + entry.info.name + "' is loaded twice");
+        }
+    }
+
+    std::vector<StringVector> dependencies;
+    for (auto& entry : pending) {
+        dependencies.push_back(entry.plugin->get_dependencies());
+        for (auto& dep : dependencies.back()) {
+            if (!names.count(dep)) {
+                String name = entry.info.name;
+                drop_pending();
+                panic("Plugin '" + name + "' depends on missing plugin '" + dep + "'");
+            }
+        }
+    }
+
+    std::set<String> done;
+    for (auto& entry : installed_)
+        done.insert(entry.info.name);
+
+    std::vector<std::vector<size_t>> waves;
+    std::vector<bool> placed(pending.size(), false);
+    for (size_t remaining = pending.size(); remaining > 0;) {
+        std::vector<size_t> wave;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            if (placed[i])
+                continue;
+            bool ready = std::all_of(dependencies[i].begin(), dependencies[i].end(), [&](const String& dep) {
+                return done.count(dep) != 0;
+            });
+            if (ready)
+                wave.push_back(i);
+        }
+        if (wave.empty()) {
+            String cycle;
+            for (size_t i = 0; i < pending.size(); ++i) {
+                if (!placed[i])
+                    cycle += (cycle.empty() ? "'" : ", '") + pending[i].info.name + "'";
+            }
+            drop_pending();
+            panic("Plugins " + cycle + " have cyclic dependencies");
+        }
+        for (auto i : wave) {
+            placed[i] = true;
+            pending[i].info.wave = waves.size();
+            done.insert(pending[i].info.name);
+        }
+        remaining -= wave.size();
+        waves.push_back(std::move(wave));
+    }
+
+    if (!executor)
+        executor = &ThreadPool::get_worker_pool();
+
+    size_t first_new = installed_.size();
+    // written by the install jobs, so not a vector<bool>
+    std::vector<char> installed(pending.size(), 0);
+    for (auto& wave : waves) {
+        auto install = [&](size_t i) {
+            Entry& entry = pending[wave[i]];
+            auto install_begin = Clock::now();
+            entry.plugin->install();
+            entry.info.install_ms = elapsed_ms(install_begin);
+            installed[wave[i]] = 1;
+        };
+
+        std::exception_ptr error;
+        try {
+            // a single plugin is not worth a trip through the executor
+            if (wave.size() == 1)
+                install(0);
+            else
+                executor->parallel_for(wave.size(), install);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        for (auto i : wave) {
+            if (installed[i])
+                installed_.push_back(pending[i]);
+        }
+        if (error) {
+            for (size_t i = 0; i < pending.size(); ++i) {
+                if (!installed[i])
+                    destroy(pending[i]);
+            }
+            for (size_t i = first_new; i < installed_.size(); ++i)
+                info_.push_back(installed_[i].info);
+            std::rethrow_exception(error);
+        }
+    }
+
+    for (size_t i = first_new; i < installed_.size(); ++i) {
+        const PluginInfo& info = installed_[i].info;
+        info_.push_back(info);
+        if (info.library.empty()) {
+            LOG(info) << "Plugin '" << info.name << "' installed in " << info.install_ms << " ms (wave "
+                      << info.wave << ")";
+        } else {
+            LOG(info) << "Plugin '" << info.name << "' loaded from '" << info.library << "' in " << info.load_ms
+                      << " ms, installed in " << info.install_ms << " ms (wave " << info.wave << ")";
+        }
+    }
+    LOG(info) << pending.size() << " plugins loaded in " << elapsed_ms(begin) << " ms, " << waves.size()
+              << " install waves";
+
+    if (initialised_) {
+        for (size_t i = first_new; i < installed_.size(); ++i)
+            installed_[i].plugin->initialise();
+    }
+}
+
+//-----------------------------------------------------------------------
+void PluginManager::initialise()
+{
+    if (initialised_)
+        return;
+
+    for (auto& entry : installed_)
+        entry.plugin->initialise();
+    initialised_ = true;
+}
+
+//-----------------------------------------------------------------------
+void PluginManager::shutdown()
+{
+    if (!initialised_)
+        return;
+
+    for (auto it = installed_.rbegin(); it != installed_.rend(); ++it)
+        it->plugin->shutdown();
+    initialised_ = false;
+}
+
+//-----------------------------------------------------------------------
+void PluginManager::unload()
+{
+    shutdown();
+
+    while (!installed_.empty()) {
+        Entry entry = installed_.back();
+        installed_.pop_back();
+        entry.plugin->uninstall();
+        destroy(entry);
+        LOG(debug) << "Plugin '" << entry.info.name << "' unloaded";
+    }
+    info_.clear();
+    queued_libraries_.clear();
+    queued_plugins_.clear();
+}
+
+//-----------------------------------------------------------------------
+Plugin* PluginManager::get_plugin(const String& name) const
+{
+    for (auto& entry : installed_) {
+        if (entry.info.name == name)
+            return entry.plugin;
+    }
+    return nullptr;
+}
+
+} // namespace hyue
@@ -0,0 +1,309 @@
+#include <hyue/RenderQueue.h>
+
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+#include <cstring>
+
+#include <hyue/thread.h>
+
+namespace hyue {
+
+namespace {
+
+/// Collections smaller than this are sorted with std::stable_sort, as in Ogre
+constexpr size_t RADIX_THRESHOLD = 2000;
+
+/// Collections must have this many renderables before the radix passes are split across threads
+constexpr size_t PARALLEL_SORT_THRESHOLD = 65536;
+
+/// Smallest block of a parallel radix pass
+constexpr size_t SORT_BLOCK = 16384;
+
+/// Elements per renderable the coherent insertion sort may shift before falling back to radix
+constexpr size_t COHERENT_MOVES = 8;
+
+/// Renderable ids per queued renderable, above this many (and RANK_TABLE_MIN) the ids are not dense
+constexpr size_t RANK_TABLE_SPREAD = 4;
+constexpr size_t RANK_TABLE_MIN = 65536;
+
+/// End of the chain of ranks of a renderable
+constexpr uint32_t NO_RANK = ~uint32_t(0);
+
+/// Set on a rank when the renderable was queued again further on
+constexpr uint32_t MORE_RANKS = 0x80000000u;
+
+/// Map a float to an unsigned integer with the same order
+inline uint32_t get_float_key(float f)
+{
+    // -0 and 0 are equal
+    f += 0.0f;
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return (u & 0x80000000u) ? ~u : u | 0x80000000u;
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------
+QueuedRenderableCollection::QueuedRenderableCollection()
+{
+}
+
+QueuedRenderableCollection::~QueuedRenderableCollection()
+{
+}
+
+//-----------------------------------------------------------------------
+void QueuedRenderableCollection::set_organisation_mode(OrganisationMode mode)
+{
+    mode_ = mode;
+    ranked_count_ = 0;
+}
+
+//-----------------------------------------------------------------------
+void QueuedRenderableCollection::clear()
+{
+    queued_.clear();
+}
+
+//-----------------------------------------------------------------------
+void QueuedRenderableCollection::add_renderables(const std::vector<uint32_t>& renderables,
+                                                 uint32_t pass,
+                                                 const float* depths)
+{
+    queued_.reserve(queued_.size() + renderables.size());
+    for (uint32_t renderable : renderables)
+        queued_.push_back({renderable, pass, depths[renderable]});
+}
+
+//-----------------------------------------------------------------------
+uint64_t QueuedRenderableCollection::get_sort_key(const RenderablePass& rp) const
+{
+    switch (mode_) {
+        case OM_PASS_GROUP:
+            return rp.pass;
+        case OM_SORT_DESCENDING:
+            return uint64_t(~get_float_key(rp.depth)) << 32 | rp.pass;
+        case OM_SORT_ASCENDING:
+            return uint64_t(get_float_key(rp.depth)) << 32 | rp.pass;
+    }
+    return 0;
+}
+
+//-----------------------------------------------------------------------
+void QueuedRenderableCollection::sort(Executor* executor)
+{
+    stats_ = SortStats();
+    const size_t count = queued_.size();
+
+    // when the coherent fix up gives up, start again from the order of addition
+    if (!(coherent_ && ranked_count_ > 0 && sort_coherent())) {
+        items_.resize(count);
+        for (size_t i = 0; i < count; ++i)
+            items_[i] = {get_sort_key(queued_[i]), uint32_t(i)};
+        if (count < RADIX_THRESHOLD) {
+            std::stable_sort(items_.begin(), items_.end(),
+                             [](const SortItem& a, const SortItem& b) { return a.key < b.key; });
+        } else {
+            radix_sort(executor);
+        }
+    }
+
+    sorted_.resize(count);
+    for (size_t i = 0; i < count; ++i)
+        sorted_[i] = queued_[items_[i].index];
+
+    if (coherent_)
+        store_ranks();
+    else
+        ranked_count_ = 0;
+}
+
+//-----------------------------------------------------------------------
+bool QueuedRenderableCollection::sort_coherent()
+{
+    const size_t count = queued_.size();
+
+    // back in the order of the previous sort, renderables new to the
+    // collection go last. The occurrences of a renderable queued several
+    // times take its previous ranks in turn. Ranks of renderables gone since
+    // are skipped by counting the ranks still in use before each one in a
+    // bitset, small enough to stay in cache.
+    item_ranks_.resize(count);
+    rank_bits_.assign((ranked_count_ + 63) / 64, 0);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t renderable = queued_[i].renderable;
+        uint32_t rank = NO_RANK;
+        if (renderable < ranks_.size() && ranks_[renderable].stamp == sort_count_) {
+            RankEntry& entry = ranks_[renderable];
+            rank = entry.rank;
+            if (rank != NO_RANK) {
+                if (rank & MORE_RANKS) {
+                    rank &= ~MORE_RANKS;
+                    entry.rank = next_ranks_[rank];
+                } else {
+                    entry.rank = NO_RANK;
+                }
+                rank_bits_[rank >> 6] |= uint64_t(1) << (rank & 63);
+            }
+        }
+        item_ranks_[i] = rank;
+    }
+    rank_offsets_.resize(rank_bits_.size());
+    uint32_t ranked = 0;
+    for (size_t w = 0; w < rank_bits_.size(); ++w) {
+        rank_offsets_[w] = ranked;
+        ranked += uint32_t(std::bitset<64>(rank_bits_[w]).count());
+    }
+    items_.resize(count);
+    scratch_.resize(count);
+    for (size_t i = 0, fresh = ranked; i < count; ++i) {
+        uint32_t rank = item_ranks_[i];
+        size_t index = fresh;
+        if (rank == NO_RANK) {
+            ++fresh;
+        } else {
+            uint64_t before = rank_bits_[rank >> 6] & ((uint64_t(1) << (rank & 63)) - 1);
+            index = rank_offsets_[rank >> 6] + std::bitset<64>(before).count();
+        }
+        items_[index] = {get_sort_key(queued_[i]), uint32_t(i)};
+    }
+
+    // insertion sort of the renderables ranked before, the index breaks ties
+    // so the result is the one of a stable sort
+    auto less = [](const SortItem& a, const SortItem& b) {
+        return a.key < b.key || (a.key == b.key && a.index < b.index);
+    };
+    const size_t budget = count * COHERENT_MOVES;
+    size_t moves = 0;
+    for (size_t i = 1; i < ranked; ++i) {
+        SortItem item = items_[i];
+        size_t j = i;
+        while (j > 0 && less(item, items_[j - 1])) {
+            items_[j] = items_[j - 1];
+            --j;
+            if (++moves > budget) {
+                stats_.moves = moves;
+                return false;
+            }
+        }
+        items_[j] = item;
+    }
+
+    // the new ones are sorted on their own and merged in
+    if (ranked < count) {
+        std::sort(items_.begin() + ranked, items_.end(), less);
+        std::merge(items_.begin(), items_.begin() + ranked, items_.begin() + ranked, items_.end(), scratch_.begin(),
+                   less);
+        items_.swap(scratch_);
+    }
+
+    stats_.coherent = true;
+    stats_.moves = moves;
+    return true;
+}
+
+//-----------------------------------------------------------------------
+void QueuedRenderableCollection::radix_sort(Executor* executor)
+{
+    const size_t count = items_.size();
+    scratch_.resize(count);
+
+    // digits that are the same in every key need no pass
+    uint64_t key_or = 0, key_and = ~uint64_t(0);
+    for (const SortItem& item : items_) {
+        key_or |= item.key;
+        key_and &= item.key;
+    }
+    const uint64_t varying = key_or ^ key_and;
+
+    size_t blocks = 1;
+    if (count >= PARALLEL_SORT_THRESHOLD) {
+        if (!executor)
+            executor = &ThreadPool::get_worker_pool();
+        blocks = std::min(executor->get_concurrency(), count / SORT_BLOCK);
+    }
+    const size_t step = (count + blocks - 1) / blocks;
+    blocks = (count + step - 1) / step;
+    stats_.parallel = blocks > 1;
+    auto run = [&](const std::function<void(size_t)>& job) {
+        if (blocks == 1)
+            job(0);
+        else
+            executor->parallel_for(blocks, job);
+    };
+
+    counts_.resize(blocks * 256);
+    for (int shift = 0; shift < 64; shift += 8) {
+        if (((varying >> shift) & 0xff) == 0)
+            continue;
+        ++stats_.radix_passes;
+
+        run([&](size_t b) {
+            size_t* counts = &counts_[b * 256];
+            std::fill(counts, counts + 256, 0);
+            for (size_t i = b * step, end = std::min(i + step, count); i < end; ++i)
+                ++counts[(items_[i].key >> shift) & 0xff];
+        });
+
+        // digit major, block minor, so the scatter keeps the order of the blocks
+        size_t offset = 0;
+        for (size_t digit = 0; digit < 256; ++digit) {
+            for (size_t b = 0; b < blocks; ++b) {
+                size_t n = counts_[b * 256 + digit];
+                counts_[b * 256 + digit] = offset;
+                offset += n;
+            }
+        }
+
+        run([&](size_t b) {
+            size_t* offsets = &counts_[b * 256];
+            for (size_t i = b * step, end = std::min(i + step, count); i < end; ++i)
+                scratch_[offsets[(items_[i].key >> shift) & 0xff]++] = items_[i];
+        });
+        items_.swap(scratch_);
+    }
+}
+
+//-----------------------------------------------------------------------
+void QueuedRenderableCollection::store_ranks()
+{
+    if (++sort_count_ == 0) {
+        // the stamps wrapped, none of them may match by accident
+        for (RankEntry& entry : ranks_)
+            entry.stamp = 0;
+        sort_count_ = 1;
+    }
+
+    uint32_t max_renderable = 0;
+    for (const RenderablePass& rp : sorted_)
+        max_renderable = std::max(max_renderable, rp.renderable);
+
+    // renderable ids are required to be dense; should sparse ones get here
+    // anyway, they go without the coherent sort rather than an unbounded table
+    size_t table_limit = std::max(sorted_.size() * RANK_TABLE_SPREAD, RANK_TABLE_MIN);
+    assert(max_renderable < table_limit && "renderable ids must be dense for coherent sorting");
+    if (max_renderable >= table_limit) {
+        ranked_count_ = 0;
+        return;
+    }
+    if (!sorted_.empty() && ranks_.size() <= max_renderable)
+        ranks_.resize(size_t(max_renderable) + 1, RankEntry{NO_RANK, 0});
+
+    // backwards, so a renderable queued several times ranks at its first
+    // occurrence and every occurrence links to the next
+    next_ranks_.resize(sorted_.size());
+    for (size_t i = sorted_.size(); i-- > 0;) {
+        RankEntry& entry = ranks_[sorted_[i].renderable];
+        if (entry.stamp == sort_count_) {
+            next_ranks_[i] = entry.rank;
+            entry.rank = uint32_t(i) | MORE_RANKS;
+        } else {
+            entry = {uint32_t(i), sort_count_};
+        }
+    }
+    ranked_count_ = sorted_.size();
+}
+
+} // namespace hyue
@@ -3,6 +3,7 @@
 #include <hyue/log.h>
 #include <hyue/FileSystemArchiveFactory.h>
 #include <hyue/ZipArchiveFactory.h>
+#include <hyue/PackArchiveFactory.h>
 #include <hyue/ArchiveManager.h>
 
 #include "init_logging.h"
@@ -16,17 +17,24 @@ Root::Root(const String &log_file) {
 
     archive_factories_.push_back(std::make_unique<FileSystemArchiveFactory>());
     archive_factories_.push_back(std::make_unique<ZipArchiveFactory>());
+    archive_factories_.push_back(std::make_unique<PackArchiveFactory>());
 
     archive_manager_ = std::make_unique<ArchiveManager>();
     for (auto& item : archive_factories_) {
         ArchiveManager::get_singleton()->add_archive_factory(item.get());
     }
+
+    plugin_manager_ = std::make_unique<PluginManager>();
 }
 
 Root::~Root()
 {
+    // plugins may still use the managers while uninstalling
+    plugin_manager_.reset();
     archive_manager_.reset();
     archive_factories_.clear();
+
+    shutdown_logging();
 }
 
 template <>
@@ -0,0 +1,169 @@
+#include <hyue/SkinningStage.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include <hyue/panic.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
+
+#include "skinning_simd.h"
+
+namespace hyue {
+
+namespace {
+
+/// Vertices per range of a run, a multiple of 8 so only the last range of a mesh has a scalar tail
+constexpr size_t SKIN_RANGE = 4096;
+
+} // namespace
+
+//-----------------------------------------------------------------------
+void skin_scalar(const SkinnedVertexData& data, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i) {
+        const float* weights = get_vertex(data.blend_weights, data.blend_weight_stride, i);
+        const uint8_t* indices = get_vertex(data.blend_indices, data.blend_index_stride, i);
+
+        // blend the matrices, then transform once
+        float m[3][4] = {};
+        for (size_t k = 0; k < data.weights_per_vertex; ++k) {
+            float weight = weights[k];
+            if (weight == 0)
+                continue;
+            const mat3x4& blend = data.blend_matrices[indices[k]];
+            for (int r = 0; r < 3; ++r) {
+                for (int c = 0; c < 4; ++c)
+                    m[r][c] += blend.a[r][c] * weight;
+            }
+        }
+
+        const float* src = get_vertex(data.src_position, data.src_position_stride, i);
+        float* dst = get_vertex(data.dst_position, data.dst_position_stride, i);
+        float x = src[0], y = src[1], z = src[2];
+        for (int r = 0; r < 3; ++r)
+            dst[r] = m[r][0] * x + m[r][1] * y + m[r][2] * z + m[r][3];
+
+        if (data.src_normal) {
+            // the 3x3 part is assumed orthogonal, its inverse transpose is itself
+            src = get_vertex(data.src_normal, data.src_normal_stride, i);
+            dst = get_vertex(data.dst_normal, data.dst_normal_stride, i);
+            x = src[0], y = src[1], z = src[2];
+            for (int r = 0; r < 3; ++r)
+                dst[r] = m[r][0] * x + m[r][1] * y + m[r][2] * z;
+            normalise(dst);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+void morph_scalar(const MorphVertexData& data, size_t begin, size_t end)
+{
+    const float t = data.t;
+    const int elements = data.morph_normals ? 6 : 3;
+    for (size_t i = begin; i < end; ++i) {
+        const float* src1 = get_vertex(data.src_position1, data.src_stride1, i);
+        const float* src2 = get_vertex(data.src_position2, data.src_stride2, i);
+        float* dst = get_vertex(data.dst_position, data.dst_stride, i);
+        for (int e = 0; e < elements; ++e)
+            dst[e] = src1[e] + t * (src2[e] - src1[e]);
+        // normals are interpolated linearly then renormalised, there is not
+        // enough information for a spherical interpolation
+        if (data.morph_normals)
+            normalise(dst + 3);
+    }
+}
+
+//-----------------------------------------------------------------------
+SkinningStage::SkinningStage()
+{
+}
+
+SkinningStage::~SkinningStage()
+{
+}
+
+//-----------------------------------------------------------------------
+void SkinningStage::add_skinning(const SkinnedVertexData& data)
+{
+    HYUE_ASSERT(data.src_position_stride % sizeof(float) == 0 && data.blend_weight_stride % sizeof(float) == 0 &&
+                    data.src_normal_stride % sizeof(float) == 0,
+                "vertex strides must be multiples of the size of a float");
+    HYUE_ASSERT(!data.src_normal || data.dst_normal, "skinned normals need a destination");
+    skinned_.push_back(data);
+}
+
+//-----------------------------------------------------------------------
+void SkinningStage::add_morph(const MorphVertexData& data)
+{
+    morphed_.push_back(data);
+}
+
+//-----------------------------------------------------------------------
+void SkinningStage::clear()
+{
+    skinned_.clear();
+    morphed_.clear();
+}
+
+//-----------------------------------------------------------------------
+void SkinningStage::run(Executor* executor)
+{
+    auto start = std::chrono::steady_clock::now();
+    stats_ = FrameStats();
+    stats_.meshes = size();
+
+    // ranges of at most SKIN_RANGE vertices, then jobs of consecutive ranges
+    // with at least SKIN_RANGE vertices so small meshes are batched together
+    ranges_.clear();
+    auto add_ranges = [&](size_t mesh, size_t count) {
+        for (size_t begin = 0; begin < count; begin += SKIN_RANGE)
+            ranges_.push_back({uint32_t(mesh), begin, std::min(begin + SKIN_RANGE, count)});
+    };
+    for (size_t m = 0; m < skinned_.size(); ++m) {
+        add_ranges(m, skinned_[m].vertex_count);
+        stats_.skinned_vertices += skinned_[m].vertex_count;
+    }
+    for (size_t m = 0; m < morphed_.size(); ++m) {
+        add_ranges(skinned_.size() + m, morphed_[m].vertex_count);
+        stats_.morphed_vertices += morphed_[m].vertex_count;
+    }
+
+    jobs_.clear();
+    size_t vertices = SKIN_RANGE;
+    for (size_t r = 0; r < ranges_.size(); ++r) {
+        if (vertices >= SKIN_RANGE) {
+            jobs_.push_back(r);
+            vertices = 0;
+        }
+        vertices += ranges_[r].end - ranges_[r].begin;
+    }
+    jobs_.push_back(ranges_.size());
+    stats_.jobs = jobs_.size() - 1;
+
+    SkinningKernel kernel = select_simd(HYUE_AVX2_KERNEL(avx2_skin),
+                                        HYUE_SSE2_KERNEL(sse2_skin),
+                                        skin_scalar);
+    auto run_job = [&](size_t job) {
+        for (size_t r = jobs_[job]; r < jobs_[job + 1]; ++r) {
+            const Range& range = ranges_[r];
+            if (range.mesh < skinned_.size())
+                kernel(skinned_[range.mesh], range.begin, range.end);
+            else
+                morph_scalar(morphed_[range.mesh - skinned_.size()], range.begin, range.end);
+        }
+    };
+    if (stats_.jobs == 1) {
+        run_job(0);
+    } else if (stats_.jobs > 1) {
+        if (!executor)
+            executor = &ThreadPool::get_worker_pool();
+        executor->parallel_for(stats_.jobs, run_job);
+    }
+
+    clear();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    stats_.milliseconds = elapsed.count();
+}
+
+} // namespace hyue
@@ -0,0 +1,216 @@
+#include <hyue/StreamReader.h>
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <hyue/panic.h>
+
+#include "simd_intrinsics.h"
+
+namespace hyue {
+
+/// Separator sets up to this size are searched with SIMD compares
+#define HYUE_SIMD_MAX_SEPARATORS 8
+
+StreamReader::StreamReader(const DataStreamPtr& stream, size_t block_size, std::vector<char>* buffer)
+: stream_(stream),
+  block_size_(std::max<size_t>(block_size, 16)),
+  buffer_(buffer ? buffer : &own_buffer_),
+  data_(nullptr),
+  begin_(0),
+  end_(0),
+  in_place_(false),
+  stream_ended_(false),
+  consumed_(0)
+{
+    std::fill(separator_table_, separator_table_ + 256, false);
+
+    // memory is already one big block, scan it where it is
+    auto memory = dynamic_cast<MemoryDataStream*>(stream_.get());
+    if (memory) {
+        size_t size = memory->get_size() - memory->tell();
+        data_ = reinterpret_cast<const char*>(memory->get_current_ptr());
+        end_ = size;
+        in_place_ = true;
+        stream_ended_ = true;
+        memory->skip(long(size));
+    }
+}
+
+bool StreamReader::fill()
+{
+    if (stream_ended_)
+        return false;
+
+    // keep the unconsumed tail, grow only when it takes most of the buffer
+    std::vector<char>& buffer = *buffer_;
+    size_t pending = end_ - begin_;
+    if (begin_ > 0 && pending > 0)
+        memmove(buffer.data(), buffer.data() + begin_, pending);
+    begin_ = 0;
+    end_ = pending;
+
+    if (buffer.size() < pending + block_size_)
+        buffer.resize(std::max(pending + block_size_, buffer.size() * 2));
+
+    size_t count = stream_->read(buffer.data() + end_, buffer.size() - end_);
+    if (count == 0)
+        stream_ended_ = true;
+    end_ += count;
+    data_ = buffer.data();
+    return count != 0;
+}
+
+bool StreamReader::is_eof()
+{
+    return begin_ == end_ && !fill();
+}
+
+std::string_view StreamReader::consume(size_t count, size_t skip)
+{
+    std::string_view ret(data_ + begin_, count);
+    begin_ += count + skip;
+    consumed_ += count + skip;
+    return ret;
+}
+
+bool StreamReader::read_line(std::string_view* line, std::string_view delim)
+{
+    HYUE_ASSERT(!delim.empty(), "StreamReader::read_line needs a delimiter");
+
+    size_t from = 0;
+    while (true) {
+        // memchr runs vectorised, most candidates are a full match anyway
+        const char* begin = data_ + begin_;
+        const char* end = data_ + end_;
+        const char* p = begin + from;
+        while (p + delim.size() <= end) {
+            p = static_cast<const char*>(memchr(p, delim[0], size_t(end - p) - delim.size() + 1));
+            if (!p)
+                break;
+            if (memcmp(p + 1, delim.data() + 1, delim.size() - 1) == 0) {
+                size_t length = size_t(p - begin);
+                *line = consume(length, delim.size());
+                if (delim == "\n" && !line->empty() && line->back() == '\r')
+                    line->remove_suffix(1);
+                return true;
+            }
+            ++p;
+        }
+
+        // the delimiter may straddle the end of the data
+        size_t pending = end_ - begin_;
+        from = pending >= delim.size() ? pending - delim.size() + 1 : 0;
+        if (!fill()) {
+            if (begin_ == end_)
+                return false;
+            // last line without delimiter
+            *line = consume(end_ - begin_, 0);
+            return true;
+        }
+    }
+}
+
+size_t StreamReader::skip_line(std::string_view delim)
+{
+    size_t start = consumed_;
+    std::string_view line;
+    read_line(&line, delim);
+    return consumed_ - start;
+}
+
+size_t StreamReader::find_separator(size_t from, bool separator) const
+{
+    const char* begin = data_ + begin_;
+    const char* p = begin + from;
+    const char* end = data_ + end_;
+
+#if HYUE_SIMD_SSE2
+    if (separator && separators_.size() <= HYUE_SIMD_MAX_SEPARATORS) {
+        __m128i chars[HYUE_SIMD_MAX_SEPARATORS];
+        for (size_t i = 0; i < separators_.size(); ++i)
+            chars[i] = _mm_set1_epi8(separators_[i]);
+
+        for (; p + 16 <= end; p += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i match = _mm_setzero_si128();
+            for (size_t i = 0; i < separators_.size(); ++i)
+                match = _mm_or_si128(match, _mm_cmpeq_epi8(v, chars[i]));
+            int mask = _mm_movemask_epi8(match);
+            if (mask)
+                return size_t(p - begin) + size_t(__builtin_ctz(unsigned(mask)));
+        }
+    }
+#endif
+
+    for (; p < end; ++p) {
+        if (separator_table_[uint8_t(*p)] == separator)
+            return size_t(p - begin);
+    }
+    return String::npos;
+}
+
+bool StreamReader::read_token(std::string_view* token, std::string_view separators)
+{
+    if (separators != separators_) {
+        separators_.assign(separators.data(), separators.size());
+        std::fill(separator_table_, separator_table_ + 256, false);
+        for (char c : separators)
+            separator_table_[uint8_t(c)] = true;
+    }
+
+    // skip the separators in front
+    while (true) {
+        size_t pos = find_separator(0, false);
+        if (pos != String::npos) {
+            consume(pos, 0);
+            break;
+        }
+        consume(end_ - begin_, 0);
+        if (!fill())
+            return false;
+    }
+
+    size_t from = 0;
+    while (true) {
+        size_t pos = find_separator(from, true);
+        if (pos != String::npos) {
+            *token = consume(pos, 1);
+            return true;
+        }
+        from = end_ - begin_;
+        if (!fill()) {
+            *token = consume(end_ - begin_, 0);
+            return true;
+        }
+    }
+}
+
+size_t StreamReader::read(void* buf, size_t count)
+{
+    char* dst = static_cast<char*>(buf);
+    size_t total = 0;
+    while (total < count) {
+        if (begin_ == end_) {
+            // large reads go straight to the stream
+            if (!in_place_ && count - total >= block_size_ && !stream_ended_) {
+                size_t n = stream_->read(dst + total, count - total);
+                if (n == 0)
+                    stream_ended_ = true;
+                total += n;
+                consumed_ += n;
+                continue;
+            }
+            if (!fill())
+                break;
+        }
+        size_t n = std::min(count - total, end_ - begin_);
+        memcpy(dst + total, data_ + begin_, n);
+        consume(n, 0);
+        total += n;
+    }
+    return total;
+}
+
+} // namespace hyue
@@ -0,0 +1,471 @@
+#include <hyue/TransformHierarchy.h>
+
+#include <algorithm>
+#include <type_traits>
+
+#include <hyue/panic.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
+
+#include "transform_update_simd.h"
+
+namespace hyue {
+
+namespace {
+
+constexpr uint32_t DEAD_SLOT = ~uint32_t(0);
+
+/// Slots a level must have before its update is split across threads
+constexpr size_t PARALLEL_BATCH = 4096;
+
+const float IDENTITY[TransformHierarchy::COMPONENT_COUNT] = {0, 0, 0, 1, 0, 0, 0, 1, 1, 1};
+
+using C = TransformHierarchy;
+
+/** Combine a local transform with the derived transform of its parent, the
+    same way as Ogre's Node::_updateFromParent.
+*/
+inline void combine(const float* parent, const float* local, uint8_t flags, float* out)
+{
+    // position: scaled and rotated by the parent, whatever the inherit flags
+    float vx = parent[C::SCALE_X] * local[C::POS_X];
+    float vy = parent[C::SCALE_Y] * local[C::POS_Y];
+    float vz = parent[C::SCALE_Z] * local[C::POS_Z];
+    float qw = parent[C::ROT_W], qx = parent[C::ROT_X], qy = parent[C::ROT_Y], qz = parent[C::ROT_Z];
+    float uvx = qy * vz - qz * vy;
+    float uvy = qz * vx - qx * vz;
+    float uvz = qx * vy - qy * vx;
+    float uuvx = qy * uvz - qz * uvy;
+    float uuvy = qz * uvx - qx * uvz;
+    float uuvz = qx * uvy - qy * uvx;
+    out[C::POS_X] = vx + 2 * (qw * uvx + uuvx) + parent[C::POS_X];
+    out[C::POS_Y] = vy + 2 * (qw * uvy + uuvy) + parent[C::POS_Y];
+    out[C::POS_Z] = vz + 2 * (qw * uvz + uuvz) + parent[C::POS_Z];
+
+    if (!(flags & INHERIT_ORIENTATION)) {
+        qw = 1;
+        qx = qy = qz = 0;
+    }
+    float lw = local[C::ROT_W], lx = local[C::ROT_X], ly = local[C::ROT_Y], lz = local[C::ROT_Z];
+    out[C::ROT_W] = qw * lw - qx * lx - qy * ly - qz * lz;
+    out[C::ROT_X] = qw * lx + qx * lw + qy * lz - qz * ly;
+    out[C::ROT_Y] = qw * ly + qy * lw + qz * lx - qx * lz;
+    out[C::ROT_Z] = qw * lz + qz * lw + qx * ly - qy * lx;
+
+    bool inherit_scale = flags & INHERIT_SCALE;
+    out[C::SCALE_X] = (inherit_scale ? parent[C::SCALE_X] : 1.0f) * local[C::SCALE_X];
+    out[C::SCALE_Y] = (inherit_scale ? parent[C::SCALE_Y] : 1.0f) * local[C::SCALE_Y];
+    out[C::SCALE_Z] = (inherit_scale ? parent[C::SCALE_Z] : 1.0f) * local[C::SCALE_Z];
+}
+
+/// Rows of the 3x4 matrix scaling, rotating then translating, like Ogre's Affine3::makeTransform
+inline void make_world_matrix(const float* t, float* m)
+{
+    float x2 = t[C::ROT_X] + t[C::ROT_X], y2 = t[C::ROT_Y] + t[C::ROT_Y], z2 = t[C::ROT_Z] + t[C::ROT_Z];
+    float wx = x2 * t[C::ROT_W], wy = y2 * t[C::ROT_W], wz = z2 * t[C::ROT_W];
+    float xx = x2 * t[C::ROT_X], xy = y2 * t[C::ROT_X], xz = z2 * t[C::ROT_X];
+    float yy = y2 * t[C::ROT_Y], yz = z2 * t[C::ROT_Y], zz = z2 * t[C::ROT_Z];
+
+    m[0] = (1 - (yy + zz)) * t[C::SCALE_X];
+    m[1] = (xy - wz) * t[C::SCALE_Y];
+    m[2] = (xz + wy) * t[C::SCALE_Z];
+    m[3] = t[C::POS_X];
+    m[4] = (xy + wz) * t[C::SCALE_X];
+    m[5] = (1 - (xx + zz)) * t[C::SCALE_Y];
+    m[6] = (yz - wx) * t[C::SCALE_Z];
+    m[7] = t[C::POS_Y];
+    m[8] = (xz - wy) * t[C::SCALE_X];
+    m[9] = (yz + wx) * t[C::SCALE_Y];
+    m[10] = (1 - (xx + yy)) * t[C::SCALE_Z];
+    m[11] = t[C::POS_Z];
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------
+void update_transforms_scalar(const TransformBatch& batch, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i) {
+        size_t p = size_t(batch.parent[i]);
+        float parent[C::COMPONENT_COUNT], local[C::COMPONENT_COUNT], derived[C::COMPONENT_COUNT];
+        for (int c = 0; c < C::COMPONENT_COUNT; ++c) {
+            parent[c] = batch.derived[c][p];
+            local[c] = batch.local[c][i];
+        }
+        combine(parent, local, batch.flags[i], derived);
+
+        float m[12];
+        make_world_matrix(derived, m);
+        for (int c = 0; c < C::COMPONENT_COUNT; ++c)
+            batch.derived[c][i] = derived[c];
+        for (int r = 0; r < 12; ++r)
+            batch.world[r][i] = m[r];
+    }
+}
+
+//-----------------------------------------------------------------------
+TransformHierarchy::TransformHierarchy()
+{
+    // slot 0, the identity parent of the root nodes
+    for (int c = 0; c < COMPONENT_COUNT; ++c) {
+        local_[c].push_back(IDENTITY[c]);
+        derived_[c].push_back(IDENTITY[c]);
+    }
+    float m[12];
+    make_world_matrix(IDENTITY, m);
+    for (int r = 0; r < 12; ++r)
+        world_[r].push_back(m[r]);
+    parent_.push_back(0);
+    flags_.push_back(0);
+    handles_.push_back(NONE);
+    levels_ = {0, 1};
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+}
+
+//-----------------------------------------------------------------------
+uint32_t TransformHierarchy::get_slot(Handle node) const
+{
+    HYUE_ASSERT(node < slots_.size() && slots_[node] != DEAD_SLOT, "invalid transform handle");
+    return slots_[node];
+}
+
+//-----------------------------------------------------------------------
+uint32_t TransformHierarchy::get_parent_slot(uint32_t slot) const
+{
+    // the parent may have been destroyed since the last layout
+    uint32_t parent = uint32_t(parent_[slot]);
+    return handles_[parent] == NONE ? 0 : parent;
+}
+
+//-----------------------------------------------------------------------
+TransformHierarchy::Handle TransformHierarchy::create(Handle parent)
+{
+    uint32_t parent_slot = parent == NONE ? 0 : get_slot(parent);
+
+    Handle ret;
+    if (free_handles_.empty()) {
+        ret = Handle(slots_.size());
+        slots_.push_back(0);
+    } else {
+        ret = free_handles_.back();
+        free_handles_.pop_back();
+    }
+
+    // appended for now, rebuild_layout moves it to its level
+    uint32_t slot = uint32_t(handles_.size());
+    slots_[ret] = slot;
+    for (int c = 0; c < COMPONENT_COUNT; ++c) {
+        local_[c].push_back(IDENTITY[c]);
+        derived_[c].push_back(IDENTITY[c]);
+    }
+    for (int r = 0; r < 12; ++r)
+        world_[r].push_back(0);
+    parent_.push_back(int32_t(parent_slot));
+    flags_.push_back(INHERIT_ORIENTATION | INHERIT_SCALE);
+    handles_.push_back(ret);
+
+    ++count_;
+    dirty_ = true;
+    layout_dirty_ = true;
+    return ret;
+}
+
+//-----------------------------------------------------------------------
+void TransformHierarchy::destroy(Handle node)
+{
+    uint32_t slot = get_slot(node);
+    // the slot stays until the next layout, its children see it as gone through get_parent_slot
+    handles_[slot] = NONE;
+    slots_[node] = DEAD_SLOT;
+    free_handles_.push_back(node);
+
+    --count_;
+    dirty_ = true;
+    layout_dirty_ = true;
+}
+
+//-----------------------------------------------------------------------
+void TransformHierarchy::set_parent(Handle node, Handle parent)
+{
+    uint32_t slot = get_slot(node);
+    uint32_t parent_slot = parent == NONE ? 0 : get_slot(parent);
+    for (uint32_t s = parent_slot; s != 0; s = get_parent_slot(s))
+        HYUE_ASSERT(s != slot, "a node cannot be attached below itself");
+
+    parent_[slot] = int32_t(parent_slot);
+    dirty_ = true;
+    layout_dirty_ = true;
+}
+
+//-----------------------------------------------------------------------
+TransformHierarchy::Handle TransformHierarchy::get_parent(Handle node) const
+{
+    return handles_[get_parent_slot(get_slot(node))];
+}
+
+//-----------------------------------------------------------------------
+void TransformHierarchy::set_position(Handle node, const vec3& position)
+{
+    uint32_t slot = get_slot(node);
+    local_[POS_X][slot] = position.a[0];
+    local_[POS_Y][slot] = position.a[1];
+    local_[POS_Z][slot] = position.a[2];
+    dirty_ = true;
+}
+
+vec3 TransformHierarchy::get_position(Handle node) const
+{
+    uint32_t slot = get_slot(node);
+    return vec3{local_[POS_X][slot], local_[POS_Y][slot], local_[POS_Z][slot]};
+}
+
+//-----------------------------------------------------------------------
+void TransformHierarchy::set_orientation(Handle node, const quat& orientation)
+{
+    uint32_t slot = get_slot(node);
+    for (int i = 0; i < 4; ++i)
+        local_[ROT_W + i][slot] = orientation.a[i];
+    dirty_ = true;
+}
+
+quat TransformHierarchy::get_orientation(Handle node) const
+{
+    uint32_t slot = get_slot(node);
+    return quat{local_[ROT_W][slot], local_[ROT_X][slot], local_[ROT_Y][slot], local_[ROT_Z][slot]};
+}
+
+//-----------------------------------------------------------------------
+void TransformHierarchy::set_scale(Handle node, const vec3& scale)
+{
+    uint32_t slot = get_slot(node);
+    local_[SCALE_X][slot] = scale.a[0];
+    local_[SCALE_Y][slot] = scale.a[1];
+    local_[SCALE_Z][slot] = scale.a[2];
+    dirty_ = true;
+}
+
+vec3 TransformHierarchy::get_scale(Handle node) const
+{
+    uint32_t slot = get_slot(node);
+    return vec3{local_[SCALE_X][slot], local_[SCALE_Y][slot], local_[SCALE_Z][slot]};
+}
+
+//-----------------------------------------------------------------------
+void TransformHierarchy::set_flag(Handle node, uint8_t flag, bool value)
+{
+    uint32_t slot = get_slot(node);
+    flags_[slot] = value ? (flags_[slot] | flag) : (flags_[slot] & ~flag);
+    dirty_ = true;
+}
+
+void TransformHierarchy::set_inherit_orientation(Handle node, bool inherit)
+{
+    set_flag(node, INHERIT_ORIENTATION, inherit);
+}
+
+bool TransformHierarchy::get_inherit_orientation(Handle node) const
+{
+    return flags_[get_slot(node)] & INHERIT_ORIENTATION;
+}
+
+void TransformHierarchy::set_inherit_scale(Handle node, bool inherit)
+{
+    set_flag(node, INHERIT_SCALE, inherit);
+}
+
+bool TransformHierarchy::get_inherit_scale(Handle node) const
+{
+    return flags_[get_slot(node)] & INHERIT_SCALE;
+}
+
+//-----------------------------------------------------------------------
+TransformHierarchy::Transform TransformHierarchy::get_local(uint32_t slot) const
+{
+    Transform ret;
+    for (int c = 0; c < COMPONENT_COUNT; ++c)
+        ret.c[c] = local_[c][slot];
+    return ret;
+}
+
+//-----------------------------------------------------------------------
+TransformHierarchy::Transform TransformHierarchy::get_derived(uint32_t slot) const
+{
+    Transform ret;
+    if (!dirty_) {
+        for (int c = 0; c < COMPONENT_COUNT; ++c)
+            ret.c[c] = derived_[c][slot];
+        return ret;
+    }
+
+    // root to node
+    std::vector<uint32_t> path;
+    for (uint32_t s = slot; s != 0; s = get_parent_slot(s))
+        path.push_back(s);
+
+    std::copy(IDENTITY, IDENTITY + COMPONENT_COUNT, ret.c);
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        Transform parent = ret;
+        Transform local = get_local(*it);
+        combine(parent.c, local.c, flags_[*it], ret.c);
+    }
+    return ret;
+}
+
+vec3 TransformHierarchy::get_derived_position(Handle node) const
+{
+    Transform t = get_derived(get_slot(node));
+    return vec3{t.c[POS_X], t.c[POS_Y], t.c[POS_Z]};
+}
+
+quat TransformHierarchy::get_derived_orientation(Handle node) const
+{
+    Transform t = get_derived(get_slot(node));
+    return quat{t.c[ROT_W], t.c[ROT_X], t.c[ROT_Y], t.c[ROT_Z]};
+}
+
+vec3 TransformHierarchy::get_derived_scale(Handle node) const
+{
+    Transform t = get_derived(get_slot(node));
+    return vec3{t.c[SCALE_X], t.c[SCALE_Y], t.c[SCALE_Z]};
+}
+
+mat4 TransformHierarchy::get_world_matrix(Handle node) const
+{
+    uint32_t slot = get_slot(node);
+    float m[12];
+    if (dirty_) {
+        make_world_matrix(get_derived(slot).c, m);
+    } else {
+        for (int r = 0; r < 12; ++r)
+            m[r] = world_[r][slot];
+    }
+
+    mat4 ret;
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 4; ++c)
+            ret.a[r][c] = m[r * 4 + c];
+    }
+    ret.a[3][0] = ret.a[3][1] = ret.a[3][2] = 0;
+    ret.a[3][3] = 1;
+    return ret;
+}
+
+//-----------------------------------------------------------------------
+void TransformHierarchy::rebuild_layout()
+{
+    const size_t slot_count = handles_.size();
+
+    // children of every slot, contiguous in slot order
+    std::vector<uint32_t> first_child(slot_count + 1, 0);
+    for (uint32_t s = 1; s < slot_count; ++s) {
+        if (handles_[s] != NONE)
+            ++first_child[get_parent_slot(s) + 1];
+    }
+    for (size_t s = 0; s < slot_count; ++s)
+        first_child[s + 1] += first_child[s];
+    std::vector<uint32_t> children(first_child[slot_count]);
+    {
+        std::vector<uint32_t> next(first_child.begin(), first_child.end() - 1);
+        for (uint32_t s = 1; s < slot_count; ++s) {
+            if (handles_[s] != NONE)
+                children[next[get_parent_slot(s)]++] = s;
+        }
+    }
+
+    // breadth first from slot 0: levels are contiguous, siblings adjacent and
+    // each level ordered like its parents
+    std::vector<uint32_t> order = {0};
+    order.reserve(count_ + 1);
+    levels_ = {0, 1};
+    for (size_t begin = 0; begin < order.size();) {
+        size_t end = order.size();
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t s = order[i];
+            order.insert(order.end(), children.begin() + first_child[s], children.begin() + first_child[s + 1]);
+        }
+        begin = end;
+        if (order.size() > end)
+            levels_.push_back(order.size());
+    }
+    HYUE_ASSERT(order.size() == count_ + 1, "transform hierarchy is corrupted");
+
+    std::vector<uint32_t> new_slot(slot_count, DEAD_SLOT);
+    for (uint32_t i = 0; i < order.size(); ++i)
+        new_slot[order[i]] = i;
+
+    std::vector<int32_t> parent(order.size(), 0);
+    for (size_t i = 1; i < order.size(); ++i)
+        parent[i] = int32_t(new_slot[get_parent_slot(order[i])]);
+
+    auto permute = [&](auto& array) {
+        std::remove_reference_t<decltype(array)> sorted(order.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            sorted[i] = array[order[i]];
+        array.swap(sorted);
+    };
+    for (auto& array : local_)
+        permute(array);
+    for (auto& array : derived_)
+        permute(array);
+    for (auto& array : world_)
+        permute(array);
+    permute(flags_);
+    permute(handles_);
+    parent_.swap(parent);
+
+    for (size_t i = 1; i < order.size(); ++i)
+        slots_[handles_[i]] = uint32_t(i);
+
+    layout_dirty_ = false;
+}
+
+//-----------------------------------------------------------------------
+void TransformHierarchy::update(Executor* executor)
+{
+    if (layout_dirty_)
+        rebuild_layout();
+    if (!dirty_)
+        return;
+
+    TransformBatch batch;
+    for (int c = 0; c < COMPONENT_COUNT; ++c) {
+        batch.local[c] = local_[c].data();
+        batch.derived[c] = derived_[c].data();
+    }
+    for (int r = 0; r < 12; ++r)
+        batch.world[r] = world_[r].data();
+    batch.parent = parent_.data();
+    batch.flags = flags_.data();
+
+    TransformUpdater updater = select_simd(HYUE_AVX2_KERNEL(avx2_update_transforms),
+                                           HYUE_SSE2_KERNEL(sse2_update_transforms),
+                                           update_transforms_scalar);
+
+    // a level only reads the levels above it, its slots are independent
+    for (size_t level = 1; level + 1 < levels_.size(); ++level) {
+        size_t begin = levels_[level], end = levels_[level + 1];
+        size_t count = end - begin;
+        if (count < 2 * PARALLEL_BATCH) {
+            updater(batch, begin, end);
+            continue;
+        }
+
+        if (!executor)
+            executor = &ThreadPool::get_worker_pool();
+        size_t jobs = std::min(executor->get_concurrency() * 4, count / PARALLEL_BATCH);
+        // multiples of 8 slots so only the last job has a scalar tail
+        size_t step = (count / jobs + 7) & ~size_t(7);
+        jobs = (count + step - 1) / step;
+        executor->parallel_for(jobs, [&](size_t i) {
+            size_t job_begin = begin + i * step;
+            updater(batch, job_begin, std::min(job_begin + step, end));
+        });
+    }
+
+    dirty_ = false;
+}
+
+} // namespace hyue
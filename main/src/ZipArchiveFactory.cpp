@@ -5,13 +5,118 @@
 #include <hyue/log.h>
 #include <hyue/panic.h>
 #include <hyue/DataStream.h>
+#include <hyue/FileInfoIndex.h>
 
 extern "C" {
-#include "zip/zip.h"
+// the miniz implementation is compiled as part of zip/zip.c
+#define MINIZ_HEADER_FILE_ONLY
+#include "zip/miniz.h"
 }
 
+#include <string.h>
+
+/// Size of the inflated data kept by a ZipEntryDataStream
+#define HYUE_ZIP_STREAM_WINDOW_SIZE (16 * 1024)
+
 namespace hyue {
 
+/// Fixed part of a local file header, followed by the name and the extra field
+const size_t ZIP_LOCAL_HEADER_SIZE = 30;
+const uint32_t ZIP_LOCAL_HEADER_SIGNATURE = 0x04034b50;
+
+/** A zip archive opened for reading, shared by a ZipArchive and all the streams
+    it handed out, so open streams stay valid after the archive is unloaded.
+
+    Once loaded, the archive data and the central directory held by archive are
+    never modified. Readers do not use archive itself but a cursor(): a copy
+    sharing the central directory with its own error state, so any number of
+    threads can locate and inflate entries at the same time.
+*/
+struct ZipSource {
+    /// Backing memory of the whole archive (mapped file, embedded data or heap copy)
+    MemoryDataStreamPtr buffer;
+    /// Reader over buffer, owns the central directory
+    mz_zip_archive archive;
+
+    ZipSource(MemoryDataStreamPtr buf)
+    : buffer(std::move(buf))
+    {
+        mz_zip_zero_struct(&archive);
+    }
+
+    ~ZipSource()
+    {
+        mz_zip_reader_end(&archive);
+    }
+
+    /// A read-only cursor over the archive, must not outlive this source
+    mz_zip_archive cursor() const
+    {
+        return archive;
+    }
+};
+
+using ZipSourcePtr = SharedPtr<ZipSource>;
+
+/** DataStream over a single zip entry, inflated on demand as it is read.
+
+    Only a window of HYUE_ZIP_STREAM_WINDOW_SIZE inflated bytes is kept, on top
+    of miniz's own dictionary, so memory use does not depend on the entry size.
+    Seeking backwards out of the window restarts decompression from the start
+    of the entry.
+*/
+class ZipEntryDataStream : public DataStream {
+public:
+    ZipEntryDataStream(const String& name, ZipSourcePtr source, mz_uint file_index, size_t size);
+
+    ~ZipEntryDataStream();
+
+    /** @copydoc DataStream::read
+     */
+    size_t read(void* buf, size_t count) override;
+
+    /** @copydoc DataStream::skip
+     */
+    void skip(long count) override;
+
+    /** @copydoc DataStream::seek
+     */
+    void seek(size_t pos) override;
+
+    /** @copydoc DataStream::tell
+     */
+    size_t tell(void) const override;
+
+    /** @copydoc DataStream::eof
+     */
+    bool is_eof(void) const override;
+
+    /** @copydoc DataStream::close
+     */
+    void close(void) override;
+
+private:
+    /// (Re)start decompression at the beginning of the entry
+    void rewind();
+    /// Inflate the next window, returns false at the end of the entry
+    bool fill_window();
+
+    ZipSourcePtr source_;
+    /// Cursor the decompression state refers to
+    mz_zip_archive cursor_;
+    mz_uint file_index_;
+    mz_zip_reader_extract_iter_state* iter_;
+
+    /// Recently inflated data
+    std::vector<uint8_t> window_;
+    /// Entry offset of window_[0]
+    size_t window_begin_;
+    /// Valid bytes in window_, the iterator is at window_begin_ + window_size_
+    size_t window_size_;
+    /// Current read position within the entry
+    size_t pos_;
+};
+
 class ZipArchive : public Archive {
 
 public:
@@ -60,23 +165,143 @@ public:
     bool exists(const String& filename) const override;
 
 private:
-    /// Handle to root zip file
-    zip_t* zip_file_;
-    MemoryDataStreamPtr buffer_;
-    /// File list (since zziplib seems to only allow scanning of dir tree once)
-    FileInfoList file_list_;
+    /// Opened archive, null if not loaded
+    ZipSourcePtr source_;
+    /// Externally provided archive data (embedded archives)
+    MemoryDataStreamPtr extern_buffer_;
+    /// Entries by name, built once in load()
+    FileInfoIndex index_;
 };
 
+//-----------------------------------------------------------------------
+// ZipEntryDataStream
+//-----------------------------------------------------------------------
+ZipEntryDataStream::ZipEntryDataStream(const String& name,
+                                       ZipSourcePtr source,
+                                       mz_uint file_index,
+                                       size_t size)
+: DataStream(name),
+  source_(std::move(source)),
+  cursor_(source_->cursor()),
+  file_index_(file_index),
+  iter_(nullptr),
+  window_(HYUE_ZIP_STREAM_WINDOW_SIZE),
+  window_begin_(0),
+  window_size_(0),
+  pos_(0)
+{
+    size_ = size;
+    rewind();
+}
+
+ZipEntryDataStream::~ZipEntryDataStream()
+{
+    close();
+}
+
+void ZipEntryDataStream::rewind()
+{
+    if (iter_)
+        mz_zip_reader_extract_iter_free(iter_);
+
+    iter_ = mz_zip_reader_extract_iter_new(&cursor_, file_index_, 0);
+    if (!iter_) {
+        panic("could not inflate " + name_);
+    }
+    window_begin_ = 0;
+    window_size_ = 0;
+}
+
+bool ZipEntryDataStream::fill_window()
+{
+    window_begin_ += window_size_;
+    window_size_ = mz_zip_reader_extract_iter_read(iter_, window_.data(), window_.size());
+    return window_size_ != 0;
+}
+
+size_t ZipEntryDataStream::read(void* buf, size_t count)
+{
+    if (!iter_)
+        return 0;
+
+    uint8_t* dst = static_cast<uint8_t*>(buf);
+    size_t total = 0;
+    while (total < count && pos_ < size_) {
+        size_t window_end = window_begin_ + window_size_;
+        if (pos_ >= window_begin_ && pos_ < window_end) {
+            // serve from the window
+            size_t cnt = std::min(count - total, window_end - pos_);
+            memcpy(dst + total, window_.data() + (pos_ - window_begin_), cnt);
+            total += cnt;
+            pos_ += cnt;
+        } else if (pos_ == window_end && count - total >= window_.size()) {
+            // large read, inflate straight into the caller's buffer
+            size_t cnt = mz_zip_reader_extract_iter_read(iter_, dst + total, count - total);
+            if (cnt == 0)
+                break;
+            total += cnt;
+            pos_ += cnt;
+            window_begin_ = pos_;
+            window_size_ = 0;
+        } else {
+            seek(pos_);
+            if (window_begin_ + window_size_ <= pos_)
+                break;
+        }
+    }
+    return total;
+}
+
+void ZipEntryDataStream::skip(long count)
+{
+    // skipping back past the start of the entry stops at it
+    seek(count < -(long)pos_ ? 0 : (size_t)((long)pos_ + count));
+}
+
+void ZipEntryDataStream::seek(size_t pos)
+{
+    HYUE_ASSERT(pos <= size_, "");
+
+    if (pos < window_begin_)
+        rewind();
+
+    // discard inflated data up to pos
+    while (pos >= window_begin_ + window_size_ && pos < size_) {
+        if (!fill_window())
+            break;
+    }
+    pos_ = pos;
+}
+
+size_t ZipEntryDataStream::tell(void) const
+{
+    return pos_;
+}
+
+bool ZipEntryDataStream::is_eof(void) const
+{
+    return pos_ >= size_;
+}
+
+void ZipEntryDataStream::close(void)
+{
+    access_ = 0;
+    if (iter_) {
+        mz_zip_reader_extract_iter_free(iter_);
+        iter_ = nullptr;
+    }
+    source_.reset();
+}
+
 ZipArchive::ZipArchive(const String& name,
                        const String& arch_type,
                        const uint8_t* extern_buf,
                        size_t extern_buf_sz)
-: Archive(name, arch_type),
-  zip_file_(nullptr)
+: Archive(name, arch_type)
 {
     if (extern_buf)
-        buffer_ = std::make_shared<MemoryDataStream>(const_cast<uint8_t*>(extern_buf),
-                                                     extern_buf_sz);
+        extern_buffer_ = std::make_shared<MemoryDataStream>(const_cast<uint8_t*>(extern_buf),
+                                                            extern_buf_sz);
 }
 //-----------------------------------------------------------------------
 ZipArchive::~ZipArchive()
@@ -84,43 +309,58 @@ ZipArchive::~ZipArchive()
     unload();
 }
 
+// entries from this uncompressed size on are inflated while being read
+size_t g_stream_threshold = 1024 * 1024;
+
 DataStreamPtr open_file_stream(const String& full_path,
                                std::ios::openmode mode,
                                const String& name = "");
 
 void ZipArchive::load()
 {
-    if (!zip_file_) {
-        if (!buffer_) {
+    if (!source_) {
+        MemoryDataStreamPtr buffer = extern_buffer_;
+        if (!buffer) {
+            // map the archive, pages are only brought in for the entries we read
+            buffer = MappedFileDataStream::open(name_);
+        }
+        if (!buffer) {
             auto file_stream = open_file_stream(name_, std::ios::binary);
-            if(file_stream) {
-                buffer_ = std::make_shared<MemoryDataStream>(file_stream.get());
+            if (file_stream) {
+                buffer = std::make_shared<MemoryDataStream>(file_stream.get());
             }
         }
 
-        if(!buffer_)
+        if (!buffer)
             return;
 
-        zip_file_ = zip_stream_open((const char*)buffer_->get_ptr(), buffer_->get_size(), 0, 'r');
+        auto source = std::make_shared<ZipSource>(buffer);
+        if (!mz_zip_reader_init_mem(&source->archive, buffer->get_ptr(), buffer->get_size(), 0)) {
+            LOG(error) << "could not read zip archive " + name_;
+            return;
+        }
+        source_ = source;
 
         // Cache names
-        int n = zip_entries_total(zip_file_);
-        for (int i = 0; i < n; ++i) {
+        mz_uint n = mz_zip_reader_get_num_files(&source_->archive);
+        for (mz_uint i = 0; i < n; ++i) {
+            mz_zip_archive_file_stat stat;
+            if (!mz_zip_reader_file_stat(&source_->archive, i, &stat))
+                continue;
+
             FileInfo info;
             info.archive = this;
 
-
-            zip_entry_openbyindex(zip_file_, i);
-
-            info.filename = zip_entry_name(zip_file_);
+            info.filename = stat.m_filename;
             // Get basename / path
             StringUtils::split_filename(info.filename, &info.dir, &info.basename);
 
             // Get sizes
-            info.uncompressed_size = zip_entry_size(zip_file_);
-            info.compressed_size = zip_entry_comp_size(zip_file_);
+            info.uncompressed_size = stat.m_uncomp_size;
+            info.compressed_size = stat.m_comp_size;
+            info.index = i;
 
-            if (zip_entry_isdir(zip_file_)) {
+            if (stat.m_is_directory) {
                 info.filename = info.filename.substr(0, info.filename.length() - 1);
                 StringUtils::split_filename(info.filename, &info.dir, &info.basename);
                 // Set compressed size to -1 for folders; anyway nobody will check
@@ -131,45 +371,87 @@ void ZipArchive::load()
                 info.is_dir = false;
             }
 
-            zip_entry_close(zip_file_);
-            file_list_.push_back(info);
+            index_.add(info.filename, info);
         }
     }
 }
 
 void ZipArchive::unload()
 {
-    if (zip_file_) {
-        zip_close(zip_file_);
-        zip_file_ = nullptr;
-    }
-    file_list_.clear();
-    buffer_.reset();
+    // streams still open keep the archive data alive
+    source_.reset();
+    index_.clear();
+}
+
+/// Data of an entry stored without compression or encryption, nullptr otherwise
+static const uint8_t* get_stored_data(const ZipSource& source, const mz_zip_archive_file_stat& stat)
+{
+    if (stat.m_method != 0 || stat.m_is_encrypted || stat.m_comp_size != stat.m_uncomp_size)
+        return nullptr;
+
+    // the local header repeats the name and may have a different extra field
+    const uint8_t* archive = source.buffer->get_ptr();
+    size_t archive_size = source.buffer->get_size();
+    size_t header = (size_t)stat.m_local_header_ofs;
+    if (header + ZIP_LOCAL_HEADER_SIZE > archive_size)
+        return nullptr;
+
+    const uint8_t* p = archive + header;
+    uint32_t signature = uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+    if (signature != ZIP_LOCAL_HEADER_SIGNATURE)
+        return nullptr;
+
+    size_t name_length = size_t(p[26]) | size_t(p[27]) << 8;
+    size_t extra_length = size_t(p[28]) | size_t(p[29]) << 8;
+    size_t data = header + ZIP_LOCAL_HEADER_SIZE + name_length + extra_length;
+    if (data > archive_size || archive_size - data < stat.m_uncomp_size)
+        return nullptr;
+    return archive + data;
 }
 
 DataStreamPtr ZipArchive::open(const String& filename, bool read_only) const
 {
-    // zip is not threadsafe
-    String look_ip_filename = filename;
+    if (!source_) {
+        LOG(error) << "could not open " + filename;
+        return nullptr;
+    }
 
-    bool open = zip_entry_open(zip_file_, look_ip_filename.c_str(), true) == 0;
+    // the index holds the position of the entry in the central directory,
+    // so opening never searches it
+    const FileInfo* info = index_.find(filename);
+    if (!info || info->is_dir) {
+        LOG(error) << "could not open " + filename;
+        return nullptr;
+    }
+
+    // source_ is shared by every thread, only work on a private cursor
+    mz_zip_archive cursor = source_->cursor();
 
-    if (!open) {
-        LOG(error) << "could not open " + look_ip_filename;
+    mz_uint index = mz_uint(info->index);
+    mz_zip_archive_file_stat stat;
+    if (!mz_zip_reader_file_stat(&cursor, index, &stat)) {
+        LOG(error) << "could not open " + filename;
         return nullptr;
     }
 
+    size_t size = (size_t)stat.m_uncomp_size;
+    const uint8_t* stored = get_stored_data(*source_, stat);
+    if (stored) {
+        // the entry is the archive bytes themselves, read them in place
+        return std::make_shared<DataStreamView>(filename, source_, stored, size);
+    }
+    if (size >= g_stream_threshold) {
+        // inflate on demand
+        return std::make_shared<ZipEntryDataStream>(filename, source_, index, size);
+    }
+
     // Construct & return stream
-    auto ret = std::make_shared<MemoryDataStream>(look_ip_filename,
-                                                  zip_entry_size(zip_file_),
-                                                  true,
-                                                  true);
+    auto ret = std::make_shared<MemoryDataStream>(filename, size, true, true);
 
-    if (zip_entry_noallocread(zip_file_, ret->get_ptr(), ret->get_size()) < 0) {
-        panic("could not read " + look_ip_filename);
+    if (!mz_zip_reader_extract_to_mem(&cursor, index, ret->get_ptr(), ret->get_size(), 0)) {
+        panic("could not read " + filename);
     }
 
-    zip_entry_close(zip_file_);
     return ret;
 }
 
@@ -187,67 +469,34 @@ void ZipArchive::remove(const String& filename)
 StringVector ZipArchive::list(bool recursive, bool dirs) const
 {
     StringVector ret;
-
-    for (auto& f : file_list_) {
-        if ((dirs == f.is_dir) && (recursive || f.dir.empty())) {
-            ret.push_back(f.filename);
-        }
-    }
-
+    index_.list(recursive, dirs, [&ret](const FileInfo& f) { ret.push_back(f.filename); });
     return ret;
 }
 //-----------------------------------------------------------------------
 FileInfoList ZipArchive::list_file_info(bool recursive, bool dirs) const
 {
     FileInfoList ret;
-    for (auto& f : file_list_) {
-        if ((dirs == f.is_dir) && (recursive || f.dir.empty())) {
-            ret.push_back(f);
-        }
-    }
-
+    index_.list(recursive, dirs, [&ret](const FileInfo& f) { ret.push_back(f); });
     return ret;
 }
 //-----------------------------------------------------------------------
 StringVector ZipArchive::find(const String& pattern, bool recursive, bool dirs) const
 {
     StringVector ret;
-
-    for (auto& f : file_list_) {
-        if ((dirs == f.is_dir) && (recursive)) {
-            if (StringUtils::fnmatch(f.filename, pattern)) {
-                ret.push_back(f.filename);
-            }
-        }
-    }
-
+    index_.find(pattern, recursive, dirs, [&ret](const FileInfo& f) { ret.push_back(f.filename); });
     return ret;
 }
 //-----------------------------------------------------------------------
 FileInfoList ZipArchive::find_file_info(const String& pattern, bool recursive, bool dirs) const
 {
     FileInfoList ret;
-    // If pattern contains a directory name, do a full match
-    for (auto& f : file_list_) {
-        if ((dirs == f.is_dir) && (recursive)) {
-            // Check name matches pattern (zip is case insensitive)
-            if (StringUtils::fnmatch(f.filename, pattern)) {
-                ret.push_back(f);
-            }
-        }
-    }
-
+    index_.find(pattern, recursive, dirs, [&ret](const FileInfo& f) { ret.push_back(f); });
     return ret;
 }
 
 bool ZipArchive::exists(const String& filename) const
 {
-    String clean_name = filename;
-
-    return std::find_if(file_list_.begin(),
-                        file_list_.end(),
-                        [&clean_name](auto& fi) { return fi.filename == clean_name; })
-           != file_list_.end();
+    return index_.exists(filename);
 }
 
 //-----------------------------------------------------------------------
@@ -268,6 +517,16 @@ const String& ZipArchiveFactory::get_type(void) const
     return name;
 }
 
+void ZipArchiveFactory::set_stream_threshold(size_t threshold)
+{
+    g_stream_threshold = threshold;
+}
+
+size_t ZipArchiveFactory::get_stream_threshold()
+{
+    return g_stream_threshold;
+}
+
 //-----------------------------------------------------------------------
 // EmbeddedZipArchiveFactory
 //-----------------------------------------------------------------------
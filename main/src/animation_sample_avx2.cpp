@@ -0,0 +1,69 @@
+#include "animation_sample_simd.h"
+
+// built with AVX2 code generation enabled, see main/CMakeLists.txt
+#if HYUE_SIMD_AVX2
+
+#include <immintrin.h>
+
+namespace hyue {
+
+namespace {
+
+using C = TransformHierarchy;
+
+/// 8 signed 16 bit integers to floats
+inline __m256 load_int16(const int16_t* p)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+}
+
+/// 8 unsigned 16 bit integers to floats
+inline __m256 load_uint16(const uint16_t* p)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+}
+
+/// min + step * lerp of the quantized values of 8 bones
+inline __m256 dequantize(const uint16_t* const* values, const float* min, const float* step, size_t i, __m256 alpha)
+{
+    __m256 a = load_uint16(values[0] + i), b = load_uint16(values[1] + i);
+    __m256 v = _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), alpha));
+    return _mm256_add_ps(_mm256_loadu_ps(min + i), _mm256_mul_ps(_mm256_loadu_ps(step + i), v));
+}
+
+} // namespace
+
+void avx2_sample_clip(const ClipSampleBatch& batch, size_t begin, size_t end)
+{
+    const __m256 alpha = _mm256_set1_ps(batch.alpha);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const size_t stride = batch.stride;
+
+    size_t b = begin;
+    for (; b + 8 <= end; b += 8) {
+        __m256 q[4], length = _mm256_setzero_ps();
+        for (int c = 0; c < 4; ++c) {
+            __m256 q1 = load_int16(batch.rotation[0] + c * stride + b);
+            __m256 q2 = load_int16(batch.rotation[1] + c * stride + b);
+            q[c] = _mm256_add_ps(q1, _mm256_mul_ps(_mm256_sub_ps(q2, q1), alpha));
+            length = _mm256_add_ps(length, _mm256_mul_ps(q[c], q[c]));
+        }
+        length = _mm256_sqrt_ps(length);
+        for (int c = 0; c < 4; ++c)
+            _mm256_storeu_ps(batch.components[C::ROT_W + c] + b, _mm256_div_ps(q[c], length));
+
+        for (int c = 0; c < 3; ++c) {
+            size_t i = c * stride + b;
+            _mm256_storeu_ps(batch.components[C::POS_X + c] + b,
+                             dequantize(batch.translation, batch.translation_min, batch.translation_step, i, alpha));
+            _mm256_storeu_ps(batch.components[C::SCALE_X + c] + b,
+                             batch.scale[0] ? dequantize(batch.scale, batch.scale_min, batch.scale_step, i, alpha) : one);
+        }
+    }
+
+    sample_clip_scalar(batch, b, end);
+}
+
+} // namespace hyue
+
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <hyue/AnimationClip.h>
+
+#include "simd_intrinsics.h"
+
+namespace hyue {
+
+/// The frames of an AnimationClip around the sampled time and where to write the bones
+struct ClipSampleBatch {
+    /// w, x, y, z arrays of the frames before and after the time
+    const int16_t* rotation[2];
+    /// x, y, z arrays of the frames before and after the time
+    const uint16_t* translation[2];
+    /// Null when the clip has no scale
+    const uint16_t* scale[2];
+    /// Minimum and step of every component, x, y, z arrays
+    const float* translation_min;
+    const float* translation_step;
+    const float* scale_min;
+    const float* scale_step;
+    /// Distance between the arrays of two components
+    size_t stride;
+    /// Position between the two frames
+    float alpha;
+    /// One array per TransformHierarchy::Component
+    float* const* components;
+};
+
+/// Interpolates bones [begin, end) of a clip
+using ClipSampler = void (*)(const ClipSampleBatch& batch, size_t begin, size_t end);
+
+void sample_clip_scalar(const ClipSampleBatch& batch, size_t begin, size_t end);
+void sse2_sample_clip(const ClipSampleBatch& batch, size_t begin, size_t end);
+void avx2_sample_clip(const ClipSampleBatch& batch, size_t begin, size_t end);
+
+} // namespace hyue
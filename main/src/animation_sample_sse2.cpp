@@ -0,0 +1,68 @@
+#include "animation_sample_simd.h"
+
+#if HYUE_SIMD_SSE2
+
+namespace hyue {
+
+namespace {
+
+using C = TransformHierarchy;
+
+/// 4 signed 16 bit integers to floats
+inline __m128 load_int16(const int16_t* p)
+{
+    __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+}
+
+/// 4 unsigned 16 bit integers to floats
+inline __m128 load_uint16(const uint16_t* p)
+{
+    __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, _mm_setzero_si128()));
+}
+
+/// min + step * lerp of the quantized values of 4 bones
+inline __m128 dequantize(const uint16_t* const* values, const float* min, const float* step, size_t i, __m128 alpha)
+{
+    __m128 a = load_uint16(values[0] + i), b = load_uint16(values[1] + i);
+    __m128 v = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), alpha));
+    return _mm_add_ps(_mm_loadu_ps(min + i), _mm_mul_ps(_mm_loadu_ps(step + i), v));
+}
+
+} // namespace
+
+void sse2_sample_clip(const ClipSampleBatch& batch, size_t begin, size_t end)
+{
+    const __m128 alpha = _mm_set1_ps(batch.alpha);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const size_t stride = batch.stride;
+
+    size_t b = begin;
+    for (; b + 4 <= end; b += 4) {
+        __m128 q[4], length = _mm_setzero_ps();
+        for (int c = 0; c < 4; ++c) {
+            __m128 q1 = load_int16(batch.rotation[0] + c * stride + b);
+            __m128 q2 = load_int16(batch.rotation[1] + c * stride + b);
+            q[c] = _mm_add_ps(q1, _mm_mul_ps(_mm_sub_ps(q2, q1), alpha));
+            length = _mm_add_ps(length, _mm_mul_ps(q[c], q[c]));
+        }
+        length = _mm_sqrt_ps(length);
+        for (int c = 0; c < 4; ++c)
+            _mm_storeu_ps(batch.components[C::ROT_W + c] + b, _mm_div_ps(q[c], length));
+
+        for (int c = 0; c < 3; ++c) {
+            size_t i = c * stride + b;
+            _mm_storeu_ps(batch.components[C::POS_X + c] + b,
+                          dequantize(batch.translation, batch.translation_min, batch.translation_step, i, alpha));
+            _mm_storeu_ps(batch.components[C::SCALE_X + c] + b,
+                          batch.scale[0] ? dequantize(batch.scale, batch.scale_min, batch.scale_step, i, alpha) : one);
+        }
+    }
+
+    sample_clip_scalar(batch, b, end);
+}
+
+} // namespace hyue
+
+#endif
@@ -0,0 +1,602 @@
+#include "block_decompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <hyue/simd.h>
+
+#include "simd_intrinsics.h"
+
+namespace hyue {
+
+namespace {
+
+/// Value of an 8 bit channel interpolated between two others
+inline uint8_t lerp_channel(int a, int b, int weight_b, int steps)
+{
+    return uint8_t(((steps - weight_b) * a + weight_b * b + steps / 2) / steps);
+}
+
+inline uint32_t read_u16(const uint8_t* p)
+{
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8;
+}
+
+inline uint32_t read_u32(const uint8_t* p)
+{
+    return read_u16(p) | read_u16(p + 2) << 16;
+}
+
+inline uint64_t read_u48(const uint8_t* p)
+{
+    return uint64_t(read_u32(p)) | uint64_t(read_u16(p + 4)) << 32;
+}
+
+//-----------------------------------------------------------------------
+// BC1 - BC3 colour blocks
+//-----------------------------------------------------------------------
+
+/** The 4 colours of a BC1 colour block as RGBA words, R in the low byte.
+    @param one_bit_alpha Whether c0 <= c1 selects the mode with a transparent colour, only BC1 has it
+*/
+void get_color_palette(const uint8_t* block, bool one_bit_alpha, uint32_t palette[4])
+{
+    uint32_t c0 = read_u16(block), c1 = read_u16(block + 2);
+
+    int rgb[2][3];
+    const uint32_t colors[2] = {c0, c1};
+    for (int i = 0; i < 2; ++i) {
+        uint32_t r = (colors[i] >> 11) & 0x1f, g = (colors[i] >> 5) & 0x3f, b = colors[i] & 0x1f;
+        rgb[i][0] = int(r << 3 | r >> 2);
+        rgb[i][1] = int(g << 2 | g >> 4);
+        rgb[i][2] = int(b << 3 | b >> 2);
+    }
+
+    uint8_t p[4][4];
+    for (int c = 0; c < 3; ++c) {
+        p[0][c] = uint8_t(rgb[0][c]);
+        p[1][c] = uint8_t(rgb[1][c]);
+        if (c0 > c1 || !one_bit_alpha) {
+            p[2][c] = lerp_channel(rgb[0][c], rgb[1][c], 1, 3);
+            p[3][c] = lerp_channel(rgb[0][c], rgb[1][c], 2, 3);
+        } else {
+            p[2][c] = lerp_channel(rgb[0][c], rgb[1][c], 1, 2);
+            p[3][c] = 0;
+        }
+    }
+    p[0][3] = p[1][3] = p[2][3] = 0xff;
+    p[3][3] = (c0 > c1 || !one_bit_alpha) ? 0xff : 0;
+
+    for (int i = 0; i < 4; ++i)
+        palette[i] = uint32_t(p[i][0]) | uint32_t(p[i][1]) << 8 | uint32_t(p[i][2]) << 16 | uint32_t(p[i][3]) << 24;
+}
+
+/** Decode a colour block.
+    @param alpha 16 alpha values replacing the palette alpha, or null
+*/
+void decode_color_block_scalar(const uint8_t* block,
+                               bool one_bit_alpha,
+                               const uint8_t* alpha,
+                               uint8_t* dst,
+                               size_t pitch)
+{
+    uint32_t palette[4];
+    get_color_palette(block, one_bit_alpha, palette);
+    uint32_t indices = read_u32(block + 4);
+
+    for (size_t y = 0; y < 4; ++y) {
+        uint8_t* p = dst + y * pitch;
+        for (size_t x = 0; x < 4; ++x, p += 4, indices >>= 2) {
+            uint32_t color = palette[indices & 3];
+            p[0] = uint8_t(color);
+            p[1] = uint8_t(color >> 8);
+            p[2] = uint8_t(color >> 16);
+            p[3] = alpha ? alpha[y * 4 + x] : uint8_t(color >> 24);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+// BC2 explicit alpha, BC3 - BC5 interpolated channels
+//-----------------------------------------------------------------------
+
+void decode_explicit_alpha(const uint8_t* block, uint8_t alpha[16])
+{
+    for (size_t i = 0; i < 16; i += 2) {
+        alpha[i] = uint8_t((block[i / 2] & 0xf) * 17);
+        alpha[i + 1] = uint8_t((block[i / 2] >> 4) * 17);
+    }
+}
+
+/// Unsigned BC4 channel block, also the alpha of BC3
+void decode_unorm_channel(const uint8_t* block, uint8_t values[16])
+{
+    int a0 = block[0], a1 = block[1];
+    uint8_t palette[8] = {uint8_t(a0), uint8_t(a1)};
+    if (a0 > a1) {
+        for (int i = 1; i < 7; ++i)
+            palette[i + 1] = lerp_channel(a0, a1, i, 7);
+    } else {
+        for (int i = 1; i < 5; ++i)
+            palette[i + 1] = lerp_channel(a0, a1, i, 5);
+        palette[6] = 0;
+        palette[7] = 0xff;
+    }
+
+    uint64_t indices = read_u48(block + 2);
+    for (size_t i = 0; i < 16; ++i, indices >>= 3)
+        values[i] = palette[indices & 7];
+}
+
+/// Signed BC4 channel block, with [-1, 1] mapped to [0, 255]
+void decode_snorm_channel(const uint8_t* block, uint8_t values[16])
+{
+    // -128 is clamped to -127, both mean -1
+    float a0 = std::max(-127, int(int8_t(block[0]))), a1 = std::max(-127, int(int8_t(block[1])));
+    float palette[8] = {a0, a1};
+    if (a0 > a1) {
+        for (int i = 1; i < 7; ++i)
+            palette[i + 1] = ((7 - i) * a0 + i * a1) / 7.0f;
+    } else {
+        for (int i = 1; i < 5; ++i)
+            palette[i + 1] = ((5 - i) * a0 + i * a1) / 5.0f;
+        palette[6] = -127.0f;
+        palette[7] = 127.0f;
+    }
+
+    uint8_t unorm[8];
+    for (int i = 0; i < 8; ++i)
+        unorm[i] = uint8_t(std::lround((palette[i] + 127.0f) * (255.0f / 254.0f)));
+
+    uint64_t indices = read_u48(block + 2);
+    for (size_t i = 0; i < 16; ++i, indices >>= 3)
+        values[i] = unorm[indices & 7];
+}
+
+/// Write 16 texels of (red, green, 0, 255)
+void write_red_green_scalar(const uint8_t red[16], const uint8_t* green, uint8_t* dst, size_t pitch)
+{
+    for (size_t y = 0; y < 4; ++y) {
+        uint8_t* p = dst + y * pitch;
+        for (size_t x = 0; x < 4; ++x, p += 4) {
+            p[0] = red[y * 4 + x];
+            p[1] = green ? green[y * 4 + x] : 0;
+            p[2] = 0;
+            p[3] = 0xff;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+// Scalar block row decoders
+//-----------------------------------------------------------------------
+
+void decode_bc1_scalar(const uint8_t* src, size_t count, uint8_t* dst, size_t dst_pitch)
+{
+    for (size_t i = 0; i < count; ++i, src += 8, dst += 16)
+        decode_color_block_scalar(src, true, nullptr, dst, dst_pitch);
+}
+
+void decode_bc2_scalar(const uint8_t* src, size_t count, uint8_t* dst, size_t dst_pitch)
+{
+    uint8_t alpha[16];
+    for (size_t i = 0; i < count; ++i, src += 16, dst += 16) {
+        decode_explicit_alpha(src, alpha);
+        decode_color_block_scalar(src + 8, false, alpha, dst, dst_pitch);
+    }
+}
+
+void decode_bc3_scalar(const uint8_t* src, size_t count, uint8_t* dst, size_t dst_pitch)
+{
+    uint8_t alpha[16];
+    for (size_t i = 0; i < count; ++i, src += 16, dst += 16) {
+        decode_unorm_channel(src, alpha);
+        decode_color_block_scalar(src + 8, false, alpha, dst, dst_pitch);
+    }
+}
+
+template <void (*DecodeChannel)(const uint8_t*, uint8_t*)>
+void decode_bc4_scalar(const uint8_t* src, size_t count, uint8_t* dst, size_t dst_pitch)
+{
+    uint8_t red[16];
+    for (size_t i = 0; i < count; ++i, src += 8, dst += 16) {
+        DecodeChannel(src, red);
+        write_red_green_scalar(red, nullptr, dst, dst_pitch);
+    }
+}
+
+template <void (*DecodeChannel)(const uint8_t*, uint8_t*)>
+void decode_bc5_scalar(const uint8_t* src, size_t count, uint8_t* dst, size_t dst_pitch)
+{
+    uint8_t red[16], green[16];
+    for (size_t i = 0; i < count; ++i, src += 16, dst += 16) {
+        DecodeChannel(src, red);
+        DecodeChannel(src + 8, green);
+        write_red_green_scalar(red, green, dst, dst_pitch);
+    }
+}
+
+BlockRowDecoder get_scalar_decoder(PixelFormat format)
+{
+    switch (format) {
+        case PixelFormat::DXT1:
+            return &decode_bc1_scalar;
+        case PixelFormat::DXT2:
+        case PixelFormat::DXT3:
+            return &decode_bc2_scalar;
+        case PixelFormat::DXT4:
+        case PixelFormat::DXT5:
+            return &decode_bc3_scalar;
+        case PixelFormat::BC4_UNORM:
+            return &decode_bc4_scalar<&decode_unorm_channel>;
+        case PixelFormat::BC4_SNORM:
+            return &decode_bc4_scalar<&decode_snorm_channel>;
+        case PixelFormat::BC5_UNORM:
+            return &decode_bc5_scalar<&decode_unorm_channel>;
+        case PixelFormat::BC5_SNORM:
+            return &decode_bc5_scalar<&decode_snorm_channel>;
+        default:
+            return nullptr;
+    }
+}
+
+#if HYUE_SIMD_SSE2
+//-----------------------------------------------------------------------
+// SSE2 colour blocks, 4 at a time
+//-----------------------------------------------------------------------
+
+/// a where mask is clear, b where it is set
+inline __m128i select(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, a));
+}
+
+/// 565 colours repeated in lanes 0-3 and 4-7, to (R, G, B, 0) in 16 bit lanes
+inline __m128i expand_565(__m128i c)
+{
+    // each channel shifted to the top of its lane, then its top bits repeated below it
+    const __m128i shifts = _mm_setr_epi16(1, 32, 2048, 0, 1, 32, 2048, 0);
+    const __m128i masks = _mm_setr_epi16(-2048, -1024, -2048, 0, -2048, -1024, -2048, 0);
+    const __m128i repeats = _mm_setr_epi16(8, 4, 8, 0, 8, 4, 8, 0);
+    __m128i top = _mm_and_si128(_mm_mullo_epi16(c, shifts), masks);
+    return _mm_or_si128(_mm_srli_epi16(top, 8), _mm_mulhi_epu16(top, repeats));
+}
+
+/** The palettes of 2 colour blocks, same values as get_color_palette.
+    @param c0 The first end point of each block, repeated in lanes 0-3 and 4-7
+    @param c1 The second end point, laid out the same way
+    @param palette The 4 colours of both blocks as (R, G, B, A) in 16 bit lanes
+*/
+inline void get_color_palettes_sse2(__m128i c0, __m128i c1, bool one_bit_alpha, __m128i palette[4])
+{
+    const __m128i sign = _mm_set1_epi16(int16_t(0x8000));
+    const __m128i alpha = _mm_setr_epi16(0, 0, 0, 0xff, 0, 0, 0, 0xff);
+    // x / 3 as the high half of x * 0x5556, exact up to 3 * 255 + 1
+    const __m128i third = _mm_set1_epi16(0x5556);
+    const __m128i one = _mm_set1_epi16(1);
+
+    __m128i e0 = expand_565(c0), e1 = expand_565(c1);
+    __m128i lerp1 = _mm_add_epi16(_mm_add_epi16(e0, e0), _mm_add_epi16(e1, one));
+    __m128i lerp2 = _mm_add_epi16(_mm_add_epi16(e1, e1), _mm_add_epi16(e0, one));
+    lerp1 = _mm_mulhi_epu16(lerp1, third);
+    lerp2 = _mm_mulhi_epu16(lerp2, third);
+
+    // c0 > c1 as unsigned, or no transparent colour
+    __m128i four_colors = _mm_cmpgt_epi16(_mm_xor_si128(c0, sign), _mm_xor_si128(c1, sign));
+    if (!one_bit_alpha)
+        four_colors = _mm_cmpeq_epi16(c0, c0);
+
+    palette[0] = _mm_or_si128(e0, alpha);
+    palette[1] = _mm_or_si128(e1, alpha);
+    palette[2] = _mm_or_si128(select(four_colors, _mm_avg_epu16(e0, e1), lerp1), alpha);
+    palette[3] = _mm_and_si128(four_colors, _mm_or_si128(lerp2, alpha));
+}
+
+/** The palettes of 4 colour blocks stride bytes apart.
+    @param palettes Colour j of block k in the RGBA word k of palettes[j]
+*/
+void get_color_palettes_sse2(const uint8_t* blocks,
+                             size_t stride,
+                             bool one_bit_alpha,
+                             __m128i palettes[4])
+{
+    // 16 bit lanes c0 c1 of blocks 0, 2, 1, 3
+    __m128i end_points = _mm_setr_epi32(int(read_u32(blocks)),
+                                        int(read_u32(blocks + stride * 2)),
+                                        int(read_u32(blocks + stride)),
+                                        int(read_u32(blocks + stride * 3)));
+
+    __m128i low[4], high[4];
+    get_color_palettes_sse2(_mm_shufflehi_epi16(_mm_shufflelo_epi16(end_points, 0x00), 0x00),
+                            _mm_shufflehi_epi16(_mm_shufflelo_epi16(end_points, 0x55), 0x55),
+                            one_bit_alpha,
+                            low);
+    get_color_palettes_sse2(_mm_shufflehi_epi16(_mm_shufflelo_epi16(end_points, 0xaa), 0xaa),
+                            _mm_shufflehi_epi16(_mm_shufflelo_epi16(end_points, 0xff), 0xff),
+                            one_bit_alpha,
+                            high);
+    for (int j = 0; j < 4; ++j)
+        palettes[j] = _mm_packus_epi16(low[j], high[j]);
+}
+
+/** Write the texels of block K of 4, selecting a row at a time with compare masks.
+    @param palettes The palettes of the 4 blocks, from get_color_palettes_sse2
+    @param alpha 16 alpha values replacing the palette alpha, or null
+*/
+template <int K>
+void store_color_block_sse2(const __m128i palettes[4],
+                            const uint8_t* block,
+                            const __m128i* alpha,
+                            uint8_t* dst,
+                            size_t pitch)
+{
+    const __m128i p0 = _mm_shuffle_epi32(palettes[0], K * 0x55);
+    const __m128i p1 = _mm_shuffle_epi32(palettes[1], K * 0x55);
+    const __m128i p2 = _mm_shuffle_epi32(palettes[2], K * 0x55);
+    const __m128i p3 = _mm_shuffle_epi32(palettes[3], K * 0x55);
+    const __m128i low_bits = _mm_setr_epi32(1, 4, 16, 64);
+    const __m128i high_bits = _mm_setr_epi32(2, 8, 32, 128);
+    const __m128i rgb_mask = _mm_set1_epi32(0x00ffffff);
+    const __m128i zero = _mm_setzero_si128();
+
+    // alpha values moved to the top byte of each texel, a row per vector
+    __m128i rows_alpha[4];
+    if (alpha) {
+        __m128i low = _mm_unpacklo_epi8(zero, *alpha), high = _mm_unpackhi_epi8(zero, *alpha);
+        rows_alpha[0] = _mm_unpacklo_epi16(zero, low);
+        rows_alpha[1] = _mm_unpackhi_epi16(zero, low);
+        rows_alpha[2] = _mm_unpacklo_epi16(zero, high);
+        rows_alpha[3] = _mm_unpackhi_epi16(zero, high);
+    }
+
+    uint32_t indices = read_u32(block + 4);
+    for (size_t y = 0; y < 4; ++y) {
+        __m128i row = _mm_set1_epi32(int((indices >> (y * 8)) & 0xff));
+        __m128i low = _mm_cmpgt_epi32(_mm_and_si128(row, low_bits), zero);
+        __m128i high = _mm_cmpgt_epi32(_mm_and_si128(row, high_bits), zero);
+        __m128i color = select(low, select(high, p0, p2), select(high, p1, p3));
+        if (alpha)
+            color = _mm_or_si128(_mm_and_si128(color, rgb_mask), rows_alpha[y]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + y * pitch), color);
+    }
+}
+
+//-----------------------------------------------------------------------
+// SSE2 alpha and channel blocks, the 16 texels at once
+//-----------------------------------------------------------------------
+
+/// Same as decode_explicit_alpha
+__m128i decode_explicit_alpha_sse2(const uint8_t* block)
+{
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(block));
+    __m128i alpha = _mm_unpacklo_epi8(_mm_and_si128(packed, nibble),
+                                      _mm_and_si128(_mm_srli_epi16(packed, 4), nibble));
+    // n * 17, the nibbles do not spill into the next byte
+    return _mm_or_si128(alpha, _mm_slli_epi16(alpha, 4));
+}
+
+/// 3 bit indices of a BC4 channel block, texels 0-7 and 8-15 in 16 bit lanes
+inline void expand_channel_indices(const uint8_t* block, __m128i indices[2])
+{
+    // texel 5 straddles the low 16 bits of each 24 bit half, texels 5-7 are read 8 bits higher
+    uint64_t bits = read_u48(block + 2);
+    uint32_t low = uint32_t(bits & 0xffffff), high = uint32_t(bits >> 24);
+    __m128i words = _mm_setr_epi32(int((low & 0xffff) | (low >> 8) << 16),
+                                   int((high & 0xffff) | (high >> 8) << 16),
+                                   0,
+                                   0);
+    words = _mm_unpacklo_epi64(words, words);
+
+    // each index shifted to the top 3 bits of its lane
+    const __m128i shifts = _mm_setr_epi16(8192, 1024, 128, 16, 2, 64, 8, 1);
+    indices[0] = _mm_shufflehi_epi16(_mm_shufflelo_epi16(words, 0x00), 0x54);
+    indices[1] = _mm_shufflehi_epi16(_mm_shufflelo_epi16(words, 0xaa), 0xfe);
+    for (int h = 0; h < 2; ++h)
+        indices[h] = _mm_srli_epi16(_mm_mullo_epi16(indices[h], shifts), 13);
+}
+
+/** Weight of the second end point for each index, out of steps: 0 and steps
+    for the end points, then 1 to steps - 1 for the interpolated values.
+*/
+inline __m128i get_channel_weights(__m128i indices, __m128i steps)
+{
+    const __m128i one = _mm_set1_epi16(1);
+    __m128i weights = _mm_max_epi16(_mm_sub_epi16(indices, one), _mm_setzero_si128());
+    return _mm_add_epi16(weights, _mm_and_si128(_mm_cmpeq_epi16(indices, one), steps));
+}
+
+/// Same as decode_unorm_channel, each texel interpolated from its index
+__m128i decode_unorm_channel_sse2(const uint8_t* block)
+{
+    int a0 = block[0], a1 = block[1];
+    int steps = a0 > a1 ? 7 : 5;
+    // x / steps as the high half of x * reciprocal, exact up to steps * 255 + steps / 2
+    const __m128i reciprocal = _mm_set1_epi16(int16_t(a0 > a1 ? 0x2493 : 0x3334));
+    const __m128i base = _mm_set1_epi16(int16_t(steps * a0 + steps / 2));
+    const __m128i delta = _mm_set1_epi16(int16_t(a1 - a0));
+    // indices 6 and 7 are 0 and 255 with 5 steps
+    const __m128i last_lerp = _mm_set1_epi16(int16_t(steps));
+    const __m128i seven = _mm_set1_epi16(7);
+
+    __m128i indices[2], values[2];
+    expand_channel_indices(block, indices);
+    for (int h = 0; h < 2; ++h) {
+        __m128i weights = get_channel_weights(indices[h], last_lerp);
+        __m128i lerp = _mm_add_epi16(base, _mm_mullo_epi16(weights, delta));
+        lerp = _mm_mulhi_epu16(lerp, reciprocal);
+        __m128i fixed = _mm_cmpgt_epi16(indices[h], last_lerp);
+        __m128i limit = _mm_srli_epi16(_mm_cmpeq_epi16(indices[h], seven), 8);
+        values[h] = select(fixed, lerp, limit);
+    }
+    return _mm_packus_epi16(values[0], values[1]);
+}
+
+/// Same as decode_snorm_channel, the float palette arithmetic done per texel
+__m128i decode_snorm_channel_sse2(const uint8_t* block)
+{
+    int a0 = std::max(-127, int(int8_t(block[0]))), a1 = std::max(-127, int(int8_t(block[1])));
+    int steps = a0 > a1 ? 7 : 5;
+    // the numerators are whole numbers, as in the scalar palette; -127 and 127
+    // are scaled so the division gives them back exactly
+    const __m128i base = _mm_set1_epi16(int16_t(steps * a0));
+    const __m128i delta = _mm_set1_epi16(int16_t(a1 - a0));
+    const __m128i last_lerp = _mm_set1_epi16(int16_t(steps));
+    const __m128i seven = _mm_set1_epi16(7);
+    const __m128i low_limit = _mm_set1_epi16(int16_t(-127 * steps));
+    const __m128i high_limit = _mm_set1_epi16(int16_t(127 * steps));
+    const __m128 divisor = _mm_set1_ps(float(steps));
+    const __m128 offset = _mm_set1_ps(127.0f);
+    const __m128 scale = _mm_set1_ps(255.0f / 254.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    __m128i indices[2], values[2];
+    expand_channel_indices(block, indices);
+    for (int h = 0; h < 2; ++h) {
+        __m128i weights = get_channel_weights(indices[h], last_lerp);
+        __m128i lerp = _mm_add_epi16(base, _mm_mullo_epi16(weights, delta));
+        __m128i fixed = _mm_cmpgt_epi16(indices[h], last_lerp);
+        __m128i limit = select(_mm_cmpeq_epi16(indices[h], seven), low_limit, high_limit);
+        __m128i numerators = select(fixed, lerp, limit);
+
+        __m128i rounded[2];
+        for (int q = 0; q < 2; ++q) {
+            __m128i wide = q ? _mm_unpackhi_epi16(numerators, numerators)
+                             : _mm_unpacklo_epi16(numerators, numerators);
+            __m128 value = _mm_div_ps(_mm_cvtepi32_ps(_mm_srai_epi32(wide, 16)), divisor);
+            value = _mm_mul_ps(_mm_add_ps(value, offset), scale);
+            // std::lround of a positive value: truncated, plus one from a fraction of a half
+            __m128i whole = _mm_cvttps_epi32(value);
+            __m128 fraction = _mm_sub_ps(value, _mm_cvtepi32_ps(whole));
+            rounded[q] = _mm_sub_epi32(whole, _mm_castps_si128(_mm_cmpge_ps(fraction, half)));
+        }
+        values[h] = _mm_packs_epi32(rounded[0], rounded[1]);
+    }
+    return _mm_packus_epi16(values[0], values[1]);
+}
+
+/// Write 16 texels of (red, green, 0, 255)
+void write_red_green_sse2(__m128i red, __m128i green, uint8_t* dst, size_t pitch)
+{
+    const __m128i blue_alpha = _mm_set1_epi16(int16_t(0xff00));
+
+    __m128i rg_low = _mm_unpacklo_epi8(red, green);
+    __m128i rg_high = _mm_unpackhi_epi8(red, green);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi16(rg_low, blue_alpha));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + pitch), _mm_unpackhi_epi16(rg_low, blue_alpha));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + pitch * 2), _mm_unpacklo_epi16(rg_high, blue_alpha));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + pitch * 3), _mm_unpackhi_epi16(rg_high, blue_alpha));
+}
+
+//-----------------------------------------------------------------------
+// SSE2 block row decoders
+//-----------------------------------------------------------------------
+
+/** BC1 - BC3 blocks, 4 per iteration; a last partial group is decoded from
+    a zero padded copy and only its real blocks are written.
+    @tparam DecodeAlpha Decoder of the alpha half of BC2 and BC3 blocks, null for BC1
+*/
+template <__m128i (*DecodeAlpha)(const uint8_t*)>
+void decode_color_blocks_sse2(const uint8_t* src, size_t count, uint8_t* dst, size_t dst_pitch)
+{
+    constexpr size_t block_bytes = DecodeAlpha ? 16 : 8;
+    constexpr size_t color_offset = DecodeAlpha ? 8 : 0;
+    using StoreBlock = void (*)(const __m128i*, const uint8_t*, const __m128i*, uint8_t*, size_t);
+    const StoreBlock store[4] = {
+        &store_color_block_sse2<0>,
+        &store_color_block_sse2<1>,
+        &store_color_block_sse2<2>,
+        &store_color_block_sse2<3>,
+    };
+
+    uint8_t padded[block_bytes * 4] = {};
+    for (size_t i = 0; i < count; i += 4, src += block_bytes * 4, dst += 64) {
+        const uint8_t* blocks = src;
+        size_t n = std::min(count - i, size_t(4));
+        if (n < 4) {
+            std::memcpy(padded, src, n * block_bytes);
+            blocks = padded;
+        }
+
+        __m128i palettes[4];
+        get_color_palettes_sse2(blocks + color_offset, block_bytes, !DecodeAlpha, palettes);
+        for (size_t k = 0; k < n; ++k) {
+            const uint8_t* block = blocks + k * block_bytes;
+            if (DecodeAlpha) {
+                __m128i alpha = DecodeAlpha(block);
+                store[k](palettes, block + color_offset, &alpha, dst + k * 16, dst_pitch);
+            } else {
+                store[k](palettes, block, nullptr, dst + k * 16, dst_pitch);
+            }
+        }
+    }
+}
+
+template <__m128i (*DecodeChannel)(const uint8_t*)>
+void decode_bc4_sse2(const uint8_t* src, size_t count, uint8_t* dst, size_t dst_pitch)
+{
+    for (size_t i = 0; i < count; ++i, src += 8, dst += 16)
+        write_red_green_sse2(DecodeChannel(src), _mm_setzero_si128(), dst, dst_pitch);
+}
+
+template <__m128i (*DecodeChannel)(const uint8_t*)>
+void decode_bc5_sse2(const uint8_t* src, size_t count, uint8_t* dst, size_t dst_pitch)
+{
+    for (size_t i = 0; i < count; ++i, src += 16, dst += 16)
+        write_red_green_sse2(DecodeChannel(src), DecodeChannel(src + 8), dst, dst_pitch);
+}
+
+BlockRowDecoder get_sse2_decoder(PixelFormat format)
+{
+    switch (format) {
+        case PixelFormat::DXT1:
+            return &decode_color_blocks_sse2<nullptr>;
+        case PixelFormat::DXT2:
+        case PixelFormat::DXT3:
+            return &decode_color_blocks_sse2<&decode_explicit_alpha_sse2>;
+        case PixelFormat::DXT4:
+        case PixelFormat::DXT5:
+            return &decode_color_blocks_sse2<&decode_unorm_channel_sse2>;
+        case PixelFormat::BC4_UNORM:
+            return &decode_bc4_sse2<&decode_unorm_channel_sse2>;
+        case PixelFormat::BC4_SNORM:
+            return &decode_bc4_sse2<&decode_snorm_channel_sse2>;
+        case PixelFormat::BC5_UNORM:
+            return &decode_bc5_sse2<&decode_unorm_channel_sse2>;
+        case PixelFormat::BC5_SNORM:
+            return &decode_bc5_sse2<&decode_snorm_channel_sse2>;
+        default:
+            return nullptr;
+    }
+}
+#endif
+
+} // namespace
+
+bool get_block_format(PixelFormat format, BlockFormat* block_format)
+{
+    using DecoderLookup = BlockRowDecoder (*)(PixelFormat);
+    DecoderLookup lookup = select_simd<DecoderLookup>(nullptr,
+                                                      HYUE_SSE2_KERNEL(get_sse2_decoder),
+                                                      &get_scalar_decoder);
+    BlockRowDecoder decode = lookup(format);
+
+    if (!decode)
+        decode = get_etc_decoder(format);
+
+    size_t block_width = 4, block_height = 4;
+    if (!decode)
+        decode = get_astc_decoder(format, &block_width, &block_height);
+    if (!decode)
+        return false;
+
+    // DXT2/DXT4 are premultiplied, the data is returned as stored
+    bool small_blocks = format == PixelFormat::DXT1 || format == PixelFormat::BC4_UNORM
+                        || format == PixelFormat::BC4_SNORM || format == PixelFormat::ETC1_RGB8
+                        || format == PixelFormat::ETC2_RGB8 || format == PixelFormat::ETC2_RGB8A1;
+    *block_format = {block_width, block_height, small_blocks ? size_t(8) : size_t(16), decode};
+    return true;
+}
+
+} // namespace hyue
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <hyue/PixelFormat.h>
+
+namespace hyue {
+
+/** Decodes count consecutive blocks of one block row to 8 bit RGBA.
+
+    Block i is written to dst + i * block_width * 4, its rows dst_pitch bytes
+    apart; dst must hold whole blocks.
+*/
+using BlockRowDecoder = void (*)(const uint8_t* src, size_t count, uint8_t* dst, size_t dst_pitch);
+
+/// Layout of a block compressed format and its decoder
+struct BlockFormat {
+    size_t block_width;
+    size_t block_height;
+    size_t block_bytes;
+    BlockRowDecoder decode;
+};
+
+/** Look up the decoder of a block compressed format. BC1-BC5 decoders use
+    SSE2 when get_simd_level() allows it, with the same results as the scalar ones.
+    @return false if the format can not be decoded
+*/
+bool get_block_format(PixelFormat format, BlockFormat* block_format);
+
+/// ETC1, ETC2 and ETC2 + EAC alpha decoders of 4x4 blocks, nullptr for other formats
+BlockRowDecoder get_etc_decoder(PixelFormat format);
+
+/// ASTC LDR decoders, nullptr for other formats
+BlockRowDecoder get_astc_decoder(PixelFormat format, size_t* block_width, size_t* block_height);
+
+} // namespace hyue
@@ -0,0 +1,689 @@
+#include "block_decompression.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace hyue {
+
+namespace {
+
+/// Largest number of weights of a block, over both planes
+const int ASTC_MAX_WEIGHTS = 64;
+/// Largest number of colour endpoint values of a block
+const int ASTC_MAX_COLOR_VALUES = 18;
+/// Largest block footprint
+const int ASTC_MAX_TEXELS = 12 * 12;
+
+/// Value ranges of the integer sequence encoding, by quantisation level
+struct IseRange {
+    int trits;
+    int quints;
+    int bits;
+};
+
+const IseRange g_ise_ranges[21] = {
+    {0, 0, 1}, // 2
+    {1, 0, 0}, // 3
+    {0, 0, 2}, // 4
+    {0, 1, 0}, // 5
+    {1, 0, 1}, // 6
+    {0, 0, 3}, // 8
+    {0, 1, 1}, // 10
+    {1, 0, 2}, // 12
+    {0, 0, 4}, // 16
+    {0, 1, 2}, // 20
+    {1, 0, 3}, // 24
+    {0, 0, 5}, // 32
+    {0, 1, 3}, // 40
+    {1, 0, 4}, // 48
+    {0, 0, 6}, // 64
+    {0, 1, 4}, // 80
+    {1, 0, 5}, // 96
+    {0, 0, 7}, // 128
+    {0, 1, 5}, // 160
+    {1, 0, 6}, // 192
+    {0, 0, 8}, // 256
+};
+
+/// Lowest quantisation level colour endpoints may use, 6 values
+const int ASTC_MIN_COLOR_LEVEL = 4;
+
+/// Magenta marks blocks that can not be decoded
+const uint8_t g_error_color[4] = {0xff, 0, 0xff, 0xff};
+
+/// Bits of the block starting at bit pos, least significant first; bits at or above end read as 0
+inline uint32_t read_bits(const uint8_t* block, int pos, int count, int end = 128)
+{
+    uint32_t ret = 0;
+    for (int i = 0; i < count && pos + i < end; ++i)
+        ret |= uint32_t((block[(pos + i) >> 3] >> ((pos + i) & 7)) & 1) << i;
+    return ret;
+}
+
+int get_ise_bit_count(int count, int level)
+{
+    const IseRange& range = g_ise_ranges[level];
+    return count * range.bits + (count * 8 * range.trits + 4) / 5 + (count * 7 * range.quints + 2) / 3;
+}
+
+/// Unpack the 5 trits of an 8 bit trit block
+void decode_trits(uint32_t t, int trits[5])
+{
+    uint32_t c;
+    if (((t >> 2) & 7) == 7) {
+        c = (t >> 5 & 7) << 2 | (t & 3);
+        trits[4] = 2;
+        trits[3] = 2;
+    } else {
+        c = t & 0x1f;
+        if (((t >> 5) & 3) == 3) {
+            trits[4] = 2;
+            trits[3] = int(t >> 7 & 1);
+        } else {
+            trits[4] = int(t >> 7 & 1);
+            trits[3] = int(t >> 5 & 3);
+        }
+    }
+
+    if ((c & 3) == 3) {
+        trits[2] = 2;
+        trits[1] = int(c >> 4 & 1);
+        trits[0] = int((c >> 3 & 1) << 1 | ((c >> 2 & 1) & ~(c >> 3 & 1)));
+    } else if (((c >> 2) & 3) == 3) {
+        trits[2] = 2;
+        trits[1] = 2;
+        trits[0] = int(c & 3);
+    } else {
+        trits[2] = int(c >> 4 & 1);
+        trits[1] = int(c >> 2 & 3);
+        trits[0] = int((c >> 1 & 1) << 1 | ((c & 1) & ~(c >> 1 & 1)));
+    }
+}
+
+/// Unpack the 3 quints of a 7 bit quint block
+void decode_quints(uint32_t q, int quints[3])
+{
+    if (((q >> 1) & 3) == 3 && ((q >> 5) & 3) == 0) {
+        quints[2] = int((q & 1) << 2 | ((q >> 4 & 1) & ~q & 1) << 1 | ((q >> 3 & 1) & ~q & 1));
+        quints[1] = 4;
+        quints[0] = 4;
+        return;
+    }
+
+    uint32_t c;
+    if (((q >> 1) & 3) == 3) {
+        quints[2] = 4;
+        c = (q >> 3 & 3) << 3 | (~q >> 5 & 3) << 1 | (q & 1);
+    } else {
+        quints[2] = int(q >> 5 & 3);
+        c = q & 0x1f;
+    }
+
+    if ((c & 7) == 5) {
+        quints[1] = 4;
+        quints[0] = int(c >> 3 & 3);
+    } else {
+        quints[1] = int(c >> 3 & 3);
+        quints[0] = int(c & 7);
+    }
+}
+
+/** Decode count values of an integer sequence starting at bit pos.
+    Each value is returned as its trit or quint times 2^bits plus its bits.
+*/
+void decode_ise(const uint8_t* block, int pos, int count, int level, int* values)
+{
+    const IseRange& range = g_ise_ranges[level];
+    const int n = range.bits;
+    const int end = pos + get_ise_bit_count(count, level);
+
+    if (range.trits) {
+        // m0 t[1:0] m1 t[3:2] m2 t[4] m3 t[6:5] m4 t[7]
+        const int t_bits[5] = {2, 2, 1, 2, 1};
+        for (int i = 0; i < count; i += 5) {
+            int m[5];
+            uint32_t t = 0;
+            for (int j = 0, t_pos = 0; j < 5; ++j) {
+                m[j] = int(read_bits(block, pos, n, end));
+                pos += n;
+                t |= read_bits(block, pos, t_bits[j], end) << t_pos;
+                pos += t_bits[j];
+                t_pos += t_bits[j];
+            }
+            int trits[5];
+            decode_trits(t, trits);
+            for (int j = 0; j < 5 && i + j < count; ++j)
+                values[i + j] = trits[j] << n | m[j];
+        }
+    } else if (range.quints) {
+        // m0 q[2:0] m1 q[4:3] m2 q[6:5]
+        const int q_bits[3] = {3, 2, 2};
+        for (int i = 0; i < count; i += 3) {
+            int m[3];
+            uint32_t q = 0;
+            for (int j = 0, q_pos = 0; j < 3; ++j) {
+                m[j] = int(read_bits(block, pos, n, end));
+                pos += n;
+                q |= read_bits(block, pos, q_bits[j], end) << q_pos;
+                pos += q_bits[j];
+                q_pos += q_bits[j];
+            }
+            int quints[3];
+            decode_quints(q, quints);
+            for (int j = 0; j < 3 && i + j < count; ++j)
+                values[i + j] = quints[j] << n | m[j];
+        }
+    } else {
+        for (int i = 0; i < count; ++i, pos += n)
+            values[i] = int(read_bits(block, pos, n));
+    }
+}
+
+/// Replicate the bits of a value of n bits to fill width bits
+int replicate_bits(int value, int n, int width)
+{
+    int ret = 0;
+    for (int shift = width - n; shift > -n; shift -= n)
+        ret |= shift >= 0 ? value << shift : value >> -shift;
+    return ret;
+}
+
+/// Colour endpoint value to [0, 255]
+int unquantize_color(int value, int level)
+{
+    const IseRange& range = g_ise_ranges[level];
+    const int n = range.bits;
+    if (!range.trits && !range.quints)
+        return replicate_bits(value, n, 8);
+
+    int d = value >> n, m = value & ((1 << n) - 1);
+    int a = (m & 1) ? 0x1ff : 0;
+    int b = 0, c = 0;
+    int hi = m >> 1;
+    if (range.trits) {
+        switch (n) {
+            case 1: c = 204; break;
+            case 2: b = hi * 0x116; c = 93; break;
+            case 3: b = hi << 7 | hi << 2 | hi; c = 44; break;
+            case 4: b = hi << 6 | hi; c = 22; break;
+            case 5: b = hi << 5 | hi >> 2; c = 11; break;
+            case 6: b = hi << 4 | hi >> 4; c = 5; break;
+        }
+    } else {
+        switch (n) {
+            case 1: c = 113; break;
+            case 2: b = hi * 0x10c; c = 54; break;
+            case 3: b = hi << 7 | hi << 1 | hi >> 1; c = 26; break;
+            case 4: b = hi << 6 | hi >> 1; c = 13; break;
+            case 5: b = hi << 5 | hi >> 3; c = 6; break;
+        }
+    }
+    int t = (d * c + b) ^ a;
+    return (a & 0x80) | (t >> 2);
+}
+
+/// Weight value to [0, 64]
+int unquantize_weight(int value, int level)
+{
+    const IseRange& range = g_ise_ranges[level];
+    const int n = range.bits;
+    int ret;
+    if (!range.trits && !range.quints) {
+        ret = replicate_bits(value, n, 6);
+    } else if (n == 0) {
+        static const int trit_weights[3] = {0, 32, 63};
+        static const int quint_weights[5] = {0, 16, 32, 47, 63};
+        ret = range.trits ? trit_weights[value] : quint_weights[value];
+    } else {
+        int d = value >> n, m = value & ((1 << n) - 1);
+        int a = (m & 1) ? 0x7f : 0;
+        int b = 0, c = 0;
+        int hi = m >> 1;
+        if (range.trits) {
+            switch (n) {
+                case 1: c = 50; break;
+                case 2: b = hi * 0x45; c = 23; break;
+                case 3: b = hi << 5 | hi; c = 11; break;
+            }
+        } else {
+            switch (n) {
+                case 1: c = 28; break;
+                case 2: b = hi * 0x42; c = 13; break;
+            }
+        }
+        int t = (d * c + b) ^ a;
+        ret = (a & 0x20) | (t >> 2);
+    }
+    return ret > 32 ? ret + 1 : ret;
+}
+
+uint32_t hash52(uint32_t p)
+{
+    p ^= p >> 15;
+    p -= p << 17;
+    p += p << 7;
+    p += p << 4;
+    p ^= p >> 5;
+    p += p << 16;
+    p ^= p >> 7;
+    p ^= p >> 3;
+    p ^= p << 6;
+    p ^= p >> 17;
+    return p;
+}
+
+/// Partition of a texel, as specified
+int select_partition(int seed, int x, int y, int partition_count, bool small_block)
+{
+    if (small_block) {
+        x <<= 1;
+        y <<= 1;
+    }
+    seed += (partition_count - 1) * 1024;
+    uint32_t rnum = hash52(uint32_t(seed));
+
+    uint32_t seeds[8];
+    for (int i = 0; i < 8; ++i) {
+        seeds[i] = (rnum >> (i * 4)) & 0xf;
+        seeds[i] *= seeds[i];
+    }
+
+    int sh1, sh2;
+    if (seed & 1) {
+        sh1 = (seed & 2) ? 4 : 5;
+        sh2 = partition_count == 3 ? 6 : 5;
+    } else {
+        sh1 = partition_count == 3 ? 6 : 5;
+        sh2 = (seed & 2) ? 4 : 5;
+    }
+    for (int i = 0; i < 8; ++i)
+        seeds[i] >>= (i & 1) ? sh2 : sh1;
+
+    // the z terms of the specification vanish in 2D
+    int a = int((seeds[0] * x + seeds[1] * y + (rnum >> 14)) & 0x3f);
+    int b = int((seeds[2] * x + seeds[3] * y + (rnum >> 10)) & 0x3f);
+    int c = int((seeds[4] * x + seeds[5] * y + (rnum >> 6)) & 0x3f);
+    int d = int((seeds[6] * x + seeds[7] * y + (rnum >> 2)) & 0x3f);
+    if (partition_count < 4)
+        d = 0;
+    if (partition_count < 3)
+        c = 0;
+
+    if (a >= b && a >= c && a >= d)
+        return 0;
+    if (b >= c && b >= d)
+        return 1;
+    if (c >= d)
+        return 2;
+    return 3;
+}
+
+/// Moves the top bit of b into a and turns a into a signed 6 bit offset
+void bit_transfer_signed(int& a, int& b)
+{
+    b >>= 1;
+    b |= a & 0x80;
+    a >>= 1;
+    a &= 0x3f;
+    if (a & 0x20)
+        a -= 0x40;
+}
+
+void blue_contract(int* color)
+{
+    color[0] = (color[0] + color[2]) >> 1;
+    color[1] = (color[1] + color[2]) >> 1;
+}
+
+/** RGBA end points of a partition from its colour values.
+    @return false for HDR modes, which the LDR profile can not decode
+*/
+bool decode_endpoints(int mode, int* v, int e0[4], int e1[4])
+{
+    auto set = [](int* e, int r, int g, int b, int a) {
+        e[0] = r;
+        e[1] = g;
+        e[2] = b;
+        e[3] = a;
+    };
+
+    switch (mode) {
+        case 0: // luminance
+            set(e0, v[0], v[0], v[0], 0xff);
+            set(e1, v[1], v[1], v[1], 0xff);
+            break;
+        case 1: { // luminance, base and offset
+            int l0 = (v[0] >> 2) | (v[1] & 0xc0);
+            int l1 = std::min(0xff, l0 + (v[1] & 0x3f));
+            set(e0, l0, l0, l0, 0xff);
+            set(e1, l1, l1, l1, 0xff);
+            break;
+        }
+        case 4: // luminance and alpha
+            set(e0, v[0], v[0], v[0], v[2]);
+            set(e1, v[1], v[1], v[1], v[3]);
+            break;
+        case 5: // luminance and alpha, base and offset
+            bit_transfer_signed(v[1], v[0]);
+            bit_transfer_signed(v[3], v[2]);
+            set(e0, v[0], v[0], v[0], v[2]);
+            set(e1, v[0] + v[1], v[0] + v[1], v[0] + v[1], v[2] + v[3]);
+            break;
+        case 6: // RGB and scale
+            set(e0, v[0] * v[3] >> 8, v[1] * v[3] >> 8, v[2] * v[3] >> 8, 0xff);
+            set(e1, v[0], v[1], v[2], 0xff);
+            break;
+        case 8: // RGB
+        case 12: { // RGBA
+            int a0 = mode == 12 ? v[6] : 0xff, a1 = mode == 12 ? v[7] : 0xff;
+            if (v[1] + v[3] + v[5] >= v[0] + v[2] + v[4]) {
+                set(e0, v[0], v[2], v[4], a0);
+                set(e1, v[1], v[3], v[5], a1);
+            } else {
+                set(e0, v[1], v[3], v[5], a1);
+                set(e1, v[0], v[2], v[4], a0);
+                blue_contract(e0);
+                blue_contract(e1);
+            }
+            break;
+        }
+        case 9: // RGB, base and offset
+        case 13: { // RGBA, base and offset
+            bit_transfer_signed(v[1], v[0]);
+            bit_transfer_signed(v[3], v[2]);
+            bit_transfer_signed(v[5], v[4]);
+            int a0 = 0xff, a1 = 0xff;
+            if (mode == 13) {
+                bit_transfer_signed(v[7], v[6]);
+                a0 = v[6];
+                a1 = v[6] + v[7];
+            }
+            if (v[1] + v[3] + v[5] >= 0) {
+                set(e0, v[0], v[2], v[4], a0);
+                set(e1, v[0] + v[1], v[2] + v[3], v[4] + v[5], a1);
+            } else {
+                set(e0, v[0] + v[1], v[2] + v[3], v[4] + v[5], a1);
+                set(e1, v[0], v[2], v[4], a0);
+                blue_contract(e0);
+                blue_contract(e1);
+            }
+            break;
+        }
+        case 10: // RGB and scale, plus two alphas
+            set(e0, v[0] * v[3] >> 8, v[1] * v[3] >> 8, v[2] * v[3] >> 8, v[4]);
+            set(e1, v[0], v[1], v[2], v[5]);
+            break;
+        default: // HDR
+            return false;
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        e0[i] = std::min(0xff, std::max(0, e0[i]));
+        e1[i] = std::min(0xff, std::max(0, e1[i]));
+    }
+    return true;
+}
+
+/// Weight grid of a block mode
+struct BlockMode {
+    int grid_width;
+    int grid_height;
+    bool dual_plane;
+    int weight_level;
+};
+
+bool decode_block_mode(uint32_t mode, BlockMode* ret)
+{
+    int r = int(mode >> 4 & 1);
+    int h = int(mode >> 9 & 1);
+    bool d = (mode >> 10 & 1) != 0;
+    int a = int(mode >> 5 & 3);
+    int w, hh;
+
+    if (mode & 3) {
+        r |= int(mode & 3) << 1;
+        int b = int(mode >> 7 & 3);
+        switch (mode >> 2 & 3) {
+            case 0: w = b + 4; hh = a + 2; break;
+            case 1: w = b + 8; hh = a + 2; break;
+            case 2: w = a + 2; hh = b + 8; break;
+            default:
+                b &= 1;
+                if (mode & 0x100) {
+                    w = b + 2;
+                    hh = a + 2;
+                } else {
+                    w = a + 2;
+                    hh = b + 6;
+                }
+                break;
+        }
+    } else {
+        r |= int(mode >> 2 & 3) << 1;
+        if ((mode >> 2 & 3) == 0)
+            return false;
+        int b = int(mode >> 9 & 3);
+        switch (mode >> 7 & 3) {
+            case 0: w = 12; hh = a + 2; break;
+            case 1: w = a + 2; hh = 12; break;
+            case 2:
+                w = a + 6;
+                hh = b + 6;
+                d = false;
+                h = 0;
+                break;
+            default:
+                if (a == 0) {
+                    w = 6;
+                    hh = 10;
+                } else if (a == 1) {
+                    w = 10;
+                    hh = 6;
+                } else {
+                    return false;
+                }
+                break;
+        }
+    }
+
+    *ret = {w, hh, d, r - 2 + 6 * h};
+    return true;
+}
+
+void fill_block(const uint8_t color[4], int block_width, int block_height, uint8_t* dst, size_t pitch)
+{
+    for (int y = 0; y < block_height; ++y)
+        for (int x = 0; x < block_width; ++x)
+            memcpy(dst + y * pitch + x * 4, color, 4);
+}
+
+/// Decode a 2D LDR block; malformed blocks and HDR content give the error colour
+void decode_astc_block(const uint8_t* block, int block_width, int block_height, uint8_t* dst, size_t pitch)
+{
+    uint32_t mode = read_bits(block, 0, 11);
+
+    // void extent: one constant colour, stored as 16 bit values
+    if ((mode & 0x1ff) == 0x1fc) {
+        if ((mode & 0x200) || read_bits(block, 10, 2) != 3) {
+            fill_block(g_error_color, block_width, block_height, dst, pitch);
+            return;
+        }
+        uint8_t color[4];
+        for (int i = 0; i < 4; ++i)
+            color[i] = block[9 + i * 2];
+        fill_block(color, block_width, block_height, dst, pitch);
+        return;
+    }
+
+    BlockMode block_mode;
+    int partition_count = int(read_bits(block, 11, 2)) + 1;
+    if (!decode_block_mode(mode, &block_mode) || block_mode.grid_width > block_width
+        || block_mode.grid_height > block_height || (block_mode.dual_plane && partition_count == 4)) {
+        fill_block(g_error_color, block_width, block_height, dst, pitch);
+        return;
+    }
+
+    const int planes = block_mode.dual_plane ? 2 : 1;
+    const int weight_count = block_mode.grid_width * block_mode.grid_height * planes;
+    const int weight_bits = get_ise_bit_count(weight_count, block_mode.weight_level);
+    if (weight_count > ASTC_MAX_WEIGHTS || weight_bits < 24 || weight_bits > 96) {
+        fill_block(g_error_color, block_width, block_height, dst, pitch);
+        return;
+    }
+
+    // colour endpoint modes; with several partitions the extra bits sit below the weights
+    int cem[4];
+    int partition_seed = 0;
+    int color_start;
+    int below_weights = 128 - weight_bits;
+    if (partition_count == 1) {
+        cem[0] = int(read_bits(block, 13, 4));
+        color_start = 17;
+    } else {
+        partition_seed = int(read_bits(block, 13, 10));
+        color_start = 29;
+        uint32_t encoded = read_bits(block, 23, 6);
+        if ((encoded & 3) == 0) {
+            for (int i = 0; i < partition_count; ++i)
+                cem[i] = int(encoded >> 2);
+        } else {
+            int extra_bits = 3 * partition_count - 4;
+            below_weights -= extra_bits;
+            encoded |= read_bits(block, below_weights, extra_bits) << 6;
+
+            int base_class = int(encoded & 3) - 1;
+            int pos = 2;
+            for (int i = 0; i < partition_count; ++i, ++pos)
+                cem[i] = (int(encoded >> pos & 1) + base_class) << 2;
+            for (int i = 0; i < partition_count; ++i, pos += 2)
+                cem[i] |= int(encoded >> pos & 3);
+        }
+    }
+
+    int dual_plane_channel = -1;
+    if (block_mode.dual_plane) {
+        below_weights -= 2;
+        dual_plane_channel = int(read_bits(block, below_weights, 2));
+    }
+
+    // the highest colour quantisation level that fits the remaining bits
+    int color_count = 0;
+    for (int i = 0; i < partition_count; ++i)
+        color_count += ((cem[i] >> 2) + 1) * 2;
+    int color_bits = below_weights - color_start;
+    int color_level = 20;
+    while (color_level >= ASTC_MIN_COLOR_LEVEL && get_ise_bit_count(color_count, color_level) > color_bits)
+        --color_level;
+    if (color_count > ASTC_MAX_COLOR_VALUES || color_level < ASTC_MIN_COLOR_LEVEL) {
+        fill_block(g_error_color, block_width, block_height, dst, pitch);
+        return;
+    }
+
+    int colors[ASTC_MAX_COLOR_VALUES];
+    decode_ise(block, color_start, color_count, color_level, colors);
+    int endpoints[4][2][4];
+    for (int i = 0, v = 0; i < partition_count; ++i) {
+        for (int j = 0; j < ((cem[i] >> 2) + 1) * 2; ++j)
+            colors[v + j] = unquantize_color(colors[v + j], color_level);
+        if (!decode_endpoints(cem[i], colors + v, endpoints[i][0], endpoints[i][1])) {
+            fill_block(g_error_color, block_width, block_height, dst, pitch);
+            return;
+        }
+        v += ((cem[i] >> 2) + 1) * 2;
+    }
+
+    // weights are stored from the top of the block downwards
+    uint8_t reversed[16];
+    for (int i = 0; i < 16; ++i) {
+        uint8_t b = block[15 - i];
+        b = uint8_t((b & 0xf0) >> 4 | (b & 0x0f) << 4);
+        b = uint8_t((b & 0xcc) >> 2 | (b & 0x33) << 2);
+        reversed[i] = uint8_t((b & 0xaa) >> 1 | (b & 0x55) << 1);
+    }
+    int weights[ASTC_MAX_WEIGHTS];
+    decode_ise(reversed, 0, weight_count, block_mode.weight_level, weights);
+    for (int i = 0; i < weight_count; ++i)
+        weights[i] = unquantize_weight(weights[i], block_mode.weight_level);
+
+    // bilinear infill of the weight grid to the texels
+    const int gw = block_mode.grid_width, gh = block_mode.grid_height;
+    const int ds = (1024 + block_width / 2) / (block_width - 1);
+    const int dt = (1024 + block_height / 2) / (block_height - 1);
+    const bool small_block = block_width * block_height < 31;
+
+    for (int y = 0; y < block_height; ++y) {
+        int gt = (dt * y * (gh - 1) + 32) >> 6;
+        int jt = gt >> 4, ft = gt & 0xf;
+        for (int x = 0; x < block_width; ++x) {
+            int gs = (ds * x * (gw - 1) + 32) >> 6;
+            int js = gs >> 4, fs = gs & 0xf;
+
+            int w11 = (fs * ft + 8) >> 4;
+            int w10 = ft - w11, w01 = fs - w11, w00 = 16 - fs - ft + w11;
+            int v0 = js + jt * gw;
+            // neighbours with a zero factor may be outside the grid
+            int x1 = fs ? 1 : 0, y1 = ft ? gw : 0;
+
+            int texel_weights[2];
+            for (int p = 0; p < planes; ++p) {
+                texel_weights[p] = (weights[v0 * planes + p] * w00 + weights[(v0 + x1) * planes + p] * w01
+                                    + weights[(v0 + y1) * planes + p] * w10
+                                    + weights[(v0 + x1 + y1) * planes + p] * w11 + 8)
+                                   >> 4;
+            }
+
+            int partition = partition_count > 1 ? select_partition(partition_seed, x, y, partition_count, small_block)
+                                                : 0;
+            const int* e0 = endpoints[partition][0];
+            const int* e1 = endpoints[partition][1];
+            uint8_t* p = dst + y * pitch + x * 4;
+            for (int c = 0; c < 4; ++c) {
+                int w = texel_weights[c == dual_plane_channel ? 1 : 0];
+                // interpolation of the end points expanded to 16 bits, keeping the top 8 bits
+                int c0 = e0[c] * 257, c1 = e1[c] * 257;
+                p[c] = uint8_t(((c0 * (64 - w) + c1 * w + 32) >> 6) >> 8);
+            }
+        }
+    }
+}
+
+template <int BlockWidth, int BlockHeight>
+void decode_astc(const uint8_t* src, size_t count, uint8_t* dst, size_t dst_pitch)
+{
+    static_assert(BlockWidth * BlockHeight <= ASTC_MAX_TEXELS, "");
+    for (size_t i = 0; i < count; ++i, src += 16, dst += BlockWidth * 4)
+        decode_astc_block(src, BlockWidth, BlockHeight, dst, dst_pitch);
+}
+
+} // namespace
+
+BlockRowDecoder get_astc_decoder(PixelFormat format, size_t* block_width, size_t* block_height)
+{
+#define HYUE_ASTC_DECODER(w, h)                                                                   \
+    case PixelFormat::ASTC_RGBA_##w##X##h##_LDR:                                                  \
+        *block_width = w;                                                                         \
+        *block_height = h;                                                                        \
+        return &decode_astc<w, h>;
+
+    switch (format) {
+        HYUE_ASTC_DECODER(4, 4)
+        HYUE_ASTC_DECODER(5, 4)
+        HYUE_ASTC_DECODER(5, 5)
+        HYUE_ASTC_DECODER(6, 5)
+        HYUE_ASTC_DECODER(6, 6)
+        HYUE_ASTC_DECODER(8, 5)
+        HYUE_ASTC_DECODER(8, 6)
+        HYUE_ASTC_DECODER(8, 8)
+        HYUE_ASTC_DECODER(10, 5)
+        HYUE_ASTC_DECODER(10, 6)
+        HYUE_ASTC_DECODER(10, 8)
+        HYUE_ASTC_DECODER(10, 10)
+        HYUE_ASTC_DECODER(12, 10)
+        HYUE_ASTC_DECODER(12, 12)
+        default:
+            return nullptr;
+    }
+#undef HYUE_ASTC_DECODER
+}
+
+} // namespace hyue
@@ -0,0 +1,294 @@
+#include "block_decompression.h"
+
+#include <algorithm>
+
+namespace hyue {
+
+namespace {
+
+/// ETC1 intensity modifiers, the small and the large one of each table
+const int g_etc1_modifiers[8][2] = {{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}};
+
+/// Distances of the ETC2 T and H modes
+const int g_etc2_distances[8] = {3, 6, 11, 16, 23, 32, 41, 64};
+
+/// EAC alpha modifiers
+const int g_eac_modifiers[16][8] = {
+    {-3, -6, -9, -15, 2, 5, 8, 14},
+    {-3, -7, -10, -13, 2, 6, 9, 12},
+    {-2, -5, -8, -13, 1, 4, 7, 12},
+    {-2, -4, -6, -13, 1, 3, 5, 12},
+    {-3, -6, -8, -12, 2, 5, 7, 11},
+    {-3, -7, -9, -11, 2, 6, 8, 10},
+    {-4, -7, -8, -11, 3, 6, 7, 10},
+    {-3, -5, -8, -11, 2, 4, 7, 10},
+    {-2, -6, -8, -10, 1, 5, 7, 9},
+    {-2, -5, -8, -10, 1, 4, 7, 9},
+    {-2, -4, -8, -10, 1, 3, 7, 9},
+    {-2, -5, -7, -10, 1, 4, 6, 9},
+    {-3, -4, -7, -10, 2, 3, 6, 9},
+    {-1, -2, -3, -10, 0, 1, 2, 9},
+    {-4, -6, -8, -9, 3, 5, 7, 8},
+    {-3, -5, -7, -9, 2, 4, 6, 8},
+};
+
+/// The variants sharing the ETC1/ETC2 colour block
+enum class EtcMode {
+    /// ETC1, no T, H or planar modes
+    ETC1,
+    /// ETC2 RGB, also the colour of ETC2 RGBA
+    ETC2,
+    /// ETC2 RGB with punch-through alpha, the differential bit is the opaque bit
+    ETC2_PUNCHTHROUGH,
+};
+
+inline uint64_t read_u64_be(const uint8_t* p)
+{
+    uint64_t ret = 0;
+    for (int i = 0; i < 8; ++i)
+        ret = ret << 8 | p[i];
+    return ret;
+}
+
+inline uint32_t bits(uint64_t block, int high, int low)
+{
+    return uint32_t(block >> low) & ((1u << (high - low + 1)) - 1);
+}
+
+inline uint8_t clamp_byte(int v)
+{
+    return uint8_t(std::min(255, std::max(0, v)));
+}
+
+inline int extend_4(uint32_t v)
+{
+    return int(v << 4 | v);
+}
+
+inline int extend_5(uint32_t v)
+{
+    return int(v << 3 | v >> 2);
+}
+
+inline int extend_6(uint32_t v)
+{
+    return int(v << 2 | v >> 4);
+}
+
+inline int extend_7(uint32_t v)
+{
+    return int(v << 1 | v >> 6);
+}
+
+struct Rgb {
+    int r, g, b;
+};
+
+inline void write_texel(uint8_t* dst, size_t pitch, int x, int y, int r, int g, int b, uint8_t a)
+{
+    uint8_t* p = dst + y * pitch + x * 4;
+    p[0] = clamp_byte(r);
+    p[1] = clamp_byte(g);
+    p[2] = clamp_byte(b);
+    p[3] = a;
+}
+
+/** Decode the 2 bit index of every texel to one of 4 colours.
+    Indices are stored column by column, the high bits in the upper half word.
+    @param transparent Index 2 is transparent black instead of the colour
+*/
+void write_paint_colors(uint64_t block, const Rgb paint[4], bool transparent, uint8_t* dst, size_t pitch)
+{
+    for (int x = 0; x < 4; ++x) {
+        for (int y = 0; y < 4; ++y) {
+            int texel = x * 4 + y;
+            int index = int((block >> (texel + 16)) & 1) << 1 | int((block >> texel) & 1);
+            if (transparent && index == 2)
+                write_texel(dst, pitch, x, y, 0, 0, 0, 0);
+            else
+                write_texel(dst, pitch, x, y, paint[index].r, paint[index].g, paint[index].b, 0xff);
+        }
+    }
+}
+
+void decode_t_mode(uint64_t block, bool transparent, uint8_t* dst, size_t pitch)
+{
+    Rgb c1 = {extend_4(bits(block, 60, 59) << 2 | bits(block, 57, 56)),
+              extend_4(bits(block, 55, 52)),
+              extend_4(bits(block, 51, 48))};
+    Rgb c2 = {extend_4(bits(block, 47, 44)), extend_4(bits(block, 43, 40)), extend_4(bits(block, 39, 36))};
+    int d = g_etc2_distances[bits(block, 35, 34) << 1 | bits(block, 32, 32)];
+
+    const Rgb paint[4] = {c1, {c2.r + d, c2.g + d, c2.b + d}, c2, {c2.r - d, c2.g - d, c2.b - d}};
+    write_paint_colors(block, paint, transparent, dst, pitch);
+}
+
+void decode_h_mode(uint64_t block, bool transparent, uint8_t* dst, size_t pitch)
+{
+    Rgb c1 = {extend_4(bits(block, 62, 59)),
+              extend_4(bits(block, 58, 56) << 1 | bits(block, 52, 52)),
+              extend_4(bits(block, 51, 51) << 3 | bits(block, 49, 47))};
+    Rgb c2 = {extend_4(bits(block, 46, 43)), extend_4(bits(block, 42, 39)), extend_4(bits(block, 38, 35))};
+
+    // the order of the base colours is the low bit of the distance index
+    int order = (c1.r << 16 | c1.g << 8 | c1.b) >= (c2.r << 16 | c2.g << 8 | c2.b) ? 1 : 0;
+    int d = g_etc2_distances[bits(block, 34, 34) << 2 | bits(block, 32, 32) << 1 | order];
+
+    const Rgb paint[4] = {{c1.r + d, c1.g + d, c1.b + d},
+                          {c1.r - d, c1.g - d, c1.b - d},
+                          {c2.r + d, c2.g + d, c2.b + d},
+                          {c2.r - d, c2.g - d, c2.b - d}};
+    write_paint_colors(block, paint, transparent, dst, pitch);
+}
+
+void decode_planar_mode(uint64_t block, uint8_t* dst, size_t pitch)
+{
+    Rgb o = {extend_6(bits(block, 62, 57)),
+             extend_7(bits(block, 56, 56) << 6 | bits(block, 54, 49)),
+             extend_6(bits(block, 48, 48) << 5 | bits(block, 44, 43) << 3 | bits(block, 41, 39))};
+    Rgb h = {extend_6(bits(block, 38, 34) << 1 | bits(block, 32, 32)),
+             extend_7(bits(block, 31, 25)),
+             extend_6(bits(block, 24, 19))};
+    Rgb v = {extend_6(bits(block, 18, 13)), extend_7(bits(block, 12, 6)), extend_6(bits(block, 5, 0))};
+
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            write_texel(dst,
+                        pitch,
+                        x,
+                        y,
+                        (x * (h.r - o.r) + y * (v.r - o.r) + 4 * o.r + 2) >> 2,
+                        (x * (h.g - o.g) + y * (v.g - o.g) + 4 * o.g + 2) >> 2,
+                        (x * (h.b - o.b) + y * (v.b - o.b) + 4 * o.b + 2) >> 2,
+                        0xff);
+        }
+    }
+}
+
+/// ETC1 individual and differential modes: two sub-blocks with a base colour and a modifier table each
+void decode_sub_blocks(uint64_t block, Rgb base[2], bool transparent, uint8_t* dst, size_t pitch)
+{
+    const int* modifiers[2] = {g_etc1_modifiers[bits(block, 39, 37)], g_etc1_modifiers[bits(block, 36, 34)]};
+    bool flip = bits(block, 32, 32) != 0;
+
+    for (int x = 0; x < 4; ++x) {
+        for (int y = 0; y < 4; ++y) {
+            int sub_block = flip ? y >> 1 : x >> 1;
+            int texel = x * 4 + y;
+            bool negative = (block >> (texel + 16)) & 1;
+            bool large = (block >> texel) & 1;
+
+            // without the opaque bit the small modifiers become 0 and transparency
+            int modifier;
+            if (transparent && !large) {
+                if (negative) {
+                    write_texel(dst, pitch, x, y, 0, 0, 0, 0);
+                    continue;
+                }
+                modifier = 0;
+            } else {
+                modifier = modifiers[sub_block][large ? 1 : 0];
+                if (negative)
+                    modifier = -modifier;
+            }
+
+            const Rgb& c = base[sub_block];
+            write_texel(dst, pitch, x, y, c.r + modifier, c.g + modifier, c.b + modifier, 0xff);
+        }
+    }
+}
+
+void decode_etc_color_block(const uint8_t* src, EtcMode mode, uint8_t* dst, size_t pitch)
+{
+    uint64_t block = read_u64_be(src);
+    bool differential = bits(block, 33, 33) != 0;
+    bool transparent = false;
+    if (mode == EtcMode::ETC2_PUNCHTHROUGH) {
+        transparent = !differential;
+        differential = true;
+    }
+
+    Rgb base[2];
+    if (!differential) {
+        base[0] = {extend_4(bits(block, 63, 60)), extend_4(bits(block, 55, 52)), extend_4(bits(block, 47, 44))};
+        base[1] = {extend_4(bits(block, 59, 56)), extend_4(bits(block, 51, 48)), extend_4(bits(block, 43, 40))};
+        decode_sub_blocks(block, base, false, dst, pitch);
+        return;
+    }
+
+    int r = int(bits(block, 63, 59)), g = int(bits(block, 55, 51)), b = int(bits(block, 47, 43));
+    // 3 bit two's complement deltas
+    int dr = int(bits(block, 58, 56) ^ 4) - 4, dg = int(bits(block, 50, 48) ^ 4) - 4,
+        db = int(bits(block, 42, 40) ^ 4) - 4;
+
+    // an overflowing second colour selects one of the ETC2 modes
+    if (mode != EtcMode::ETC1) {
+        if (r + dr < 0 || r + dr > 31) {
+            decode_t_mode(block, transparent, dst, pitch);
+            return;
+        }
+        if (g + dg < 0 || g + dg > 31) {
+            decode_h_mode(block, transparent, dst, pitch);
+            return;
+        }
+        if (b + db < 0 || b + db > 31) {
+            decode_planar_mode(block, dst, pitch);
+            return;
+        }
+    }
+
+    base[0] = {extend_5(uint32_t(r)), extend_5(uint32_t(g)), extend_5(uint32_t(b))};
+    base[1] = {extend_5(uint32_t(r + dr) & 31), extend_5(uint32_t(g + dg) & 31), extend_5(uint32_t(b + db) & 31)};
+    decode_sub_blocks(block, base, transparent, dst, pitch);
+}
+
+/// EAC alpha, 3 bit indices stored column by column from the most significant bit
+void decode_eac_alpha(const uint8_t* src, uint8_t* dst, size_t pitch)
+{
+    uint64_t block = read_u64_be(src);
+    int base = src[0];
+    int multiplier = src[1] >> 4;
+    const int* modifiers = g_eac_modifiers[src[1] & 0xf];
+
+    for (int x = 0; x < 4; ++x) {
+        for (int y = 0; y < 4; ++y) {
+            int index = int((block >> (45 - 3 * (x * 4 + y))) & 7);
+            dst[y * pitch + x * 4 + 3] = clamp_byte(base + modifiers[index] * multiplier);
+        }
+    }
+}
+
+template <EtcMode Mode>
+void decode_etc_rgb(const uint8_t* src, size_t count, uint8_t* dst, size_t dst_pitch)
+{
+    for (size_t i = 0; i < count; ++i, src += 8, dst += 16)
+        decode_etc_color_block(src, Mode, dst, dst_pitch);
+}
+
+void decode_etc2_rgba(const uint8_t* src, size_t count, uint8_t* dst, size_t dst_pitch)
+{
+    for (size_t i = 0; i < count; ++i, src += 16, dst += 16) {
+        decode_etc_color_block(src + 8, EtcMode::ETC2, dst, dst_pitch);
+        decode_eac_alpha(src, dst, dst_pitch);
+    }
+}
+
+} // namespace
+
+BlockRowDecoder get_etc_decoder(PixelFormat format)
+{
+    switch (format) {
+        case PixelFormat::ETC1_RGB8:
+            return &decode_etc_rgb<EtcMode::ETC1>;
+        case PixelFormat::ETC2_RGB8:
+            return &decode_etc_rgb<EtcMode::ETC2>;
+        case PixelFormat::ETC2_RGB8A1:
+            return &decode_etc_rgb<EtcMode::ETC2_PUNCHTHROUGH>;
+        case PixelFormat::ETC2_RGBA8:
+            return &decode_etc2_rgba;
+        default:
+            return nullptr;
+    }
+}
+
+} // namespace hyue
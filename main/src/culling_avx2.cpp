@@ -0,0 +1,82 @@
+#include "culling_simd.h"
+
+// built with AVX2 code generation enabled, see main/CMakeLists.txt
+#if HYUE_SIMD_AVX2
+
+#include <immintrin.h>
+
+#include <cmath>
+
+namespace hyue {
+
+namespace {
+
+/// A plane broadcast to every lane
+struct PlaneAvx2 {
+    __m256 n[3];
+    __m256 abs_n[3];
+    __m256 d;
+};
+
+} // namespace
+
+void avx2_cull(const CullingBatch& batch, size_t begin, size_t end, std::vector<uint32_t>* visible)
+{
+    std::vector<PlaneAvx2> planes(batch.frustum_count * 6);
+    for (size_t f = 0; f < batch.frustum_count; ++f) {
+        for (int p = 0; p < 6; ++p) {
+            const Plane& plane = batch.frustums[f].planes[p];
+            PlaneAvx2& out = planes[f * 6 + p];
+            for (int k = 0; k < 3; ++k) {
+                out.n[k] = _mm256_set1_ps(plane.normal.a[k]);
+                out.abs_n[k] = _mm256_set1_ps(std::abs(plane.normal.a[k]));
+            }
+            out.d = _mm256_set1_ps(plane.d);
+        }
+    }
+
+    const __m256i mask = _mm256_set1_epi32(int(batch.visibility_mask));
+    const __m256i zero = _mm256_setzero_si256();
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        // lanes whose flags match the mask
+        __m256i flags = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(batch.flags + i));
+        __m256 selected = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(flags, mask), zero));
+        int selected_bits = ~_mm256_movemask_ps(selected) & 0xFF;
+        if (!selected_bits)
+            continue;
+
+        __m256 cx = _mm256_loadu_ps(batch.center[0] + i);
+        __m256 cy = _mm256_loadu_ps(batch.center[1] + i);
+        __m256 cz = _mm256_loadu_ps(batch.center[2] + i);
+        __m256 hx = _mm256_loadu_ps(batch.half_size[0] + i);
+        __m256 hy = _mm256_loadu_ps(batch.half_size[1] + i);
+        __m256 hz = _mm256_loadu_ps(batch.half_size[2] + i);
+
+        for (size_t f = 0; f < batch.frustum_count; ++f) {
+            int bits = selected_bits;
+            for (int p = 0; p < 6 && bits; ++p) {
+                const PlaneAvx2& plane = planes[f * 6 + p];
+                // outside if distance < -max_abs_distance, see Frustum::is_visible
+                __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane.n[0], cx), _mm256_mul_ps(plane.n[1], cy)),
+                               _mm256_mul_ps(plane.n[2], cz)),
+                    plane.d);
+                __m256 max_abs_distance =
+                    _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane.abs_n[0], hx), _mm256_mul_ps(plane.abs_n[1], hy)),
+                               _mm256_mul_ps(plane.abs_n[2], hz));
+                __m256 outside = _mm256_cmp_ps(distance, _mm256_sub_ps(_mm256_setzero_ps(), max_abs_distance), _CMP_LT_OQ);
+                bits &= ~_mm256_movemask_ps(outside);
+            }
+            for (; bits; bits &= bits - 1)
+                visible[f].push_back(uint32_t(i + __builtin_ctz(unsigned(bits))));
+        }
+    }
+
+    cull_scalar(batch, i, end, visible);
+}
+
+} // namespace hyue
+
+#endif
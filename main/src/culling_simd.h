@@ -0,0 +1,28 @@
+#pragma once
+
+#include <hyue/Frustum.h>
+
+#include "simd_intrinsics.h"
+
+namespace hyue {
+
+/// The arrays of a CullingStage and the frustums a cull tests them against
+struct CullingBatch {
+    const float* center[3];
+    const float* half_size[3];
+    const uint32_t* flags;
+    uint32_t visibility_mask;
+    const Frustum* frustums;
+    size_t frustum_count;
+};
+
+/** Appends the objects of [begin, end) inside each frustum to visible[frustum],
+    in increasing order.
+*/
+using CullKernel = void (*)(const CullingBatch& batch, size_t begin, size_t end, std::vector<uint32_t>* visible);
+
+void cull_scalar(const CullingBatch& batch, size_t begin, size_t end, std::vector<uint32_t>* visible);
+void sse2_cull(const CullingBatch& batch, size_t begin, size_t end, std::vector<uint32_t>* visible);
+void avx2_cull(const CullingBatch& batch, size_t begin, size_t end, std::vector<uint32_t>* visible);
+
+} // namespace hyue
@@ -0,0 +1,79 @@
+#include "culling_simd.h"
+
+#if HYUE_SIMD_SSE2
+
+#include <cmath>
+
+namespace hyue {
+
+namespace {
+
+/// A plane broadcast to every lane
+struct PlaneSse2 {
+    __m128 n[3];
+    __m128 abs_n[3];
+    __m128 d;
+};
+
+} // namespace
+
+void sse2_cull(const CullingBatch& batch, size_t begin, size_t end, std::vector<uint32_t>* visible)
+{
+    std::vector<PlaneSse2> planes(batch.frustum_count * 6);
+    for (size_t f = 0; f < batch.frustum_count; ++f) {
+        for (int p = 0; p < 6; ++p) {
+            const Plane& plane = batch.frustums[f].planes[p];
+            PlaneSse2& out = planes[f * 6 + p];
+            for (int k = 0; k < 3; ++k) {
+                out.n[k] = _mm_set1_ps(plane.normal.a[k]);
+                out.abs_n[k] = _mm_set1_ps(std::abs(plane.normal.a[k]));
+            }
+            out.d = _mm_set1_ps(plane.d);
+        }
+    }
+
+    const __m128i mask = _mm_set1_epi32(int(batch.visibility_mask));
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        // lanes whose flags match the mask
+        __m128i flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(batch.flags + i));
+        __m128 selected = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, mask), zero));
+        int selected_bits = ~_mm_movemask_ps(selected) & 0xF;
+        if (!selected_bits)
+            continue;
+
+        __m128 cx = _mm_loadu_ps(batch.center[0] + i);
+        __m128 cy = _mm_loadu_ps(batch.center[1] + i);
+        __m128 cz = _mm_loadu_ps(batch.center[2] + i);
+        __m128 hx = _mm_loadu_ps(batch.half_size[0] + i);
+        __m128 hy = _mm_loadu_ps(batch.half_size[1] + i);
+        __m128 hz = _mm_loadu_ps(batch.half_size[2] + i);
+
+        for (size_t f = 0; f < batch.frustum_count; ++f) {
+            int bits = selected_bits;
+            for (int p = 0; p < 6 && bits; ++p) {
+                const PlaneSse2& plane = planes[f * 6 + p];
+                // outside if distance < -max_abs_distance, see Frustum::is_visible
+                __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane.n[0], cx), _mm_mul_ps(plane.n[1], cy)),
+                               _mm_mul_ps(plane.n[2], cz)),
+                    plane.d);
+                __m128 max_abs_distance =
+                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane.abs_n[0], hx), _mm_mul_ps(plane.abs_n[1], hy)),
+                               _mm_mul_ps(plane.abs_n[2], hz));
+                __m128 outside = _mm_cmplt_ps(distance, _mm_sub_ps(_mm_setzero_ps(), max_abs_distance));
+                bits &= ~_mm_movemask_ps(outside);
+            }
+            for (; bits; bits &= bits - 1)
+                visible[f].push_back(uint32_t(i + __builtin_ctz(unsigned(bits))));
+        }
+    }
+
+    cull_scalar(batch, i, end, visible);
+}
+
+} // namespace hyue
+
+#endif
@@ -6,4 +6,7 @@ namespace hyue {
 
 void init_logging(const String &log_file);
 
+/// Write out queued messages and remove the sink of init_logging
+void shutdown_logging();
+
 }
\ No newline at end of file
@@ -1,22 +1,32 @@
+#include <cstdlib>
+#include <mutex>
 #include <stdexcept>
 
+#include <boost/make_shared.hpp>
 #include <boost/log/core.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/log/expressions.hpp>
 #include <boost/log/sinks/text_file_backend.hpp>
+#include <boost/filesystem/path.hpp>
 #include <boost/log/utility/setup/common_attributes.hpp>
-#include <boost/log/utility/setup/file.hpp>
-#include <boost/log/utility/setup/console.hpp>
 
 #include <hyue/log.h>
 #include <hyue/panic.h>
 
+#include "AsyncLogSink.h"
 #include "init_logging.h"
 
 namespace hyue {
 
 namespace log = boost::log;
 
+namespace detail {
+std::atomic<int> g_log_level(int(LogLevel::trace));
+} // namespace detail
+
+/// The sink installed by init_logging
+static boost::shared_ptr<AsyncLogSink> g_sink;
+
 void init_logging(const String &log_file) {
     // 添加全局属性 AppName
     log::core::get()->add_global_attribute(
@@ -25,39 +35,66 @@ void init_logging(const String &log_file) {
     );
     
     // 设置前缀格式
-    log::add_console_log(
-        std::clog,
-        log::keywords::format = (
-            log::expressions::stream 
-                << "[" 
-                << log::expressions::attr<std::string>("AppName") 
-                << "] ["
-                << log::trivial::severity
-                << "] "
-                << log::expressions::smessage
-        )
+    log::formatter formatter = (
+        log::expressions::stream 
+            << "[" 
+            << log::expressions::attr<std::string>("AppName") 
+            << "] ["
+            << log::trivial::severity
+            << "] "
+            << log::expressions::smessage
     );
 
-    log::add_file_log(
+    boost::filesystem::path path(log_file);
+    auto file = boost::make_shared<log::sinks::text_file_backend>(
         log::keywords::file_name = log_file,
+        // 轮转后的日志文件名, 例如 hyue_20240101_000000_0.log
+        log::keywords::target_file_name = path.stem().string() + "_%Y%m%d_%H%M%S_%N" + path.extension().string(),
         log::keywords::rotation_size = 10 * 1024 * 1024, // 日志文件大小达到10MB时轮转
-        log::keywords::max_size = 50 * 1024 * 1024,     // 最大保留50MB日志
         log::keywords::time_based_rotation = log::sinks::file::rotation_at_time_point(0, 0, 0), // 每天午夜轮转
-        log::keywords::format = (
-            log::expressions::stream 
-                << "[" 
-                << log::expressions::attr<std::string>("AppName") 
-                << "] ["
-                << log::trivial::severity
-                << "] "
-                << log::expressions::smessage
-        ),
-        log::keywords::auto_flush = true
+        log::keywords::enable_final_rotation = false // 退出时保留当前日志文件名
     );
+    // 轮转后的日志保留在同一目录, 最大保留50MB日志
+    file->set_file_collector(log::sinks::file::make_collector(
+        log::keywords::target = path.has_parent_path() ? path.parent_path() : boost::filesystem::path("."),
+        log::keywords::max_size = 50 * 1024 * 1024
+    ));
+    file->scan_for_files();
+
+    // console and file are written in batches by a background thread
+    shutdown_logging();
+    g_sink = boost::make_shared<AsyncLogSink>(boost::make_shared<AsyncLogBackend>(formatter, file, &std::clog));
+    log::core::get()->add_sink(g_sink);
+
+    // without a Root destroyed before exit, write out the queue while the
+    // rings of AsyncLogSink.cpp are still alive: handlers registered after
+    // those statics were constructed run before they are destroyed
+    static std::once_flag s_shutdown_at_exit;
+    std::call_once(s_shutdown_at_exit, []() { std::atexit(shutdown_logging); });
 
     log::add_common_attributes();
 }
 
+void shutdown_logging() {
+    if (!g_sink)
+        return;
+    log::core::get()->remove_sink(g_sink);
+    g_sink->flush();
+    g_sink.reset();
+}
+
+void set_log_level(LogLevel level) {
+    detail::g_log_level = int(level);
+}
+
+LogLevel get_log_level() {
+    return LogLevel(detail::g_log_level.load());
+}
+
+void flush_log() {
+    log::core::get()->flush();
+}
+
 void panic(const std::string &panic_msg) {
     LOG(fatal) << panic_msg;
     throw std::runtime_error(panic_msg);
@@ -0,0 +1,184 @@
+#include "lz4_block.h"
+
+#include <algorithm>
+
+#include <string.h>
+
+namespace hyue {
+
+namespace {
+
+const size_t MIN_MATCH = 4;
+/// The last 5 bytes of a block are always literals
+const size_t LAST_LITERALS = 5;
+/// The last match starts at least 12 bytes before the end of the block
+const size_t MF_LIMIT = 12;
+const size_t MAX_DISTANCE = 65535;
+const int HASH_LOG = 12;
+
+inline uint32_t read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint32_t hash4(const uint8_t* p)
+{
+    return (read32(p) * 2654435761u) >> (32 - HASH_LOG);
+}
+
+/// Length bytes following a token nibble of 15
+inline uint8_t* write_length(uint8_t* op, size_t length)
+{
+    for (; length >= 255; length -= 255)
+        *op++ = 255;
+    *op++ = uint8_t(length);
+    return op;
+}
+
+/// Worst case size of a sequence
+inline size_t sequence_bound(size_t literals, size_t match)
+{
+    return 1 + literals / 255 + 1 + literals + 2 + match / 255 + 1;
+}
+
+} // namespace
+
+size_t lz4_compress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_capacity)
+{
+    if (src_size > LZ4_MAX_INPUT_SIZE)
+        return 0;
+
+    const uint8_t* anchor = src;
+    const uint8_t* iend = src + src_size;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + dst_capacity;
+
+    if (src_size > MF_LIMIT) {
+        // offsets of the last position seen with each hash; stale or colliding
+        // entries are harmless since candidates are always compared
+        std::vector<uint32_t> table(size_t(1) << HASH_LOG, 0);
+        const uint8_t* mflimit = iend - MF_LIMIT;
+        const uint8_t* matchlimit = iend - LAST_LITERALS;
+
+        const uint8_t* ip = src + 1;
+        while (ip < mflimit) {
+            uint32_t h = hash4(ip);
+            const uint8_t* ref = src + table[h];
+            table[h] = uint32_t(ip - src);
+            if (size_t(ip - ref) > MAX_DISTANCE || read32(ref) != read32(ip)) {
+                ++ip;
+                continue;
+            }
+
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                --ip;
+                --ref;
+            }
+            const uint8_t* end = ip + MIN_MATCH;
+            for (const uint8_t* r = ref + MIN_MATCH; end < matchlimit && *end == *r; ++r)
+                ++end;
+
+            size_t literals = size_t(ip - anchor);
+            size_t match = size_t(end - ip) - MIN_MATCH;
+            if (size_t(oend - op) < sequence_bound(literals, match))
+                return 0;
+
+            uint8_t* token = op++;
+            *token = uint8_t(std::min<size_t>(literals, 15) << 4 | std::min<size_t>(match, 15));
+            if (literals >= 15)
+                op = write_length(op, literals - 15);
+            memcpy(op, anchor, literals);
+            op += literals;
+            size_t offset = size_t(ip - ref);
+            *op++ = uint8_t(offset);
+            *op++ = uint8_t(offset >> 8);
+            if (match >= 15)
+                op = write_length(op, match - 15);
+
+            anchor = ip = end;
+            // the position just before the next one is a likely match source
+            if (ip < mflimit)
+                table[hash4(ip - 2)] = uint32_t(ip - 2 - src);
+        }
+    }
+
+    size_t literals = size_t(iend - anchor);
+    if (size_t(oend - op) < 1 + literals / 255 + 1 + literals)
+        return 0;
+    *op++ = uint8_t(std::min<size_t>(literals, 15) << 4);
+    if (literals >= 15)
+        op = write_length(op, literals - 15);
+    if (literals != 0)
+        memcpy(op, anchor, literals);
+    op += literals;
+    return size_t(op - dst);
+}
+
+bool lz4_decompress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size)
+{
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + src_size;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + dst_size;
+
+    auto read_length = [&](size_t& length) {
+        uint8_t b;
+        do {
+            if (ip == iend)
+                return false;
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+        return true;
+    };
+
+    if (src_size == 0)
+        return false;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        size_t literals = token >> 4;
+        if (literals == 15 && !read_length(literals))
+            return false;
+        if (size_t(iend - ip) < literals || size_t(oend - op) < literals)
+            return false;
+        if (literals != 0)
+            memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        // the last sequence has no match
+        if (ip == iend)
+            break;
+
+        if (iend - ip < 2)
+            return false;
+        size_t offset = size_t(ip[0]) | size_t(ip[1]) << 8;
+        ip += 2;
+        if (offset == 0 || offset > size_t(op - dst))
+            return false;
+
+        size_t match = token & 15;
+        if (match == 15 && !read_length(match))
+            return false;
+        match += MIN_MATCH;
+        if (size_t(oend - op) < match)
+            return false;
+
+        const uint8_t* ref = op - offset;
+        if (offset >= match) {
+            memcpy(op, ref, match);
+        } else {
+            // overlapping copy, repeats the last offset bytes
+            for (size_t i = 0; i < match; ++i)
+                op[i] = ref[i];
+        }
+        op += match;
+    }
+    return op == oend;
+}
+
+} // namespace hyue
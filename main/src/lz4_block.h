@@ -0,0 +1,34 @@
+#pragma once
+
+#include <hyue/type.h>
+
+namespace hyue {
+
+/// Largest input the LZ4 block format can describe
+const size_t LZ4_MAX_INPUT_SIZE = 0x7E000000;
+
+/// Size of a buffer large enough for the compressed form of size bytes
+inline size_t lz4_compress_bound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+/** Compress a block to the LZ4 block format (no frame header or checksums).
+
+    Greedy single pass compressor with a 4096 entry hash table, comparable to
+    the reference LZ4_compress_default; the output is readable by any LZ4
+    block decompressor.
+@return The compressed size, 0 if it does not fit in dst_capacity or
+    src_size is larger than LZ4_MAX_INPUT_SIZE
+*/
+size_t lz4_compress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_capacity);
+
+/** Decompress an LZ4 block of known uncompressed size.
+
+    All reads and writes are bounds checked, so corrupt or hostile input can
+    not overrun either buffer.
+@return false if src is not a valid block that decompresses to exactly dst_size bytes
+*/
+bool lz4_decompress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size);
+
+} // namespace hyue
@@ -0,0 +1,386 @@
+#include "pixel_conversion_simd.h"
+
+// built with AVX2 code generation enabled, see main/CMakeLists.txt
+#if HYUE_SIMD_AVX2
+
+#include <immintrin.h>
+
+#include <array>
+
+namespace hyue {
+
+using namespace pixel_simd;
+
+/** pshufb control for a swizzle: every 4 destination bytes take source bytes
+    relative to the pixel start, which advances by SRC_SIZE per pixel.
+*/
+template <uint32_t SWIZZLE, int SRC_SIZE>
+struct SwizzleControl {
+    static constexpr std::array<int8_t, 32> make()
+    {
+        std::array<int8_t, 32> ret{};
+        for (int k = 0; k < 32; ++k) {
+            int pixel = (k % 16) / 4;
+            uint32_t i = (SWIZZLE >> (8 * (k % 4))) & 0xFF;
+            ret[k] = int8_t(i == SWIZZLE_ONE ? 0x80 : pixel * SRC_SIZE + int(i));
+        }
+        return ret;
+    }
+
+    static constexpr std::array<int8_t, 32> bytes = make();
+
+    static __m256i load()
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes.data()));
+    }
+};
+
+template <uint32_t SWIZZLE>
+static void convert_32_to_32(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    const __m256i control = SwizzleControl<SWIZZLE, 4>::load();
+    const __m256i alpha = _mm256_set1_epi32(int(swizzle_alpha_mask(SWIZZLE)));
+
+    size_t x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+        v = _mm256_or_si256(_mm256_shuffle_epi8(v, control), alpha);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), v);
+    }
+    swizzle_pixels(src + x * 4, dst + x * 4, count - x, 4, SWIZZLE);
+}
+
+template <uint32_t SWIZZLE>
+static void convert_24_to_32(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    const __m256i control = SwizzleControl<SWIZZLE, 3>::load();
+    const __m256i alpha = _mm256_set1_epi32(int(swizzle_alpha_mask(SWIZZLE)));
+
+    size_t x = 0;
+    // 4 pixels per 128 bit lane; the upper lane load ends 4 bytes past the 8 pixels
+    for (; x + 10 <= count; x += 8) {
+        const uint8_t* p = src + x * 3;
+        __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12)),
+            1);
+        v = _mm256_or_si256(_mm256_shuffle_epi8(v, control), alpha);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), v);
+    }
+    swizzle_pixels(src + x * 3, dst + x * 4, count - x, 3, SWIZZLE);
+}
+
+template <uint32_t SWIZZLE>
+static void convert_8_to_32(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    const __m256i alpha = _mm256_set1_epi32(int(swizzle_alpha_mask(SWIZZLE)));
+    // pixel k of the lane takes byte k, lane 1 continues at byte 4
+    const __m256i control_lo = _mm256_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                                4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7);
+    const __m256i control_hi = _mm256_add_epi8(control_lo, _mm256_set1_epi8(8));
+
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m256i v = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x)));
+        __m256i* out = reinterpret_cast<__m256i*>(dst + x * 4);
+        _mm256_storeu_si256(out + 0, _mm256_or_si256(_mm256_shuffle_epi8(v, control_lo), alpha));
+        _mm256_storeu_si256(out + 1, _mm256_or_si256(_mm256_shuffle_epi8(v, control_hi), alpha));
+    }
+    swizzle_pixels(src + x, dst + x * 4, count - x, 1, SWIZZLE);
+}
+
+/// Same steps as Bitwise::half_to_float_u16 on 8 values, denormals flush to (signed) zero
+static inline __m256i half_to_float_epi32(__m256i h)
+{
+    __m256i em = _mm256_and_si256(h, _mm256_set1_epi32(0x7fff));
+    __m256i s = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(0x8000)), 16);
+
+    __m256i r = _mm256_slli_epi32(_mm256_add_epi32(em, _mm256_set1_epi32(112 << 10)), 13);
+    r = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(1 << 10), em), r);
+
+    __m256i inf_nan = _mm256_cmpgt_epi32(em, _mm256_set1_epi32((31 << 10) - 1));
+    r = _mm256_add_epi32(r, _mm256_and_si256(inf_nan, _mm256_set1_epi32(112 << 23)));
+
+    return _mm256_or_si256(s, r);
+}
+
+template <int CHANNELS>
+static void convert_half_to_float(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    count *= CHANNELS;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i h = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), half_to_float_epi32(h));
+    }
+    half_to_float(src + i * 2, dst + i * 4, count - i);
+}
+
+/// Clamp 8 colours to [0, 1] and convert to bytes like Bitwise::float_to_fixed(v, 8), bytes in r, g, b, a order
+static inline __m256i pack_unorm8(const float* src)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_set1_ps(256.0f);
+
+    __m256i c[4];
+    for (int i = 0; i < 4; ++i) {
+        // max first so NaN becomes 0
+        __m256 v = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i * 8), zero), one);
+        c[i] = _mm256_cvttps_epi32(_mm256_mul_ps(v, scale));
+    }
+    // 1.0 truncates to 256, which saturates to 255
+    const __m256i max = _mm256_set1_epi16(255);
+    __m256i lo = _mm256_min_epi16(_mm256_packs_epi32(c[0], c[1]), max);
+    __m256i hi = _mm256_min_epi16(_mm256_packs_epi32(c[2], c[3]), max);
+    // the packs work per 128 bit lane, which leaves colours 0 2 4 6 1 3 5 7
+    __m256i v = _mm256_packus_epi16(lo, hi);
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+/// 8 bytes of r, g, b, a to 2 colours like Bitwise::fixed_to_float(v, 8)
+static inline void unpack_unorm8(__m128i bytes, float* dst)
+{
+    __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+    _mm256_storeu_ps(dst, _mm256_div_ps(v, _mm256_set1_ps(255.0f)));
+}
+
+template <int R, int G, int B, int A>
+static void pack_colors(const Color* src, uint8_t* dst, size_t count)
+{
+    constexpr ByteLayout layout = {4, R, G, B, A};
+    const __m256i control = SwizzleControl<make_swizzle(LAYOUT_A8B8G8R8, full_layout(layout)), 4>::load();
+    const __m256i keep = _mm256_set1_epi32(int(layout_keep_mask(layout)));
+
+    size_t x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m256i v = _mm256_shuffle_epi8(pack_unorm8(src[x].get_ptr()), control);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), _mm256_and_si256(v, keep));
+    }
+    pack_color_bytes(src + x, dst + x * 4, count - x, layout);
+}
+
+template <int R, int G, int B, int A>
+static void unpack_colors(const uint8_t* src, Color* dst, size_t count)
+{
+    constexpr ByteLayout layout = {4, R, G, B, A};
+    constexpr uint32_t swizzle = make_swizzle(layout, LAYOUT_A8B8G8R8);
+    const __m256i control = SwizzleControl<swizzle, 4>::load();
+    const __m256i alpha = _mm256_set1_epi32(int(swizzle_alpha_mask(swizzle)));
+
+    size_t x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+        v = _mm256_or_si256(_mm256_shuffle_epi8(v, control), alpha);
+        __m128i lo = _mm256_castsi256_si128(v);
+        __m128i hi = _mm256_extracti128_si256(v, 1);
+        float* out = dst[x].get_ptr();
+        unpack_unorm8(lo, out + 0);
+        unpack_unorm8(_mm_srli_si128(lo, 8), out + 8);
+        unpack_unorm8(hi, out + 16);
+        unpack_unorm8(_mm_srli_si128(hi, 8), out + 24);
+    }
+    unpack_color_bytes(src + x * 4, dst + x, count - x, layout);
+}
+
+ColorPacker get_avx2_color_packer(PixelFormat format)
+{
+    switch (format) {
+        HYUE_SIMD_COLOR_FORMATS(HYUE_SIMD_COLOR_PACKER_CASE)
+        default:
+            return nullptr;
+    }
+}
+
+ColorUnpacker get_avx2_color_unpacker(PixelFormat format)
+{
+    switch (format) {
+        HYUE_SIMD_COLOR_FORMATS(HYUE_SIMD_COLOR_UNPACKER_CASE)
+        default:
+            return nullptr;
+    }
+}
+
+/// Same steps as Bitwise::float_to_half on 8 values, in the low 16 bits of each lane
+static inline __m256i float_to_half_epi32(__m256 f)
+{
+    __m256i ui = _mm256_castps_si256(f);
+    __m256i s = _mm256_and_si256(_mm256_srli_epi32(ui, 16), _mm256_set1_epi32(0x8000));
+    __m256i em = _mm256_and_si256(ui, _mm256_set1_epi32(0x7fffffff));
+
+    // bias exponent and round to nearest; 112 is relative exponent bias (127-15)
+    __m256i h = _mm256_srai_epi32(_mm256_add_epi32(em, _mm256_set1_epi32(int(-(112 << 23) + (1 << 12)))), 13);
+    // underflow: flush to zero; 113 encodes exponent -14
+    h = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(113 << 23), em), h);
+
+    // overflow: infinity; 143 encodes exponent 16
+    __m256i inf = _mm256_cmpgt_epi32(em, _mm256_set1_epi32((143 << 23) - 1));
+    h = _mm256_blendv_epi8(h, _mm256_set1_epi32(0x7c00), inf);
+
+    // NaN; note that we convert all types of NaN to qNaN
+    __m256i nan = _mm256_cmpgt_epi32(em, _mm256_set1_epi32(255 << 23));
+    h = _mm256_or_si256(h, _mm256_and_si256(nan, _mm256_set1_epi32(0x0200)));
+
+    return _mm256_or_si256(s, h);
+}
+
+void avx2_float_to_half(const float* src, uint16_t* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        // sign extend the low 16 bits so the signed saturation of packs keeps them
+        __m256i lo = _mm256_srai_epi32(_mm256_slli_epi32(float_to_half_epi32(_mm256_loadu_ps(src + i)), 16), 16);
+        __m256i hi = _mm256_srai_epi32(_mm256_slli_epi32(float_to_half_epi32(_mm256_loadu_ps(src + i + 8)), 16), 16);
+        // the pack works per 128 bit lane, put the 64 bit quarters back in order
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+    }
+    float_to_half(src + i, dst + i, count - i);
+}
+
+/// log2 of 8 positive normal floats (Cephes logf polynomial), absolute error about 1e-7
+static inline __m256 log2_ps(__m256 x)
+{
+    __m256i bits = _mm256_castps_si256(x);
+    __m256i e = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+    __m256 m = _mm256_castsi256_ps(
+        _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+
+    // m in [1, 2), halve the upper part to centre it on 1
+    __m256 upper = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+    m = _mm256_sub_ps(m, _mm256_and_ps(upper, _mm256_mul_ps(m, _mm256_set1_ps(0.5f))));
+    e = _mm256_sub_epi32(e, _mm256_castps_si256(upper));
+
+    __m256 t = _mm256_sub_ps(m, _mm256_set1_ps(1.0f));
+    __m256 z = _mm256_mul_ps(t, t);
+    __m256 p = _mm256_set1_ps(7.0376836292E-2f);
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(-1.1514610310E-1f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(1.1676998740E-1f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(-1.2420140846E-1f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(1.4249322787E-1f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(-1.6668057665E-1f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(2.0000714765E-1f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(-2.4999993993E-1f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(3.3333331174E-1f));
+    // ln(m) = t - z / 2 + t z p
+    __m256 ln = _mm256_add_ps(
+        _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(t, z), p), _mm256_mul_ps(z, _mm256_set1_ps(0.5f))), t);
+
+    return _mm256_add_ps(_mm256_cvtepi32_ps(e), _mm256_mul_ps(ln, _mm256_set1_ps(1.44269504f)));
+}
+
+/// 2^x of 8 floats (Cephes exp2f polynomial), x is clamped to the normal range
+static inline __m256 exp2_ps(__m256 x)
+{
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-126.0f)), _mm256_set1_ps(127.99f));
+    // round to nearest, leaving a fraction in [-0.5, 0.5]
+    __m256i i = _mm256_cvtps_epi32(x);
+    __m256 f = _mm256_sub_ps(x, _mm256_cvtepi32_ps(i));
+
+    __m256 p = _mm256_set1_ps(1.535336188319500E-4f);
+    p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.339887440266574E-3f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(9.618437357674640E-3f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(5.550332471162809E-2f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(2.402264791363012E-1f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(6.931472028550421E-1f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(1.0f));
+
+    return _mm256_castsi256_ps(_mm256_add_epi32(_mm256_castps_si256(p), _mm256_slli_epi32(i, 23)));
+}
+
+/// v, with the inf and NaN values of c passed through, see the SSE2 version
+static inline __m256 keep_non_finite_ps(__m256 c, __m256 v)
+{
+    __m256i abs = _mm256_and_si256(_mm256_castps_si256(c), _mm256_set1_epi32(0x7fffffff));
+    return _mm256_blendv_ps(v, c, _mm256_castsi256_ps(_mm256_cmpgt_epi32(abs, _mm256_set1_epi32(0x7f7fffff))));
+}
+
+/// sRGB to linear of 8 channel values
+static inline __m256 srgb_to_linear_ps(__m256 c)
+{
+    __m256 lin = _mm256_mul_ps(c, _mm256_set1_ps(1.0f / 12.92f));
+    __m256 base = _mm256_mul_ps(_mm256_add_ps(c, _mm256_set1_ps(0.055f)), _mm256_set1_ps(1.0f / 1.055f));
+    __m256 curve = exp2_ps(_mm256_mul_ps(log2_ps(base), _mm256_set1_ps(2.4f)));
+    return keep_non_finite_ps(c, _mm256_blendv_ps(curve, lin, _mm256_cmp_ps(c, _mm256_set1_ps(0.04045f), _CMP_LE_OQ)));
+}
+
+/// Linear to sRGB of 8 channel values
+static inline __m256 linear_to_srgb_ps(__m256 c)
+{
+    __m256 lin = _mm256_mul_ps(c, _mm256_set1_ps(12.92f));
+    __m256 curve = exp2_ps(_mm256_mul_ps(log2_ps(c), _mm256_set1_ps(1.0f / 2.4f)));
+    curve = _mm256_sub_ps(_mm256_mul_ps(curve, _mm256_set1_ps(1.055f)), _mm256_set1_ps(0.055f));
+    return keep_non_finite_ps(c, _mm256_blendv_ps(curve, lin, _mm256_cmp_ps(c, _mm256_set1_ps(0.0031308f), _CMP_LE_OQ)));
+}
+
+/// _MM_TRANSPOSE4_PS within each 128 bit lane
+static inline void transpose4_ps(__m256& r0, __m256& r1, __m256& r2, __m256& r3)
+{
+    __m256 t0 = _mm256_shuffle_ps(r0, r1, 0x44);
+    __m256 t2 = _mm256_shuffle_ps(r0, r1, 0xEE);
+    __m256 t1 = _mm256_shuffle_ps(r2, r3, 0x44);
+    __m256 t3 = _mm256_shuffle_ps(r2, r3, 0xEE);
+    r0 = _mm256_shuffle_ps(t0, t1, 0x88);
+    r1 = _mm256_shuffle_ps(t0, t1, 0xDD);
+    r2 = _mm256_shuffle_ps(t2, t3, 0x88);
+    r3 = _mm256_shuffle_ps(t2, t3, 0xDD);
+}
+
+/// Applies a channel function to the r, g and b of colours, 8 colours are transposed so alpha is skipped
+template <__m256 (*FUNC)(__m256)>
+static inline void transform_rgb(const Color* src, Color* dst, size_t count)
+{
+    size_t x = 0;
+    for (; x + 8 <= count; x += 8) {
+        // colours 0 1, 2 3, 4 5 and 6 7; the lanes transpose to r0 r2 r4 r6 r1 r3 r5 r7 and back
+        const float* in = src[x].get_ptr();
+        __m256 r = _mm256_loadu_ps(in + 0);
+        __m256 g = _mm256_loadu_ps(in + 8);
+        __m256 b = _mm256_loadu_ps(in + 16);
+        __m256 a = _mm256_loadu_ps(in + 24);
+        transpose4_ps(r, g, b, a);
+        r = FUNC(r);
+        g = FUNC(g);
+        b = FUNC(b);
+        transpose4_ps(r, g, b, a);
+        float* out = dst[x].get_ptr();
+        _mm256_storeu_ps(out + 0, r);
+        _mm256_storeu_ps(out + 8, g);
+        _mm256_storeu_ps(out + 16, b);
+        _mm256_storeu_ps(out + 24, a);
+    }
+    // the remaining colours one or two at a time, keeping alpha
+    const __m256 alpha = _mm256_castsi256_ps(_mm256_setr_epi32(0, 0, 0, -1, 0, 0, 0, -1));
+    for (; x + 2 <= count; x += 2) {
+        __m256 c = _mm256_loadu_ps(src[x].get_ptr());
+        _mm256_storeu_ps(dst[x].get_ptr(), _mm256_blendv_ps(FUNC(c), c, alpha));
+    }
+    if (x < count) {
+        __m256 c = _mm256_castps128_ps256(_mm_loadu_ps(src[x].get_ptr()));
+        _mm_storeu_ps(dst[x].get_ptr(), _mm256_castps256_ps128(_mm256_blendv_ps(FUNC(c), c, alpha)));
+    }
+}
+
+void avx2_srgb_to_linear(const Color* src, Color* dst, size_t count)
+{
+    transform_rgb<srgb_to_linear_ps>(src, dst, count);
+}
+
+void avx2_linear_to_srgb(const Color* src, Color* dst, size_t count)
+{
+    transform_rgb<linear_to_srgb_ps>(src, dst, count);
+}
+
+PixelRowConverter get_avx2_row_converter(PixelFormat src_format, PixelFormat dst_format)
+{
+    switch (conversion_id(src_format, dst_format)) {
+        HYUE_SIMD_PIXEL_CONVERSIONS(HYUE_SIMD_PIXEL_CONVERSION_CASE)
+        default:
+            return nullptr;
+    }
+}
+
+} // namespace hyue
+
+#endif // HYUE_SIMD_AVX2
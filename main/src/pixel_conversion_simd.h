@@ -0,0 +1,241 @@
+#pragma once
+
+#include <hyue/PixelFormat.h>
+#include <hyue/Bitwise.h>
+
+#include "simd_intrinsics.h"
+
+namespace hyue {
+
+/// Converts count consecutive pixels of a row
+using PixelRowConverter = void (*)(const uint8_t* src, uint8_t* dst, size_t count);
+
+/// Vectorised converters for a format pair, or nullptr if the pair has none
+PixelRowConverter get_sse2_row_converter(PixelFormat src_format, PixelFormat dst_format);
+PixelRowConverter get_avx2_row_converter(PixelFormat src_format, PixelFormat dst_format);
+
+/// Packs count colours to consecutive pixels of one format
+using ColorPacker = void (*)(const Color* src, uint8_t* dst, size_t count);
+/// Unpacks count consecutive pixels of one format to colours
+using ColorUnpacker = void (*)(const uint8_t* src, Color* dst, size_t count);
+
+/// Vectorised colour packers and unpackers for a format, or nullptr if it has none
+ColorPacker get_sse2_color_packer(PixelFormat format);
+ColorUnpacker get_sse2_color_unpacker(PixelFormat format);
+ColorPacker get_avx2_color_packer(PixelFormat format);
+ColorUnpacker get_avx2_color_unpacker(PixelFormat format);
+
+/// Vectorised PixelUtil::float_to_half
+void sse2_float_to_half(const float* src, uint16_t* dst, size_t count);
+void avx2_float_to_half(const float* src, uint16_t* dst, size_t count);
+
+/// Vectorised PixelUtil::srgb_to_linear and PixelUtil::linear_to_srgb
+void sse2_srgb_to_linear(const Color* src, Color* dst, size_t count);
+void sse2_linear_to_srgb(const Color* src, Color* dst, size_t count);
+void avx2_srgb_to_linear(const Color* src, Color* dst, size_t count);
+void avx2_linear_to_srgb(const Color* src, Color* dst, size_t count);
+
+namespace pixel_simd {
+
+/// Key of a format pair in the converter switches
+constexpr uint32_t conversion_id(PixelFormat src, PixelFormat dst)
+{
+    return (uint32_t(src) << 16) | uint32_t(dst);
+}
+
+/// Byte offsets of the channels of an 8 bit per channel format in memory, -1 if absent
+struct ByteLayout {
+    int size;
+    int r, g, b, a;
+};
+
+// little endian only, see simd_intrinsics.h
+constexpr ByteLayout LAYOUT_A8R8G8B8 = {4, 2, 1, 0, 3};
+constexpr ByteLayout LAYOUT_X8R8G8B8 = {4, 2, 1, 0, -1};
+constexpr ByteLayout LAYOUT_A8B8G8R8 = {4, 0, 1, 2, 3};
+constexpr ByteLayout LAYOUT_X8B8G8R8 = {4, 0, 1, 2, -1};
+constexpr ByteLayout LAYOUT_B8G8R8A8 = {4, 1, 2, 3, 0};
+constexpr ByteLayout LAYOUT_R8G8B8A8 = {4, 3, 2, 1, 0};
+constexpr ByteLayout LAYOUT_R8G8B8 = {3, 2, 1, 0, -1};
+constexpr ByteLayout LAYOUT_B8G8R8 = {3, 0, 1, 2, -1};
+constexpr ByteLayout LAYOUT_L8 = {1, 0, 0, 0, -1};
+
+/// Marks a destination byte of a swizzle that is set to 0xFF (opaque alpha)
+constexpr uint32_t SWIZZLE_ONE = 0x80;
+
+/** Swizzle from src to a 4 byte dst layout: byte j holds the index of the
+    source byte that ends up in destination byte j, or SWIZZLE_ONE.
+*/
+constexpr uint32_t make_swizzle(ByteLayout src, ByteLayout dst)
+{
+    int dst_to_src[4] = {-1, -1, -1, -1};
+    dst_to_src[dst.r] = src.r;
+    dst_to_src[dst.g] = src.g;
+    dst_to_src[dst.b] = src.b;
+    dst_to_src[dst.a] = src.a;
+
+    uint32_t ret = 0;
+    for (int j = 0; j < 4; ++j)
+        ret |= uint32_t(dst_to_src[j] < 0 ? SWIZZLE_ONE : dst_to_src[j]) << (8 * j);
+    return ret;
+}
+
+/// Bytes of a 4 byte pixel a swizzle sets to 0xFF
+constexpr uint32_t swizzle_alpha_mask(uint32_t swizzle)
+{
+    uint32_t ret = 0;
+    for (int j = 0; j < 4; ++j)
+        ret |= ((swizzle >> (8 * j)) & SWIZZLE_ONE) ? 0xFFu << (8 * j) : 0;
+    return ret;
+}
+
+/// Scalar swizzle of count pixels of src_size bytes, for the tails of the vector loops
+inline void swizzle_pixels(const uint8_t* src, uint8_t* dst, size_t count, int src_size, uint32_t swizzle)
+{
+    for (size_t x = 0; x < count; ++x) {
+        for (int j = 0; j < 4; ++j) {
+            uint32_t i = (swizzle >> (8 * j)) & 0xFF;
+            dst[j] = i == SWIZZLE_ONE ? 0xFF : src[i];
+        }
+        src += src_size;
+        dst += 4;
+    }
+}
+
+/// Scalar half to float of count values, matching Bitwise::half_to_float
+inline void half_to_float(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    const uint16_t* h = reinterpret_cast<const uint16_t*>(src);
+    float* f = reinterpret_cast<float*>(dst);
+    for (size_t i = 0; i < count; ++i)
+        f[i] = Bitwise::half_to_float(h[i]);
+}
+
+/// Scalar float to half of count values, matching Bitwise::float_to_half
+inline void float_to_half(const float* src, uint16_t* dst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        dst[i] = Bitwise::float_to_half(src[i]);
+}
+
+/** Byte offsets of a 4 byte layout with the missing alpha of the X formats
+    placed in the unused byte, so it can be the target of make_swizzle.
+*/
+constexpr ByteLayout full_layout(ByteLayout layout)
+{
+    return {4, layout.r, layout.g, layout.b, layout.a < 0 ? 6 - layout.r - layout.g - layout.b : layout.a};
+}
+
+/// Bytes of a 4 byte pixel that hold a channel of the layout, the unused byte of the X formats is 0
+constexpr uint32_t layout_keep_mask(ByteLayout layout)
+{
+    return layout.a < 0 ? ~(0xFFu << (8 * full_layout(layout).a)) : 0xFFFFFFFFu;
+}
+
+/// Scalar PixelUtil::pack_color of count colours to a 4 byte layout, for the tails of the vector loops
+inline void pack_color_bytes(const Color* src, uint8_t* dst, size_t count, ByteLayout layout)
+{
+    for (size_t x = 0; x < count; ++x) {
+        const float* c = src[x].get_ptr();
+        uint8_t* p = dst + x * 4;
+        p[0] = p[1] = p[2] = p[3] = 0;
+        p[layout.r] = uint8_t(Bitwise::float_to_fixed(c[0], 8));
+        p[layout.g] = uint8_t(Bitwise::float_to_fixed(c[1], 8));
+        p[layout.b] = uint8_t(Bitwise::float_to_fixed(c[2], 8));
+        if (layout.a >= 0)
+            p[layout.a] = uint8_t(Bitwise::float_to_fixed(c[3], 8));
+    }
+}
+
+/// Scalar PixelUtil::unpack_color of count pixels of a 4 byte layout, for the tails of the vector loops
+inline void unpack_color_bytes(const uint8_t* src, Color* dst, size_t count, ByteLayout layout)
+{
+    for (size_t x = 0; x < count; ++x) {
+        const uint8_t* p = src + x * 4;
+        float* c = dst[x].get_ptr();
+        c[0] = Bitwise::fixed_to_float(p[layout.r], 8);
+        c[1] = Bitwise::fixed_to_float(p[layout.g], 8);
+        c[2] = Bitwise::fixed_to_float(p[layout.b], 8);
+        c[3] = layout.a >= 0 ? Bitwise::fixed_to_float(p[layout.a], 8) : 1.0f;
+    }
+}
+
+} // namespace pixel_simd
+
+/** Expands to X(src, dst, kernel) for every format pair with vectorised converters.
+
+    kernel is one of SWIZZLE32 (4 byte to 4 byte), SWIZZLE24 (3 byte to 4 byte),
+    EXPAND8 (1 byte to 4 byte) or HALF<n> (n channel half to float).
+*/
+#define HYUE_SIMD_PIXEL_CONVERSIONS(X)     \
+    X(A8R8G8B8, A8B8G8R8, SWIZZLE32)        \
+    X(A8R8G8B8, B8G8R8A8, SWIZZLE32)        \
+    X(A8R8G8B8, R8G8B8A8, SWIZZLE32)        \
+    X(A8B8G8R8, A8R8G8B8, SWIZZLE32)        \
+    X(A8B8G8R8, B8G8R8A8, SWIZZLE32)        \
+    X(A8B8G8R8, R8G8B8A8, SWIZZLE32)        \
+    X(B8G8R8A8, A8R8G8B8, SWIZZLE32)        \
+    X(B8G8R8A8, A8B8G8R8, SWIZZLE32)        \
+    X(B8G8R8A8, R8G8B8A8, SWIZZLE32)        \
+    X(R8G8B8A8, A8R8G8B8, SWIZZLE32)        \
+    X(R8G8B8A8, A8B8G8R8, SWIZZLE32)        \
+    X(R8G8B8A8, B8G8R8A8, SWIZZLE32)        \
+    X(X8R8G8B8, A8R8G8B8, SWIZZLE32)        \
+    X(X8R8G8B8, A8B8G8R8, SWIZZLE32)        \
+    X(X8R8G8B8, B8G8R8A8, SWIZZLE32)        \
+    X(X8R8G8B8, R8G8B8A8, SWIZZLE32)        \
+    X(X8B8G8R8, A8R8G8B8, SWIZZLE32)        \
+    X(X8B8G8R8, A8B8G8R8, SWIZZLE32)        \
+    X(X8B8G8R8, B8G8R8A8, SWIZZLE32)        \
+    X(X8B8G8R8, R8G8B8A8, SWIZZLE32)        \
+    X(R8G8B8, A8R8G8B8, SWIZZLE24)          \
+    X(R8G8B8, A8B8G8R8, SWIZZLE24)          \
+    X(R8G8B8, B8G8R8A8, SWIZZLE24)          \
+    X(R8G8B8, R8G8B8A8, SWIZZLE24)          \
+    X(B8G8R8, A8R8G8B8, SWIZZLE24)          \
+    X(B8G8R8, A8B8G8R8, SWIZZLE24)          \
+    X(B8G8R8, B8G8R8A8, SWIZZLE24)          \
+    X(B8G8R8, R8G8B8A8, SWIZZLE24)          \
+    X(L8, A8R8G8B8, EXPAND8)                \
+    X(L8, A8B8G8R8, EXPAND8)                \
+    X(L8, B8G8R8A8, EXPAND8)                \
+    X(L8, R8G8B8A8, EXPAND8)                \
+    X(FLOAT16_R, FLOAT32_R, HALF1)          \
+    X(FLOAT16_GR, FLOAT32_GR, HALF2)        \
+    X(FLOAT16_RGB, FLOAT32_RGB, HALF3)      \
+    X(FLOAT16_RGBA, FLOAT32_RGBA, HALF4)
+
+// Switch case returning the kernel of a HYUE_SIMD_PIXEL_CONVERSIONS entry; the
+// files of every instruction set define convert_32_to_32, convert_24_to_32,
+// convert_8_to_32 and convert_half_to_float.
+#define HYUE_SIMD_PIXEL_CONVERSION_CASE(src, dst, kernel)          \
+    case pixel_simd::conversion_id(PixelFormat::src, PixelFormat::dst): \
+        HYUE_SIMD_KERNEL_##kernel(src, dst)
+
+#define HYUE_SIMD_KERNEL_SWIZZLE32(src, dst) \
+    return &convert_32_to_32<pixel_simd::make_swizzle(pixel_simd::LAYOUT_##src, pixel_simd::LAYOUT_##dst)>;
+#define HYUE_SIMD_KERNEL_SWIZZLE24(src, dst) \
+    return &convert_24_to_32<pixel_simd::make_swizzle(pixel_simd::LAYOUT_##src, pixel_simd::LAYOUT_##dst)>;
+#define HYUE_SIMD_KERNEL_EXPAND8(src, dst) \
+    return &convert_8_to_32<pixel_simd::make_swizzle(pixel_simd::LAYOUT_##src, pixel_simd::LAYOUT_##dst)>;
+#define HYUE_SIMD_KERNEL_HALF1(src, dst) return &convert_half_to_float<1>;
+#define HYUE_SIMD_KERNEL_HALF2(src, dst) return &convert_half_to_float<2>;
+#define HYUE_SIMD_KERNEL_HALF3(src, dst) return &convert_half_to_float<3>;
+#define HYUE_SIMD_KERNEL_HALF4(src, dst) return &convert_half_to_float<4>;
+
+/// Expands to X(format) for every format with vectorised colour packers and unpackers
+#define HYUE_SIMD_COLOR_FORMATS(X) X(A8R8G8B8) X(X8R8G8B8) X(A8B8G8R8) X(X8B8G8R8) X(B8G8R8A8) X(R8G8B8A8)
+
+// Switch cases returning the kernels of a HYUE_SIMD_COLOR_FORMATS entry; the files
+// of every instruction set define pack_colors and unpack_colors templated on the
+// byte offsets of the format.
+#define HYUE_SIMD_COLOR_PACKER_CASE(format) \
+    case PixelFormat::format:                \
+        return &pack_colors<pixel_simd::LAYOUT_##format.r, pixel_simd::LAYOUT_##format.g, \
+                            pixel_simd::LAYOUT_##format.b, pixel_simd::LAYOUT_##format.a>;
+#define HYUE_SIMD_COLOR_UNPACKER_CASE(format) \
+    case PixelFormat::format:                  \
+        return &unpack_colors<pixel_simd::LAYOUT_##format.r, pixel_simd::LAYOUT_##format.g, \
+                              pixel_simd::LAYOUT_##format.b, pixel_simd::LAYOUT_##format.a>;
+
+} // namespace hyue
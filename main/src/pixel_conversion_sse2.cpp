@@ -0,0 +1,373 @@
+#include "pixel_conversion_simd.h"
+
+#if HYUE_SIMD_SSE2
+
+namespace hyue {
+
+using namespace pixel_simd;
+
+template <int SHIFT>
+static inline __m128i shift_epi32(__m128i v)
+{
+    if constexpr (SHIFT > 0)
+        return _mm_slli_epi32(v, SHIFT);
+    else if constexpr (SHIFT < 0)
+        return _mm_srli_epi32(v, -SHIFT);
+    else
+        return v;
+}
+
+/// Destination byte J of every 32 bit lane, zero if it is set to 0xFF afterwards
+template <uint32_t SWIZZLE, int J>
+static inline __m128i swizzle_byte(__m128i v)
+{
+    constexpr int i = (SWIZZLE >> (8 * J)) & 0xFF;
+    if constexpr (i == SWIZZLE_ONE)
+        return _mm_setzero_si128();
+    else
+        return _mm_and_si128(shift_epi32<8 * (J - i)>(v), _mm_set1_epi32(int(0xFFu << (8 * J))));
+}
+
+/// SSE2 has no byte shuffle, so every destination byte is shifted and masked into place
+template <uint32_t SWIZZLE>
+static inline __m128i swizzle_epi32(__m128i v)
+{
+    __m128i ret = _mm_or_si128(_mm_or_si128(swizzle_byte<SWIZZLE, 0>(v), swizzle_byte<SWIZZLE, 1>(v)),
+                               _mm_or_si128(swizzle_byte<SWIZZLE, 2>(v), swizzle_byte<SWIZZLE, 3>(v)));
+    constexpr uint32_t alpha = swizzle_alpha_mask(SWIZZLE);
+    if constexpr (alpha != 0)
+        ret = _mm_or_si128(ret, _mm_set1_epi32(int(alpha)));
+    return ret;
+}
+
+template <uint32_t SWIZZLE>
+static void convert_32_to_32(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    size_t x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), swizzle_epi32<SWIZZLE>(v));
+    }
+    swizzle_pixels(src + x * 4, dst + x * 4, count - x, 4, SWIZZLE);
+}
+
+template <uint32_t SWIZZLE>
+static void convert_24_to_32(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    size_t x = 0;
+    // 4 pixels per step, but each load reads 16 of the 12 bytes
+    for (; x + 6 <= count; x += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 3));
+        // move pixel i to the low dword of p_i, then gather the low dwords
+        __m128i p01 = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+        __m128i p23 = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+        __m128i p = _mm_castps_si128(_mm_movelh_ps(_mm_castsi128_ps(p01), _mm_castsi128_ps(p23)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), swizzle_epi32<SWIZZLE>(p));
+    }
+    swizzle_pixels(src + x * 3, dst + x * 4, count - x, 3, SWIZZLE);
+}
+
+template <uint32_t SWIZZLE>
+static void convert_8_to_32(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    constexpr uint32_t alpha = swizzle_alpha_mask(SWIZZLE);
+    const __m128i alpha_mask = _mm_set1_epi32(int(alpha));
+
+    size_t x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        // replicate every byte over a whole 32 bit lane
+        __m128i lo = _mm_unpacklo_epi8(v, v);
+        __m128i hi = _mm_unpackhi_epi8(v, v);
+        __m128i* out = reinterpret_cast<__m128i*>(dst + x * 4);
+        _mm_storeu_si128(out + 0, _mm_or_si128(_mm_unpacklo_epi16(lo, lo), alpha_mask));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_unpackhi_epi16(lo, lo), alpha_mask));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_unpacklo_epi16(hi, hi), alpha_mask));
+        _mm_storeu_si128(out + 3, _mm_or_si128(_mm_unpackhi_epi16(hi, hi), alpha_mask));
+    }
+    swizzle_pixels(src + x, dst + x * 4, count - x, 1, SWIZZLE);
+}
+
+/// Same steps as Bitwise::half_to_float_u16 on 4 values, denormals flush to (signed) zero
+static inline __m128i half_to_float_epi32(__m128i h)
+{
+    __m128i em = _mm_and_si128(h, _mm_set1_epi32(0x7fff));
+    __m128i s = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+
+    __m128i r = _mm_slli_epi32(_mm_add_epi32(em, _mm_set1_epi32(112 << 10)), 13);
+    r = _mm_andnot_si128(_mm_cmplt_epi32(em, _mm_set1_epi32(1 << 10)), r);
+
+    __m128i inf_nan = _mm_cmpgt_epi32(em, _mm_set1_epi32((31 << 10) - 1));
+    r = _mm_add_epi32(r, _mm_and_si128(inf_nan, _mm_set1_epi32(112 << 23)));
+
+    return _mm_or_si128(s, r);
+}
+
+template <int CHANNELS>
+static void convert_half_to_float(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    count *= CHANNELS;
+
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+        __m128i* out = reinterpret_cast<__m128i*>(dst + i * 4);
+        _mm_storeu_si128(out + 0, half_to_float_epi32(_mm_unpacklo_epi16(h, zero)));
+        _mm_storeu_si128(out + 1, half_to_float_epi32(_mm_unpackhi_epi16(h, zero)));
+    }
+    half_to_float(src + i * 2, dst + i * 4, count - i);
+}
+
+/// Clamp 4 colours to [0, 1] and convert to bytes like Bitwise::float_to_fixed(v, 8), bytes in r, g, b, a order
+static inline __m128i pack_unorm8(const float* src)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(256.0f);
+
+    __m128i c[4];
+    for (int i = 0; i < 4; ++i) {
+        // max first so NaN becomes 0
+        __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i * 4), zero), one);
+        c[i] = _mm_cvttps_epi32(_mm_mul_ps(v, scale));
+    }
+    // 1.0 truncates to 256, which saturates to 255
+    const __m128i max = _mm_set1_epi16(255);
+    __m128i lo = _mm_min_epi16(_mm_packs_epi32(c[0], c[1]), max);
+    __m128i hi = _mm_min_epi16(_mm_packs_epi32(c[2], c[3]), max);
+    return _mm_packus_epi16(lo, hi);
+}
+
+/// 4 bytes of r, g, b, a to a colour like Bitwise::fixed_to_float(v, 8)
+static inline __m128 unpack_unorm8(__m128i bytes)
+{
+    return _mm_div_ps(_mm_cvtepi32_ps(bytes), _mm_set1_ps(255.0f));
+}
+
+template <int R, int G, int B, int A>
+static void pack_colors(const Color* src, uint8_t* dst, size_t count)
+{
+    constexpr ByteLayout layout = {4, R, G, B, A};
+    constexpr uint32_t swizzle = make_swizzle(LAYOUT_A8B8G8R8, full_layout(layout));
+    const __m128i keep = _mm_set1_epi32(int(layout_keep_mask(layout)));
+
+    size_t x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128i v = swizzle_epi32<swizzle>(pack_unorm8(src[x].get_ptr()));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_and_si128(v, keep));
+    }
+    pack_color_bytes(src + x, dst + x * 4, count - x, layout);
+}
+
+template <int R, int G, int B, int A>
+static void unpack_colors(const uint8_t* src, Color* dst, size_t count)
+{
+    constexpr ByteLayout layout = {4, R, G, B, A};
+    constexpr uint32_t swizzle = make_swizzle(layout, LAYOUT_A8B8G8R8);
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128i v = swizzle_epi32<swizzle>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4)));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        float* out = dst[x].get_ptr();
+        _mm_storeu_ps(out + 0, unpack_unorm8(_mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_ps(out + 4, unpack_unorm8(_mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_ps(out + 8, unpack_unorm8(_mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_ps(out + 12, unpack_unorm8(_mm_unpackhi_epi16(hi, zero)));
+    }
+    unpack_color_bytes(src + x * 4, dst + x, count - x, layout);
+}
+
+ColorPacker get_sse2_color_packer(PixelFormat format)
+{
+    switch (format) {
+        HYUE_SIMD_COLOR_FORMATS(HYUE_SIMD_COLOR_PACKER_CASE)
+        default:
+            return nullptr;
+    }
+}
+
+ColorUnpacker get_sse2_color_unpacker(PixelFormat format)
+{
+    switch (format) {
+        HYUE_SIMD_COLOR_FORMATS(HYUE_SIMD_COLOR_UNPACKER_CASE)
+        default:
+            return nullptr;
+    }
+}
+
+/// Same steps as Bitwise::float_to_half on 4 values, in the low 16 bits of each lane
+static inline __m128i float_to_half_epi32(__m128 f)
+{
+    __m128i ui = _mm_castps_si128(f);
+    __m128i s = _mm_and_si128(_mm_srli_epi32(ui, 16), _mm_set1_epi32(0x8000));
+    __m128i em = _mm_and_si128(ui, _mm_set1_epi32(0x7fffffff));
+
+    // bias exponent and round to nearest; 112 is relative exponent bias (127-15)
+    __m128i h = _mm_srai_epi32(_mm_add_epi32(em, _mm_set1_epi32(int(-(112 << 23) + (1 << 12)))), 13);
+    // underflow: flush to zero; 113 encodes exponent -14
+    h = _mm_andnot_si128(_mm_cmplt_epi32(em, _mm_set1_epi32(113 << 23)), h);
+
+    // overflow: infinity; 143 encodes exponent 16
+    __m128i inf = _mm_cmpgt_epi32(em, _mm_set1_epi32((143 << 23) - 1));
+    h = _mm_or_si128(_mm_andnot_si128(inf, h), _mm_and_si128(inf, _mm_set1_epi32(0x7c00)));
+
+    // NaN; note that we convert all types of NaN to qNaN
+    __m128i nan = _mm_cmpgt_epi32(em, _mm_set1_epi32(255 << 23));
+    h = _mm_or_si128(h, _mm_and_si128(nan, _mm_set1_epi32(0x0200)));
+
+    return _mm_or_si128(s, h);
+}
+
+/// Pack the low 16 bits of the lanes of a and b, without the signed saturation of _mm_packs_epi32
+static inline __m128i pack_low_epi32(__m128i a, __m128i b)
+{
+    a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+    b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+    return _mm_packs_epi32(a, b);
+}
+
+void sse2_float_to_half(const float* src, uint16_t* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i lo = float_to_half_epi32(_mm_loadu_ps(src + i));
+        __m128i hi = float_to_half_epi32(_mm_loadu_ps(src + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), pack_low_epi32(lo, hi));
+    }
+    float_to_half(src + i, dst + i, count - i);
+}
+
+/// log2 of 4 positive normal floats (Cephes logf polynomial), absolute error about 1e-7
+static inline __m128 log2_ps(__m128 x)
+{
+    __m128i bits = _mm_castps_si128(x);
+    __m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+    __m128 m = _mm_castsi128_ps(
+        _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+
+    // m in [1, 2), halve the upper part to centre it on 1
+    __m128 upper = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+    m = _mm_sub_ps(m, _mm_and_ps(upper, _mm_mul_ps(m, _mm_set1_ps(0.5f))));
+    e = _mm_sub_epi32(e, _mm_castps_si128(upper));
+
+    __m128 t = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+    __m128 z = _mm_mul_ps(t, t);
+    __m128 p = _mm_set1_ps(7.0376836292E-2f);
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-1.1514610310E-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.1676998740E-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-1.2420140846E-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.4249322787E-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-1.6668057665E-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(2.0000714765E-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-2.4999993993E-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(3.3333331174E-1f));
+    // ln(m) = t - z / 2 + t z p
+    __m128 ln = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(t, z), p), _mm_mul_ps(z, _mm_set1_ps(0.5f))), t);
+
+    return _mm_add_ps(_mm_cvtepi32_ps(e), _mm_mul_ps(ln, _mm_set1_ps(1.44269504f)));
+}
+
+/// 2^x of 4 floats (Cephes exp2f polynomial), x is clamped to the normal range
+static inline __m128 exp2_ps(__m128 x)
+{
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(127.99f));
+    // round to nearest, leaving a fraction in [-0.5, 0.5]
+    __m128i i = _mm_cvtps_epi32(x);
+    __m128 f = _mm_sub_ps(x, _mm_cvtepi32_ps(i));
+
+    __m128 p = _mm_set1_ps(1.535336188319500E-4f);
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.339887440266574E-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.618437357674640E-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.550332471162809E-2f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.402264791363012E-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.931472028550421E-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+
+    return _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(p), _mm_slli_epi32(i, 23)));
+}
+
+static inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/// v, with the inf and NaN values of c passed through as std::pow does; the polynomials would make them finite
+static inline __m128 keep_non_finite_ps(__m128 c, __m128 v)
+{
+    __m128i abs = _mm_and_si128(_mm_castps_si128(c), _mm_set1_epi32(0x7fffffff));
+    return select_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(abs, _mm_set1_epi32(0x7f7fffff))), c, v);
+}
+
+/// sRGB to linear of 4 channel values
+static inline __m128 srgb_to_linear_ps(__m128 c)
+{
+    __m128 lin = _mm_mul_ps(c, _mm_set1_ps(1.0f / 12.92f));
+    __m128 base = _mm_mul_ps(_mm_add_ps(c, _mm_set1_ps(0.055f)), _mm_set1_ps(1.0f / 1.055f));
+    __m128 curve = exp2_ps(_mm_mul_ps(log2_ps(base), _mm_set1_ps(2.4f)));
+    return keep_non_finite_ps(c, select_ps(_mm_cmple_ps(c, _mm_set1_ps(0.04045f)), lin, curve));
+}
+
+/// Linear to sRGB of 4 channel values
+static inline __m128 linear_to_srgb_ps(__m128 c)
+{
+    __m128 lin = _mm_mul_ps(c, _mm_set1_ps(12.92f));
+    __m128 curve = exp2_ps(_mm_mul_ps(log2_ps(c), _mm_set1_ps(1.0f / 2.4f)));
+    curve = _mm_sub_ps(_mm_mul_ps(curve, _mm_set1_ps(1.055f)), _mm_set1_ps(0.055f));
+    return keep_non_finite_ps(c, select_ps(_mm_cmple_ps(c, _mm_set1_ps(0.0031308f)), lin, curve));
+}
+
+/// Applies a channel function to the r, g and b of colours, 4 colours are transposed so alpha is skipped
+template <__m128 (*FUNC)(__m128)>
+static inline void transform_rgb(const Color* src, Color* dst, size_t count)
+{
+    size_t x = 0;
+    for (; x + 4 <= count; x += 4) {
+        const float* in = src[x].get_ptr();
+        __m128 r = _mm_loadu_ps(in + 0);
+        __m128 g = _mm_loadu_ps(in + 4);
+        __m128 b = _mm_loadu_ps(in + 8);
+        __m128 a = _mm_loadu_ps(in + 12);
+        _MM_TRANSPOSE4_PS(r, g, b, a);
+        r = FUNC(r);
+        g = FUNC(g);
+        b = FUNC(b);
+        _MM_TRANSPOSE4_PS(r, g, b, a);
+        float* out = dst[x].get_ptr();
+        _mm_storeu_ps(out + 0, r);
+        _mm_storeu_ps(out + 4, g);
+        _mm_storeu_ps(out + 8, b);
+        _mm_storeu_ps(out + 12, a);
+    }
+    const __m128 alpha = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+    for (; x < count; ++x) {
+        __m128 c = _mm_loadu_ps(src[x].get_ptr());
+        _mm_storeu_ps(dst[x].get_ptr(), select_ps(alpha, c, FUNC(c)));
+    }
+}
+
+void sse2_srgb_to_linear(const Color* src, Color* dst, size_t count)
+{
+    transform_rgb<srgb_to_linear_ps>(src, dst, count);
+}
+
+void sse2_linear_to_srgb(const Color* src, Color* dst, size_t count)
+{
+    transform_rgb<linear_to_srgb_ps>(src, dst, count);
+}
+
+PixelRowConverter get_sse2_row_converter(PixelFormat src_format, PixelFormat dst_format)
+{
+    switch (conversion_id(src_format, dst_format)) {
+        HYUE_SIMD_PIXEL_CONVERSIONS(HYUE_SIMD_PIXEL_CONVERSION_CASE)
+        default:
+            return nullptr;
+    }
+}
+
+} // namespace hyue
+
+#endif // HYUE_SIMD_SSE2
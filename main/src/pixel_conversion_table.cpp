@@ -0,0 +1,94 @@
+#include "PixelFormatTraits.h"
+
+#include <array>
+#include <utility>
+
+namespace hyue {
+
+namespace {
+
+constexpr size_t FORMAT_COUNT = size_t(PixelFormat::COUNT);
+
+constexpr size_t count_traits_formats()
+{
+    size_t ret = 0;
+    for (size_t i = 0; i < FORMAT_COUNT; ++i)
+        ret += has_pixel_format_traits(PixelFormat(i)) ? 1 : 0;
+    return ret;
+}
+
+/// Number of formats with PixelFormatTraits, the size of each side of the table
+constexpr size_t TRAITS_FORMAT_COUNT = count_traits_formats();
+
+/// The formats with PixelFormatTraits, in enum order
+constexpr std::array<PixelFormat, TRAITS_FORMAT_COUNT> make_traits_formats()
+{
+    std::array<PixelFormat, TRAITS_FORMAT_COUNT> ret{};
+    size_t n = 0;
+    for (size_t i = 0; i < FORMAT_COUNT; ++i) {
+        if (has_pixel_format_traits(PixelFormat(i)))
+            ret[n++] = PixelFormat(i);
+    }
+    return ret;
+}
+
+constexpr std::array<PixelFormat, TRAITS_FORMAT_COUNT> TRAITS_FORMATS = make_traits_formats();
+
+/// Position of every format in TRAITS_FORMATS, -1 for the formats without traits
+constexpr std::array<int, FORMAT_COUNT> make_traits_index()
+{
+    std::array<int, FORMAT_COUNT> ret{};
+    for (size_t i = 0; i < FORMAT_COUNT; ++i)
+        ret[i] = -1;
+    for (size_t n = 0; n < TRAITS_FORMAT_COUNT; ++n)
+        ret[size_t(TRAITS_FORMATS[n])] = int(n);
+    return ret;
+}
+
+constexpr std::array<int, FORMAT_COUNT> TRAITS_INDEX = make_traits_index();
+
+template <PixelFormat SRC, PixelFormat DST>
+void convert_row(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    using Src = PixelFormatTraits<SRC>;
+    using Dst = PixelFormatTraits<DST>;
+    for (size_t x = 0; x < count; ++x) {
+        float rgba[4];
+        Src::unpack(src, rgba);
+        Dst::pack(rgba, dst);
+        src += Src::elem_bytes;
+        dst += Dst::elem_bytes;
+    }
+}
+
+template <size_t SRC, size_t... DST>
+constexpr std::array<PixelRowConverter, TRAITS_FORMAT_COUNT> make_table_row(std::index_sequence<DST...>)
+{
+    return {{&convert_row<TRAITS_FORMATS[SRC], TRAITS_FORMATS[DST]>...}};
+}
+
+template <size_t... SRC>
+constexpr std::array<std::array<PixelRowConverter, TRAITS_FORMAT_COUNT>, TRAITS_FORMAT_COUNT>
+make_table(std::index_sequence<SRC...>)
+{
+    return {{make_table_row<SRC>(std::make_index_sequence<TRAITS_FORMAT_COUNT>())...}};
+}
+
+/// Converters indexed by the TRAITS_INDEX of the source and destination format
+constexpr std::array<std::array<PixelRowConverter, TRAITS_FORMAT_COUNT>, TRAITS_FORMAT_COUNT> ROW_CONVERTERS =
+    make_table(std::make_index_sequence<TRAITS_FORMAT_COUNT>());
+
+} // namespace
+
+PixelRowConverter get_traits_row_converter(PixelFormat src_format, PixelFormat dst_format)
+{
+    if (size_t(src_format) >= FORMAT_COUNT || size_t(dst_format) >= FORMAT_COUNT)
+        return nullptr;
+    int src = TRAITS_INDEX[size_t(src_format)];
+    int dst = TRAITS_INDEX[size_t(dst_format)];
+    if (src < 0 || dst < 0)
+        return nullptr;
+    return ROW_CONVERTERS[size_t(src)][size_t(dst)];
+}
+
+} // namespace hyue
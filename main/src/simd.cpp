@@ -0,0 +1,37 @@
+#include <hyue/simd.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "simd_intrinsics.h"
+
+namespace hyue {
+
+static SimdLevel detect_simd_level()
+{
+#if HYUE_SIMD_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return SimdLevel::AVX2;
+#endif
+#if HYUE_SIMD_SSE2
+    return SimdLevel::SSE2;
+#else
+    return SimdLevel::NONE;
+#endif
+}
+
+static std::atomic<SimdLevel> g_max_simd_level{SimdLevel::AVX2};
+
+SimdLevel get_simd_level()
+{
+    static const SimdLevel detected = detect_simd_level();
+    return std::min(detected, g_max_simd_level.load(std::memory_order_relaxed));
+}
+
+void set_max_simd_level(SimdLevel level)
+{
+    g_max_simd_level.store(level, std::memory_order_relaxed);
+}
+
+} // namespace hyue
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <hyue/type.h>
+
+// HYUE_SIMD_SSE2 is set when SSE2 intrinsics can be used unconditionally: on
+// x86 SSE2 is part of the 64 bit baseline, on ARM SSE2NEON.h maps them to NEON.
+// HYUE_SIMD_AVX2 comes from the build when the AVX2 kernels are compiled in;
+// they may only run after get_simd_level() confirmed CPU support.
+#if HYUE_ENDIAN_LITTLE && (defined(__SSE2__) || defined(_M_X64))
+    #define HYUE_SIMD_SSE2 1
+    #include <emmintrin.h>
+#elif HYUE_ENDIAN_LITTLE && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+    #define HYUE_SIMD_SSE2 1
+    #include "SSE2NEON.h"
+#else
+    #define HYUE_SIMD_SSE2 0
+#endif
+
+#ifndef HYUE_SIMD_AVX2
+    #define HYUE_SIMD_AVX2 0
+#endif
+
+// Kernels for select_simd(), null when the instruction set is not built in
+#if HYUE_SIMD_SSE2
+    #define HYUE_SSE2_KERNEL(f) (&f)
+#else
+    #define HYUE_SSE2_KERNEL(f) static_cast<decltype(&f)>(nullptr)
+#endif
+#if HYUE_SIMD_AVX2
+    #define HYUE_AVX2_KERNEL(f) (&f)
+#else
+    #define HYUE_AVX2_KERNEL(f) static_cast<decltype(&f)>(nullptr)
+#endif
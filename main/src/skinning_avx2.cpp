@@ -0,0 +1,108 @@
+#include "skinning_simd.h"
+
+// built with AVX2 and FMA code generation enabled, see main/CMakeLists.txt
+#if HYUE_SIMD_AVX2
+
+#include <immintrin.h>
+
+namespace hyue {
+
+namespace {
+
+/// Two 128 bit halves, lo in the low lane
+inline __m256 combine(__m128 lo, __m128 hi)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+/// The 3 components of a vertex element broadcast to the 4 floats of each lane, one vertex per lane
+inline void load_broadcast(const float* a, const float* b, __m256* x, __m256* y, __m256* z)
+{
+    *x = combine(_mm_set1_ps(a[0]), _mm_set1_ps(b[0]));
+    *y = combine(_mm_set1_ps(a[1]), _mm_set1_ps(b[1]));
+    *z = combine(_mm_set1_ps(a[2]), _mm_set1_ps(b[2]));
+}
+
+/// Write the first 3 floats of each lane to two vertices, the destination may be packed
+inline void store_vertices(float* a, float* b, __m256 v)
+{
+    alignas(32) float out[8];
+    _mm256_store_ps(out, v);
+    a[0] = out[0];
+    a[1] = out[1];
+    a[2] = out[2];
+    b[0] = out[4];
+    b[1] = out[5];
+    b[2] = out[6];
+}
+
+} // namespace
+
+void avx2_skin(const SkinnedVertexData& data, size_t begin, size_t end)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 min_length = _mm256_set1_ps(1e-08f);
+
+    // the SSE2 kernel on two vertices at once, one per 128 bit lane, with
+    // fused multiply adds; gathering the matrices of 8 vertices costs more
+    // than it saves
+    size_t i = begin;
+    for (; i + 2 <= end; i += 2) {
+        const float* weights[2] = {get_vertex(data.blend_weights, data.blend_weight_stride, i),
+                                   get_vertex(data.blend_weights, data.blend_weight_stride, i + 1)};
+        const uint8_t* indices[2] = {get_vertex(data.blend_indices, data.blend_index_stride, i),
+                                     get_vertex(data.blend_indices, data.blend_index_stride, i + 1)};
+
+        // blend the rows of the matrices, a zero weight points at the first
+        // matrix which it then scales to nothing
+        __m256 r0 = zero, r1 = zero, r2 = zero;
+        for (size_t k = 0; k < data.weights_per_vertex; ++k) {
+            float wa = weights[0][k], wb = weights[1][k];
+            if (wa == 0 && wb == 0)
+                continue;
+            const float* a = data.blend_matrices[wa != 0 ? indices[0][k] : 0].a[0];
+            const float* b = data.blend_matrices[wb != 0 ? indices[1][k] : 0].a[0];
+            __m256 w = combine(_mm_set1_ps(wa), _mm_set1_ps(wb));
+            r0 = _mm256_fmadd_ps(_mm256_loadu2_m128(b, a), w, r0);
+            r1 = _mm256_fmadd_ps(_mm256_loadu2_m128(b + 4, a + 4), w, r1);
+            r2 = _mm256_fmadd_ps(_mm256_loadu2_m128(b + 8, a + 8), w, r2);
+        }
+
+        // transpose each lane to columns, see sse2_skin
+        __m256 lo01 = _mm256_unpacklo_ps(r0, r1), hi01 = _mm256_unpackhi_ps(r0, r1);
+        __m256 lo2 = _mm256_unpacklo_ps(r2, zero), hi2 = _mm256_unpackhi_ps(r2, zero);
+        __m256 c0 = _mm256_shuffle_ps(lo01, lo2, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 c1 = _mm256_shuffle_ps(lo01, lo2, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 c2 = _mm256_shuffle_ps(hi01, hi2, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 c3 = _mm256_shuffle_ps(hi01, hi2, _MM_SHUFFLE(3, 2, 3, 2));
+
+        __m256 x, y, z;
+        load_broadcast(get_vertex(data.src_position, data.src_position_stride, i),
+                       get_vertex(data.src_position, data.src_position_stride, i + 1), &x, &y, &z);
+        __m256 v = _mm256_fmadd_ps(c0, x, _mm256_fmadd_ps(c1, y, _mm256_fmadd_ps(c2, z, c3)));
+        store_vertices(get_vertex(data.dst_position, data.dst_position_stride, i),
+                       get_vertex(data.dst_position, data.dst_position_stride, i + 1), v);
+
+        if (data.src_normal) {
+            load_broadcast(get_vertex(data.src_normal, data.src_normal_stride, i),
+                           get_vertex(data.src_normal, data.src_normal_stride, i + 1), &x, &y, &z);
+            v = _mm256_fmadd_ps(c0, x, _mm256_fmadd_ps(c1, y, _mm256_mul_ps(c2, z)));
+
+            // normalise unless degenerate, see normalise(); the last float of each lane is 0
+            __m256 squared = _mm256_mul_ps(v, v);
+            squared = _mm256_add_ps(squared, _mm256_shuffle_ps(squared, squared, _MM_SHUFFLE(2, 3, 0, 1)));
+            squared = _mm256_add_ps(squared, _mm256_shuffle_ps(squared, squared, _MM_SHUFFLE(1, 0, 3, 2)));
+            __m256 length = _mm256_sqrt_ps(squared);
+            __m256 scale = _mm256_blendv_ps(one, _mm256_div_ps(one, length), _mm256_cmp_ps(length, min_length, _CMP_GT_OQ));
+            store_vertices(get_vertex(data.dst_normal, data.dst_normal_stride, i),
+                           get_vertex(data.dst_normal, data.dst_normal_stride, i + 1), _mm256_mul_ps(v, scale));
+        }
+    }
+
+    skin_scalar(data, i, end);
+}
+
+} // namespace hyue
+
+#endif
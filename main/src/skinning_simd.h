@@ -0,0 +1,42 @@
+#pragma once
+
+#include <hyue/SkinningStage.h>
+
+#include <cmath>
+#include <type_traits>
+
+#include "simd_intrinsics.h"
+
+namespace hyue {
+
+/// Skins vertices [begin, end) of a mesh
+using SkinningKernel = void (*)(const SkinnedVertexData& data, size_t begin, size_t end);
+
+void skin_scalar(const SkinnedVertexData& data, size_t begin, size_t end);
+void sse2_skin(const SkinnedVertexData& data, size_t begin, size_t end);
+void avx2_skin(const SkinnedVertexData& data, size_t begin, size_t end);
+
+/// Morphs vertices [begin, end) of a mesh
+void morph_scalar(const MorphVertexData& data, size_t begin, size_t end);
+
+/// Element of a vertex buffer, stride in bytes
+template <class T>
+inline T* get_vertex(T* base, size_t stride, size_t index)
+{
+    using Byte = typename std::conditional<std::is_const<T>::value, const uint8_t, uint8_t>::type;
+    return reinterpret_cast<T*>(reinterpret_cast<Byte*>(base) + stride * index);
+}
+
+/// Scale a vector to unit length unless it is degenerate, as Ogre's Vector3::normalise
+inline void normalise(float* v)
+{
+    float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (length > 1e-08f) {
+        float inv_length = 1.0f / length;
+        v[0] *= inv_length;
+        v[1] *= inv_length;
+        v[2] *= inv_length;
+    }
+}
+
+} // namespace hyue
@@ -0,0 +1,61 @@
+#include "skinning_simd.h"
+
+#if HYUE_SIMD_SSE2
+
+namespace hyue {
+
+void sse2_skin(const SkinnedVertexData& data, size_t begin, size_t end)
+{
+    const __m128 zero = _mm_setzero_ps();
+    for (size_t i = begin; i < end; ++i) {
+        const float* weights = get_vertex(data.blend_weights, data.blend_weight_stride, i);
+        const uint8_t* indices = get_vertex(data.blend_indices, data.blend_index_stride, i);
+
+        // blend the rows of the matrices
+        __m128 r0 = zero, r1 = zero, r2 = zero;
+        for (size_t k = 0; k < data.weights_per_vertex; ++k) {
+            if (weights[k] == 0)
+                continue;
+            const float* m = data.blend_matrices[indices[k]].a[0];
+            __m128 w = _mm_set1_ps(weights[k]);
+            r0 = _mm_add_ps(r0, _mm_mul_ps(_mm_loadu_ps(m), w));
+            r1 = _mm_add_ps(r1, _mm_mul_ps(_mm_loadu_ps(m + 4), w));
+            r2 = _mm_add_ps(r2, _mm_mul_ps(_mm_loadu_ps(m + 8), w));
+        }
+
+        // transpose to columns, the transformed vector is then a sum of columns
+        __m128 lo01 = _mm_unpacklo_ps(r0, r1), hi01 = _mm_unpackhi_ps(r0, r1);
+        __m128 lo2 = _mm_unpacklo_ps(r2, zero), hi2 = _mm_unpackhi_ps(r2, zero);
+        __m128 c0 = _mm_movelh_ps(lo01, lo2);
+        __m128 c1 = _mm_movehl_ps(lo2, lo01);
+        __m128 c2 = _mm_movelh_ps(hi01, hi2);
+        __m128 c3 = _mm_movehl_ps(hi2, hi01);
+
+        // the destination may be packed, only 3 floats are written
+        alignas(16) float out[4];
+        const float* src = get_vertex(data.src_position, data.src_position_stride, i);
+        __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(src[0])), _mm_mul_ps(c1, _mm_set1_ps(src[1]))),
+                              _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(src[2])), c3));
+        _mm_store_ps(out, v);
+        float* dst = get_vertex(data.dst_position, data.dst_position_stride, i);
+        dst[0] = out[0];
+        dst[1] = out[1];
+        dst[2] = out[2];
+
+        if (data.src_normal) {
+            src = get_vertex(data.src_normal, data.src_normal_stride, i);
+            v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(src[0])), _mm_mul_ps(c1, _mm_set1_ps(src[1]))),
+                           _mm_mul_ps(c2, _mm_set1_ps(src[2])));
+            _mm_store_ps(out, v);
+            normalise(out);
+            dst = get_vertex(data.dst_normal, data.dst_normal_stride, i);
+            dst[0] = out[0];
+            dst[1] = out[1];
+            dst[2] = out[2];
+        }
+    }
+}
+
+} // namespace hyue
+
+#endif
@@ -1 +1,116 @@
-#include <hyue/thread.h>
\ No newline at end of file
+#include <hyue/thread.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace hyue {
+
+/// Workers of ThreadPool::get_io_pool
+#define HYUE_IO_POOL_THREADS 4
+
+ThreadPool::ThreadPool(size_t num_threads)
+: stop_(false)
+{
+    if (num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i)
+        workers_.emplace_back([this]() { run(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cond_.notify_all();
+
+    for (auto& worker : workers_)
+        worker.join();
+}
+
+void ThreadPool::post(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    cond_.notify_one();
+}
+
+void ThreadPool::run()
+{
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+            // drain the queue before stopping
+            if (tasks_.empty())
+                return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& job)
+{
+    if (count == 0)
+        return;
+
+    // shared with the helper tasks, which may only start after everything is done
+    struct State {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+
+    // job is only touched while jobs are left, so the caller is still waiting
+    auto run_jobs = [state, count, &job]() {
+        for (size_t i = state->next++; i < count; i = state->next++) {
+            try {
+                job(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->error)
+                    state->error = std::current_exception();
+            }
+            if (++state->done == count) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(workers_.size(), count - 1);
+    for (size_t i = 0; i < helpers; ++i)
+        post(run_jobs);
+
+    run_jobs();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]() { return state->done == count; });
+    if (state->error)
+        std::rethrow_exception(state->error);
+}
+
+ThreadPool& ThreadPool::get_io_pool()
+{
+    static ThreadPool pool(HYUE_IO_POOL_THREADS);
+    return pool;
+}
+
+ThreadPool& ThreadPool::get_worker_pool()
+{
+    static ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+} // namespace hyue
@@ -0,0 +1,111 @@
+#include "transform_update_simd.h"
+
+// built with AVX2 code generation enabled, see main/CMakeLists.txt
+#if HYUE_SIMD_AVX2
+
+#include <immintrin.h>
+
+namespace hyue {
+
+namespace {
+
+using C = TransformHierarchy;
+
+/// a where mask is set, b elsewhere
+inline __m256 select(__m256 mask, __m256 a, __m256 b)
+{
+    return _mm256_blendv_ps(b, a, mask);
+}
+
+} // namespace
+
+void avx2_update_transforms(const TransformBatch& batch, size_t begin, size_t end)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256i orientation_bit = _mm256_set1_epi32(INHERIT_ORIENTATION);
+    const __m256i scale_bit = _mm256_set1_epi32(INHERIT_SCALE);
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256i parent = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(batch.parent + i));
+        __m256 p[C::COMPONENT_COUNT], l[C::COMPONENT_COUNT];
+        for (int c = 0; c < C::COMPONENT_COUNT; ++c) {
+            p[c] = _mm256_i32gather_ps(batch.derived[c], parent, 4);
+            l[c] = _mm256_loadu_ps(batch.local[c] + i);
+        }
+        __m256i f = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(batch.flags + i)));
+        __m256 inherit_orientation = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(f, orientation_bit), orientation_bit));
+        __m256 inherit_scale = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(f, scale_bit), scale_bit));
+
+        // position: v = parent scale * local position, rotated by the parent orientation
+        __m256 vx = _mm256_mul_ps(p[C::SCALE_X], l[C::POS_X]);
+        __m256 vy = _mm256_mul_ps(p[C::SCALE_Y], l[C::POS_Y]);
+        __m256 vz = _mm256_mul_ps(p[C::SCALE_Z], l[C::POS_Z]);
+        __m256 qw = p[C::ROT_W], qx = p[C::ROT_X], qy = p[C::ROT_Y], qz = p[C::ROT_Z];
+        __m256 uvx = _mm256_sub_ps(_mm256_mul_ps(qy, vz), _mm256_mul_ps(qz, vy));
+        __m256 uvy = _mm256_sub_ps(_mm256_mul_ps(qz, vx), _mm256_mul_ps(qx, vz));
+        __m256 uvz = _mm256_sub_ps(_mm256_mul_ps(qx, vy), _mm256_mul_ps(qy, vx));
+        __m256 uuvx = _mm256_sub_ps(_mm256_mul_ps(qy, uvz), _mm256_mul_ps(qz, uvy));
+        __m256 uuvy = _mm256_sub_ps(_mm256_mul_ps(qz, uvx), _mm256_mul_ps(qx, uvz));
+        __m256 uuvz = _mm256_sub_ps(_mm256_mul_ps(qx, uvy), _mm256_mul_ps(qy, uvx));
+        __m256 d[C::COMPONENT_COUNT];
+        d[C::POS_X] = _mm256_add_ps(_mm256_add_ps(vx, _mm256_mul_ps(two, _mm256_add_ps(_mm256_mul_ps(qw, uvx), uuvx))), p[C::POS_X]);
+        d[C::POS_Y] = _mm256_add_ps(_mm256_add_ps(vy, _mm256_mul_ps(two, _mm256_add_ps(_mm256_mul_ps(qw, uvy), uuvy))), p[C::POS_Y]);
+        d[C::POS_Z] = _mm256_add_ps(_mm256_add_ps(vz, _mm256_mul_ps(two, _mm256_add_ps(_mm256_mul_ps(qw, uvz), uuvz))), p[C::POS_Z]);
+
+        // orientation: parent orientation, or identity, times local orientation
+        qw = select(inherit_orientation, qw, one);
+        qx = _mm256_and_ps(inherit_orientation, qx);
+        qy = _mm256_and_ps(inherit_orientation, qy);
+        qz = _mm256_and_ps(inherit_orientation, qz);
+        __m256 lw = l[C::ROT_W], lx = l[C::ROT_X], ly = l[C::ROT_Y], lz = l[C::ROT_Z];
+        d[C::ROT_W] = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_mul_ps(qw, lw), _mm256_mul_ps(qx, lx)), _mm256_mul_ps(qy, ly)),
+                                 _mm256_mul_ps(qz, lz));
+        d[C::ROT_X] = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(qw, lx), _mm256_mul_ps(qx, lw)), _mm256_mul_ps(qy, lz)),
+                                 _mm256_mul_ps(qz, ly));
+        d[C::ROT_Y] = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(qw, ly), _mm256_mul_ps(qy, lw)), _mm256_mul_ps(qz, lx)),
+                                 _mm256_mul_ps(qx, lz));
+        d[C::ROT_Z] = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(qw, lz), _mm256_mul_ps(qz, lw)), _mm256_mul_ps(qx, ly)),
+                                 _mm256_mul_ps(qy, lx));
+
+        // scale: parent scale, or one, times local scale
+        d[C::SCALE_X] = _mm256_mul_ps(select(inherit_scale, p[C::SCALE_X], one), l[C::SCALE_X]);
+        d[C::SCALE_Y] = _mm256_mul_ps(select(inherit_scale, p[C::SCALE_Y], one), l[C::SCALE_Y]);
+        d[C::SCALE_Z] = _mm256_mul_ps(select(inherit_scale, p[C::SCALE_Z], one), l[C::SCALE_Z]);
+
+        for (int c = 0; c < C::COMPONENT_COUNT; ++c)
+            _mm256_storeu_ps(batch.derived[c] + i, d[c]);
+
+        // world matrix, see make_world_matrix
+        __m256 x2 = _mm256_add_ps(d[C::ROT_X], d[C::ROT_X]);
+        __m256 y2 = _mm256_add_ps(d[C::ROT_Y], d[C::ROT_Y]);
+        __m256 z2 = _mm256_add_ps(d[C::ROT_Z], d[C::ROT_Z]);
+        __m256 wx = _mm256_mul_ps(x2, d[C::ROT_W]), wy = _mm256_mul_ps(y2, d[C::ROT_W]), wz = _mm256_mul_ps(z2, d[C::ROT_W]);
+        __m256 xx = _mm256_mul_ps(x2, d[C::ROT_X]), xy = _mm256_mul_ps(y2, d[C::ROT_X]), xz = _mm256_mul_ps(z2, d[C::ROT_X]);
+        __m256 yy = _mm256_mul_ps(y2, d[C::ROT_Y]), yz = _mm256_mul_ps(z2, d[C::ROT_Y]), zz = _mm256_mul_ps(z2, d[C::ROT_Z]);
+        __m256 sx = d[C::SCALE_X], sy = d[C::SCALE_Y], sz = d[C::SCALE_Z];
+
+        __m256 m[12];
+        m[0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx);
+        m[1] = _mm256_mul_ps(_mm256_sub_ps(xy, wz), sy);
+        m[2] = _mm256_mul_ps(_mm256_add_ps(xz, wy), sz);
+        m[3] = d[C::POS_X];
+        m[4] = _mm256_mul_ps(_mm256_add_ps(xy, wz), sx);
+        m[5] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy);
+        m[6] = _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz);
+        m[7] = d[C::POS_Y];
+        m[8] = _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx);
+        m[9] = _mm256_mul_ps(_mm256_add_ps(yz, wx), sy);
+        m[10] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz);
+        m[11] = d[C::POS_Z];
+        for (int r = 0; r < 12; ++r)
+            _mm256_storeu_ps(batch.world[r] + i, m[r]);
+    }
+
+    update_transforms_scalar(batch, i, end);
+}
+
+} // namespace hyue
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <hyue/TransformHierarchy.h>
+
+#include "simd_intrinsics.h"
+
+namespace hyue {
+
+/// Inherit flags of TransformHierarchy slots
+enum TransformFlags : uint8_t {
+    INHERIT_ORIENTATION = 1 << 0,
+    INHERIT_SCALE = 1 << 1,
+};
+
+/// The arrays of a TransformHierarchy a level update reads and writes
+struct TransformBatch {
+    const float* local[TransformHierarchy::COMPONENT_COUNT];
+    /// Read at the parent slots, written at the updated slots
+    float* derived[TransformHierarchy::COMPONENT_COUNT];
+    float* world[12];
+    const int32_t* parent;
+    const uint8_t* flags;
+};
+
+/** Updates the derived transforms and world matrices of slots [begin, end),
+    whose parents are already up to date.
+*/
+using TransformUpdater = void (*)(const TransformBatch& batch, size_t begin, size_t end);
+
+void update_transforms_scalar(const TransformBatch& batch, size_t begin, size_t end);
+void sse2_update_transforms(const TransformBatch& batch, size_t begin, size_t end);
+void avx2_update_transforms(const TransformBatch& batch, size_t begin, size_t end);
+
+} // namespace hyue
@@ -0,0 +1,115 @@
+#include "transform_update_simd.h"
+
+#if HYUE_SIMD_SSE2
+
+namespace hyue {
+
+namespace {
+
+using C = TransformHierarchy;
+
+/// Component c of the parents of 4 slots
+inline __m128 gather(const float* array, const int32_t* parent)
+{
+    return _mm_set_ps(array[parent[3]], array[parent[2]], array[parent[1]], array[parent[0]]);
+}
+
+/// a where mask is set, b elsewhere
+inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+} // namespace
+
+void sse2_update_transforms(const TransformBatch& batch, size_t begin, size_t end)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128i orientation_bit = _mm_set1_epi32(INHERIT_ORIENTATION);
+    const __m128i scale_bit = _mm_set1_epi32(INHERIT_SCALE);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        const int32_t* parent = batch.parent + i;
+        __m128 p[C::COMPONENT_COUNT], l[C::COMPONENT_COUNT];
+        for (int c = 0; c < C::COMPONENT_COUNT; ++c) {
+            p[c] = gather(batch.derived[c], parent);
+            l[c] = _mm_loadu_ps(batch.local[c] + i);
+        }
+        const uint8_t* flags = batch.flags + i;
+        __m128i f = _mm_set_epi32(flags[3], flags[2], flags[1], flags[0]);
+        __m128 inherit_orientation = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(f, orientation_bit), orientation_bit));
+        __m128 inherit_scale = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(f, scale_bit), scale_bit));
+
+        // position: v = parent scale * local position, rotated by the parent orientation
+        __m128 vx = _mm_mul_ps(p[C::SCALE_X], l[C::POS_X]);
+        __m128 vy = _mm_mul_ps(p[C::SCALE_Y], l[C::POS_Y]);
+        __m128 vz = _mm_mul_ps(p[C::SCALE_Z], l[C::POS_Z]);
+        __m128 qw = p[C::ROT_W], qx = p[C::ROT_X], qy = p[C::ROT_Y], qz = p[C::ROT_Z];
+        __m128 uvx = _mm_sub_ps(_mm_mul_ps(qy, vz), _mm_mul_ps(qz, vy));
+        __m128 uvy = _mm_sub_ps(_mm_mul_ps(qz, vx), _mm_mul_ps(qx, vz));
+        __m128 uvz = _mm_sub_ps(_mm_mul_ps(qx, vy), _mm_mul_ps(qy, vx));
+        __m128 uuvx = _mm_sub_ps(_mm_mul_ps(qy, uvz), _mm_mul_ps(qz, uvy));
+        __m128 uuvy = _mm_sub_ps(_mm_mul_ps(qz, uvx), _mm_mul_ps(qx, uvz));
+        __m128 uuvz = _mm_sub_ps(_mm_mul_ps(qx, uvy), _mm_mul_ps(qy, uvx));
+        __m128 d[C::COMPONENT_COUNT];
+        d[C::POS_X] = _mm_add_ps(_mm_add_ps(vx, _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(qw, uvx), uuvx))), p[C::POS_X]);
+        d[C::POS_Y] = _mm_add_ps(_mm_add_ps(vy, _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(qw, uvy), uuvy))), p[C::POS_Y]);
+        d[C::POS_Z] = _mm_add_ps(_mm_add_ps(vz, _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(qw, uvz), uuvz))), p[C::POS_Z]);
+
+        // orientation: parent orientation, or identity, times local orientation
+        qw = select(inherit_orientation, qw, one);
+        qx = _mm_and_ps(inherit_orientation, qx);
+        qy = _mm_and_ps(inherit_orientation, qy);
+        qz = _mm_and_ps(inherit_orientation, qz);
+        __m128 lw = l[C::ROT_W], lx = l[C::ROT_X], ly = l[C::ROT_Y], lz = l[C::ROT_Z];
+        d[C::ROT_W] = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(qw, lw), _mm_mul_ps(qx, lx)), _mm_mul_ps(qy, ly)),
+                                 _mm_mul_ps(qz, lz));
+        d[C::ROT_X] = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(qw, lx), _mm_mul_ps(qx, lw)), _mm_mul_ps(qy, lz)),
+                                 _mm_mul_ps(qz, ly));
+        d[C::ROT_Y] = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(qw, ly), _mm_mul_ps(qy, lw)), _mm_mul_ps(qz, lx)),
+                                 _mm_mul_ps(qx, lz));
+        d[C::ROT_Z] = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(qw, lz), _mm_mul_ps(qz, lw)), _mm_mul_ps(qx, ly)),
+                                 _mm_mul_ps(qy, lx));
+
+        // scale: parent scale, or one, times local scale
+        d[C::SCALE_X] = _mm_mul_ps(select(inherit_scale, p[C::SCALE_X], one), l[C::SCALE_X]);
+        d[C::SCALE_Y] = _mm_mul_ps(select(inherit_scale, p[C::SCALE_Y], one), l[C::SCALE_Y]);
+        d[C::SCALE_Z] = _mm_mul_ps(select(inherit_scale, p[C::SCALE_Z], one), l[C::SCALE_Z]);
+
+        for (int c = 0; c < C::COMPONENT_COUNT; ++c)
+            _mm_storeu_ps(batch.derived[c] + i, d[c]);
+
+        // world matrix, see make_world_matrix
+        __m128 x2 = _mm_add_ps(d[C::ROT_X], d[C::ROT_X]);
+        __m128 y2 = _mm_add_ps(d[C::ROT_Y], d[C::ROT_Y]);
+        __m128 z2 = _mm_add_ps(d[C::ROT_Z], d[C::ROT_Z]);
+        __m128 wx = _mm_mul_ps(x2, d[C::ROT_W]), wy = _mm_mul_ps(y2, d[C::ROT_W]), wz = _mm_mul_ps(z2, d[C::ROT_W]);
+        __m128 xx = _mm_mul_ps(x2, d[C::ROT_X]), xy = _mm_mul_ps(y2, d[C::ROT_X]), xz = _mm_mul_ps(z2, d[C::ROT_X]);
+        __m128 yy = _mm_mul_ps(y2, d[C::ROT_Y]), yz = _mm_mul_ps(z2, d[C::ROT_Y]), zz = _mm_mul_ps(z2, d[C::ROT_Z]);
+        __m128 sx = d[C::SCALE_X], sy = d[C::SCALE_Y], sz = d[C::SCALE_Z];
+
+        __m128 m[12];
+        m[0] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx);
+        m[1] = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+        m[2] = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+        m[3] = d[C::POS_X];
+        m[4] = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+        m[5] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy);
+        m[6] = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+        m[7] = d[C::POS_Y];
+        m[8] = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+        m[9] = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+        m[10] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz);
+        m[11] = d[C::POS_Z];
+        for (int r = 0; r < 12; ++r)
+            _mm_storeu_ps(batch.world[r] + i, m[r]);
+    }
+
+    update_transforms_scalar(batch, i, end);
+}
+
+} // namespace hyue
+
+#endif
@@ -0,0 +1,79 @@
+#include <hyue/PackArchiveFactory.h>
+#include <hyue/FileSystemArchiveFactory.h>
+
+#include <exception>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace hyue {
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: hyue_pack [options] <directory> <pack>\n"
+            "\n"
+            "Pack all the files below a directory into a pack archive.\n"
+            "\n"
+            "options:\n"
+            "  -s, --store        store all files uncompressed\n"
+            "  -a, --align <n>    alignment of stored files, a power of two (default %d)\n"
+            "  -H, --hidden       include hidden files\n",
+            HYUE_PACK_ALIGNMENT);
+}
+
+int main(int argc, char* argv[])
+{
+    PackWriter::Compression compression = PackWriter::LZ4;
+    size_t alignment = HYUE_PACK_ALIGNMENT;
+    const char* dir = nullptr;
+    const char* output = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (!strcmp(arg, "-s") || !strcmp(arg, "--store")) {
+            compression = PackWriter::STORE;
+        } else if ((!strcmp(arg, "-a") || !strcmp(arg, "--align")) && i + 1 < argc) {
+            alignment = strtoul(argv[++i], nullptr, 10);
+            if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+                fprintf(stderr, "hyue_pack: alignment must be a power of two\n");
+                return 1;
+            }
+        } else if (!strcmp(arg, "-H") || !strcmp(arg, "--hidden")) {
+            FileSystemArchiveFactory::set_ignore_hidden(false);
+        } else if (arg[0] == '-') {
+            usage();
+            return 1;
+        } else if (!dir) {
+            dir = arg;
+        } else if (!output) {
+            output = arg;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (!dir || !output) {
+        usage();
+        return 1;
+    }
+
+    try {
+        PackWriter writer(alignment);
+        size_t count = writer.add_directory(dir, compression);
+        size_t size = writer.write(output);
+        printf("%s: %zu files, %zu bytes\n", output, count, size);
+    } catch (const std::exception& e) {
+        fprintf(stderr, "hyue_pack: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace hyue
+
+int main(int argc, char* argv[])
+{
+    return hyue::main(argc, argv);
+}
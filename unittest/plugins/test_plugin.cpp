@@ -0,0 +1,80 @@
+#include <hyue/ArchiveManager.h>
+#include <hyue/Plugin.h>
+#include <hyue/StringUtils.h>
+
+// TEST_PLUGIN_NAME and TEST_PLUGIN_DEPENDENCIES are set per library by the build,
+// TEST_PLUGIN_THROW makes creating the plugin fail
+
+using namespace hyue;
+
+namespace {
+
+/// Archive factory registered by a test plugin, never creates anything
+class TestArchiveFactory : public ArchiveFactory {
+public:
+    explicit TestArchiveFactory(const String& type)
+        : type_(type)
+    {
+    }
+
+    const String& get_type(void) const override
+    {
+        return type_;
+    }
+
+    using ArchiveFactory::create_instance;
+
+    Archive* create_instance(const String&, bool) override
+    {
+        return nullptr;
+    }
+
+private:
+    String type_;
+};
+
+/// Registers the archive type "TestPlugin" + name, once its dependencies registered theirs
+class TestPlugin : public Plugin {
+public:
+    TestPlugin()
+        : name_(TEST_PLUGIN_NAME)
+        , factory_("TestPlugin" + name_)
+    {
+#ifdef TEST_PLUGIN_THROW
+        panic("plugin " + name_ + " can not be created");
+#endif
+    }
+
+    const String& get_name() const override
+    {
+        return name_;
+    }
+
+    StringVector get_dependencies() const override
+    {
+        String deps = TEST_PLUGIN_DEPENDENCIES;
+        return deps.empty() ? StringVector() : StringUtils::split(deps, ",");
+    }
+
+    void install() override
+    {
+        for (auto& dep : get_dependencies()) {
+            if (!ArchiveManager::get_singleton()->has_archive_factory("TestPlugin" + dep))
+                panic("plugin " + name_ + " installed before " + dep);
+        }
+        ArchiveManager::get_singleton()->add_archive_factory(&factory_);
+    }
+
+    void uninstall() override
+    {
+        ArchiveManager::get_singleton()->remove_archive_factory(factory_.get_type());
+    }
+
+private:
+    String name_;
+    TestArchiveFactory factory_;
+};
+
+} // namespace
+
+HYUE_PLUGIN(TestPlugin)
@@ -0,0 +1,255 @@
+#include <gtest/gtest.h>
+
+#include <hyue/AnimationClip.h>
+#include <hyue/simd.h>
+
+#include <cmath>
+#include <random>
+
+using namespace hyue;
+
+namespace {
+
+using C = TransformHierarchy;
+
+quat random_rotation(std::mt19937& rng)
+{
+    std::normal_distribution<float> normal;
+    quat q{normal(rng), normal(rng), normal(rng), normal(rng)};
+    float length = std::sqrt(q.a[0] * q.a[0] + q.a[1] * q.a[1] + q.a[2] * q.a[2] + q.a[3] * q.a[3]);
+    for (int c = 0; c < 4; ++c)
+        q.a[c] /= length;
+    return q;
+}
+
+/// Bones with keys at random times, rotations a quarter turn apart at most
+SkeletonAnimation random_animation(size_t bone_count, float length, bool scaled, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> unit(-1, 1);
+    SkeletonAnimation animation;
+    animation.length = length;
+    animation.tracks.resize(bone_count);
+    for (auto& track : animation.tracks) {
+        float time = 0;
+        quat rotation = random_rotation(rng);
+        while (time < length) {
+            TransformKey key;
+            key.time = time;
+            key.translate = {unit(rng) * 5, unit(rng) * 5, unit(rng) * 5};
+            // small turns from the previous key, with the sign flipped at random
+            float sign = rng() % 2 ? -1.0f : 1.0f;
+            for (int c = 0; c < 4; ++c)
+                key.rotation.a[c] = sign * (rotation.a[c] + unit(rng) * 0.3f);
+            float norm = std::sqrt(key.rotation.a[0] * key.rotation.a[0] + key.rotation.a[1] * key.rotation.a[1] +
+                                   key.rotation.a[2] * key.rotation.a[2] + key.rotation.a[3] * key.rotation.a[3]);
+            for (int c = 0; c < 4; ++c)
+                rotation.a[c] = key.rotation.a[c] /= norm;
+            if (scaled)
+                key.scale = {1 + unit(rng) * 0.5f, 1 + unit(rng) * 0.5f, 1 + unit(rng) * 0.5f};
+            track.push_back(key);
+            time += 0.1f + (unit(rng) + 1) * 0.2f;
+        }
+    }
+    return animation;
+}
+
+/// Bones swinging and bobbing with keys at 30 frames per second, as exported from a modelling tool
+SkeletonAnimation smooth_animation(size_t bone_count, float length)
+{
+    SkeletonAnimation animation;
+    animation.length = length;
+    animation.tracks.resize(bone_count);
+    for (size_t bone = 0; bone < bone_count; ++bone) {
+        float speed = 1 + float(bone % 5) * 0.5f;
+        for (int frame = 0; frame <= int(length * 30); ++frame) {
+            TransformKey key;
+            key.time = float(frame) / 30;
+            float phase = key.time * speed;
+            key.translate = {std::sin(phase), 0.5f * std::cos(phase), float(bone) * 0.1f};
+            float angle = 0.8f * std::sin(phase);
+            key.rotation = {std::cos(angle / 2), std::sin(angle / 2), 0, 0};
+            animation.tracks[bone].push_back(key);
+        }
+    }
+    return animation;
+}
+
+/// One array per TransformHierarchy component
+struct Pose {
+    std::vector<float> components[C::COMPONENT_COUNT];
+    float* outputs[C::COMPONENT_COUNT];
+
+    explicit Pose(size_t bone_count)
+    {
+        for (int c = 0; c < C::COMPONENT_COUNT; ++c) {
+            components[c].assign(bone_count, -100);
+            outputs[c] = components[c].data();
+        }
+    }
+};
+
+float rotation_angle(const quat& a, const quat& b)
+{
+    float dot = a.a[0] * b.a[0] + a.a[1] * b.a[1] + a.a[2] * b.a[2] + a.a[3] * b.a[3];
+    return 2 * std::acos(std::min(1.0f, std::abs(dot)));
+}
+
+} // namespace
+
+TEST(SkeletonAnimation, sample)
+{
+    SkeletonAnimation animation;
+    animation.length = 2;
+    animation.tracks.resize(2);
+    TransformKey key;
+    key.time = 0.5f;
+    key.translate = {1, 0, 0};
+    animation.tracks[0].push_back(key);
+    key.time = 1.5f;
+    key.translate = {3, 2, 0};
+    key.scale = {2, 2, 2};
+    // the same rotation as the first key with the opposite sign
+    key.rotation = {-1, 0, 0, 0};
+    animation.tracks[0].push_back(key);
+
+    TransformKey t = animation.sample(0, 1);
+    EXPECT_FLOAT_EQ(t.translate.a[0], 2);
+    EXPECT_FLOAT_EQ(t.translate.a[1], 1);
+    EXPECT_FLOAT_EQ(t.scale.a[2], 1.5f);
+    EXPECT_NEAR(rotation_angle(t.rotation, quat{1, 0, 0, 0}), 0, 1e-3f);
+
+    // clamped outside of the keys, wrapped past the length
+    EXPECT_FLOAT_EQ(animation.sample(0, 0.25f).translate.a[0], 1);
+    EXPECT_FLOAT_EQ(animation.sample(0, 1.75f).translate.a[0], 3);
+    EXPECT_FLOAT_EQ(animation.sample(0, 5).translate.a[0], 2);
+
+    // no keys is the identity
+    t = animation.sample(1, 1);
+    EXPECT_FLOAT_EQ(t.translate.a[0], 0);
+    EXPECT_FLOAT_EQ(t.rotation.a[0], 1);
+    EXPECT_FLOAT_EQ(t.scale.a[1], 1);
+}
+
+TEST(AnimationClip, bake_uniform)
+{
+    std::mt19937 rng(3);
+    SkeletonAnimation animation = random_animation(20, 2, true, rng);
+    AnimationBakeOptions options;
+    options.sample_rate = 100;
+    options.reduce_frames = false;
+
+    AnimationClip clip;
+    clip.bake(animation, options);
+    EXPECT_EQ(clip.get_bone_count(), 20u);
+    EXPECT_FLOAT_EQ(clip.get_length(), 2);
+    EXPECT_EQ(clip.get_frame_count(), 201u);
+    EXPECT_TRUE(clip.has_scale());
+
+    // on a frame only the quantization is left
+    Pose pose(20);
+    for (float time : {0.0f, 0.5f, 1.27f, 2.0f}) {
+        clip.sample(time, pose.outputs);
+        for (size_t bone = 0; bone < 20; ++bone) {
+            TransformKey key = animation.sample(bone, time);
+            for (int c = 0; c < 3; ++c) {
+                EXPECT_NEAR(pose.components[C::POS_X + c][bone], key.translate.a[c], 1e-3f);
+                EXPECT_NEAR(pose.components[C::SCALE_X + c][bone], key.scale.a[c], 1e-4f);
+            }
+            quat q{pose.components[C::ROT_W][bone], pose.components[C::ROT_X][bone], pose.components[C::ROT_Y][bone],
+                   pose.components[C::ROT_Z][bone]};
+            EXPECT_NEAR(rotation_angle(q, key.rotation), 0, 1e-3f);
+        }
+    }
+}
+
+TEST(AnimationClip, reduce_frames)
+{
+    // a bone moving at constant speed and a bone standing still
+    SkeletonAnimation animation;
+    animation.length = 4;
+    animation.tracks.resize(2);
+    for (int i = 0; i <= 4; ++i) {
+        TransformKey key;
+        key.time = float(i);
+        key.translate = {float(i) * 2, 1, -float(i)};
+        animation.tracks[0].push_back(key);
+    }
+    TransformKey key;
+    key.translate = {5, 5, 5};
+    animation.tracks[1].push_back(key);
+
+    AnimationClip clip;
+    clip.bake(animation, AnimationBakeOptions());
+    EXPECT_EQ(clip.get_frame_count(), 2u);
+    EXPECT_FALSE(clip.has_scale());
+    // 2 frames of 8 bones, rotations and translations, and translation ranges only
+    EXPECT_EQ(clip.get_memory_size(), 2 * sizeof(float) + 2 * 8 * 7 * sizeof(uint16_t) + 2 * 3 * 8 * sizeof(float));
+
+    Pose pose(2);
+    clip.sample(1.5f, pose.outputs);
+    EXPECT_NEAR(pose.components[C::POS_X][0], 3, 1e-3f);
+    EXPECT_NEAR(pose.components[C::POS_Y][0], 1, 1e-3f);
+    EXPECT_NEAR(pose.components[C::POS_Z][0], -1.5f, 1e-3f);
+    EXPECT_FLOAT_EQ(pose.components[C::POS_X][1], 5);
+    EXPECT_FLOAT_EQ(pose.components[C::ROT_W][1], 1);
+    for (int c = 0; c < 3; ++c)
+        EXPECT_EQ(pose.components[C::SCALE_X + c][0], 1);
+
+    // a change of direction keeps the key it happens on
+    animation.tracks[0][4].translate = {0, 0, 0};
+    clip.bake(animation, AnimationBakeOptions());
+    EXPECT_EQ(clip.get_frame_count(), 3u);
+}
+
+TEST(AnimationClip, simd_levels)
+{
+    // not a multiple of 8 bones, so every kernel has a scalar tail
+    const size_t bone_count = 37;
+    std::mt19937 rng(11);
+    AnimationClip clip;
+    clip.bake(random_animation(bone_count, 3, true, rng), AnimationBakeOptions());
+
+    std::vector<float> times;
+    std::uniform_real_distribution<float> time(0, 7);
+    for (int i = 0; i < 50; ++i)
+        times.push_back(time(rng));
+
+    set_max_simd_level(SimdLevel::NONE);
+    std::vector<Pose> expected;
+    for (float t : times) {
+        expected.emplace_back(bone_count);
+        clip.sample(t, expected.back().outputs);
+    }
+
+    for (auto level : {SimdLevel::SSE2, SimdLevel::AVX2}) {
+        set_max_simd_level(level);
+        if (get_simd_level() != level)
+            continue;
+        SCOPED_TRACE(int(level));
+        for (size_t i = 0; i < times.size(); ++i) {
+            Pose pose(bone_count);
+            clip.sample(times[i], pose.outputs);
+            for (int c = 0; c < C::COMPONENT_COUNT; ++c) {
+                for (size_t bone = 0; bone < bone_count; ++bone)
+                    EXPECT_NEAR(pose.components[c][bone], expected[i].components[c][bone], 1e-5f);
+            }
+        }
+    }
+    set_max_simd_level(SimdLevel::AVX2);
+}
+
+TEST(AnimationClip, report)
+{
+    SkeletonAnimation animation = smooth_animation(60, 4);
+    AnimationClip clip;
+    clip.bake(animation, AnimationBakeOptions());
+    EXPECT_FALSE(clip.has_scale());
+
+    AnimationCompressionReport report = clip.get_report(animation);
+    EXPECT_EQ(report.clip_frames, clip.get_frame_count());
+    EXPECT_EQ(report.clip_bytes, clip.get_memory_size());
+    EXPECT_GT(report.ratio, 1);
+    EXPECT_LT(report.max_translation_error, 5e-3f);
+    EXPECT_LT(report.max_rotation_error, 5e-3f);
+    EXPECT_EQ(report.max_scale_error, 0);
+}
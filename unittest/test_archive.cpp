@@ -2,9 +2,12 @@
 
 #include <hyue/FileSystemArchiveFactory.h>
 #include <hyue/ZipArchiveFactory.h>
+#include <hyue/ArchiveManager.h>
 
 #include <hyue/StringUtils.h>
 
+#include <fstream>
+
 using namespace hyue;
 
 TEST(FileSystemArchive, open)
@@ -22,6 +25,33 @@ TEST(FileSystemArchive, open)
     factory.destroy_instance(archive);
 }
 
+TEST(FileSystemArchive, open_mapped)
+{
+    FileSystemArchiveFactory factory;
+    auto archive = factory.create_instance(UNITTEST_DIR, true);
+
+    archive->load();
+
+    auto threshold = FileSystemArchiveFactory::get_mmap_threshold();
+
+    FileSystemArchiveFactory::set_mmap_threshold(std::numeric_limits<size_t>::max());
+    auto file_stream = archive->open("CMakeLists.txt");
+    EXPECT_EQ(std::dynamic_pointer_cast<MappedFileDataStream>(file_stream), nullptr);
+
+    FileSystemArchiveFactory::set_mmap_threshold(0);
+    auto mapped_stream = std::dynamic_pointer_cast<MappedFileDataStream>(archive->open("CMakeLists.txt"));
+    EXPECT_NE(mapped_stream, nullptr);
+    EXPECT_EQ(mapped_stream->get_size(), file_stream->get_size());
+    EXPECT_EQ(String((const char*)mapped_stream->get_ptr(), mapped_stream->get_size()),
+              file_stream->get_as_string());
+
+    FileSystemArchiveFactory::set_mmap_threshold(threshold);
+
+    archive->unload();
+
+    factory.destroy_instance(archive);
+}
+
 TEST(FileSystemArchive, create)
 {
     {
@@ -114,6 +144,143 @@ TEST(FileSystemArchive, exists)
     factory.destroy_instance(archive);
 }
 
+TEST(FileSystemArchive, exists_after_create_remove)
+{
+    auto dir = std_fs::temp_directory_path() / "hyue_test_archive_index";
+    std_fs::remove_all(dir);
+    std_fs::create_directories(dir / "sub");
+
+    FileSystemArchiveFactory factory;
+    auto archive = factory.create_instance(dir, false);
+
+    archive->load();
+
+    EXPECT_TRUE(archive->exists("sub"));
+    EXPECT_FALSE(archive->exists("sub/new.txt"));
+
+    archive->create("sub/new.txt")->write("hello", 5);
+    EXPECT_TRUE(archive->exists("sub/new.txt"));
+    EXPECT_TRUE(archive->exists("./sub/../sub/new.txt"));
+    EXPECT_EQ(archive->find("*/sub/*.txt").size(), 1);
+    EXPECT_EQ(archive->find("*.txt", false).size(), 0);
+
+    archive->remove("sub/new.txt");
+    EXPECT_FALSE(archive->exists("sub/new.txt"));
+    EXPECT_EQ(archive->find("*.txt").size(), 0);
+
+    archive->unload();
+
+    factory.destroy_instance(archive);
+    std_fs::remove_all(dir);
+}
+
+namespace {
+
+/// Make a tree of 8 directories holding 5 files and a subdirectory with 3 more
+FilePath make_tree(const String& name)
+{
+    auto dir = std_fs::temp_directory_path() / name;
+    std_fs::remove_all(dir);
+    for (int d = 0; d < 8; ++d) {
+        auto sub = dir / ("d" + std::to_string(d)) / "sub";
+        std_fs::create_directories(sub);
+        for (int f = 0; f < 5; ++f)
+            std::ofstream(sub.parent_path() / ("f" + std::to_string(f) + ".txt")) << "file";
+        for (int f = 0; f < 3; ++f)
+            std::ofstream(sub / ("g" + std::to_string(f) + ".txt")) << "file";
+    }
+    std::ofstream(dir / "root.txt") << "root";
+    std_fs::create_directories(dir / ".hidden");
+    std::ofstream(dir / ".hidden" / "h.txt") << "hidden";
+    return dir;
+}
+
+/// Date back every directory of a tree, so the listing cache trusts their modification times
+void age_directories(const FilePath& dir)
+{
+    auto old = std_fs::file_time_type::clock::now() - std::chrono::hours(1);
+    std_fs::last_write_time(dir, old);
+    for (const auto& entry : std_fs::recursive_directory_iterator(dir)) {
+        if (entry.is_directory())
+            std_fs::last_write_time(entry.path(), old);
+    }
+}
+
+size_t get_listed_size(Archive* archive, const String& pattern)
+{
+    auto infos = archive->find_file_info(pattern);
+    return infos.size() == 1 ? infos[0].uncompressed_size : 0;
+}
+
+} // namespace
+
+TEST(FileSystemArchive, scan_tree)
+{
+    auto dir = make_tree("hyue_test_scan_tree");
+
+    FileSystemArchiveFactory factory;
+    auto archive = factory.create_instance(dir, true);
+    archive->load();
+
+    EXPECT_EQ(archive->list().size(), 8 * (5 + 3) + 1);
+    EXPECT_EQ(archive->list(true, true).size(), 16);
+    EXPECT_EQ(archive->list(false).size(), 1);
+    EXPECT_TRUE(archive->exists("d7/sub/g2.txt"));
+    EXPECT_FALSE(archive->exists(".hidden/h.txt"));
+    EXPECT_EQ(archive->find("*/d3/f*.txt").size(), 5);
+    EXPECT_EQ(get_listed_size(archive, "*/root.txt"), 4);
+
+    archive->unload();
+    factory.destroy_instance(archive);
+    std_fs::remove_all(dir);
+}
+
+TEST(FileSystemArchive, listing_cache)
+{
+    auto dir = make_tree("hyue_test_listing_cache");
+    auto cache_dir = std_fs::temp_directory_path() / "hyue_test_listing_cache_dir";
+    std_fs::remove_all(cache_dir);
+    age_directories(dir);
+    FileSystemArchiveFactory::set_listing_cache_dir(cache_dir.string());
+
+    FileSystemArchiveFactory factory;
+    auto archive = factory.create_instance(dir, true);
+    archive->load();
+    EXPECT_EQ(archive->list().size(), 8 * (5 + 3) + 1);
+    EXPECT_EQ(std::distance(std_fs::directory_iterator(cache_dir), std_fs::directory_iterator()), 1);
+
+    // rewriting a file does not touch its directory, the cached size is kept
+    std::ofstream(dir / "d0" / "f0.txt") << "longer contents";
+    archive->load();
+    EXPECT_EQ(get_listed_size(archive, "*/d0/f0.txt"), 4);
+
+    // adding a file does, the directory is scanned again
+    std::ofstream(dir / "d0" / "new.txt") << "new";
+    archive->load();
+    EXPECT_TRUE(archive->exists("d0/new.txt"));
+    EXPECT_EQ(get_listed_size(archive, "*/d0/f0.txt"), 15);
+    EXPECT_EQ(archive->list().size(), 8 * (5 + 3) + 2);
+
+    // removed trees disappear
+    std_fs::remove_all(dir / "d1");
+    archive->load();
+    EXPECT_FALSE(archive->exists("d1/f0.txt"));
+    EXPECT_FALSE(archive->exists("d1/sub"));
+    EXPECT_EQ(archive->list().size(), 7 * (5 + 3) + 2);
+
+    // a fresh archive on the same tree reads the same listing
+    auto other = factory.create_instance(dir, true);
+    other->load();
+    EXPECT_EQ(other->list().size(), archive->list().size());
+    factory.destroy_instance(other);
+
+    archive->unload();
+    factory.destroy_instance(archive);
+    FileSystemArchiveFactory::set_listing_cache_dir("");
+    std_fs::remove_all(cache_dir);
+    std_fs::remove_all(dir);
+}
+
 TEST(ZipArchiveFactory, non_exists)
 {
     ZipArchiveFactory factory;
@@ -153,6 +320,10 @@ TEST(ZipArchiveFactory, find)
     EXPECT_EQ(archive->find("a/*.txt").size(), 0);
     EXPECT_EQ(archive->find("*a/*.txt").size(), 1);
     EXPECT_EQ(archive->find("*").size(), 2);
+    EXPECT_EQ(archive->find("test/a/*").size(), 1);
+    EXPECT_EQ(archive->find("test/a/1.txt").size(), 1);
+    EXPECT_EQ(archive->find("test/a/1.txt", false).size(), 0);
+    EXPECT_EQ(archive->find("test/*", true, true).size(), 2);
 
     archive->unload();
     factory.destroy_instance(archive);
@@ -165,6 +336,7 @@ TEST(ZipArchiveFactory, open)
     archive->load();
 
     EXPECT_EQ(archive->open("test.txt"), nullptr);
+    EXPECT_EQ(archive->open("test/a"), nullptr);
     EXPECT_NE(archive->open("test/a/1.txt"), nullptr);
 
     auto data_stream = archive->open("test/a/1.txt");
@@ -177,4 +349,164 @@ TEST(ZipArchiveFactory, open)
 
     archive->unload();
     factory.destroy_instance(archive);
-}
\ No newline at end of file
+}
+
+TEST(ZipArchiveFactory, open_stored)
+{
+    ZipArchiveFactory factory;
+    auto archive = factory.create_instance(UNITTEST_DIR "/test.zip");
+    archive->load();
+
+    // stored entries are read in place from the archive
+    auto data_stream = archive->open("test/a/1.txt");
+    auto view = std::dynamic_pointer_cast<DataStreamView>(data_stream);
+    ASSERT_NE(view, nullptr);
+    EXPECT_EQ(data_stream->get_size(), 12);
+    EXPECT_EQ(memcmp(view->get_ptr(), "hello", 5), 0);
+
+    auto other = archive->open("test/a/1.txt");
+    EXPECT_EQ(std::dynamic_pointer_cast<DataStreamView>(other)->get_ptr(), view->get_ptr());
+    data_stream->skip(7);
+    EXPECT_EQ(other->tell(), 0);
+
+    // views outlive the archive they were opened from
+    archive->unload();
+    factory.destroy_instance(archive);
+
+    EXPECT_EQ(data_stream->get_line(), "yue!");
+    EXPECT_EQ(other->get_as_string(), "hello, yue!\n");
+}
+
+TEST(ZipArchiveFactory, open_streamed)
+{
+    auto threshold = ZipArchiveFactory::get_stream_threshold();
+    ZipArchiveFactory::set_stream_threshold(0);
+
+    ZipArchiveFactory factory;
+    auto archive = factory.create_instance(UNITTEST_DIR "/test_deflated.zip");
+    archive->load();
+
+    auto data_stream = archive->open("test/a/1.txt");
+    EXPECT_EQ(std::dynamic_pointer_cast<MemoryDataStream>(data_stream), nullptr);
+    EXPECT_EQ(data_stream->get_size(), 12);
+
+    char buf[6] = {};
+    EXPECT_EQ(data_stream->read(buf, 5), 5);
+    EXPECT_EQ(String(buf), "hello");
+    data_stream->skip(-3);
+    EXPECT_EQ(data_stream->tell(), 2);
+    data_stream->skip(-10);
+    EXPECT_EQ(data_stream->tell(), 0);
+    data_stream->skip(2);
+    EXPECT_EQ(data_stream->get_line(), "llo, yue!");
+    EXPECT_TRUE(data_stream->is_eof());
+    EXPECT_EQ(data_stream->get_as_string(), "hello, yue!\n");
+
+    // streams outlive the archive they were opened from
+    archive->unload();
+    factory.destroy_instance(archive);
+
+    data_stream->seek(7);
+    EXPECT_EQ(data_stream->get_line(), "yue!");
+
+    ZipArchiveFactory::set_stream_threshold(threshold);
+}
+
+TEST(ArchiveManager, mount)
+{
+    auto dir = std_fs::temp_directory_path() / "hyue_test_archive_mount";
+    std_fs::remove_all(dir);
+    std_fs::create_directories(dir / "base/a");
+    std_fs::create_directories(dir / "patch/a");
+    std::ofstream(dir / "base/a/1.txt") << "base";
+    std::ofstream(dir / "base/2.txt") << "base";
+    std::ofstream(dir / "patch/a/1.txt") << "patch";
+
+    FileSystemArchiveFactory file_system_factory;
+    ZipArchiveFactory zip_factory;
+    ArchiveManager manager;
+    manager.add_archive_factory(&file_system_factory);
+    manager.add_archive_factory(&zip_factory);
+
+    auto patch = manager.mount((dir / "patch").string(), "FileSystem", "", 1);
+    auto base = manager.mount((dir / "base").string(), "FileSystem");
+    auto zip = manager.mount(UNITTEST_DIR "/test.zip", "Zip", "/zip/");
+
+    EXPECT_EQ(manager.find_archive("a/1.txt"), patch);
+    EXPECT_EQ(manager.find_archive("/a/./1.txt"), patch);
+    EXPECT_EQ(manager.find_archive("2.txt"), base);
+    EXPECT_EQ(manager.find_archive("zip/test/a/1.txt"), zip);
+    EXPECT_FALSE(manager.exists("test/a/1.txt"));
+    EXPECT_FALSE(manager.exists("a"));
+
+    EXPECT_EQ(manager.open("a/1.txt")->get_as_string(), "patch");
+    EXPECT_EQ(manager.open("2.txt")->get_as_string(), "base");
+    EXPECT_EQ(manager.open("zip/test/a/1.txt")->get_as_string(), "hello, yue!\n");
+    EXPECT_EQ(manager.open("non_exists.txt"), nullptr);
+
+    // the base archive takes over once the patch is gone
+    manager.unload(patch);
+    EXPECT_EQ(manager.open("a/1.txt")->get_as_string(), "base");
+
+    // base mounted again under zip/ with a higher priority goes on top of
+    // the zip, which still serves the files base does not have
+    manager.mount(base, "zip", 1);
+    EXPECT_EQ(manager.find_archive("zip/2.txt"), base);
+    EXPECT_EQ(manager.find_archive("zip/test/a/1.txt"), zip);
+
+    manager.unmount(zip);
+    EXPECT_FALSE(manager.exists("zip/test/a/1.txt"));
+    EXPECT_TRUE(manager.exists("zip/2.txt"));
+
+    std_fs::remove_all(dir);
+}
+
+TEST(ArchiveManager, mount_folder_named_as_archive)
+{
+    std::ifstream file(UNITTEST_DIR "/test.zip", std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    // the top folder of test.zip is "test" too
+    EmbeddedZipArchiveFactory::add_embbedded_file("test", data.data(), data.size());
+
+    EmbeddedZipArchiveFactory embedded_zip_factory;
+    ArchiveManager manager;
+    manager.add_archive_factory(&embedded_zip_factory);
+    auto zip = manager.mount("test", "EmbeddedZip");
+
+    EXPECT_EQ(manager.find_archive("test/a/1.txt"), zip);
+    EXPECT_FALSE(manager.exists("a/1.txt"));
+    auto stream = manager.open("test/a/1.txt");
+    ASSERT_NE(stream, nullptr);
+    EXPECT_EQ(stream->get_as_string(), "hello, yue!\n");
+
+    stream.reset();
+    manager.unload(zip);
+    EmbeddedZipArchiveFactory::remove_embbedded_file("test");
+}
+
+TEST(Archive, open_batch_async)
+{
+    FileSystemArchiveFactory file_system_factory;
+    auto file_system = file_system_factory.create_instance(UNITTEST_DIR, true);
+    file_system->load();
+
+    ZipArchiveFactory zip_factory;
+    auto zip = zip_factory.create_instance(UNITTEST_DIR "/test.zip");
+    zip->load();
+
+    auto files = file_system->open_batch_async({"CMakeLists.txt", "test.zip", "non_exists.txt"});
+    auto entry = zip->open_async("test/a/1.txt");
+
+    ASSERT_EQ(files.size(), 3);
+    auto cmake_lists = files[0].get();
+    ASSERT_NE(cmake_lists, nullptr);
+    EXPECT_EQ(cmake_lists->get_as_string(), file_system->open("CMakeLists.txt")->get_as_string());
+    EXPECT_EQ(files[1].get()->get_size(), std_fs::file_size(UNITTEST_DIR "/test.zip"));
+    EXPECT_EQ(files[2].get(), nullptr);
+    EXPECT_EQ(entry.get()->get_as_string(), "hello, yue!\n");
+
+    zip->unload();
+    zip_factory.destroy_instance(zip);
+    file_system->unload();
+    file_system_factory.destroy_instance(file_system);
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <hyue/ASTCCodec.h>
+#include <hyue/thread.h>
+
+using namespace hyue;
+
+#define MEDIA_DIR UNITTEST_DIR "/../Tests/Media/"
+
+namespace {
+
+std::vector<uint8_t> decompress(const uint8_t* block, PixelFormat format, int width, int height)
+{
+    PixelBox src(width, height, 1, format, const_cast<uint8_t*>(block));
+    std::vector<uint8_t> ret(width * height * 4);
+    PixelBox dst(width, height, 1, PixelFormat::BYTE_RGBA, ret.data());
+    PixelUtil::decompress(&src, &dst);
+    return ret;
+}
+
+const uint8_t g_magenta[4] = {255, 0, 255, 255};
+
+} // namespace
+
+TEST(ASTCCodec, void_extent_block)
+{
+    // constant colour with 16 bit channels, the extent covers everything
+    const uint8_t block[16] = {0xfc, 0xfd, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                               0xff, 0xff, 0x00, 0x80, 0x00, 0x00, 0xff, 0xff};
+    const uint8_t expected[4] = {255, 128, 0, 255};
+
+    auto pixels = decompress(block, PixelFormat::ASTC_RGBA_6X5_LDR, 6, 5);
+    for (size_t i = 0; i < 6 * 5; ++i)
+        EXPECT_EQ(0, memcmp(&pixels[i * 4], expected, 4)) << i;
+
+    // reserved block mode
+    const uint8_t reserved[16] = {};
+    pixels = decompress(reserved, PixelFormat::ASTC_RGBA_4X4_LDR, 4, 4);
+    for (size_t i = 0; i < 4 * 4; ++i)
+        EXPECT_EQ(0, memcmp(&pixels[i * 4], g_magenta, 4)) << i;
+}
+
+TEST(ASTCCodec, rgb_block)
+{
+    // single partition RGB end points, weights quantised to quints without bits
+    const uint8_t block[16] = {0x36, 0x01, 0x85, 0x61, 0x37, 0x24, 0x0d, 0xf0,
+                               0xed, 0x00, 0x18, 0x1f, 0x00, 0xe1, 0x0b, 0x00};
+    const uint8_t e0[4] = {13, 56, 78, 255}, e1[4] = {253, 250, 247, 255}, mid[4] = {0xdc, 0xdf, 0xe0, 255};
+
+    auto pixels = decompress(block, PixelFormat::ASTC_RGBA_10X6_LDR, 10, 6);
+    EXPECT_EQ(0, memcmp(&pixels[0], e0, 4));
+    EXPECT_EQ(0, memcmp(&pixels[9 * 4], e1, 4));
+    EXPECT_EQ(0, memcmp(&pixels[(2 * 10 + 5) * 4], mid, 4));
+}
+
+TEST(ASTCCodec, decode_file)
+{
+    auto stream = MappedFileDataStream::open(MEDIA_DIR "Earth-Color10x6.astc");
+    ASSERT_TRUE(stream);
+    Image image;
+    ASTCCodec::decode(stream, &image);
+    EXPECT_EQ(image.get_format(), PixelFormat::ASTC_RGBA_10X6_LDR);
+    EXPECT_EQ(image.get_width(), 1024u);
+    EXPECT_EQ(image.get_height(), 512u);
+    EXPECT_EQ(image.get_size(), 103u * 86u * 16u);
+
+    Image serial = image;
+    PixelBox src = serial.get_pixel_box();
+    std::vector<uint8_t> expected(1024 * 512 * 4);
+    PixelBox dst(1024, 512, 1, PixelFormat::BYTE_RGBA, expected.data());
+    PixelUtil::decompress(&src, &dst);
+
+    image.decompress(&ThreadPool::get_worker_pool());
+    ASSERT_EQ(image.get_format(), PixelFormat::BYTE_RGBA);
+    ASSERT_EQ(image.get_size(), expected.size());
+    EXPECT_EQ(0, memcmp(image.get_data(), expected.data(), expected.size()));
+
+    // the encoder produced no blocks the decoder rejects
+    size_t errors = 0;
+    for (size_t i = 0; i < expected.size(); i += 4)
+        errors += memcmp(&expected[i], g_magenta, 4) == 0;
+    EXPECT_EQ(errors, 0u);
+
+    // ocean
+    const uint8_t ocean[4] = {13, 55, 79, 255};
+    EXPECT_EQ(0, memcmp(&expected[(200 * 1024 + 10) * 4], ocean, 4));
+}
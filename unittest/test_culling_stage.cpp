@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <hyue/CullingStage.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "test_executor.h"
+
+using namespace hyue;
+
+namespace {
+
+/// OpenGL style perspective projection of a camera at eye looking down -z
+mat4 perspective(float fovy, float aspect, float near, float far, const vec3& eye)
+{
+    float f = 1 / std::tan(fovy / 2);
+    mat4 m = {{{f / aspect, 0, 0, 0},
+               {0, f, 0, 0},
+               {0, 0, (far + near) / (near - far), 2 * far * near / (near - far)},
+               {0, 0, -1, 0}}};
+    // translate by -eye
+    for (int r = 0; r < 4; ++r)
+        m.a[r][3] -= m.a[r][0] * eye.a[0] + m.a[r][1] * eye.a[1] + m.a[r][2] * eye.a[2];
+    return m;
+}
+
+mat4 identity()
+{
+    return {{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}}};
+}
+
+} // namespace
+
+TEST(Frustum, from_view_projection)
+{
+    // the clip cube itself
+    Frustum cube = Frustum::from_view_projection(identity());
+    EXPECT_TRUE(cube.is_visible(vec3{0, 0, 0}, vec3{0.1f, 0.1f, 0.1f}));
+    EXPECT_TRUE(cube.is_visible(vec3{1.5f, 0, 0}, vec3{0.6f, 0.1f, 0.1f}));
+    EXPECT_FALSE(cube.is_visible(vec3{1.5f, 0, 0}, vec3{0.4f, 0.1f, 0.1f}));
+    EXPECT_FALSE(cube.is_visible(vec3{0, -3, 0}, vec3{1, 1, 1}));
+    EXPECT_FALSE(cube.is_visible(vec3{0, 0, 2}, vec3{0.5f, 0.5f, 0.5f}));
+    EXPECT_NEAR(cube.planes[Frustum::PLANE_RIGHT].get_distance(vec3{0.5f, 0, 0}), 0.5f, 1e-6f);
+
+    Frustum camera = Frustum::from_view_projection(perspective(1.5707964f, 1, 1, 100, vec3{0, 0, 10}));
+    EXPECT_NEAR(camera.planes[Frustum::PLANE_NEAR].get_distance(vec3{0, 0, 0}), 9, 1e-4f);
+    EXPECT_NEAR(camera.planes[Frustum::PLANE_FAR].get_distance(vec3{0, 0, 0}), 90, 1e-3f);
+    EXPECT_TRUE(camera.is_visible(vec3{0, 0, 0}, vec3{1, 1, 1}));
+    EXPECT_TRUE(camera.is_visible(vec3{9, 0, 0}, vec3{0.1f, 0.1f, 0.1f}));
+    EXPECT_FALSE(camera.is_visible(vec3{11, 0, 0}, vec3{0.1f, 0.1f, 0.1f}));
+    EXPECT_FALSE(camera.is_visible(vec3{0, 0, 20}, vec3{1, 1, 1}));
+    EXPECT_FALSE(camera.is_visible(vec3{0, 0, -100}, vec3{1, 1, 1}));
+}
+
+TEST(CullingStage, set_bounds)
+{
+    CullingStage stage;
+    stage.resize(2);
+    stage.set_bounds(0, vec3{-1, 0, 2}, vec3{3, 2, 4});
+    vec3 center, half_size;
+    stage.get_bounds(0, &center, &half_size);
+    EXPECT_TRUE(center == (vec3{1, 1, 3}));
+    EXPECT_TRUE(half_size == (vec3{2, 1, 1}));
+
+    // a unit cube rotated by 45 degrees around z, then moved
+    const float s = std::sqrt(0.5f);
+    mat4 world = {{{s, -s, 0, 5}, {s, s, 0, 6}, {0, 0, 2, 7}, {0, 0, 0, 1}}};
+    stage.set_bounds(1, vec3{-1, -1, -1}, vec3{1, 1, 1}, world);
+    stage.get_bounds(1, &center, &half_size);
+    EXPECT_TRUE(center == (vec3{5, 6, 7}));
+    EXPECT_NEAR(half_size.a[0], 2 * s, 1e-6f);
+    EXPECT_NEAR(half_size.a[1], 2 * s, 1e-6f);
+    EXPECT_NEAR(half_size.a[2], 2, 1e-6f);
+
+    // new objects are never visible
+    EXPECT_EQ(stage.get_visibility_flags(1), 0u);
+}
+
+TEST(CullingStage, cull)
+{
+    const size_t count = 100003;
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> pos(-100, 100);
+    std::uniform_real_distribution<float> size(0, 3);
+
+    CullingStage stage;
+    stage.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        vec3 min{pos(rng), pos(rng), pos(rng)};
+        vec3 max{min.a[0] + size(rng), min.a[1] + size(rng), min.a[2] + size(rng)};
+        stage.set_bounds(i, min, max);
+        stage.set_visibility_flags(i, 1u << (rng() % 4));
+    }
+
+    const Frustum frustums[] = {
+        Frustum::from_view_projection(perspective(1.0f, 1.5f, 1, 120, vec3{0, 0, 50})),
+        Frustum::from_view_projection(perspective(0.3f, 1, 10, 300, vec3{20, -10, 150})),
+        Frustum::from_view_projection(identity()),
+    };
+    const uint32_t mask = 0x7;
+
+    // brute force
+    std::vector<uint32_t> expected[3];
+    for (size_t i = 0; i < count; ++i) {
+        if (!(stage.get_visibility_flags(i) & mask))
+            continue;
+        vec3 center, half_size;
+        stage.get_bounds(i, &center, &half_size);
+        for (int f = 0; f < 3; ++f) {
+            if (frustums[f].is_visible(center, half_size))
+                expected[f].push_back(uint32_t(i));
+        }
+    }
+    EXPECT_GT(expected[0].size(), 1000u);
+    EXPECT_LT(expected[0].size(), count / 2);
+    EXPECT_GT(expected[2].size(), 0u);
+
+    const SimdLevel levels[] = {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2};
+    for (auto level : levels) {
+        set_max_simd_level(level);
+        if (get_simd_level() != level)
+            continue;
+        SCOPED_TRACE(int(level));
+
+        CountingExecutor executor;
+        std::vector<uint32_t> visible[3];
+        stage.cull(frustums, 3, mask, visible, &executor);
+        EXPECT_GT(executor.jobs, 1u);
+        for (int f = 0; f < 3; ++f)
+            EXPECT_EQ(visible[f], expected[f]) << f;
+
+        // on the worker pool, reusing the lists
+        stage.cull(frustums[1], mask, &visible[0]);
+        EXPECT_EQ(visible[0], expected[1]);
+    }
+    set_max_simd_level(SimdLevel::AVX2);
+
+    // a small stage runs in one range
+    CullingStage small;
+    small.resize(3);
+    small.set_bounds(0, vec3{-1, -1, -1}, vec3{1, 1, 1});
+    small.set_bounds(1, vec3{5, 5, 5}, vec3{6, 6, 6});
+    small.set_bounds(2, vec3{0, 0, 0}, vec3{0, 0, 0});
+    small.set_visibility_flags(0, 1);
+    small.set_visibility_flags(1, 1);
+    CountingExecutor executor;
+    std::vector<uint32_t> visible;
+    small.cull(frustums[2], 1, &visible, &executor);
+    EXPECT_EQ(executor.jobs, 0u);
+    EXPECT_EQ(visible, std::vector<uint32_t>({0}));
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <hyue/DataStream.h>
+
+#include <atomic>
+#include <thread>
+
+#include <string.h>
+
+using namespace hyue;
+
+namespace {
+
+MemoryDataStreamPtr make_stream(const String& contents)
+{
+    auto ret = std::make_shared<MemoryDataStream>("contents", contents.size());
+    memcpy(ret->get_ptr(), contents.data(), contents.size());
+    return ret;
+}
+
+} // namespace
+
+TEST(DataStreamView, slice)
+{
+    auto parent = make_stream("header\nfirst line\nsecond line\ntrailer");
+    parent->seek(3);
+
+    auto view = std::make_shared<DataStreamView>("lines", parent, 7, 23);
+    EXPECT_EQ(view->get_size(), 23);
+    EXPECT_EQ(view->get_ptr(), parent->get_ptr() + 7);
+    EXPECT_FALSE(view->is_writeable());
+
+    EXPECT_EQ(view->get_line(), "first line");
+    EXPECT_EQ(view->tell(), 11);
+    EXPECT_EQ(view->get_line(), "second line");
+    EXPECT_TRUE(view->is_eof());
+    view->seek(6);
+    EXPECT_EQ(view->get_line(), "line");
+    EXPECT_EQ(view->get_as_string(), "first line\nsecond line\n");
+
+    // the parent position is independent
+    EXPECT_EQ(parent->tell(), 3);
+}
+
+TEST(DataStreamView, nested)
+{
+    auto parent = make_stream("0123456789");
+    auto view = std::make_shared<DataStreamView>("outer", parent, 2, 6);
+    auto inner = std::make_shared<DataStreamView>("inner", view, 1, 3);
+
+    // closing the outer view does not release the memory of the inner one
+    view->close();
+    parent.reset();
+    EXPECT_EQ(inner->get_as_string(), "345");
+}
+
+TEST(DataStreamView, concurrent_reads)
+{
+    String contents;
+    for (int i = 0; i < 4096; ++i)
+        contents += char('a' + i % 26);
+    auto parent = make_stream(contents);
+
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int r = 0; r < 100; ++r) {
+                size_t offset = size_t(t * 512 + r);
+                DataStreamView view("slice", parent, offset, 256);
+                char buf[256];
+                view.skip(128);
+                view.read(buf, 128);
+                view.seek(0);
+                view.read(buf, 128);
+                if (memcmp(buf, contents.data() + offset, 128) != 0 || view.tell() != 128)
+                    ++failures;
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(failures, 0);
+}
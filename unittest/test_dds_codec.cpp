@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <hyue/DDSCodec.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
+
+#include <cmath>
+#include <random>
+
+using namespace hyue;
+
+#define MEDIA_DIR UNITTEST_DIR "/../Tests/Media/"
+
+namespace {
+
+const PixelFormat g_block_formats[] = {
+    PixelFormat::DXT1,
+    PixelFormat::DXT3,
+    PixelFormat::DXT5,
+    PixelFormat::BC4_UNORM,
+    PixelFormat::BC4_SNORM,
+    PixelFormat::BC5_UNORM,
+    PixelFormat::BC5_SNORM,
+};
+
+std::vector<uint8_t> decompress(const PixelBox& src, SimdLevel level, Executor* executor = nullptr)
+{
+    PixelBox dst(src.get_width(), src.get_height(), src.get_depth(), PixelFormat::BYTE_RGBA);
+    std::vector<uint8_t> ret(dst.get_consecutive_size());
+    dst.data = ret.data();
+
+    set_max_simd_level(level);
+    if (executor)
+        PixelUtil::decompress(&src, &dst, executor);
+    else
+        PixelUtil::decompress(&src, &dst);
+    set_max_simd_level(SimdLevel::AVX2);
+
+    return ret;
+}
+
+Image load(const char* name, bool decompress)
+{
+    auto stream = MappedFileDataStream::open(String(MEDIA_DIR) + name);
+    EXPECT_TRUE(stream) << name;
+    Image image;
+    DDSCodec::decode(stream, &image, decompress);
+    return image;
+}
+
+} // namespace
+
+TEST(DDSCodec, bc1_block)
+{
+    // red and blue end points, the row indices count up 0 1 2 3
+    const uint8_t opaque[8] = {0x00, 0xf8, 0x1f, 0x00, 0xe4, 0xe4, 0xe4, 0xe4};
+    // end points swapped: 3 colour mode with transparent black
+    const uint8_t transparent[8] = {0x1f, 0x00, 0x00, 0xf8, 0xe4, 0xe4, 0xe4, 0xe4};
+
+    const uint8_t expected_opaque[4][4] = {{255, 0, 0, 255}, {0, 0, 255, 255}, {170, 0, 85, 255}, {85, 0, 170, 255}};
+    const uint8_t expected_transparent[4][4] = {{0, 0, 255, 255}, {255, 0, 0, 255}, {128, 0, 128, 255}, {0, 0, 0, 0}};
+
+    for (auto level : {SimdLevel::NONE, SimdLevel::SSE2}) {
+        auto pixels = decompress(PixelBox(4, 4, 1, PixelFormat::DXT1, const_cast<uint8_t*>(opaque)), level);
+        for (size_t i = 0; i < 16; ++i)
+            EXPECT_EQ(0, memcmp(&pixels[i * 4], expected_opaque[i % 4], 4)) << i;
+
+        pixels = decompress(PixelBox(4, 4, 1, PixelFormat::DXT1, const_cast<uint8_t*>(transparent)), level);
+        for (size_t i = 0; i < 16; ++i)
+            EXPECT_EQ(0, memcmp(&pixels[i * 4], expected_transparent[i % 4], 4)) << i;
+    }
+}
+
+TEST(DDSCodec, bc3_alpha_block)
+{
+    // alpha 255 to 0 over 8 steps, texel i uses index i % 8; white colour block
+    const uint8_t block[16] = {0xff, 0x00, 0x88, 0xc6, 0xfa, 0x88, 0xc6, 0xfa,
+                               0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00};
+    const uint8_t expected[8] = {255, 0, 219, 182, 146, 109, 73, 36};
+
+    for (auto level : {SimdLevel::NONE, SimdLevel::SSE2}) {
+        auto pixels = decompress(PixelBox(4, 4, 1, PixelFormat::DXT5, const_cast<uint8_t*>(block)), level);
+        for (size_t i = 0; i < 16; ++i) {
+            EXPECT_EQ(pixels[i * 4], 255);
+            EXPECT_EQ(pixels[i * 4 + 3], expected[i % 8]) << i;
+        }
+    }
+}
+
+TEST(DDSCodec, decompress_simd)
+{
+    std::mt19937 rng(42);
+
+    // partial blocks at the right and bottom edges, and a few slices
+    const int width = 37, height = 22, depth = 3;
+    for (auto format : g_block_formats) {
+        std::vector<uint8_t> blocks(PixelUtil::get_memory_size(width, height, depth, format));
+        for (auto& b : blocks)
+            b = uint8_t(rng());
+        PixelBox src(width, height, depth, format, blocks.data());
+
+        auto expected = decompress(src, SimdLevel::NONE);
+        EXPECT_EQ(decompress(src, SimdLevel::SSE2), expected) << PixelUtil::getFormatName(format);
+    }
+}
+
+TEST(DDSCodec, decompress_parallel)
+{
+    std::mt19937 rng(7);
+    const int width = 517, height = 389;
+    std::vector<uint8_t> blocks(PixelUtil::get_memory_size(width, height, 1, PixelFormat::DXT5));
+    for (auto& b : blocks)
+        b = uint8_t(rng());
+    PixelBox src(width, height, 1, PixelFormat::DXT5, blocks.data());
+
+    auto expected = decompress(src, SimdLevel::AVX2);
+    EXPECT_EQ(decompress(src, SimdLevel::AVX2, &ThreadPool::get_worker_pool()), expected);
+
+    // into a sub box of a different format
+    std::vector<uint8_t> padded(PixelUtil::get_memory_size(width + 2, height + 1, 1, PixelFormat::A8R8G8B8));
+    PixelBox dst = PixelBox(width + 2, height + 1, 1, PixelFormat::A8R8G8B8, padded.data())
+                       .get_sub_volume(Box(1, 1, width + 1, height + 1), false);
+    PixelUtil::decompress(&src, &dst, &ThreadPool::get_worker_pool());
+
+    // get_color takes coordinates relative to the data, not to the sub box
+    PixelBox expected_box(width, height, 1, PixelFormat::BYTE_RGBA, expected.data());
+    EXPECT_TRUE(dst.get_color(4, 6, 0) == expected_box.get_color(3, 5, 0));
+    EXPECT_TRUE(dst.get_color(width, height, 0) == expected_box.get_color(width - 1, height - 1, 0));
+}
+
+TEST(DDSCodec, decode_files)
+{
+    Image compressed = load("ogreborderUp_dxt5.dds", false);
+    EXPECT_EQ(compressed.get_format(), PixelFormat::DXT5);
+    EXPECT_EQ(compressed.get_width(), 256u);
+    EXPECT_EQ(compressed.get_size(), 256u * 256u);
+
+    // the compressed files are encodings of the float one
+    Image reference = load("ogreborderUp_float128.dds", false);
+    ASSERT_EQ(reference.get_format(), PixelFormat::FLOAT32_RGBA);
+    PixelBox reference_box = reference.get_pixel_box();
+
+    for (auto name : {"ogreborderUp_dxt3.dds", "ogreborderUp_dxt5.dds"}) {
+        Image image = load(name, true);
+        ASSERT_EQ(image.get_format(), PixelFormat::BYTE_RGBA);
+        PixelBox box = image.get_pixel_box();
+
+        double error = 0;
+        for (size_t y = 0; y < box.get_height(); ++y) {
+            for (size_t x = 0; x < box.get_width(); ++x) {
+                Color a = box.get_color(x, y, 0), b = reference_box.get_color(x, y, 0);
+                error += std::fabs(a.r - b.r) + std::fabs(a.g - b.g) + std::fabs(a.b - b.b) + std::fabs(a.a - b.a);
+            }
+        }
+        EXPECT_LT(error / (box.get_width() * box.get_height() * 4), 0.02) << name;
+    }
+
+    // cube map with a full mip chain
+    Image cube = load("grace_cube.dds", true);
+    EXPECT_EQ(cube.get_num_faces(), 6u);
+    EXPECT_EQ(cube.get_num_mipmaps(), 8u);
+    EXPECT_EQ(cube.get_pixel_box(5, 8).get_width(), 1u);
+    EXPECT_EQ(cube.get_pixel_box(5, 8).data + 4, cube.get_data() + cube.get_size());
+}
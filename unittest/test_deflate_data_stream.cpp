@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <hyue/DeflateDataStream.h>
+
+#include <random>
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace hyue;
+
+namespace {
+
+/// Contents of lines.txt.gz: "line 000000\n" to "line 019999\n"
+String expected_lines()
+{
+    String ret;
+    char line[16];
+    for (int i = 0; i < 20000; ++i) {
+        snprintf(line, sizeof(line), "line %06d\n", i);
+        ret += line;
+    }
+    return ret;
+}
+
+SharedPtr<DeflateDataStream> open_lines(size_t checkpoint_interval)
+{
+    auto file = MappedFileDataStream::open(UNITTEST_DIR "/lines.txt.gz");
+    EXPECT_TRUE(file);
+    return std::make_shared<DeflateDataStream>("lines.txt", file, DeflateDataStream::AUTO, checkpoint_interval);
+}
+
+/// "hello, yue!\n"
+const uint8_t g_zlib_hello[] = {0x78, 0x9c, 0xcb, 0x48, 0xcd, 0xc9, 0xc9, 0xd7, 0x51, 0xa8,
+                                0x2c, 0x4d, 0x55, 0xe4, 0x02, 0x00, 0x1c, 0x5f, 0x03, 0xdf};
+const uint8_t g_raw_hello[] = {0xcb, 0x48, 0xcd, 0xc9, 0xc9, 0xd7, 0x51, 0xa8, 0x2c, 0x4d, 0x55, 0xe4, 0x02, 0x00};
+
+} // namespace
+
+TEST(DeflateDataStream, stream_types)
+{
+    auto zlib = std::make_shared<MemoryDataStream>((void*)g_zlib_hello, sizeof(g_zlib_hello));
+    DeflateDataStream zlib_stream("zlib", zlib);
+    EXPECT_EQ(zlib_stream.get_stream_type(), DeflateDataStream::ZLIB);
+    EXPECT_EQ(zlib_stream.get_line(), "hello, yue!");
+    EXPECT_TRUE(zlib_stream.is_eof());
+    EXPECT_EQ(zlib_stream.get_size(), 12);
+
+    auto raw = std::make_shared<MemoryDataStream>((void*)g_raw_hello, sizeof(g_raw_hello));
+    DeflateDataStream raw_stream("raw", raw, DeflateDataStream::DEFLATE);
+    EXPECT_EQ(raw_stream.get_as_string(), "hello, yue!\n");
+
+    // a wrong adler32 checksum
+    uint8_t corrupt[sizeof(g_zlib_hello)];
+    memcpy(corrupt, g_zlib_hello, sizeof(corrupt));
+    corrupt[sizeof(corrupt) - 1] ^= 1;
+    DeflateDataStream corrupt_stream("corrupt", std::make_shared<MemoryDataStream>(corrupt, sizeof(corrupt)));
+    EXPECT_ANY_THROW(corrupt_stream.get_as_string());
+}
+
+TEST(DeflateDataStream, gzip_sequential)
+{
+    String expected = expected_lines();
+    auto stream = open_lines(HYUE_DEFLATE_CHECKPOINT_INTERVAL);
+    EXPECT_EQ(stream->get_stream_type(), DeflateDataStream::GZIP);
+
+    // odd sized reads cross the window boundaries
+    String contents;
+    char buf[4099];
+    size_t count;
+    while ((count = stream->read(buf, sizeof(buf))) != 0)
+        contents.append(buf, count);
+    EXPECT_TRUE(contents == expected);
+    EXPECT_TRUE(stream->is_eof());
+    EXPECT_EQ(stream->get_size(), expected.size());
+    EXPECT_EQ(stream->get_checkpoint_count(), 1u);
+}
+
+TEST(DeflateDataStream, skip_and_seek)
+{
+    String expected = expected_lines();
+    // shorter than a window, so the interval is clamped
+    auto stream = open_lines(1);
+
+    char line[12];
+    stream->skip(12 * 5000);
+    EXPECT_EQ(stream->read(line, 12), 12u);
+    EXPECT_EQ(String(line, 12), "line 005000\n");
+
+    // inside the window
+    stream->skip(-24);
+    EXPECT_EQ(stream->read(line, 12), 12u);
+    EXPECT_EQ(String(line, 12), "line 004999\n");
+
+    stream->seek(12 * 19999);
+    EXPECT_EQ(stream->get_line(), "line 019999");
+    EXPECT_TRUE(stream->is_eof());
+    // checkpoints are at least a window apart
+    EXPECT_GT(stream->get_checkpoint_count(), 1u);
+    EXPECT_LE(stream->get_checkpoint_count(), expected.size() / (32 * 1024) + 1);
+
+    // past the end
+    stream->seek(expected.size() + 100);
+    EXPECT_EQ(stream->tell(), expected.size());
+    EXPECT_EQ(stream->read(line, 12), 0u);
+
+    // before the start
+    stream->seek(24);
+    stream->skip(-100);
+    EXPECT_EQ(stream->tell(), 0u);
+    EXPECT_EQ(stream->read(line, 12), 12u);
+    EXPECT_EQ(String(line, 12), "line 000000\n");
+
+    // random access from the checkpoints
+    std::mt19937 rng(5);
+    for (int i = 0; i < 200; ++i) {
+        size_t pos = rng() % (expected.size() - 100);
+        stream->seek(pos);
+        char buf[100];
+        ASSERT_EQ(stream->read(buf, 100), 100u);
+        ASSERT_EQ(memcmp(buf, expected.data() + pos, 100), 0) << pos;
+    }
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <hyue/ETCCodec.h>
+#include <hyue/thread.h>
+
+#include <random>
+
+using namespace hyue;
+
+#define MEDIA_DIR UNITTEST_DIR "/../Tests/Media/"
+
+namespace {
+
+std::vector<uint8_t> decompress(const uint8_t* block, PixelFormat format)
+{
+    PixelBox src(4, 4, 1, format, const_cast<uint8_t*>(block));
+    std::vector<uint8_t> ret(4 * 4 * 4);
+    PixelBox dst(4, 4, 1, PixelFormat::BYTE_RGBA, ret.data());
+    PixelUtil::decompress(&src, &dst);
+    return ret;
+}
+
+Image load(const char* name, bool decompress)
+{
+    auto stream = MappedFileDataStream::open(String(MEDIA_DIR) + name);
+    EXPECT_TRUE(stream) << name;
+    Image image;
+    ETCCodec::decode(stream, &image, decompress);
+    return image;
+}
+
+} // namespace
+
+TEST(ETCCodec, etc1_block)
+{
+    // individual mode, grey 0x88 in both halves with the smallest table; the
+    // first column uses the large positive modifier, the others the small one
+    const uint8_t block[8] = {0x88, 0x88, 0x88, 0x00, 0x00, 0x00, 0x00, 0x0f};
+
+    for (auto format : {PixelFormat::ETC1_RGB8, PixelFormat::ETC2_RGB8}) {
+        auto pixels = decompress(block, format);
+        for (size_t y = 0; y < 4; ++y) {
+            for (size_t x = 0; x < 4; ++x) {
+                const uint8_t* p = &pixels[(y * 4 + x) * 4];
+                uint8_t expected = x == 0 ? 0x88 + 8 : 0x88 + 2;
+                EXPECT_EQ(p[0], expected) << x << "," << y;
+                EXPECT_EQ(p[2], expected) << x << "," << y;
+                EXPECT_EQ(p[3], 255);
+            }
+        }
+    }
+}
+
+TEST(ETCCodec, punch_through_block)
+{
+    // differential mode without the opaque bit: index 2 is transparent black,
+    // index 0 has no modifier; the two left columns use index 2
+    const uint8_t block[8] = {0x80, 0x80, 0x80, 0x00, 0x00, 0xff, 0x00, 0x00};
+
+    auto pixels = decompress(block, PixelFormat::ETC2_RGB8A1);
+    for (size_t y = 0; y < 4; ++y) {
+        for (size_t x = 0; x < 4; ++x) {
+            const uint8_t* p = &pixels[(y * 4 + x) * 4];
+            const uint8_t transparent[4] = {0, 0, 0, 0}, base[4] = {132, 132, 132, 255};
+            EXPECT_EQ(0, memcmp(p, x < 2 ? transparent : base, 4)) << x << "," << y;
+        }
+    }
+}
+
+TEST(ETCCodec, eac_alpha_block)
+{
+    // base 128, multiplier 1, table 0: the first texel uses -3, the others +14
+    const uint8_t block[16] = {0x80, 0x10, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff,
+                               0x88, 0x88, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+    auto pixels = decompress(block, PixelFormat::ETC2_RGBA8);
+    for (size_t i = 0; i < 16; ++i) {
+        EXPECT_EQ(pixels[i * 4], 0x88 + 2);
+        EXPECT_EQ(pixels[i * 4 + 3], i == 0 ? 125 : 142) << i;
+    }
+}
+
+TEST(ETCCodec, decompress_parallel)
+{
+    std::mt19937 rng(11);
+    const int width = 301, height = 263;
+    for (auto format : {PixelFormat::ETC1_RGB8, PixelFormat::ETC2_RGB8A1, PixelFormat::ETC2_RGBA8}) {
+        std::vector<uint8_t> blocks(PixelUtil::get_memory_size(width, height, 1, format));
+        for (auto& b : blocks)
+            b = uint8_t(rng());
+        PixelBox src(width, height, 1, format, blocks.data());
+
+        std::vector<uint8_t> serial(width * height * 4), parallel(width * height * 4);
+        PixelBox dst(width, height, 1, PixelFormat::BYTE_RGBA, serial.data());
+        PixelUtil::decompress(&src, &dst);
+        dst.data = parallel.data();
+        PixelUtil::decompress(&src, &dst, &ThreadPool::get_worker_pool());
+        EXPECT_EQ(serial, parallel) << PixelUtil::getFormatName(format);
+    }
+}
+
+TEST(ETCCodec, decode_files)
+{
+    Image pkm = load("Texture.pkm", false);
+    EXPECT_EQ(pkm.get_format(), PixelFormat::ETC2_RGB8);
+    EXPECT_EQ(pkm.get_width(), 512u);
+    EXPECT_EQ(pkm.get_size(), 512u * 512u / 2);
+
+    pkm = load("Texture.pkm", true);
+    ASSERT_EQ(pkm.get_format(), PixelFormat::BYTE_RGBA);
+    EXPECT_EQ(pkm.get_pixel_box().get_color(256, 256, 0).a, 1.0f);
+
+    // a photo faded out to transparent corners
+    Image ktx = load("etc2-rgba8.ktx", false);
+    EXPECT_EQ(ktx.get_format(), PixelFormat::ETC2_RGBA8);
+    EXPECT_EQ(ktx.get_width(), 128u);
+    EXPECT_EQ(ktx.get_num_mipmaps(), 0u);
+
+    ktx.decompress();
+    ASSERT_EQ(ktx.get_format(), PixelFormat::BYTE_RGBA);
+    PixelBox box = ktx.get_pixel_box();
+    EXPECT_EQ(box.get_color(0, 0, 0).a, 0.0f);
+    EXPECT_EQ(box.get_color(127, 127, 0).a, 0.0f);
+    EXPECT_GT(box.get_color(64, 64, 0).a, 0.95f);
+}
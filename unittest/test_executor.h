@@ -0,0 +1,34 @@
+#pragma once
+
+#include <hyue/thread.h>
+
+/// Order a CountingExecutor runs the jobs of a parallel_for in
+enum class JobOrder {
+    FORWARD,
+    /// Catches jobs that rely on the ones before them having run
+    REVERSE,
+};
+
+/// Runs jobs on the calling thread and counts them
+struct CountingExecutor : public hyue::Executor {
+    JobOrder order;
+    size_t jobs = 0;
+
+    explicit CountingExecutor(JobOrder order = JobOrder::REVERSE)
+    : order(order)
+    {
+    }
+
+    size_t get_concurrency() const override
+    {
+        return 4;
+    }
+
+    void parallel_for(size_t count, const std::function<void(size_t)>& job) override
+    {
+        for (size_t i = 0; i < count; ++i) {
+            job(order == JobOrder::REVERSE ? count - 1 - i : i);
+            ++jobs;
+        }
+    }
+};
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include <hyue/ImageResampler.h>
+
+#include <random>
+
+using namespace hyue;
+
+namespace {
+
+const ResampleFilter g_filters[] = {ResampleFilter::BOX, ResampleFilter::BILINEAR, ResampleFilter::LANCZOS3};
+
+std::vector<float> random_image(size_t width, size_t height, size_t depth = 1)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> value(0.0f, 1.0f);
+    std::vector<float> ret(width * height * depth * 4);
+    for (auto& v : ret)
+        v = value(rng);
+    return ret;
+}
+
+} // namespace
+
+TEST(ImageResampler, box_halves)
+{
+    // 4x2 RGBA float, every 2x2 block averages to a known value
+    std::vector<float> src(4 * 2 * 4);
+    for (size_t y = 0; y < 2; ++y)
+        for (size_t x = 0; x < 4; ++x)
+            for (size_t c = 0; c < 4; ++c)
+                src[(y * 4 + x) * 4 + c] = float(x + y * 4 + c);
+
+    std::vector<float> dst(2 * 4);
+    PixelBox src_box(4, 2, 1, PixelFormat::FLOAT32_RGBA, src.data());
+    PixelBox dst_box(2, 1, 1, PixelFormat::FLOAT32_RGBA, dst.data());
+    ImageResampler::scale(src_box, dst_box, ResampleFilter::BOX);
+
+    for (size_t x = 0; x < 2; ++x)
+        for (size_t c = 0; c < 4; ++c)
+            EXPECT_FLOAT_EQ(dst[x * 4 + c], float(x * 2 + 0.5f + 2 + c));
+}
+
+TEST(ImageResampler, constant_stays_constant)
+{
+    std::vector<uint8_t> src(37 * 23 * 4);
+    for (size_t i = 0; i < src.size(); i += 4) {
+        src[i + 0] = 10;
+        src[i + 1] = 200;
+        src[i + 2] = 77;
+        src[i + 3] = 255;
+    }
+    PixelBox src_box(37, 23, 1, PixelFormat::R8G8B8A8, src.data());
+
+    const std::pair<size_t, size_t> sizes[] = {{16, 9}, {37, 23}, {80, 51}, {1, 1}};
+    for (auto filter : g_filters) {
+        for (auto& size : sizes) {
+            std::vector<uint8_t> dst(size.first * size.second * 4);
+            PixelBox dst_box(size.first, size.second, 1, PixelFormat::R8G8B8A8, dst.data());
+            ImageResampler::scale(src_box, dst_box, filter);
+
+            for (size_t i = 0; i < dst.size(); i += 4) {
+                ASSERT_EQ(dst[i + 0], 10);
+                ASSERT_EQ(dst[i + 1], 200);
+                ASSERT_EQ(dst[i + 2], 77);
+                ASSERT_EQ(dst[i + 3], 255);
+            }
+        }
+    }
+}
+
+TEST(ImageResampler, same_size_is_identity)
+{
+    std::vector<uint8_t> src(19 * 7 * 4);
+    std::mt19937 rng(3);
+    for (auto& v : src)
+        v = uint8_t(rng());
+
+    PixelBox src_box(19, 7, 1, PixelFormat::B8G8R8A8, src.data());
+    for (auto filter : g_filters) {
+        std::vector<uint8_t> dst(src.size());
+        PixelBox dst_box(19, 7, 1, PixelFormat::B8G8R8A8, dst.data());
+        ImageResampler::scale(src_box, dst_box, filter);
+        EXPECT_EQ(src, dst);
+    }
+}
+
+TEST(ImageResampler, pitched_sub_box)
+{
+    // scaling a sub box of a larger image only reads and writes inside the boxes
+    std::vector<float> src = random_image(32, 32);
+    std::vector<float> src_copy(16 * 16 * 4);
+    for (size_t y = 0; y < 16; ++y)
+        std::copy(&src[((y + 8) * 32 + 4) * 4], &src[((y + 8) * 32 + 20) * 4], &src_copy[y * 16 * 4]);
+
+    std::vector<float> dst(20 * 20 * 4, -1.0f);
+    std::vector<float> expected(8 * 8 * 4);
+
+    PixelBox src_box(32, 32, 1, PixelFormat::FLOAT32_RGBA, src.data());
+    PixelBox dst_box(20, 20, 1, PixelFormat::FLOAT32_RGBA, dst.data());
+    PixelBox src_sub = src_box.get_sub_volume(Box(4, 8, 20, 24), false);
+    PixelBox dst_sub = dst_box.get_sub_volume(Box(2, 3, 10, 11), false);
+    ImageResampler::scale(src_sub, dst_sub, ResampleFilter::LANCZOS3);
+
+    PixelBox copy_box(16, 16, 1, PixelFormat::FLOAT32_RGBA, src_copy.data());
+    PixelBox expected_box(8, 8, 1, PixelFormat::FLOAT32_RGBA, expected.data());
+    ImageResampler::scale(copy_box, expected_box, ResampleFilter::LANCZOS3);
+
+    for (size_t y = 0; y < 20; ++y) {
+        for (size_t x = 0; x < 20; ++x) {
+            bool inside = x >= 2 && x < 10 && y >= 3 && y < 11;
+            for (size_t c = 0; c < 4; ++c) {
+                float value = dst[(y * 20 + x) * 4 + c];
+                if (inside)
+                    ASSERT_FLOAT_EQ(value, expected[((y - 3) * 8 + x - 2) * 4 + c]);
+                else
+                    ASSERT_EQ(value, -1.0f);
+            }
+        }
+    }
+}
+
+TEST(ImageResampler, generate_mipmaps)
+{
+    const size_t width = 45, height = 30;
+    std::vector<float> src = random_image(width, height);
+    PixelBox src_box(width, height, 1, PixelFormat::FLOAT32_RGBA, src.data());
+
+    for (auto filter : g_filters) {
+        std::vector<std::vector<float>> levels;
+        std::vector<PixelBox> mips;
+        for (size_t level = 1; level <= 6; ++level) {
+            size_t w = ImageResampler::get_mip_size(width, level);
+            size_t h = ImageResampler::get_mip_size(height, level);
+            levels.emplace_back(w * h * 4);
+            mips.emplace_back(w, h, 1, PixelFormat::FLOAT32_RGBA, levels.back().data());
+        }
+        ImageResampler::generate_mipmaps(src_box, mips, filter);
+
+        // the streamed chain matches scaling level by level
+        PixelBox previous = src_box;
+        std::vector<std::vector<float>> expected(mips.size());
+        for (size_t i = 0; i < mips.size(); ++i) {
+            expected[i].resize(levels[i].size());
+            PixelBox box(mips[i].get_width(), mips[i].get_height(), 1, PixelFormat::FLOAT32_RGBA, expected[i].data());
+            ImageResampler::scale(previous, box, filter);
+            previous = box;
+
+            for (size_t k = 0; k < levels[i].size(); ++k)
+                ASSERT_NEAR(levels[i][k], expected[i][k], 1e-5f);
+        }
+
+        EXPECT_EQ(mips.back().get_width(), 1u);
+        EXPECT_EQ(mips.back().get_height(), 1u);
+    }
+}
+
+TEST(ImageResampler, generate_mipmaps_volume)
+{
+    const size_t size = 8;
+    std::vector<uint8_t> src(size * size * size * 4, 128);
+    PixelBox src_box(size, size, size, PixelFormat::A8B8G8R8, src.data());
+
+    std::vector<std::vector<uint8_t>> levels;
+    std::vector<PixelBox> mips;
+    for (size_t level = 1; level <= 3; ++level) {
+        size_t s = ImageResampler::get_mip_size(size, level);
+        levels.emplace_back(s * s * s * 4, 0);
+        mips.emplace_back(s, s, s, PixelFormat::A8B8G8R8, levels.back().data());
+    }
+    ImageResampler::generate_mipmaps(src_box, mips);
+
+    for (auto& level : levels)
+        for (auto v : level)
+            ASSERT_EQ(v, 128);
+}
+
+TEST(ImageResampler, large_downscale)
+{
+    // far more taps per output row and slice than a small fixed window holds
+    const size_t size = 1024;
+    std::vector<uint8_t> src(size * size * 4, 90);
+    PixelBox src_box(size, size, 1, PixelFormat::A8B8G8R8, src.data());
+    std::vector<uint8_t> volume(4 * 4 * 256 * 4, 90);
+    PixelBox volume_box(4, 4, 256, PixelFormat::A8B8G8R8, volume.data());
+
+    for (auto filter : g_filters) {
+        std::vector<uint8_t> dst(16 * 16 * 4, 0);
+        PixelBox dst_box(16, 16, 1, PixelFormat::A8B8G8R8, dst.data());
+        ImageResampler::scale(src_box, dst_box, filter);
+        for (auto v : dst)
+            ASSERT_EQ(v, 90);
+
+        std::vector<uint8_t> dst_volume(4 * 4 * 2 * 4, 0);
+        PixelBox dst_volume_box(4, 4, 2, PixelFormat::A8B8G8R8, dst_volume.data());
+        ImageResampler::scale(volume_box, dst_volume_box, filter);
+        for (auto v : dst_volume)
+            ASSERT_EQ(v, 90);
+    }
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <hyue/Root.h>
+#include <hyue/log.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace hyue;
+
+TEST(Log, async_sink)
+{
+    const char* log_file = "test_log_sink.log";
+    const int num_threads = 4, num_lines = 200;
+
+    // keep the console quiet
+    std::streambuf* console = std::clog.rdbuf(nullptr);
+    {
+        Root root(log_file);
+        set_log_level(LogLevel::info);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([t]() {
+                for (int i = 0; i < num_lines; ++i) {
+                    LOG(info) << "line " << t << " " << i;
+                    LOG(trace) << "not written";
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        set_log_level(LogLevel::error);
+        EXPECT_FALSE(is_log_enabled(LogLevel::warning));
+        EXPECT_TRUE(is_log_enabled(LogLevel::fatal));
+        LOG(warning) << "not written";
+        LOG(error) << "last";
+        flush_log();
+
+        std::ifstream in(log_file);
+        std::vector<int> next(num_threads, 0);
+        String line, last;
+        int info_lines = 0;
+        while (std::getline(in, line)) {
+            int t, i;
+            if (sscanf(line.c_str(), "[Hyue] [info] line %d %d", &t, &i) == 2) {
+                // lines of one thread keep their order
+                ASSERT_EQ(i, next[t]);
+                ++next[t];
+                ++info_lines;
+            }
+            last = line;
+        }
+        EXPECT_EQ(info_lines, num_threads * num_lines);
+        EXPECT_EQ(last, "[Hyue] [error] last");
+
+        set_log_level(LogLevel::trace);
+    }
+    std::clog.rdbuf(console);
+    std::remove(log_file);
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include <hyue/PackArchiveFactory.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+using namespace hyue;
+
+namespace {
+
+String temp_pack(const String& name)
+{
+    return (std_fs::temp_directory_path() / name).string();
+}
+
+String read_file(const FilePath& path)
+{
+    std::ifstream is(path, std::ios::binary);
+    return String(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+TEST(PackArchive, write_and_open)
+{
+    String text;
+    for (int i = 0; i < 1000; ++i)
+        text += "the quick brown fox jumps over the lazy dog " + std::to_string(i % 7) + "\n";
+    String random(10000, '\0');
+    std::mt19937 rng(3);
+    for (auto& c : random)
+        c = char(rng());
+
+    String path = temp_pack("hyue_test_write_and_open.pack");
+    PackWriter writer(64);
+    writer.add("readme.txt", text.data(), text.size());
+    writer.add("data/random.bin", random.data(), random.size());
+    writer.add("data/empty.txt", "", 0);
+    writer.add("data/sub/text.txt", text.data(), text.size(), PackWriter::STORE);
+    EXPECT_EQ(writer.get_entry_count(), 4u);
+    writer.write(path);
+
+    PackArchiveFactory factory;
+    EXPECT_EQ(factory.create_instance(path, false), nullptr);
+    auto archive = factory.create_instance(path, true);
+    archive->load();
+
+    auto files = archive->list();
+    std::sort(files.begin(), files.end());
+    EXPECT_EQ(files, StringVector({"data/empty.txt", "data/random.bin", "data/sub/text.txt", "readme.txt"}));
+    auto dirs = archive->list(true, true);
+    std::sort(dirs.begin(), dirs.end());
+    EXPECT_EQ(dirs, StringVector({"data", "data/sub"}));
+    EXPECT_EQ(archive->list(false).size(), 1u);
+    EXPECT_EQ(archive->find("data/*.txt").size(), 2u);
+    EXPECT_TRUE(archive->exists("data/random.bin"));
+    EXPECT_FALSE(archive->exists("random.bin"));
+    EXPECT_EQ(archive->open("data/missing.txt"), nullptr);
+
+    // compressible text is LZ4, random data and forced entries are stored
+    for (const auto& info : archive->list_file_info()) {
+        if (info.filename == "readme.txt")
+            EXPECT_LT(info.compressed_size, info.uncompressed_size / 4);
+        else
+            EXPECT_EQ(info.compressed_size, info.uncompressed_size);
+    }
+
+    auto readme = archive->open("readme.txt");
+    auto stored = std::dynamic_pointer_cast<DataStreamView>(archive->open("data/sub/text.txt"));
+    ASSERT_NE(stored, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(stored->get_ptr()) % 64, 0u);
+    auto random_stream = std::dynamic_pointer_cast<DataStreamView>(archive->open("data/random.bin"));
+    ASSERT_NE(random_stream, nullptr);
+    EXPECT_EQ(archive->open("data/empty.txt")->get_size(), 0u);
+
+    // streams stay valid once the archive is gone
+    archive->unload();
+    factory.destroy_instance(archive);
+    EXPECT_TRUE(readme->get_as_string() == text);
+    EXPECT_TRUE(stored->get_as_string() == text);
+    EXPECT_TRUE(random_stream->get_as_string() == random);
+
+    std_fs::remove(path);
+}
+
+TEST(PackArchive, add_directory)
+{
+    String path = temp_pack("hyue_test_add_directory.pack");
+    PackWriter writer;
+    size_t count = writer.add_directory(UNITTEST_DIR);
+    writer.write(path);
+
+    PackArchiveFactory factory;
+    auto archive = factory.create_instance(path, true);
+    archive->load();
+
+    auto files = archive->list();
+    EXPECT_EQ(files.size(), count);
+    EXPECT_TRUE(archive->exists("CMakeLists.txt"));
+    EXPECT_TRUE(archive->exists("test.zip"));
+    for (const auto& name : files)
+        EXPECT_TRUE(archive->open(name)->get_as_string() == read_file(FilePath(UNITTEST_DIR) / name)) << name;
+
+    archive->unload();
+    factory.destroy_instance(archive);
+    std_fs::remove(path);
+}
+
+TEST(PackArchive, corrupt)
+{
+    String path = temp_pack("hyue_test_corrupt.pack");
+    PackWriter writer;
+    writer.add("file.txt", "contents", 8);
+    size_t size = writer.write(path);
+
+    // cut into the data of the entry
+    std_fs::resize_file(path, size - 1);
+
+    PackArchiveFactory factory;
+    auto archive = factory.create_instance(path, true);
+    archive->load();
+    EXPECT_FALSE(archive->exists("file.txt"));
+    EXPECT_EQ(archive->open("file.txt"), nullptr);
+    factory.destroy_instance(archive);
+
+    std_fs::remove(path);
+}
@@ -0,0 +1,355 @@
+#include <gtest/gtest.h>
+
+#include <hyue/Bitwise.h>
+#include <hyue/PixelFormat.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include <string.h>
+
+#include "test_executor.h"
+
+using namespace hyue;
+
+namespace {
+
+/// Formats pairs with vectorised conversions
+const std::pair<PixelFormat, PixelFormat> g_simd_pairs[] = {
+    {PixelFormat::A8R8G8B8, PixelFormat::A8B8G8R8},
+    {PixelFormat::A8R8G8B8, PixelFormat::B8G8R8A8},
+    {PixelFormat::A8R8G8B8, PixelFormat::R8G8B8A8},
+    {PixelFormat::A8B8G8R8, PixelFormat::A8R8G8B8},
+    {PixelFormat::B8G8R8A8, PixelFormat::R8G8B8A8},
+    {PixelFormat::R8G8B8A8, PixelFormat::A8B8G8R8},
+    {PixelFormat::X8R8G8B8, PixelFormat::A8B8G8R8},
+    {PixelFormat::X8B8G8R8, PixelFormat::B8G8R8A8},
+    {PixelFormat::R8G8B8, PixelFormat::A8B8G8R8},
+    {PixelFormat::R8G8B8, PixelFormat::A8R8G8B8},
+    {PixelFormat::B8G8R8, PixelFormat::B8G8R8A8},
+    {PixelFormat::B8G8R8, PixelFormat::R8G8B8A8},
+    {PixelFormat::L8, PixelFormat::A8B8G8R8},
+    {PixelFormat::L8, PixelFormat::A8R8G8B8},
+    {PixelFormat::L8, PixelFormat::B8G8R8A8},
+    {PixelFormat::L8, PixelFormat::R8G8B8A8},
+    {PixelFormat::FLOAT16_R, PixelFormat::FLOAT32_R},
+    {PixelFormat::FLOAT16_GR, PixelFormat::FLOAT32_GR},
+    {PixelFormat::FLOAT16_RGB, PixelFormat::FLOAT32_RGB},
+    {PixelFormat::FLOAT16_RGBA, PixelFormat::FLOAT32_RGBA},
+};
+
+std::vector<uint8_t> convert(const PixelBox& src, PixelFormat dst_format, SimdLevel level)
+{
+    PixelBox dst(src.get_width(), src.get_height(), src.get_depth(), dst_format);
+    std::vector<uint8_t> ret(dst.get_consecutive_size());
+    dst.data = ret.data();
+
+    set_max_simd_level(level);
+    PixelUtil::bulk_pixel_conversion(&src, &dst);
+    set_max_simd_level(SimdLevel::AVX2);
+
+    return ret;
+}
+
+} // namespace
+
+TEST(PixelUtil, bulk_pixel_conversion_simd)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    // odd width so every kernel runs its scalar tail, and a sub box for the pitches
+    const size_t width = 67, height = 5;
+
+    for (auto& pair : g_simd_pairs) {
+        std::vector<uint8_t> buffer(PixelUtil::get_memory_size(width + 3, height + 2, 1, pair.first));
+        for (auto& b : buffer)
+            b = uint8_t(byte(rng));
+
+        PixelBox whole(width + 3, height + 2, 1, pair.first, buffer.data());
+        PixelBox src = whole.get_sub_volume(Box(1, 1, width + 1, height + 1), false);
+
+        auto expected = convert(src, pair.second, SimdLevel::NONE);
+        for (auto level : {SimdLevel::SSE2, SimdLevel::AVX2}) {
+            EXPECT_EQ(convert(src, pair.second, level), expected)
+                << PixelUtil::getFormatName(pair.first) << " -> " << PixelUtil::getFormatName(pair.second)
+                << " level " << int(level);
+        }
+    }
+}
+
+TEST(PixelUtil, bulk_pixel_conversion_half)
+{
+    // every half value, including denormals, infinities and NaNs
+    std::vector<uint16_t> halfs(65536);
+    for (size_t i = 0; i < halfs.size(); ++i)
+        halfs[i] = uint16_t(i);
+
+    PixelBox src(int(halfs.size()), 1, 1, PixelFormat::FLOAT16_R, halfs.data());
+    auto expected = convert(src, PixelFormat::FLOAT32_R, SimdLevel::NONE);
+
+    for (auto level : {SimdLevel::SSE2, SimdLevel::AVX2})
+        EXPECT_EQ(convert(src, PixelFormat::FLOAT32_R, level), expected);
+}
+
+TEST(PixelUtil, bulk_pixel_conversion_generic)
+{
+    // formats unpack_color and pack_color support
+    std::vector<PixelFormat> formats;
+    for (int i = 1; i < int(PixelFormat::COUNT); ++i) {
+        PixelFormat format = PixelFormat(i);
+        if (!PixelUtil::is_accessible(format))
+            continue;
+        uint8_t pixel[16] = {};
+        Color color;
+        try {
+            PixelUtil::unpack_color(&color, format, pixel);
+            PixelUtil::pack_color(color, format, pixel);
+        } catch (const std::runtime_error&) {
+            continue;
+        }
+        formats.push_back(format);
+    }
+    EXPECT_GT(formats.size(), 50u);
+
+    const size_t width = 13, height = 3;
+    std::mt19937 rng(11);
+    for (auto src_format : formats) {
+        std::vector<uint8_t> src_data(PixelUtil::get_memory_size(width, height, 1, src_format));
+        for (auto& b : src_data)
+            b = uint8_t(rng());
+        PixelBox src(width, height, 1, src_format, src_data.data());
+
+        for (auto dst_format : formats) {
+            // one pixel at a time, the reference; X8 destinations are written as their A8 variants
+            PixelFormat pack_format = dst_format;
+            if (dst_format == PixelFormat::X8R8G8B8)
+                pack_format = PixelFormat::A8R8G8B8;
+            else if (dst_format == PixelFormat::X8B8G8R8)
+                pack_format = PixelFormat::A8B8G8R8;
+            const size_t src_size = PixelUtil::get_elem_bytes(src_format);
+            const size_t dst_size = PixelUtil::get_elem_bytes(dst_format);
+            std::vector<uint8_t> expected(PixelUtil::get_memory_size(width, height, 1, dst_format));
+            for (size_t i = 0; i < width * height; ++i) {
+                float r, g, b, a;
+                PixelUtil::unpack_color(&r, &g, &b, &a, src_format, &src_data[i * src_size]);
+                PixelUtil::pack_color(r, g, b, a, pack_format, &expected[i * dst_size]);
+            }
+
+            if (src_format == dst_format)
+                expected = src_data;
+            EXPECT_EQ(convert(src, dst_format, SimdLevel::NONE), expected)
+                << PixelUtil::getFormatName(src_format) << " -> " << PixelUtil::getFormatName(dst_format);
+        }
+    }
+}
+
+TEST(PixelUtil, pack_colors)
+{
+    // out of range values are clamped, 1.0 and values just below it are the edge cases
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> value(-0.25f, 1.25f);
+    std::vector<Color> colors(67);
+    for (auto& c : colors)
+        c = Color(value(rng), value(rng), value(rng), value(rng));
+    colors[0] = Color(0.0f, 1.0f, 0.99999994f, -0.0f);
+    colors[1] = Color(0.5f, 1.0f / 255, 254.5f / 256, 2.0f);
+
+    const PixelFormat formats[] = {PixelFormat::A8R8G8B8, PixelFormat::X8R8G8B8,     PixelFormat::A8B8G8R8,
+                                   PixelFormat::X8B8G8R8, PixelFormat::B8G8R8A8,     PixelFormat::R8G8B8A8,
+                                   PixelFormat::R5G6B5,   PixelFormat::FLOAT16_RGBA, PixelFormat::FLOAT32_RGBA};
+    for (auto format : formats) {
+        const size_t size = PixelUtil::get_elem_bytes(format);
+        std::vector<uint8_t> expected(colors.size() * size);
+        for (size_t i = 0; i < colors.size(); ++i)
+            PixelUtil::pack_color(colors[i], format, &expected[i * size]);
+
+        std::vector<Color> unpacked_expected(colors.size());
+        for (size_t i = 0; i < colors.size(); ++i)
+            PixelUtil::unpack_color(&unpacked_expected[i], format, &expected[i * size]);
+
+        for (auto level : {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2}) {
+            set_max_simd_level(level);
+            std::vector<uint8_t> packed(expected.size());
+            PixelUtil::pack_colors(colors.data(), format, packed.data(), colors.size());
+            EXPECT_EQ(packed, expected) << PixelUtil::getFormatName(format) << " level " << int(level);
+
+            std::vector<Color> unpacked(colors.size());
+            PixelUtil::unpack_colors(packed.data(), format, unpacked.data(), unpacked.size());
+            EXPECT_EQ(memcmp(unpacked.data(), unpacked_expected.data(), unpacked.size() * sizeof(Color)), 0)
+                << PixelUtil::getFormatName(format) << " level " << int(level);
+        }
+        set_max_simd_level(SimdLevel::AVX2);
+    }
+}
+
+TEST(PixelUtil, float_to_half)
+{
+    // every float exponent with random mantissas and signs, and the special values
+    std::mt19937 rng(9);
+    std::vector<float> values;
+    for (uint32_t e = 0; e < 256; ++e) {
+        for (int i = 0; i < 8; ++i) {
+            uint32_t bits = (rng() & 0x807fffffu) | (e << 23);
+            float f;
+            memcpy(&f, &bits, 4);
+            values.push_back(f);
+        }
+    }
+    for (float f : {0.0f, -0.0f, 65504.0f, 65520.0f, 6.1035156e-05f, 1.0f / 3, std::numeric_limits<float>::infinity(),
+                    std::numeric_limits<float>::quiet_NaN()})
+        values.push_back(f);
+
+    std::vector<uint16_t> expected(values.size());
+    for (size_t i = 0; i < values.size(); ++i)
+        expected[i] = Bitwise::float_to_half(values[i]);
+
+    for (auto level : {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2}) {
+        set_max_simd_level(level);
+        std::vector<uint16_t> halfs(values.size());
+        PixelUtil::float_to_half(values.data(), halfs.data(), values.size());
+        EXPECT_EQ(halfs, expected) << "level " << int(level);
+
+        std::vector<float> floats(halfs.size());
+        PixelUtil::half_to_float(halfs.data(), floats.data(), halfs.size());
+        for (size_t i = 0; i < halfs.size(); ++i) {
+            float f = Bitwise::half_to_float(halfs[i]);
+            EXPECT_EQ(memcmp(&floats[i], &f, 4), 0) << halfs[i];
+        }
+    }
+    set_max_simd_level(SimdLevel::AVX2);
+}
+
+TEST(PixelUtil, srgb_to_linear)
+{
+    std::vector<Color> colors;
+    for (int i = 0; i <= 1000; ++i) {
+        float v = i / 1000.0f;
+        colors.emplace_back(v, 1.0f - v, v * v, v);
+    }
+    // an odd count so every tail runs
+    colors.emplace_back(0.0f, 0.003f, 0.04f, 0.75f);
+    colors.emplace_back(0.04045f, 0.0031308f, 0.5f, 0.25f);
+
+    set_max_simd_level(SimdLevel::NONE);
+    std::vector<Color> expected(colors.size());
+    PixelUtil::srgb_to_linear(colors.data(), expected.data(), colors.size());
+    EXPECT_NEAR(expected.back().b, 0.214041f, 1e-6f);
+
+    std::vector<Color> roundtrip(colors.size());
+    PixelUtil::linear_to_srgb(expected.data(), roundtrip.data(), colors.size());
+    EXPECT_NEAR(roundtrip.back().b, 0.5f, 1e-6f);
+
+    for (auto level : {SimdLevel::SSE2, SimdLevel::AVX2}) {
+        set_max_simd_level(level);
+        std::vector<Color> linear(colors.size());
+        PixelUtil::srgb_to_linear(colors.data(), linear.data(), colors.size());
+        // in place
+        std::vector<Color> srgb = linear;
+        PixelUtil::linear_to_srgb(srgb.data(), srgb.data(), srgb.size());
+
+        for (size_t i = 0; i < colors.size(); ++i) {
+            for (int j = 0; j < 4; ++j) {
+                EXPECT_NEAR(linear[i].get_ptr()[j], expected[i].get_ptr()[j], 1e-6f) << i << " " << j;
+                EXPECT_NEAR(srgb[i].get_ptr()[j], roundtrip[i].get_ptr()[j], 1e-6f) << i << " " << j;
+            }
+            EXPECT_EQ(linear[i].a, colors[i].a);
+            EXPECT_EQ(srgb[i].a, colors[i].a);
+        }
+    }
+    set_max_simd_level(SimdLevel::AVX2);
+}
+
+TEST(PixelUtil, srgb_non_finite)
+{
+    const float inf = std::numeric_limits<float>::infinity();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    // 9 colours so the vector bodies and the tails both see them
+    std::vector<Color> colors;
+    for (int i = 0; i < 9; ++i)
+        colors.emplace_back(inf, -inf, nan, 0.5f);
+
+    for (auto level : {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2}) {
+        set_max_simd_level(level);
+        std::vector<Color> linear(colors.size()), srgb(colors.size());
+        PixelUtil::srgb_to_linear(colors.data(), linear.data(), colors.size());
+        PixelUtil::linear_to_srgb(colors.data(), srgb.data(), colors.size());
+        for (auto* converted : {&linear, &srgb}) {
+            for (auto& c : *converted) {
+                EXPECT_EQ(c.r, inf) << "level " << int(level);
+                EXPECT_EQ(c.g, -inf) << "level " << int(level);
+                EXPECT_TRUE(std::isnan(c.b)) << "level " << int(level);
+                EXPECT_EQ(c.a, 0.5f);
+            }
+        }
+    }
+    set_max_simd_level(SimdLevel::AVX2);
+}
+
+namespace {
+
+std::vector<uint8_t> random_bytes(size_t size)
+{
+    std::mt19937 rng(7);
+    std::vector<uint8_t> ret(size);
+    for (auto& b : ret)
+        b = uint8_t(rng());
+    return ret;
+}
+
+} // namespace
+
+TEST(PixelUtil, bulk_pixel_conversion_parallel)
+{
+    // a padded image split into row bands, and a volume split into slices
+    const Box boxes[] = {Box(3, 2, 0, 603, 402, 1), Box(1, 1, 1, 65, 65, 41)};
+
+    for (auto& box : boxes) {
+        size_t width = box.right + 2, height = box.bottom + 1, depth = box.back + 1;
+        auto src_data = random_bytes(PixelUtil::get_memory_size(width, height, depth, PixelFormat::R8G8B8));
+        PixelBox src = PixelBox(width, height, depth, PixelFormat::R8G8B8, src_data.data()).get_sub_volume(box, false);
+
+        PixelBox dst(box.get_width(), box.get_height(), box.get_depth(), PixelFormat::A8B8G8R8);
+        std::vector<uint8_t> expected(dst.get_consecutive_size());
+        dst.data = expected.data();
+        PixelUtil::bulk_pixel_conversion(&src, &dst);
+
+        CountingExecutor executor;
+        std::vector<uint8_t> result(expected.size());
+        dst.data = result.data();
+        PixelUtil::bulk_pixel_conversion(&src, &dst, &executor);
+        EXPECT_GT(executor.jobs, 1);
+        EXPECT_EQ(result, expected);
+
+        std::fill(result.begin(), result.end(), 0);
+        PixelUtil::bulk_pixel_conversion(&src, &dst, nullptr);
+        EXPECT_EQ(result, expected);
+    }
+}
+
+TEST(PixelUtil, bulk_pixel_vertical_flip_parallel)
+{
+    const size_t width = 517, height = 301, depth = 3;
+    auto data = random_bytes(PixelUtil::get_memory_size(width, height, depth, PixelFormat::A8R8G8B8));
+    PixelBox box = PixelBox(width, height, depth, PixelFormat::A8R8G8B8, data.data())
+                       .get_sub_volume(Box(1, 0, 0, width - 2, height, depth), false);
+
+    const auto original = data;
+    PixelUtil::bulk_pixel_vertical_flip(&box);
+    auto flipped = data;
+    EXPECT_NE(flipped, original);
+
+    data = original;
+    CountingExecutor executor;
+    box.data = data.data();
+    PixelUtil::bulk_pixel_vertical_flip(&box, &executor);
+    EXPECT_GT(executor.jobs, 1);
+    EXPECT_EQ(data, flipped);
+
+    // flipping twice restores the image
+    PixelUtil::bulk_pixel_vertical_flip(&box, nullptr);
+    EXPECT_EQ(data, original);
+}
@@ -0,0 +1,247 @@
+#include <gtest/gtest.h>
+
+#include <hyue/ArchiveManager.h>
+#include <hyue/PluginManager.h>
+
+#include <fstream>
+#include <stdexcept>
+
+#include <dlfcn.h>
+
+#include "test_executor.h"
+
+using namespace hyue;
+
+namespace {
+
+/// Compiled in plugin recording its lifecycle calls into a log
+class StaticPlugin : public Plugin {
+public:
+    StaticPlugin(const String& name, StringVector dependencies, StringVector* log)
+        : name_(name)
+        , dependencies_(std::move(dependencies))
+        , log_(log)
+    {
+    }
+
+    const String& get_name() const override
+    {
+        return name_;
+    }
+
+    StringVector get_dependencies() const override
+    {
+        return dependencies_;
+    }
+
+    void install() override
+    {
+        if (fail_install)
+            throw std::runtime_error("install of " + name_ + " failed");
+        log_->push_back("install " + name_);
+    }
+
+    void initialise() override
+    {
+        log_->push_back("initialise " + name_);
+    }
+
+    void shutdown() override
+    {
+        log_->push_back("shutdown " + name_);
+    }
+
+    void uninstall() override
+    {
+        log_->push_back("uninstall " + name_);
+    }
+
+    bool fail_install = false;
+
+private:
+    String name_;
+    StringVector dependencies_;
+    StringVector* log_;
+};
+
+const PluginInfo* find_info(const PluginManager& manager, const String& name)
+{
+    for (auto& info : manager.get_plugin_info()) {
+        if (info.name == name)
+            return &info;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST(DynLib, get_symbol)
+{
+    DynLib lib(TEST_PLUGIN_DIR "/libtest_plugin_a.so");
+    EXPECT_FALSE(lib.is_loaded());
+    lib.load(DYNLIB_BIND_NOW | DYNLIB_LOCAL);
+    EXPECT_TRUE(lib.is_loaded());
+
+    void* create = lib.get_symbol("hyue_create_plugin");
+    EXPECT_NE(create, nullptr);
+    EXPECT_EQ(lib.get_symbol("hyue_create_plugin"), create);
+    EXPECT_EQ(lib.get_symbol("missing_symbol"), nullptr);
+    EXPECT_EQ(lib.get_symbol("missing_symbol"), nullptr);
+
+    lib.unload();
+    EXPECT_FALSE(lib.is_loaded());
+
+    DynLib missing(TEST_PLUGIN_DIR "/libmissing.so");
+    EXPECT_THROW(missing.load(), std::runtime_error);
+}
+
+TEST(PluginManager, load_directory)
+{
+    ArchiveManager archive_manager;
+    {
+        PluginManager manager;
+        EXPECT_EQ(manager.add_directory(TEST_PLUGIN_DIR), 3u);
+        manager.load();
+
+        ASSERT_EQ(manager.get_plugin_info().size(), 3u);
+        EXPECT_EQ(find_info(manager, "a")->wave, 0u);
+        EXPECT_EQ(find_info(manager, "b")->wave, 0u);
+        EXPECT_EQ(find_info(manager, "c")->wave, 1u);
+        EXPECT_EQ(manager.get_plugin_info().back().name, "c");
+        for (auto& info : manager.get_plugin_info()) {
+            EXPECT_FALSE(info.library.empty());
+            EXPECT_GE(info.load_ms, 0);
+            EXPECT_GE(info.install_ms, 0);
+        }
+
+        EXPECT_NE(manager.get_plugin("c"), nullptr);
+        EXPECT_EQ(manager.get_plugin("d"), nullptr);
+        for (auto name : {"TestPlugina", "TestPluginb", "TestPluginc"})
+            EXPECT_TRUE(archive_manager.has_archive_factory(name)) << name;
+
+        manager.initialise();
+        manager.unload();
+        EXPECT_TRUE(manager.get_plugin_info().empty());
+        EXPECT_EQ(manager.get_plugin("a"), nullptr);
+        EXPECT_FALSE(archive_manager.has_archive_factory("TestPlugina"));
+
+        // the libraries can be loaded again, and are released by the destructor
+        manager.add_directory(TEST_PLUGIN_DIR);
+        manager.load();
+        EXPECT_TRUE(archive_manager.has_archive_factory("TestPluginc"));
+    }
+    EXPECT_FALSE(archive_manager.has_archive_factory("TestPluginc"));
+}
+
+TEST(PluginManager, load_config)
+{
+    String path = (std_fs::temp_directory_path() / "hyue_test_plugins.cfg").string();
+    {
+        std::ofstream os(path);
+        os << "# dependencies first is not required\n"
+           << "PluginFolder=" << TEST_PLUGIN_DIR << "\n"
+           << "Plugin=libtest_plugin_c\n"
+           << "\n"
+           << "Plugin=libtest_plugin_b.so\n"
+           << "Plugin = libtest_plugin_a\n";
+    }
+
+    ArchiveManager archive_manager;
+    PluginManager manager;
+    manager.set_library_flags(DYNLIB_BIND_NOW);
+    EXPECT_EQ(manager.add_config(path), 3u);
+    manager.load();
+    EXPECT_EQ(manager.get_plugin_info().size(), 3u);
+    EXPECT_EQ(find_info(manager, "c")->wave, 1u);
+    EXPECT_TRUE(archive_manager.has_archive_factory("TestPluginc"));
+
+    std_fs::remove(path);
+    EXPECT_THROW(manager.add_config(path), std::runtime_error);
+}
+
+TEST(PluginManager, static_plugins)
+{
+    StringVector log;
+    StaticPlugin x("x", {}, &log);
+    StaticPlugin y("y", {"x"}, &log);
+    StaticPlugin z("z", {"x"}, &log);
+    StaticPlugin w("w", {"z", "y"}, &log);
+
+    CountingExecutor executor(JobOrder::FORWARD);
+    PluginManager manager;
+    for (auto plugin : {&w, &z, &y, &x})
+        manager.add_plugin(plugin);
+    manager.load(&executor);
+
+    // only the wave of y and z goes through the executor
+    EXPECT_EQ(executor.jobs, 2u);
+    EXPECT_EQ(log, StringVector({"install x", "install z", "install y", "install w"}));
+    EXPECT_EQ(find_info(manager, "w")->wave, 2u);
+    EXPECT_TRUE(find_info(manager, "w")->library.empty());
+
+    log.clear();
+    manager.initialise();
+    manager.initialise();
+    manager.unload();
+    EXPECT_EQ(log,
+              StringVector({"initialise x", "initialise z", "initialise y", "initialise w", "shutdown w",
+                            "shutdown y", "shutdown z", "shutdown x", "uninstall w", "uninstall y",
+                            "uninstall z", "uninstall x"}));
+
+    // plugins loaded later depend on the installed ones, and are initialised right away
+    log.clear();
+    manager.add_plugin(&x);
+    manager.load(&executor);
+    manager.initialise();
+    manager.add_plugin(&y);
+    manager.load(&executor);
+    EXPECT_EQ(log, StringVector({"install x", "initialise x", "install y", "initialise y"}));
+}
+
+TEST(PluginManager, errors)
+{
+    StringVector log;
+    StaticPlugin x("x", {}, &log);
+    StaticPlugin y("y", {"z"}, &log);
+    StaticPlugin z("z", {"y"}, &log);
+    StaticPlugin missing("missing", {"nothing"}, &log);
+    StaticPlugin a("a", {"x"}, &log);
+    StaticPlugin b("b", {"x"}, &log);
+    b.fail_install = true;
+
+    CountingExecutor executor(JobOrder::FORWARD);
+    PluginManager manager;
+
+    manager.add_plugin(&missing);
+    EXPECT_THROW(manager.load(&executor), std::runtime_error);
+
+    manager.add_plugin(&x);
+    manager.add_plugin(&y);
+    manager.add_plugin(&z);
+    EXPECT_THROW(manager.load(&executor), std::runtime_error);
+
+    manager.add_plugin(&x);
+    manager.add_plugin(&x);
+    EXPECT_THROW(manager.load(&executor), std::runtime_error);
+
+    // nothing was installed
+    EXPECT_TRUE(log.empty());
+    EXPECT_TRUE(manager.get_plugin_info().empty());
+
+    manager.add_library(TEST_PLUGIN_DIR "/libmissing.so");
+    EXPECT_THROW(manager.load(&executor), std::runtime_error);
+
+    // a plugin failing to be created leaves its library unloaded
+    manager.add_library(TEST_THROWING_PLUGIN);
+    EXPECT_THROW(manager.load(&executor), std::runtime_error);
+    EXPECT_EQ(dlopen(TEST_THROWING_PLUGIN, RTLD_NOW | RTLD_NOLOAD), nullptr);
+
+    // a failed install keeps the plugins installed before it
+    manager.add_plugin(&x);
+    manager.add_plugin(&a);
+    manager.add_plugin(&b);
+    EXPECT_THROW(manager.load(&executor), std::runtime_error);
+    EXPECT_EQ(log, StringVector({"install x", "install a"}));
+    EXPECT_EQ(manager.get_plugin_info().size(), 2u);
+    EXPECT_EQ(manager.get_plugin("b"), nullptr);
+}
@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+
+#include <hyue/RenderQueue.h>
+#include <hyue/thread.h>
+
+#include <algorithm>
+#include <random>
+#include <thread>
+
+#include "test_executor.h"
+
+using namespace hyue;
+
+namespace {
+
+using Mode = QueuedRenderableCollection::OrganisationMode;
+
+/// The order of a mode, by std::stable_sort
+std::vector<RenderablePass> stable_sorted(std::vector<RenderablePass> list, Mode mode)
+{
+    std::stable_sort(list.begin(), list.end(), [mode](const RenderablePass& a, const RenderablePass& b) {
+        switch (mode) {
+            case QueuedRenderableCollection::OM_PASS_GROUP:
+                return a.pass < b.pass;
+            case QueuedRenderableCollection::OM_SORT_DESCENDING:
+                return a.depth > b.depth || (a.depth == b.depth && a.pass < b.pass);
+            case QueuedRenderableCollection::OM_SORT_ASCENDING:
+                return a.depth < b.depth || (a.depth == b.depth && a.pass < b.pass);
+        }
+        return false;
+    });
+    return list;
+}
+
+/// Renderables with a few passes and depths, with ties and negative depths
+std::vector<RenderablePass> make_renderables(size_t count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> depth(-10, 1000);
+    std::vector<RenderablePass> ret(count);
+    for (size_t i = 0; i < count; ++i) {
+        ret[i].renderable = uint32_t(i);
+        ret[i].pass = rng() % 7;
+        // every 4th depth from a small set, to get ties
+        ret[i].depth = (i % 4 == 0) ? float(rng() % 5) : depth(rng);
+    }
+    return ret;
+}
+
+bool same_order(const std::vector<RenderablePass>& a, const std::vector<RenderablePass>& b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const RenderablePass& x, const RenderablePass& y) {
+        return x.renderable == y.renderable && x.pass == y.pass && x.depth == y.depth;
+    });
+}
+
+} // namespace
+
+TEST(QueuedRenderableCollection, sort)
+{
+    const Mode modes[] = {QueuedRenderableCollection::OM_PASS_GROUP, QueuedRenderableCollection::OM_SORT_DESCENDING,
+                          QueuedRenderableCollection::OM_SORT_ASCENDING};
+    // std::stable_sort, serial radix and parallel radix sizes
+    const size_t sizes[] = {0, 1, 100, 5000, 100003};
+    std::mt19937 rng(23);
+
+    for (size_t count : sizes) {
+        auto list = make_renderables(count, rng);
+        for (auto mode : modes) {
+            SCOPED_TRACE(count);
+            SCOPED_TRACE(int(mode));
+
+            QueuedRenderableCollection queue;
+            queue.set_organisation_mode(mode);
+            for (auto& rp : list)
+                queue.add_renderable(rp.pass, rp.renderable, rp.depth);
+            EXPECT_EQ(queue.size(), count);
+
+            CountingExecutor executor;
+            queue.sort(&executor);
+            EXPECT_TRUE(same_order(queue.get_sorted(), stable_sorted(list, mode)));
+            EXPECT_FALSE(queue.get_sort_stats().coherent);
+            EXPECT_EQ(queue.get_sort_stats().parallel, count > 65536);
+            EXPECT_EQ(executor.jobs > 0, count > 65536);
+        }
+    }
+
+    // pass group keys have no depth bits, and with passes below 256 a single radix pass
+    QueuedRenderableCollection queue;
+    auto list = make_renderables(5000, rng);
+    for (auto& rp : list)
+        queue.add_renderable(rp.pass, rp.renderable, rp.depth);
+    queue.sort();
+    EXPECT_EQ(queue.get_sort_stats().radix_passes, 1u);
+
+    // -0 and 0 tie
+    QueuedRenderableCollection zeros;
+    zeros.set_organisation_mode(QueuedRenderableCollection::OM_SORT_ASCENDING);
+    zeros.add_renderable(0, 0, 0.0f);
+    zeros.add_renderable(0, 1, -0.0f);
+    zeros.add_renderable(0, 2, -1.0f);
+    zeros.sort();
+    ASSERT_EQ(zeros.get_sorted().size(), 3u);
+    EXPECT_EQ(zeros.get_sorted()[0].renderable, 2u);
+    EXPECT_EQ(zeros.get_sorted()[1].renderable, 0u);
+    EXPECT_EQ(zeros.get_sorted()[2].renderable, 1u);
+}
+
+TEST(QueuedRenderableCollection, coherent)
+{
+    const size_t count = 20000;
+    std::mt19937 rng(29);
+    auto list = make_renderables(count, rng);
+    std::shuffle(list.begin(), list.end(), rng);
+
+    QueuedRenderableCollection queue;
+    queue.set_organisation_mode(QueuedRenderableCollection::OM_SORT_DESCENDING);
+    queue.set_coherent(true);
+    EXPECT_TRUE(queue.is_coherent());
+
+    auto queue_frame = [&]() {
+        queue.clear();
+        for (auto& rp : list)
+            queue.add_renderable(rp.pass, rp.renderable, rp.depth);
+        queue.sort();
+        EXPECT_TRUE(same_order(queue.get_sorted(), stable_sorted(list, queue.get_organisation_mode())));
+    };
+
+    // the first frame has no previous order
+    queue_frame();
+    EXPECT_FALSE(queue.get_sort_stats().coherent);
+
+    // the camera moves a little and a few renderables move on their own,
+    // some renderables appear and others vanish
+    std::uniform_real_distribution<float> jitter(-5, 5);
+    for (int frame = 0; frame < 5; ++frame) {
+        for (auto& rp : list)
+            rp.depth = rp.depth * 1.002f + 0.3f;
+        for (int i = 0; i < 100; ++i) {
+            // not the tied ones, moving one of those is a long way
+            auto& rp = list[rng() % list.size()];
+            if (rp.renderable % 4 != 0)
+                rp.depth += jitter(rng);
+        }
+        list.erase(list.begin() + rng() % list.size());
+        list.insert(list.begin() + rng() % list.size(), {uint32_t(count + frame), 3, 500.0f});
+        queue_frame();
+        EXPECT_TRUE(queue.get_sort_stats().coherent);
+        EXPECT_LT(queue.get_sort_stats().moves, count / 2);
+    }
+
+    // everything moved, the fix up gives up and radix sorts
+    for (auto& rp : list)
+        rp.depth = -rp.depth;
+    queue_frame();
+    EXPECT_FALSE(queue.get_sort_stats().coherent);
+    EXPECT_GT(queue.get_sort_stats().moves, count);
+    EXPECT_GT(queue.get_sort_stats().radix_passes, 0u);
+
+    // a renderable queued with two passes
+    list.push_back({list[0].renderable, 6, list[0].depth});
+    queue_frame();
+    EXPECT_TRUE(queue.get_sort_stats().coherent);
+
+    // a new mode starts from scratch
+    queue.set_organisation_mode(QueuedRenderableCollection::OM_PASS_GROUP);
+    queue_frame();
+    EXPECT_FALSE(queue.get_sort_stats().coherent);
+    queue_frame();
+    EXPECT_TRUE(queue.get_sort_stats().coherent);
+    EXPECT_EQ(queue.get_sort_stats().moves, 0u);
+
+    // as does a sort outside of coherent mode
+    queue.set_coherent(false);
+    queue_frame();
+    queue.set_coherent(true);
+    queue_frame();
+    EXPECT_FALSE(queue.get_sort_stats().coherent);
+}
+
+TEST(QueuedRenderableCollection, concurrent)
+{
+    // queues of two viewports sorted at the same time
+    std::mt19937 rng(31);
+    std::vector<RenderablePass> lists[2] = {make_renderables(80000, rng), make_renderables(30000, rng)};
+    QueuedRenderableCollection queues[2];
+    for (int i = 0; i < 2; ++i) {
+        queues[i].set_organisation_mode(QueuedRenderableCollection::OM_SORT_DESCENDING);
+        for (auto& rp : lists[i])
+            queues[i].add_renderable(rp.pass, rp.renderable, rp.depth);
+    }
+
+    std::thread thread([&]() { queues[1].sort(); });
+    queues[0].sort();
+    thread.join();
+    for (int i = 0; i < 2; ++i)
+        EXPECT_TRUE(same_order(queues[i].get_sorted(), stable_sorted(lists[i], QueuedRenderableCollection::OM_SORT_DESCENDING)));
+}
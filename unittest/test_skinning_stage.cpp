@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+
+#include <hyue/SkinningStage.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
+
+#include <cmath>
+#include <random>
+
+#include "test_executor.h"
+
+using namespace hyue;
+
+namespace {
+
+/// Interleaved vertex as a mesh would have it, position and normal followed by texture coordinates
+struct Vertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+/// Rotation by a random unit quaternion followed by a translation
+mat3x4 random_bone(std::mt19937& rng)
+{
+    std::normal_distribution<float> normal;
+    float w = normal(rng), x = normal(rng), y = normal(rng), z = normal(rng);
+    float inv_length = 1 / std::sqrt(w * w + x * x + y * y + z * z);
+    w *= inv_length, x *= inv_length, y *= inv_length, z *= inv_length;
+    std::uniform_real_distribution<float> translation(-10, 10);
+    return {{{1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y), translation(rng)},
+             {2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x), translation(rng)},
+             {2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y), translation(rng)}}};
+}
+
+/// A mesh with 4 bone weights per vertex, some of them zero with an index past the bones
+struct SkinnedMesh {
+    std::vector<Vertex> vertices;
+    std::vector<float> weights;
+    std::vector<uint8_t> indices;
+    std::vector<mat3x4> bones;
+
+    SkinnedMesh(size_t count, std::mt19937& rng)
+        : vertices(count)
+        , weights(count * 4)
+        , indices(count * 4)
+    {
+        for (int b = 0; b < 8; ++b)
+            bones.push_back(random_bone(rng));
+
+        std::uniform_real_distribution<float> pos(-5, 5);
+        std::uniform_real_distribution<float> weight(0, 1);
+        for (size_t i = 0; i < count; ++i) {
+            Vertex& v = vertices[i];
+            float length = 0;
+            for (int c = 0; c < 3; ++c) {
+                v.position[c] = pos(rng);
+                v.normal[c] = pos(rng);
+                length += v.normal[c] * v.normal[c];
+            }
+            for (int c = 0; c < 3; ++c)
+                v.normal[c] /= std::sqrt(length);
+            v.uv[0] = v.uv[1] = 0.5f;
+
+            int used = 1 + int(rng() % 4);
+            float sum = 0;
+            for (int k = 0; k < 4; ++k) {
+                weights[i * 4 + k] = k < used ? weight(rng) + 0.01f : 0;
+                indices[i * 4 + k] = k < used ? uint8_t(rng() % bones.size()) : 255;
+                sum += weights[i * 4 + k];
+            }
+            for (int k = 0; k < 4; ++k)
+                weights[i * 4 + k] /= sum;
+        }
+    }
+
+    /// Skin into packed positions and normals
+    SkinnedVertexData get_data(std::vector<float>* positions, std::vector<float>* normals) const
+    {
+        SkinnedVertexData data;
+        data.src_position = vertices[0].position;
+        data.dst_position = positions->data();
+        data.src_position_stride = sizeof(Vertex);
+        data.dst_position_stride = 3 * sizeof(float);
+        data.src_normal = vertices[0].normal;
+        data.dst_normal = normals->data();
+        data.src_normal_stride = sizeof(Vertex);
+        data.dst_normal_stride = 3 * sizeof(float);
+        data.blend_weights = weights.data();
+        data.blend_indices = indices.data();
+        data.blend_weight_stride = 4 * sizeof(float);
+        data.blend_index_stride = 4;
+        data.weights_per_vertex = 4;
+        data.blend_matrices = bones.data();
+        data.vertex_count = vertices.size();
+        return data;
+    }
+
+    /// Skin a vertex one weight at a time, as Ogre's OptimisedUtilGeneral
+    void skin(size_t i, float* position, float* normal) const
+    {
+        float p[3] = {}, n[3] = {};
+        for (int k = 0; k < 4; ++k) {
+            float weight = weights[i * 4 + k];
+            if (weight == 0)
+                continue;
+            const mat3x4& m = bones[indices[i * 4 + k]];
+            for (int r = 0; r < 3; ++r) {
+                p[r] += (m.a[r][0] * vertices[i].position[0] + m.a[r][1] * vertices[i].position[1] +
+                         m.a[r][2] * vertices[i].position[2] + m.a[r][3]) *
+                        weight;
+                n[r] += (m.a[r][0] * vertices[i].normal[0] + m.a[r][1] * vertices[i].normal[1] +
+                         m.a[r][2] * vertices[i].normal[2]) *
+                        weight;
+            }
+        }
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        for (int r = 0; r < 3; ++r) {
+            position[r] = p[r];
+            normal[r] = n[r] / length;
+        }
+    }
+};
+
+} // namespace
+
+TEST(SkinningStage, skin)
+{
+    std::mt19937 rng(41);
+    const size_t count = 20005;
+    SkinnedMesh mesh(count, rng);
+
+    const SimdLevel levels[] = {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2};
+    for (auto level : levels) {
+        set_max_simd_level(level);
+        if (get_simd_level() != level)
+            continue;
+        SCOPED_TRACE(int(level));
+
+        // one more vertex than skinned, which must be left alone
+        std::vector<float> positions(count * 3 + 3, -1), normals(count * 3 + 3, -1);
+        SkinningStage stage;
+        stage.add_skinning(mesh.get_data(&positions, &normals));
+        EXPECT_EQ(stage.size(), 1u);
+
+        CountingExecutor executor;
+        stage.run(&executor);
+        EXPECT_EQ(stage.size(), 0u);
+        EXPECT_GT(executor.jobs, 1u);
+        EXPECT_EQ(stage.get_frame_stats().jobs, executor.jobs);
+        EXPECT_EQ(stage.get_frame_stats().skinned_vertices, count);
+        EXPECT_EQ(stage.get_frame_stats().meshes, 1u);
+        EXPECT_GE(stage.get_frame_stats().milliseconds, 0.0);
+
+        for (size_t i = 0; i < count; ++i) {
+            float position[3], normal[3];
+            mesh.skin(i, position, normal);
+            for (int c = 0; c < 3; ++c) {
+                ASSERT_NEAR(positions[i * 3 + c], position[c], 1e-4f) << i;
+                ASSERT_NEAR(normals[i * 3 + c], normal[c], 1e-5f) << i;
+            }
+        }
+        EXPECT_EQ(positions[count * 3], -1);
+        EXPECT_EQ(normals[count * 3], -1);
+
+        // without normals, back into the vertices of a copy
+        std::vector<Vertex> vertices = mesh.vertices;
+        SkinnedVertexData data = mesh.get_data(&positions, &normals);
+        data.dst_position = vertices[0].position;
+        data.dst_position_stride = sizeof(Vertex);
+        data.src_normal = nullptr;
+        stage.add_skinning(data);
+        stage.run();
+        for (size_t i = 0; i < count; ++i) {
+            for (int c = 0; c < 3; ++c)
+                ASSERT_NEAR(vertices[i].position[c], positions[i * 3 + c], 1e-4f) << i;
+            ASSERT_EQ(vertices[i].normal[0], mesh.vertices[i].normal[0]);
+            ASSERT_EQ(vertices[i].uv[0], 0.5f);
+        }
+    }
+    set_max_simd_level(SimdLevel::AVX2);
+}
+
+TEST(SkinningStage, morph)
+{
+    const size_t count = 1000;
+    std::vector<Vertex> key1(count), key2(count), out(count);
+    for (size_t i = 0; i < count; ++i) {
+        key1[i] = {{float(i), 0, 2}, {1, 0, 0}, {0, 0}};
+        key2[i] = {{float(i) + 4, 2, 2}, {0, 1, 0}, {0, 0}};
+        out[i].uv[0] = 0.5f;
+    }
+
+    MorphVertexData data;
+    data.t = 0.25f;
+    data.src_position1 = key1[0].position;
+    data.src_position2 = key2[0].position;
+    data.dst_position = out[0].position;
+    data.src_stride1 = data.src_stride2 = data.dst_stride = sizeof(Vertex);
+    data.morph_normals = true;
+    data.vertex_count = count;
+
+    SkinningStage stage;
+    stage.add_morph(data);
+    stage.run();
+    EXPECT_EQ(stage.get_frame_stats().morphed_vertices, count);
+    EXPECT_EQ(stage.get_frame_stats().skinned_vertices, 0u);
+    const float s = 1 / std::sqrt(0.75f * 0.75f + 0.25f * 0.25f);
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_FLOAT_EQ(out[i].position[0], float(i) + 1);
+        EXPECT_FLOAT_EQ(out[i].position[1], 0.5f);
+        EXPECT_FLOAT_EQ(out[i].position[2], 2);
+        EXPECT_FLOAT_EQ(out[i].normal[0], 0.75f * s);
+        EXPECT_FLOAT_EQ(out[i].normal[1], 0.25f * s);
+        EXPECT_FLOAT_EQ(out[i].normal[2], 0);
+        EXPECT_EQ(out[i].uv[0], 0.5f);
+    }
+}
+
+TEST(SkinningStage, jobs)
+{
+    // small meshes share jobs, large ones are split
+    std::mt19937 rng(43);
+    std::vector<SkinnedMesh> meshes;
+    for (int m = 0; m < 40; ++m)
+        meshes.emplace_back(300, rng);
+    meshes.emplace_back(10000, rng);
+
+    std::vector<std::vector<float>> positions, normals;
+    for (auto& mesh : meshes) {
+        positions.emplace_back(mesh.vertices.size() * 3);
+        normals.emplace_back(mesh.vertices.size() * 3);
+    }
+
+    SkinningStage stage;
+    for (size_t m = 0; m < meshes.size(); ++m)
+        stage.add_skinning(meshes[m].get_data(&positions[m], &normals[m]));
+    CountingExecutor executor;
+    stage.run(&executor);
+    // 14, 14 then 12 small meshes with the first range of the large mesh, then its 2 other ranges
+    EXPECT_EQ(stage.get_frame_stats().jobs, 5u);
+    EXPECT_EQ(stage.get_frame_stats().skinned_vertices, 22000u);
+    EXPECT_EQ(stage.get_frame_stats().meshes, 41u);
+
+    for (size_t m = 0; m < meshes.size(); m += 10) {
+        float position[3], normal[3];
+        size_t last = meshes[m].vertices.size() - 1;
+        meshes[m].skin(last, position, normal);
+        for (int c = 0; c < 3; ++c)
+            EXPECT_NEAR(positions[m][last * 3 + c], position[c], 1e-4f) << m;
+    }
+
+    // nothing queued
+    stage.run(&executor);
+    EXPECT_EQ(stage.get_frame_stats().jobs, 0u);
+    EXPECT_EQ(stage.get_frame_stats().meshes, 0u);
+
+    SkinnedVertexData bad = meshes[0].get_data(&positions[0], &normals[0]);
+    bad.src_position_stride = 13;
+    EXPECT_THROW(stage.add_skinning(bad), std::exception);
+}
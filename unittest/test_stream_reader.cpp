@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <hyue/StreamReader.h>
+
+#include <string.h>
+
+using namespace hyue;
+
+namespace {
+
+/// Stream handing out at most a few bytes per read, to cross block edges everywhere
+class TrickleDataStream : public DataStream {
+public:
+    TrickleDataStream(const String& data, size_t chunk) : data_(data), chunk_(chunk), pos_(0)
+    {
+        size_ = data.size();
+    }
+
+    size_t read(void* buf, size_t count) override
+    {
+        count = std::min({count, chunk_, data_.size() - pos_});
+        memcpy(buf, data_.data() + pos_, count);
+        pos_ += count;
+        return count;
+    }
+
+    void skip(long count) override
+    {
+        pos_ = size_t(long(pos_) + count);
+    }
+
+    void seek(size_t pos) override
+    {
+        pos_ = pos;
+    }
+
+    size_t tell() const override
+    {
+        return pos_;
+    }
+
+    bool is_eof() const override
+    {
+        return pos_ == data_.size();
+    }
+
+    void close() override { }
+
+private:
+    String data_;
+    size_t chunk_;
+    size_t pos_;
+};
+
+/// Readers over the same data: in place on memory, and buffered with tiny blocks
+std::vector<DataStreamPtr> make_streams(const String& data)
+{
+    auto memory = std::make_shared<MemoryDataStream>(data.size());
+    memory->write(data.data(), data.size());
+    memory->seek(0);
+    return {memory, std::make_shared<TrickleDataStream>(data, 3)};
+}
+
+} // namespace
+
+TEST(StreamReader, read_line)
+{
+    String data("first\r\nsecond\n\nwith\0nul\nlast", 28);
+
+    for (auto& stream : make_streams(data)) {
+        StreamReader reader(stream, 16);
+        std::vector<String> lines;
+        std::string_view line;
+        while (reader.read_line(&line))
+            lines.emplace_back(line);
+
+        ASSERT_EQ(lines.size(), 5u);
+        EXPECT_EQ(lines[0], "first");
+        EXPECT_EQ(lines[1], "second");
+        EXPECT_EQ(lines[2], "");
+        EXPECT_EQ(lines[3], String("with\0nul", 8));
+        EXPECT_EQ(lines[4], "last");
+        EXPECT_TRUE(reader.is_eof());
+        EXPECT_EQ(reader.tell(), data.size());
+    }
+}
+
+TEST(StreamReader, long_lines_and_multi_char_delimiter)
+{
+    String big(1000, 'x');
+    String data = "a--b-c--" + big + "--";
+
+    for (auto& stream : make_streams(data)) {
+        StreamReader reader(stream, 16);
+        std::string_view line;
+        ASSERT_TRUE(reader.read_line(&line, "--"));
+        EXPECT_EQ(line, "a");
+        ASSERT_TRUE(reader.read_line(&line, "--"));
+        EXPECT_EQ(line, "b-c");
+        ASSERT_TRUE(reader.read_line(&line, "--"));
+        EXPECT_EQ(line, big);
+        EXPECT_FALSE(reader.read_line(&line, "--"));
+    }
+}
+
+TEST(StreamReader, read_token)
+{
+    String data = "  material Foo/Bar\n{\n\tambient 1 0.5\t0\n}  ";
+
+    for (auto& stream : make_streams(data)) {
+        StreamReader reader(stream, 16);
+        std::vector<String> tokens;
+        std::string_view token;
+        while (reader.read_token(&token))
+            tokens.emplace_back(token);
+
+        std::vector<String> expected = {"material", "Foo/Bar", "{", "ambient", "1", "0.5", "0", "}"};
+        EXPECT_EQ(tokens, expected);
+    }
+}
+
+TEST(StreamReader, mixed_reads)
+{
+    String data = "header 4\nBIN!skipped line\nnext";
+
+    for (auto& stream : make_streams(data)) {
+        std::vector<char> buffer;
+        StreamReader reader(stream, 16, &buffer);
+
+        std::string_view token;
+        ASSERT_TRUE(reader.read_token(&token, " "));
+        EXPECT_EQ(token, "header");
+        std::string_view line;
+        ASSERT_TRUE(reader.read_line(&line));
+        EXPECT_EQ(line, "4");
+
+        char bin[4];
+        ASSERT_EQ(reader.read(bin, 4), 4u);
+        EXPECT_EQ(memcmp(bin, "BIN!", 4), 0);
+
+        EXPECT_EQ(reader.skip_line(), strlen("skipped line\n"));
+        ASSERT_TRUE(reader.read_line(&line));
+        EXPECT_EQ(line, "next");
+        EXPECT_EQ(reader.read(bin, 4), 0u);
+    }
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <hyue/thread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+using namespace hyue;
+
+TEST(ThreadPool, submit)
+{
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.size(), 4);
+
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; ++i)
+        results.push_back(pool.submit([i]() { return i * i; }));
+
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(results[i].get(), i * i);
+
+    auto failed = pool.submit([]() -> int { throw std::runtime_error("failed"); });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+}
+
+TEST(ThreadPool, drain_on_destroy)
+{
+    std::atomic<int> count{0};
+    {
+        ThreadPool pool(2);
+        for (int i = 0; i < 100; ++i)
+            pool.post([&count]() { ++count; });
+    }
+    EXPECT_EQ(count, 100);
+}
+
+TEST(ThreadPool, parallel_for)
+{
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.get_concurrency(), 4);
+
+    std::vector<int> hits(1000);
+    pool.parallel_for(hits.size(), [&hits](size_t i) { ++hits[i]; });
+    EXPECT_EQ(std::count(hits.begin(), hits.end(), 1), hits.size());
+
+    // every job still runs when some throw
+    std::atomic<int> count{0};
+    EXPECT_THROW(pool.parallel_for(100,
+                                   [&count](size_t i) {
+                                       ++count;
+                                       if (i % 10 == 0)
+                                           throw std::runtime_error("failed");
+                                   }),
+                 std::runtime_error);
+    EXPECT_EQ(count, 100);
+
+    // nested use from a worker must not dead lock
+    std::atomic<int> nested{0};
+    pool.parallel_for(8, [&](size_t) { pool.parallel_for(8, [&](size_t) { ++nested; }); });
+    EXPECT_EQ(nested, 64);
+}
@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+
+#include <hyue/Node.h>
+#include <hyue/simd.h>
+#include <hyue/thread.h>
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include "test_executor.h"
+
+using namespace hyue;
+using boost::qvm::operator*;
+
+namespace {
+
+/// Transform of a node computed the way Ogre's Node::_updateFromParent does
+struct Reference {
+    vec3 position;
+    quat orientation;
+    vec3 scale;
+};
+
+Reference reference(const TransformHierarchy& h, TransformHierarchy::Handle node)
+{
+    Reference local{h.get_position(node), h.get_orientation(node), h.get_scale(node)};
+    auto parent_node = h.get_parent(node);
+    if (parent_node == TransformHierarchy::NONE)
+        return local;
+
+    Reference parent = reference(h, parent_node);
+    Reference ret;
+    ret.orientation = h.get_inherit_orientation(node) ? parent.orientation * local.orientation : local.orientation;
+    ret.scale = local.scale;
+    vec3 scaled = local.position;
+    for (int i = 0; i < 3; ++i) {
+        if (h.get_inherit_scale(node))
+            ret.scale.a[i] *= parent.scale.a[i];
+        scaled.a[i] *= parent.scale.a[i];
+    }
+    ret.position = parent.orientation * scaled;
+    for (int i = 0; i < 3; ++i)
+        ret.position.a[i] += parent.position.a[i];
+    return ret;
+}
+
+void expect_near(const vec3& a, const vec3& b, float tolerance = 1e-4f)
+{
+    for (int i = 0; i < 3; ++i)
+        EXPECT_NEAR(a.a[i], b.a[i], tolerance);
+}
+
+void expect_near(const quat& a, const quat& b, float tolerance = 1e-4f)
+{
+    for (int i = 0; i < 4; ++i)
+        EXPECT_NEAR(a.a[i], b.a[i], tolerance);
+}
+
+/// Check the derived transform and world matrix of a node against reference()
+void expect_reference(const TransformHierarchy& h, TransformHierarchy::Handle node)
+{
+    Reference ref = reference(h, node);
+    expect_near(h.get_derived_position(node), ref.position);
+    expect_near(h.get_derived_orientation(node), ref.orientation);
+    expect_near(h.get_derived_scale(node), ref.scale);
+
+    // the world matrix maps the local axes to world space
+    mat4 m = h.get_world_matrix(node);
+    for (int axis = 0; axis < 3; ++axis) {
+        vec3 v{0, 0, 0};
+        v.a[axis] = ref.scale.a[axis];
+        v = ref.orientation * v;
+        for (int r = 0; r < 3; ++r)
+            EXPECT_NEAR(m.a[r][axis], v.a[r], 1e-4f);
+    }
+    for (int r = 0; r < 3; ++r)
+        EXPECT_NEAR(m.a[r][3], ref.position.a[r], 1e-4f);
+    EXPECT_EQ(m.a[3][3], 1.0f);
+}
+
+quat random_orientation(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> angle(-3.14f, 3.14f);
+    std::uniform_real_distribution<float> axis(-1, 1);
+    vec3 a{axis(rng), axis(rng), axis(rng) + 2};
+    return boost::qvm::rot_quat(boost::qvm::normalized(a), angle(rng));
+}
+
+} // namespace
+
+TEST(TransformHierarchy, update)
+{
+    // a few roots, a level wide enough to be split across jobs, then chains
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> pos(-10, 10);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+    TransformHierarchy h;
+    std::vector<TransformHierarchy::Handle> nodes;
+    for (int i = 0; i < 5; ++i)
+        nodes.push_back(h.create());
+    for (int i = 0; i < 10000; ++i)
+        nodes.push_back(h.create(nodes[rng() % 5]));
+    for (int i = 0; i < 3000; ++i)
+        nodes.push_back(h.create(nodes[5 + rng() % (nodes.size() - 5)]));
+
+    for (auto node : nodes) {
+        h.set_position(node, vec3{pos(rng), pos(rng), pos(rng)});
+        h.set_orientation(node, random_orientation(rng));
+        h.set_scale(node, vec3{scale(rng), scale(rng), scale(rng)});
+        h.set_inherit_orientation(node, rng() % 4 != 0);
+        h.set_inherit_scale(node, rng() % 4 != 0);
+    }
+    EXPECT_EQ(h.size(), nodes.size());
+    EXPECT_TRUE(h.is_dirty());
+
+    // computed on demand before the first update
+    for (size_t i = 0; i < nodes.size(); i += 97)
+        expect_reference(h, nodes[i]);
+
+    const SimdLevel levels[] = {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2};
+    for (auto level : levels) {
+        set_max_simd_level(level);
+        if (get_simd_level() != level)
+            continue;
+        SCOPED_TRACE(int(level));
+
+        h.set_position(nodes[0], vec3{pos(rng), pos(rng), pos(rng)});
+        CountingExecutor executor;
+        h.update(&executor);
+        EXPECT_FALSE(h.is_dirty());
+        EXPECT_GT(executor.jobs, 1u);
+        EXPECT_GE(h.get_depth(), 3u);
+
+        for (size_t i = 0; i < nodes.size(); i += 7)
+            expect_reference(h, nodes[i]);
+    }
+    set_max_simd_level(SimdLevel::AVX2);
+
+    // on the worker pool
+    h.set_scale(nodes[1], vec3{2, 2, 2});
+    h.update();
+    for (size_t i = 1; i < nodes.size(); i += 31)
+        expect_reference(h, nodes[i]);
+}
+
+TEST(TransformHierarchy, structure)
+{
+    TransformHierarchy h;
+    auto a = h.create();
+    auto b = h.create(a);
+    auto c = h.create(b);
+    h.set_position(a, vec3{1, 0, 0});
+    h.set_position(b, vec3{0, 1, 0});
+    h.set_position(c, vec3{0, 0, 1});
+    h.update();
+    EXPECT_EQ(h.get_depth(), 3u);
+    expect_near(h.get_derived_position(c), vec3{1, 1, 1});
+    EXPECT_EQ(h.get_parent(c), b);
+    EXPECT_EQ(h.get_parent(a), TransformHierarchy::NONE);
+
+    // cycles are refused
+    EXPECT_THROW(h.set_parent(a, c), std::runtime_error);
+    EXPECT_THROW(h.set_parent(a, a), std::runtime_error);
+
+    // reparent a subtree
+    h.set_parent(b, TransformHierarchy::NONE);
+    expect_near(h.get_derived_position(c), vec3{0, 1, 1});
+    h.update();
+    EXPECT_EQ(h.get_depth(), 2u);
+    expect_near(h.get_derived_position(c), vec3{0, 1, 1});
+
+    // destroying a node makes its children roots, handles are reused
+    h.set_parent(b, a);
+    h.destroy(b);
+    EXPECT_EQ(h.size(), 2u);
+    EXPECT_EQ(h.get_parent(c), TransformHierarchy::NONE);
+    expect_near(h.get_derived_position(c), vec3{0, 0, 1});
+    EXPECT_THROW(h.get_position(b), std::runtime_error);
+    auto d = h.create(c);
+    EXPECT_EQ(d, b);
+    h.update();
+    EXPECT_EQ(h.get_depth(), 2u);
+    expect_near(h.get_derived_position(d), vec3{0, 0, 1});
+    expect_near(h.get_derived_position(a), vec3{1, 0, 0});
+}
+
+TEST(Node, transform)
+{
+    TransformHierarchy h;
+    Node root(&h, "root");
+    auto child = root.create_child("child", vec3{0, 0, 1});
+    auto grandchild = child->create_child("grandchild", vec3{1, 0, 0});
+    EXPECT_EQ(root.num_children(), 1u);
+    EXPECT_EQ(root.get_child("child"), child.get());
+    EXPECT_EQ(grandchild->get_parent(), child.get());
+
+    const float half_pi = 1.5707964f;
+    root.set_scale(vec3{2, 2, 2});
+    root.rotate(vec3{0, 1, 0}, half_pi);
+    expect_near(grandchild->get_derived_position(), vec3{2, 0, -2});
+    expect_near(grandchild->get_derived_scale(), vec3{2, 2, 2});
+
+    h.update();
+    expect_near(grandchild->get_derived_position(), vec3{2, 0, -2});
+    expect_reference(h, grandchild->get_handle());
+
+    grandchild->set_inherit_scale(false);
+    grandchild->set_inherit_orientation(false);
+    expect_near(grandchild->get_derived_scale(), vec3{1, 1, 1});
+    expect_near(grandchild->get_derived_orientation(), quat{1, 0, 0, 0});
+
+    // translate in local space follows the orientation of the node
+    child->rotate(vec3{0, 0, 1}, half_pi, Node::TS_PARENT);
+    child->translate(vec3{1, 0, 0}, Node::TS_LOCAL);
+    expect_near(child->get_position(), vec3{0, 1, 1});
+
+    // translate in world space is undone by the parent transform
+    vec3 before = child->get_derived_position();
+    child->translate(vec3{0, 4, 0}, Node::TS_WORLD);
+    vec3 after = child->get_derived_position();
+    expect_near(vec3{after.a[0] - before.a[0], after.a[1] - before.a[1], after.a[2] - before.a[2]}, vec3{0, 4, 0});
+
+    // rotate in world space
+    quat world_before = child->get_derived_orientation();
+    quat q = boost::qvm::rot_quat(vec3{1, 0, 0}, half_pi);
+    child->rotate(q, Node::TS_WORLD);
+    expect_near(child->get_derived_orientation(), q * world_before);
+    h.update();
+    expect_reference(h, child->get_handle());
+
+    // removing a child keeps its local transform
+    child->remove_child(grandchild.get());
+    EXPECT_EQ(grandchild->get_parent(), nullptr);
+    expect_near(grandchild->get_derived_position(), vec3{1, 0, 0});
+    EXPECT_THROW(root.add_child(child.get()), std::runtime_error);
+
+    // destroying a node orphans its children
+    child->add_child(grandchild.get());
+    child.reset();
+    EXPECT_EQ(root.num_children(), 0u);
+    EXPECT_EQ(grandchild->get_parent(), nullptr);
+    EXPECT_EQ(h.get_parent(grandchild->get_handle()), TransformHierarchy::NONE);
+    EXPECT_EQ(h.size(), 2u);
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <atomic>
+
+#include <hyue/ZipArchiveFactory.h>
+
+using namespace hyue;
+
+static void open_all_entries_concurrently(Archive* archive, int thread_count, int rounds)
+{
+    auto files = archive->list();
+
+    std::map<String, String> expected;
+    for (auto& f : files) {
+        expected[f] = archive->open(f)->get_as_string();
+    }
+
+    std::atomic<int> failures { 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int r = 0; r < rounds; ++r) {
+                for (size_t i = 0; i < files.size(); ++i) {
+                    // every thread walks the entries in a different order
+                    auto& f = files[(i + t) % files.size()];
+                    auto stream = archive->open(f);
+                    if (!stream || stream->get_as_string() != expected[f])
+                        ++failures;
+                }
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(failures, 0);
+}
+
+TEST(ZipArchiveThreads, open)
+{
+    ZipArchiveFactory factory;
+    auto archive = factory.create_instance(UNITTEST_DIR "/test.zip");
+    archive->load();
+
+    EXPECT_EQ(archive->list().size(), 2);
+    open_all_entries_concurrently(archive, 8, 200);
+
+    archive->unload();
+    factory.destroy_instance(archive);
+}
+
+TEST(ZipArchiveThreads, open_streamed)
+{
+    auto threshold = ZipArchiveFactory::get_stream_threshold();
+    ZipArchiveFactory::set_stream_threshold(0);
+
+    ZipArchiveFactory factory;
+    auto archive = factory.create_instance(UNITTEST_DIR "/test_deflated.zip");
+    archive->load();
+
+    open_all_entries_concurrently(archive, 8, 200);
+
+    archive->unload();
+    factory.destroy_instance(archive);
+
+    ZipArchiveFactory::set_stream_threshold(threshold);
+}